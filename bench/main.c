@@ -0,0 +1,399 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif // !defined(_WIN32)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif // _WIN32
+
+#include <cce/engine_common.h>
+#include <cce/engine_common_IO.h>
+#include <cce/os_interaction.h>
+#include <cce/utils.h>
+#include <cce/plugins/actions.h>
+#include <cce/plugins/actions_internal.h>
+#include <cce/plugins/map2D/map2D.h>
+
+// Every benchmark is run this many times, the fastest round is reported (least disturbed by the scheduler)
+#define BENCH_ROUNDS 7u
+#define BENCH_DATA_SIZE 1024u
+#define BENCH_DATA_MASK (BENCH_DATA_SIZE - 1u)
+#define BENCH_DELAYED_ACTIONS 1024u
+#define BENCH_MAP_ELEMENTS 4096u
+#define BENCH_CCF_SECTION_SIZE 16384u
+
+static volatile uint32_t g_sink;
+
+static uint64_t benchGetTime (void)
+{
+#ifdef _WIN32
+   static LARGE_INTEGER frequency = {0};
+   LARGE_INTEGER counter;
+   if (frequency.QuadPart == 0)
+      QueryPerformanceFrequency(&frequency);
+   QueryPerformanceCounter(&counter);
+   return (uint64_t)((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#else
+   struct timespec tp;
+   clock_gettime(CLOCK_MONOTONIC, &tp);
+   return (uint64_t) tp.tv_sec * 1000000000u + (uint64_t) tp.tv_nsec;
+#endif // _WIN32
+}
+
+static void benchReport (const char *name, uint64_t bestTime, uint64_t iterations)
+{
+   double nsPerOp = (double) bestTime / (double) iterations;
+   printf("%-36s %12.2f ns/op %16.0f ops/sec\n", name, nsPerOp, (nsPerOp > 0.0) ? 1e9 / nsPerOp : 0.0);
+}
+
+// setup is run before each round and is not measured
+#define BENCH(name, iterations, setup, body) \
+do \
+{ \
+   uint64_t BEST = UINT64_MAX; \
+   for (unsigned ROUND = 0; ROUND < BENCH_ROUNDS; ++ROUND) \
+   { \
+      setup; \
+      uint64_t START = benchGetTime(); \
+      for (uint64_t I = 0; I < (uint64_t)(iterations); ++I) \
+      { \
+         body; \
+      } \
+      uint64_t ELAPSED = benchGetTime() - START; \
+      BEST = CCE_MIN(BEST, ELAPSED); \
+   } \
+   benchReport(name, BEST, iterations); \
+} \
+while (0)
+
+static uint32_t g_randomState = 0x2545F491u;
+
+static uint32_t benchRandom (void)
+{
+   // xorshift32, deterministic so that results are comparable between runs
+   g_randomState ^= g_randomState << 13;
+   g_randomState ^= g_randomState >> 17;
+   g_randomState ^= g_randomState << 5;
+   return g_randomState;
+}
+
+static void benchColors (void)
+{
+   union cce_color *hsv = malloc(BENCH_DATA_SIZE * sizeof(union cce_color));
+   union cce_color *hsl = malloc(BENCH_DATA_SIZE * sizeof(union cce_color));
+   union cce_color *hcl = malloc(BENCH_DATA_SIZE * sizeof(union cce_color));
+   union cce_color *rgb = malloc(BENCH_DATA_SIZE * sizeof(union cce_color));
+   for (uint32_t i = 0; i < BENCH_DATA_SIZE; ++i)
+   {
+      uint32_t random = benchRandom();
+      uint16_t hue = random % 3600u;
+      hsv[i] = CCE_COLOR_SET_HSV(hue, (uint8_t)(random >> 12), (uint8_t)(random >> 20));
+      hsl[i] = CCE_COLOR_SET_HSL(hue, (uint8_t)(random >> 12), (uint8_t)(random >> 20));
+      rgb[i] = CCE_COLOR_SET_RGB((uint8_t)(random >> 8), (uint8_t)(random >> 16), (uint8_t)(random >> 24));
+      hcl[i] = cceRGBtoHCL(rgb[i]);
+   }
+   BENCH("cceHSVtoRGB", 1u << 22, (void) 0, g_sink += cceHSVtoRGB(hsv[I & BENCH_DATA_MASK]).rgb.r);
+   BENCH("cceHSLtoRGB", 1u << 22, (void) 0, g_sink += cceHSLtoRGB(hsl[I & BENCH_DATA_MASK]).rgb.r);
+   BENCH("cceHCLtoRGB", 1u << 22, (void) 0, g_sink += cceHCLtoRGB(hcl[I & BENCH_DATA_MASK]).rgb.r);
+   BENCH("cceRGBtoHSV", 1u << 22, (void) 0, g_sink += cceRGBtoHSV(rgb[I & BENCH_DATA_MASK]).hsv.s);
+   BENCH("cceRGBtoHSL", 1u << 22, (void) 0, g_sink += cceRGBtoHSL(rgb[I & BENCH_DATA_MASK]).hsv.s);
+   BENCH("cceRGBtoHCL", 1u << 22, (void) 0, g_sink += cceRGBtoHCL(rgb[I & BENCH_DATA_MASK]).hsv.s);
+   free(hsv);
+   free(hsl);
+   free(hcl);
+   free(rgb);
+}
+
+static void benchCollisions (void)
+{
+   struct cce_collider_rect2D_16_16 *rects = malloc(BENCH_DATA_SIZE * sizeof(struct cce_collider_rect2D_16_16));
+   struct cce_collider_cir2D_16_16  *circles = malloc(BENCH_DATA_SIZE * sizeof(struct cce_collider_cir2D_16_16));
+   for (uint32_t i = 0; i < BENCH_DATA_SIZE; ++i)
+   {
+      uint32_t random = benchRandom();
+      rects[i].position.x = (int16_t)(random & 0x3FF) - 512;
+      rects[i].position.y = (int16_t)((random >> 10) & 0x3FF) - 512;
+      rects[i].size.x = 1 + ((random >> 20) & 0x3F);
+      rects[i].size.y = 1 + ((random >> 26) & 0x3F);
+      random = benchRandom();
+      circles[i].position.x = (int16_t)(random & 0x3FF) - 512;
+      circles[i].position.y = (int16_t)((random >> 10) & 0x3FF) - 512;
+      circles[i].diameter = 1 + ((random >> 20) & 0x3F);
+   }
+   #define PAIR_A (I & BENCH_DATA_MASK)
+   #define PAIR_B ((I * 7u + 3u) & BENCH_DATA_MASK)
+   BENCH("cceCheckCollisionRect2D",    1u << 24, (void) 0, g_sink += cceCheckCollisionRect2D(rects[PAIR_A], rects[PAIR_B]));
+   BENCH("cceCheckCollisionCir2D",     1u << 24, (void) 0, g_sink += cceCheckCollisionCir2D(circles[PAIR_A], circles[PAIR_B]));
+   BENCH("cceCheckCollisionCirRect2D", 1u << 24, (void) 0, g_sink += cceCheckCollisionCirRect2D(circles[PAIR_A], rects[PAIR_B]));
+   #undef PAIR_A
+   #undef PAIR_B
+   // Same data as structure of arrays, one collider against whole batch
+   int16_t  *positionX = malloc(BENCH_DATA_SIZE * sizeof(int16_t)), *positionY = malloc(BENCH_DATA_SIZE * sizeof(int16_t));
+   uint16_t *sizeX = malloc(BENCH_DATA_SIZE * sizeof(uint16_t)), *sizeY = malloc(BENCH_DATA_SIZE * sizeof(uint16_t));
+   uint16_t *diameter = malloc(BENCH_DATA_SIZE * sizeof(uint16_t));
+   uint32_t *mask = malloc((BENCH_DATA_SIZE + 31) / 32 * sizeof(uint32_t));
+   for (uint32_t i = 0; i < BENCH_DATA_SIZE; ++i)
+   {
+      positionX[i] = rects[i].position.x;
+      positionY[i] = rects[i].position.y;
+      sizeX[i] = rects[i].size.x;
+      sizeY[i] = rects[i].size.y;
+      diameter[i] = circles[i].diameter;
+   }
+   const struct cce_rect2Dbatch_16_16 rectBatch = {positionX, positionY, sizeX, sizeY};
+   const struct cce_cir2Dbatch_16_16 circleBatch = {positionX, positionY, diameter};
+   static const char *const implementationNames[] = {"auto", "scalar", "SSE2", "AVX2", "NEON"};
+   char name[48];
+   for (uint8_t implementation = CCE_COLLISION_BATCH_SCALAR; implementation <= CCE_COLLISION_BATCH_NEON; ++implementation)
+   {
+      if (cceSetCollisionBatchImplementation(implementation) != implementation)
+         continue;
+      // Reported per tested pair
+      snprintf(name, sizeof(name), "Rect2DBatch (%s)", implementationNames[implementation]);
+      BENCH(name, (1u << 12) * BENCH_DATA_SIZE, (void) 0,
+            cceCheckCollisionRect2DBatch(rects[(I / BENCH_DATA_SIZE) & BENCH_DATA_MASK], &rectBatch, BENCH_DATA_SIZE, mask); I += BENCH_DATA_SIZE - 1; g_sink += mask[0]);
+      snprintf(name, sizeof(name), "Cir2DBatch (%s)", implementationNames[implementation]);
+      BENCH(name, (1u << 12) * BENCH_DATA_SIZE, (void) 0,
+            cceCheckCollisionCir2DBatch(circles[(I / BENCH_DATA_SIZE) & BENCH_DATA_MASK], &circleBatch, BENCH_DATA_SIZE, mask); I += BENCH_DATA_SIZE - 1; g_sink += mask[0]);
+      snprintf(name, sizeof(name), "CirRect2DBatch (%s)", implementationNames[implementation]);
+      BENCH(name, (1u << 12) * BENCH_DATA_SIZE, (void) 0,
+            cceCheckCollisionCirRect2DBatch(circles[(I / BENCH_DATA_SIZE) & BENCH_DATA_MASK], &rectBatch, BENCH_DATA_SIZE, mask); I += BENCH_DATA_SIZE - 1; g_sink += mask[0]);
+   }
+   cceSetCollisionBatchImplementation(CCE_COLLISION_BATCH_AUTO);
+   free(positionX);
+   free(positionY);
+   free(sizeX);
+   free(sizeY);
+   free(diameter);
+   free(mask);
+   free(rects);
+   free(circles);
+}
+
+static void benchUTF8 (void)
+{
+   // $, £, €, 😀 and plain ASCII - typical mixed text
+   static const unsigned char sample[] = "Score: 1024$ \xc2\xa3 \xe2\x82\xac \xf0\x9f\x98\x80 Conservative Creator's Engine";
+   unsigned char *text = malloc(BENCH_DATA_SIZE * sizeof(sample));
+   size_t textLength = 0;
+   for (uint32_t i = 0; i < BENCH_DATA_SIZE; ++i, textLength += sizeof(sample) - 1)
+      memcpy(text + textLength, sample, sizeof(sample) - 1);
+   text[textLength] = '\0';
+   uint32_t characters = 0;
+   for (const unsigned char *it = text; *it != '\0'; it += cceGetCharSizeUTF8(it))
+      ++characters;
+   const unsigned char *iterator = text;
+   BENCH("cceGetCharUTF8", characters, iterator = text, g_sink += cceGetCharUTF8(iterator); iterator += cceGetCharSizeUTF8(iterator));
+   free(text);
+}
+
+struct benchSection
+{
+   uint32_t *data;
+   uint16_t  dataQuantity;
+};
+
+static int loadBenchSection (void *buffer, uint16_t sectionSize, struct cce_buffer *info, FILE *file)
+{
+   CCE_UNUSED(info);
+   struct benchSection *section = buffer;
+   section->data = malloc(sectionSize * sizeof(uint32_t));
+   section->dataQuantity = sectionSize;
+   return fread(section->data, sizeof(uint32_t), sectionSize, file) != sectionSize;
+}
+
+static void createBenchSection (void *buffer, struct cce_buffer *info)
+{
+   CCE_UNUSED(info);
+   struct benchSection *section = buffer;
+   section->dataQuantity = BENCH_CCF_SECTION_SIZE;
+   section->data = malloc(BENCH_CCF_SECTION_SIZE * sizeof(uint32_t));
+   for (uint32_t i = 0; i < BENCH_CCF_SECTION_SIZE; ++i)
+      section->data[i] = benchRandom();
+}
+
+static void freeBenchSection (void *buffer, struct cce_buffer *info)
+{
+   CCE_UNUSED(info);
+   free(((struct benchSection*) buffer)->data);
+}
+
+static uint16_t storeBenchSection (void *buffer, struct cce_buffer *info, FILE *file)
+{
+   CCE_UNUSED(info);
+   struct benchSection *section = buffer;
+   fwrite(section->data, sizeof(uint32_t), section->dataQuantity, file);
+   return section->dataQuantity;
+}
+
+static void benchBinaryCCF (const char *tmpDir)
+{
+   uint16_t functionSet = cceGetFileIOfunctionSet();
+   cceRegisterFileIOcallbacks(functionSet, cceNameToUID("bench1"), loadBenchSection, freeBenchSection, createBenchSection, storeBenchSection, sizeof(struct benchSection));
+   cceRegisterFileIOcallbacks(functionSet, cceNameToUID("bench2"), loadBenchSection, freeBenchSection, createBenchSection, storeBenchSection, sizeof(struct benchSection));
+   char *path = cceCreateNewPathFromOldPath(tmpDir, "bench.ccf", 0);
+   struct cce_buffer *buffer = cceCreateBuffer(2, functionSet);
+   if (cceWriteBinaryCCF(buffer, path) != 0)
+   {
+      fprintf(stderr, "BENCH::CCF:\nfile %s cannot be written\n", path);
+      cceFreeBuffer(buffer);
+      free(path);
+      return;
+   }
+   cceFreeBuffer(buffer);
+   BENCH("cceLoadBinaryCCF (128 KiB)", 1024, (void) 0, buffer = cceLoadBinaryCCF(path, functionSet); g_sink += (buffer != NULL); cceFreeBuffer(buffer));
+   remove(path);
+   free(path);
+}
+
+static void nopAction (void *data, uint32_t repeats, struct cce_buffer *state)
+{
+   CCE_UNUSED(data);
+   CCE_UNUSED(state);
+   g_sink += repeats;
+}
+
+static void benchActions (struct cce_buffer *map)
+{
+   uint32_t nopUID = cceNameToUID("bnop");
+   cceaRegisterAction(nopUID, nopAction, NULL, sizeof(struct cceaAction));
+   struct cceaAction actions[64];
+   for (struct cceaAction *iterator = actions, *end = actions + CCE_STATIC_ARRAY_LENGTH(actions); iterator < end; ++iterator)
+      iterator->UID = nopUID;
+   BENCH("ccea__runActions (64 actions)", 1u << 16, (void) 0, ccea__runActions(actions, sizeof(actions), 1, map));
+   for (uint32_t i = 0; i < CCE_STATIC_ARRAY_LENGTH(actions); ++i)
+      cceaAddActionOnEvent(cceaBasicEventsUIDs[CCEA_EVENT_WRITE], i + 1, actions + i, map);
+   BENCH("cceaInvokeEvent (64 actions)", 1u << 16, (void) 0, cceaInvokeEvent(cceaBasicEventsUIDs[CCEA_EVENT_WRITE], 1, map));
+
+   // Delayed far into the future: measures the per-frame cost of pending actions that do not fire
+   for (uint32_t i = 0; i < BENCH_DELAYED_ACTIONS; ++i)
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC1(action, struct cceaDelayActions, ((struct cceaDelayActions){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS], 0, 0x7FFFFFFF - i}),
+                                             struct cceaAction, ((struct cceaAction){nopUID}));
+      cceaRunAction((struct cceaAction*)action, 1, map);
+   }
+   BENCH("cceaRunDelayedActions (1024 idle)", 1u << 12, (void) 0, cceaRunDelayedActions(map));
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC1(action, struct cceaDelayActions, ((struct cceaDelayActions){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS], 0, 0}),
+                                             struct cceaAction, ((struct cceaAction){nopUID}));
+      BENCH("delay + fire (1 action, 1024 idle)", 1u << 14, (void) 0, cceaRunAction((struct cceaAction*)action, 1, map); cceaRunDelayedActions(map));
+   }
+   struct cceaPoolStatistics statistics;
+   cceaGetPoolStatistics(&statistics);
+   for (uint32_t i = 0; i < CCEA_POOL_SIZE_CLASSES; ++i)
+      printf("action pool %4u B: %6u in use, %6u high-water mark, %6u reserved\n", statistics.blockSize[i], statistics.inUse[i], statistics.highWaterMark[i], statistics.reserved[i]);
+}
+
+static void benchMap2D (struct cce_buffer *map, const char *tmpDir)
+{
+   struct cce_element *elements = cceGetElements(0, 1, map);
+   *elements = (struct cce_element) {{0, 0}, {.rgba = {255, 255, 255, 255}}, {1, 1}, 0, 0, 0};
+   struct cce_elementposition *positions = cceGetElementsPosition(0, 0, BENCH_MAP_ELEMENTS, map);
+   for (uint32_t i = 0; i < BENCH_MAP_ELEMENTS; ++i)
+      positions[i] = (struct cce_elementposition) {{(int16_t)(i & 0x3F), (int16_t)(i >> 6)}, 1, 0, 0};
+   char *path = cceCreateNewPathFromOldPath(tmpDir, "bench.c2m", 0);
+   if (cceWriteMap2Ddynamic(map, path) != 0)
+   {
+      fprintf(stderr, "BENCH::MAP2D:\nfile %s cannot be written\n", path);
+      free(path);
+      return;
+   }
+   struct cce_buffer *loaded;
+   BENCH("cceLoadMap2D (4096 elements)", 256, (void) 0, loaded = cceLoadMap2D(path); g_sink += (loaded != NULL); cceFreeMap2D(loaded));
+   remove(path);
+   free(path);
+}
+
+#define BENCH_BROADPHASE_POSITIONS 50000
+
+static void benchBroadphase (struct cce_buffer *map)
+{
+   // Two colliders per element position, 100000 in total
+   struct cce_collidermap2D colliders[2];
+   colliders[0] = (struct cce_collidermap2D){.data.rectangle = {{0, 0}, {8, 8}}, 1, 2, CCE_RECTANGLE_COLLIDER};
+   colliders[1] = (struct cce_collidermap2D){.data.circle = {{2, -6}, 6}, 1, 2, CCE_CIRCLE_COLLIDER};
+   struct cce_collisioninfo collisionInfo = {colliders, 2};
+   struct cce_element *element = cceGetElements(1, 1, map);
+   *element = (struct cce_element) {{0, 0}, {.rgba = {255, 255, 255, 255}}, {8, 8}, 0, 0, 0};
+   struct cce_elementposition *positions = cceGetElementsPosition(1, 0, BENCH_BROADPHASE_POSITIONS, map);
+   for (uint32_t i = 0; i < BENCH_BROADPHASE_POSITIONS; ++i)
+   {
+      uint32_t random = benchRandom();
+      positions[i] = (struct cce_elementposition) {{(int16_t)(random & 0x1FFF) - 4096, (int16_t)((random >> 13) & 0x1FFF) - 4096}, 2, 0, 0};
+   }
+   struct cce_broadphase2D *broadphase = cceCreateBroadphase2D(4);
+   struct cce_broadphasepair2D *pairs = malloc(BENCH_BROADPHASE_POSITIONS * 4 * sizeof(struct cce_broadphasepair2D));
+   struct cce_broadphasecandidate2D candidates[256];
+   BENCH("cceBuildBroadphaseMap2D (100k)", 1, (void) 0, g_sink += cceBuildBroadphaseMap2D(broadphase, &collisionInfo, 1, map));
+   BENCH("cceGetBroadphasePairs2D (100k)", 1, (void) 0, g_sink += cceGetBroadphasePairs2D(broadphase, pairs, BENCH_BROADPHASE_POSITIONS * 4));
+   BENCH("cceUpdateBroadphaseMap2D (1 moved)", 1u << 16, (void) 0,
+         positions = cceGetElementsPosition(1, I % BENCH_BROADPHASE_POSITIONS, 1, map);
+         positions->position.x += (I & 0x2) ? 3 : -3;
+         g_sink += cceUpdateBroadphaseMap2D(broadphase, I % BENCH_BROADPHASE_POSITIONS, 1));
+   BENCH("cceQueryBroadphaseAABB2D (64x64)", 1u << 16, (void) 0,
+         g_sink += cceQueryBroadphaseAABB2D(broadphase, (struct cce_collider_rect2D_32_32){{(int32_t)(I & 0x1FFF) - 4096, (int32_t)((I * 7u) & 0x1FFF) - 4096}, {64, 64}}, candidates, 256));
+   BENCH("cceQueryBroadphaseRay2D (256 long)", 1u << 16, (void) 0,
+         g_sink += cceQueryBroadphaseRay2D(broadphase, (struct cce_i32vec2){(int32_t)(I & 0x1FFF) - 4096, (int32_t)((I * 7u) & 0x1FFF) - 4096},
+                                           (struct cce_i32vec2){(int32_t)(I & 0x1FFF) - 3904, (int32_t)((I * 7u) & 0x1FFF) - 4000}, candidates, 256));
+   free(pairs);
+   cceFreeBroadphase2D(broadphase);
+}
+
+int main (int argc, char **argv)
+{
+   if (argc >= 2)
+   {
+      if (argc > 2 || (argc == 2 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))))
+      {
+         printf("Usage: %s [PATH_TO_ENGINE_RESOURCES]\nWhen PATH_TO_ENGINE_RESOURCES is not provided, current directory is assumed.", argv[0]);
+         return -(argc > 2);
+      }
+      cceSetCurrentPath(argv[1]);
+   }
+   char *tmpDir = cceGetTemporaryDirectory(0);
+   if (tmpDir == NULL)
+      return -1;
+   benchColors();
+   benchCollisions();
+   benchUTF8();
+   benchBinaryCCF(tmpDir);
+
+   cceSetBackend("null");
+   cceaLoadActionsPlugin();
+   cceLoadMap2Dplugin();
+   if (cceInit("bench/game.ini") != 0)
+   {
+      fputs("BENCH::SKIPPED:\nactions and map2D benchmarks require engine initialization\n", stderr);
+      free(tmpDir);
+      cceTerminateTemporaryDirectory();
+      return 0;
+   }
+   struct cce_buffer *map = cceCreateMap2Ddynamic();
+   benchActions(map);
+   benchMap2D(map, tmpDir);
+   benchBroadphase(map);
+   cceFreeMap2Ddynamic(map);
+   cceTerminate();
+   free(tmpDir);
+   cceTerminateTemporaryDirectory();
+   return 0;
+}
@@ -0,0 +1,248 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cce/engine_common.h>
+#include <cce/os_interaction.h>
+#include <cce/utils.h>
+#include <cce/plugins/actions.h>
+#include <cce/plugins/map2D/map2D.h>
+
+#include "fuzz.h"
+
+#define CCF_VERSION 3u
+#define CCF_SECTION_HEADER_SIZE 21u
+#define CCF_CODEC_NONE 0u
+
+const char *const fuzzTargetNames[FUZZ_TARGETS_QUANTITY] = {"ccf", "m2dres", "m2drend", "actions", "ini"};
+const char *const fuzzSectionNames[FUZZ_TARGETS_QUANTITY] = {NULL, "m2Dres", "m2Drend", "cceacde", NULL};
+
+// Map loading has to be deterministic: failed map is NULL instead of the generated fallback one
+static const char g_gameINI[] =
+   "[Window]\n"
+   "gameResolution = 32x32\n"
+   "\n"
+   "[Map2D]\n"
+   "renderer = software\n"
+   "renderingLayersQuantity = 1\n"
+   "textureSize = 16x16\n"
+   "pxPerCell = 1\n"
+   "useFallbackMap = false\n";
+
+struct alterMapSt
+{
+   uint32_t actionUID;
+   uint8_t counter;
+};
+
+// Stored maps refer to game-defined actions by UID, loader rejects ones which aren't registered
+static void emptyAction (void *data, uint32_t repeats, struct cce_buffer *state)
+{
+   CCE_UNUSED(data);
+   CCE_UNUSED(repeats);
+   CCE_UNUSED(state);
+}
+
+char* fuzzGetTemporaryPath (const char *fileName)
+{
+   size_t length = strlen(fileName);
+   char *path = cceGetTemporaryDirectory(length + 2u);
+   if (path == NULL)
+      return NULL;
+   size_t pathLength = strlen(path);
+   path[pathLength] = '/';
+   memcpy(path + pathLength + 1, fileName, length + 1);
+   return path;
+}
+
+int fuzzWriteFile (const char *path, const void *data, size_t size)
+{
+   FILE *file = fopen(path, "wb");
+   if (file == NULL)
+      return -1;
+   int result = (fwrite(data, sizeof(uint8_t), size, file) == size) - 1;
+   return (fclose(file) == 0 && result == 0) - 1;
+}
+
+uint8_t* fuzzReadFile (const char *path, size_t *size)
+{
+   FILE *file = fopen(path, "rb");
+   if (file == NULL)
+      return NULL;
+   fseek(file, 0, SEEK_END);
+   long fileSize = ftell(file);
+   fseek(file, 0, SEEK_SET);
+   uint8_t *data = (fileSize >= 0) ? malloc(fileSize + 1) : NULL; // +1 - empty files are valid inputs
+   if (data != NULL && fread(data, sizeof(uint8_t), fileSize, file) != (size_t) fileSize)
+   {
+      free(data);
+      data = NULL;
+   }
+   fclose(file);
+   *size = (size_t) fileSize;
+   return data;
+}
+
+int fuzzInitEngine (void)
+{
+   char *path = fuzzGetTemporaryPath("game.ini");
+   if (path == NULL || fuzzWriteFile(path, g_gameINI, sizeof(g_gameINI) - 1) != 0)
+   {
+      fputs("Game configuration can't be written\n", stderr);
+      free(path);
+      return -1;
+   }
+   cceSetBackend("null");
+   cceaLoadActionsPlugin();
+   cceLoadMap2Dplugin();
+   cceSetMap2Dchecksums(CCE_CCF_WRITE_CHECKSUMS); // Seeds are split by their checksummed header
+   int result = cceInit(path);
+   free(path);
+   if (result != 0)
+   {
+      fputs("Initialization failure\n", stderr);
+      return -1;
+   }
+   cceaRegisterAction(cceNameToUID("flip"),   emptyAction, NULL, sizeof(uint32_t));
+   cceaRegisterAction(cceNameToUID("altMap"), emptyAction, NULL, sizeof(struct alterMapSt));
+   cceaRegisterAction(cceNameToUID("rotate"), emptyAction, NULL, sizeof(uint32_t));
+   cceaRegisterAction(cceNameToUID("setbit"), emptyAction, NULL, sizeof(uint32_t));
+   return 0;
+}
+
+void fuzzTerminateEngine (void)
+{
+   cceTerminate();
+}
+
+struct cce_buffer* fuzzCreateSeedMap (void)
+{
+   struct cce_buffer *map = cceCreateMap2Ddynamic();
+   struct cce_elementposition positions[] =
+   {
+      {{0,  0}, 1, 0, 0},
+      {{0,  0}, 2, 0, 0},
+      {{0,  0}, 3, 0, 0},
+      {{5,  0}, 4, 0, 0},
+   };
+   struct cce_element elements[] =
+   {
+      {{-16, -16}, {.rgba = {255,   0,   0, 255}}, {11,  4}, 0, 0,   0},
+      {{-16,   0}, {.rgba = {  0, 255,   0, 255}}, { 5,  3}, 0, 0,   0},
+      {{-16,   8}, {.rgba = {  0,   0, 255, 255}}, { 8,  8}, 0, 0,   0},
+      {{  0, -16}, {.rgba = {255, 255, 255, 128}}, { 5, 13}, 0, 192, 0},
+   };
+   memcpy(cceGetElementsPosition(0, 0, 4, map), positions, 4 * sizeof(struct cce_elementposition));
+   memcpy(cceGetElements(0, 4, map),            elements,  4 * sizeof(struct cce_element));
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC1(action, struct cceaDelayActionsRepeated, ((struct cceaDelayActionsRepeated){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS_REPEATED], 0, 800, 9}),
+                                             uint32_t, cceNameToUID("flip"));
+      cceaRunAction((struct cceaAction*)action, 1, map);
+   }
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC1(action, struct cceaDelayActionsPeriodic, ((struct cceaDelayActionsPeriodic){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS_PERIODIC], 0, 330}),
+                                             struct alterMapSt, ((struct alterMapSt){cceNameToUID("altMap"), 0}));
+      cceaRunAction((struct cceaAction*)action, 1, map);
+   }
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC2(action, struct cceaDelayActions, ((struct cceaDelayActions){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS], 0, 6000}),
+                                             struct cceaInvokeEvent,  ((struct cceaInvokeEvent){cceaBasicActionUIDs[CCEA_INVOKE_EVENT], cceaBasicEventsUIDs[CCEA_EVENT_LOAD]}),
+                                             struct cceaTerminateEngine, ((struct cceaTerminateEngine){cceaBasicActionUIDs[CCEA_TERMINATE_ENGINE]}));
+      cceaRunAction((struct cceaAction*)action, 1, map);
+   }
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC1(action, struct cceaDelayActionsPeriodic, ((struct cceaDelayActionsPeriodic){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS_PERIODIC], 0, 3}),
+                                             uint32_t, cceNameToUID("rotate"));
+      cceaRunAction((struct cceaAction*)action, 1, map);
+   }
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC2(action, struct cceaAddActionsOnEvent, ((struct cceaAddActionsOnEvent){cceaBasicActionUIDs[CCEA_ADD_ACTIONS_ON_EVENT], 0,
+                                                                             cceaBasicEventsUIDs[CCEA_EVENT_LOAD], cceNameToUID("test2")}),
+                                             uint32_t, cceNameToUID("setbit"),
+                                             struct cceaRemoveActionOnEvent, ((struct cceaRemoveActionOnEvent){cceaBasicActionUIDs[CCEA_REMOVE_ACTIONS_ON_EVENT],
+                                             cceaBasicEventsUIDs[CCEA_EVENT_LOAD], cceNameToUID("test2")}));
+      cceaRunAction((struct cceaAction*)action, 1, map);
+   }
+   return map;
+}
+
+static uint32_t readUint32 (const uint8_t *data)
+{
+   return data[0] | (uint32_t) data[1] << 8 | (uint32_t) data[2] << 16 | (uint32_t) data[3] << 24;
+}
+
+static uint8_t* writeUint32 (uint8_t *output, uint32_t value)
+{
+   output[0] = (uint8_t) value;
+   output[1] = (uint8_t)(value >> 8);
+   output[2] = (uint8_t)(value >> 16);
+   output[3] = (uint8_t)(value >> 24);
+   return output + sizeof(uint32_t);
+}
+
+unsigned fuzzSplitCCF (const uint8_t *data, size_t size, struct fuzzsection *sections)
+{
+   if (size < 3u || data[0] != 0 || data[1] != CCF_VERSION)
+      return 0;
+   const unsigned quantity = data[2];
+   const uint8_t *header = data + 3, *payload = header + quantity * CCF_SECTION_HEADER_SIZE;
+   if ((size_t)(payload - data) > size)
+      return 0;
+   for (unsigned i = 0; i < quantity; ++i)
+   {
+      const uint32_t sectionSize = readUint32(header + (quantity + i) * sizeof(uint32_t));
+      const uint32_t storedSize  = readUint32(header + (2u * quantity + i) * sizeof(uint32_t));
+      const uint32_t rawSize     = readUint32(header + (3u * quantity + i) * sizeof(uint32_t));
+      if (header[5u * quantity * sizeof(uint32_t) + i] != CCF_CODEC_NONE || storedSize != rawSize || sectionSize > UINT16_MAX ||
+          storedSize > size - (size_t)(payload - data))
+         return 0;
+      sections[i].uid = readUint32(header + i * sizeof(uint32_t));
+      sections[i].sectionSize = (uint16_t) sectionSize;
+      sections[i].size = storedSize;
+      sections[i].data = payload;
+      payload += storedSize;
+   }
+   return quantity;
+}
+
+size_t fuzzJoinCCF (const struct fuzzsection *sections, unsigned sectionsQuantity, uint8_t *output)
+{
+   size_t size = 3u + sectionsQuantity * CCF_SECTION_HEADER_SIZE;
+   for (unsigned i = 0; i < sectionsQuantity; ++i)
+      size += sections[i].size;
+   if (output == NULL)
+      return size;
+   *output++ = 0;
+   *output++ = CCF_VERSION;
+   *output++ = (uint8_t) sectionsQuantity;
+   for (unsigned i = 0; i < sectionsQuantity; ++i)
+      output = writeUint32(output, sections[i].uid);
+   for (unsigned i = 0; i < sectionsQuantity; ++i)
+      output = writeUint32(output, sections[i].sectionSize);
+   for (unsigned i = 0; i < sectionsQuantity; ++i)
+      output = writeUint32(output, sections[i].size);
+   for (unsigned i = 0; i < sectionsQuantity; ++i)
+      output = writeUint32(output, sections[i].size);
+   for (unsigned i = 0; i < sectionsQuantity; ++i)
+      output = writeUint32(output, cceCRC32C(0, sections[i].data, sections[i].size));
+   memset(output, CCF_CODEC_NONE, sectionsQuantity);
+   output += sectionsQuantity;
+   for (unsigned i = 0; i < sectionsQuantity; ++i)
+   {
+      memcpy(output, sections[i].data, sections[i].size);
+      output += sections[i].size;
+   }
+   return size;
+}
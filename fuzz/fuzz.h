@@ -0,0 +1,55 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#ifndef CCE_FUZZ_H
+#define CCE_FUZZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cce/engine_common.h>
+
+#define FUZZ_TARGET_CCF       0
+#define FUZZ_TARGET_RESOURCES 1
+#define FUZZ_TARGET_RENDERING 2
+#define FUZZ_TARGET_ACTIONS   3
+#define FUZZ_TARGET_INI       4
+#define FUZZ_TARGETS_QUANTITY 5
+
+// Section inputs begin with the value passed to the loader as sectionSize (uint16_t, little-endian), section bytes follow
+#define FUZZ_SECTION_INPUT_HEADER_SIZE 2u
+
+struct fuzzsection
+{
+   const uint8_t *data;
+   uint32_t uid;
+   uint32_t size;
+   uint16_t sectionSize;
+};
+
+extern const char *const fuzzTargetNames[FUZZ_TARGETS_QUANTITY];
+extern const char *const fuzzSectionNames[FUZZ_TARGETS_QUANTITY];
+
+// Headless engine with map2D (software renderer) and actions plugins, actions used by test2 map are registered
+int      fuzzInitEngine (void);
+void     fuzzTerminateEngine (void);
+char*    fuzzGetTemporaryPath (const char *fileName);
+int      fuzzWriteFile (const char *path, const void *data, size_t size);
+uint8_t* fuzzReadFile (const char *path, size_t *size);
+// Same map as test2 creates, but without textures: the corpus shouldn't depend on where engine resources are
+struct cce_buffer* fuzzCreateSeedMap (void);
+// Only uncompressed files with checksummed header are split, returns sections quantity or 0
+unsigned fuzzSplitCCF (const uint8_t *data, size_t size, struct fuzzsection *sections);
+// Writes checksummed header and sections into output (may be NULL), returns file size
+size_t   fuzzJoinCCF (const struct fuzzsection *sections, unsigned sectionsQuantity, uint8_t *output);
+
+#endif // CCE_FUZZ_H
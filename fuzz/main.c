@@ -0,0 +1,344 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cce/engine_common.h>
+#include <cce/os_interaction.h>
+#include <cce/utils.h>
+#include <cce/plugins/actions.h>
+#include <cce/plugins/map2D/map2D.h>
+
+#include "fuzz.h"
+
+/* One executable per target (CCE_FUZZ_TARGET is one of FUZZ_TARGET_* values):
+ * ccf - whole file, loaded as static (memory mapped) and as dynamic (stream) map
+ * m2dres, m2drend, actions - one section, the rest of the file is taken from the seed map and header is generated, so checksums don't stop mutations
+ * ini - game.ini given to cceInit with headless backend, map2D and actions plugins
+ * With CCE_FUZZ_LIBFUZZER libFuzzer provides main, otherwise inputs are files (AFL's @@) or directories and throughput is reported */
+
+#ifndef CCE_FUZZ_TARGET
+#error "CCE_FUZZ_TARGET has to be defined as one of FUZZ_TARGET_* values"
+#endif // CCE_FUZZ_TARGET
+
+#define FUZZ_SECTION_TARGET (CCE_FUZZ_TARGET != FUZZ_TARGET_CCF && CCE_FUZZ_TARGET != FUZZ_TARGET_INI)
+
+static char *g_mapPath = NULL;
+static char *g_workingDirectory = NULL;
+static uint8_t *g_seedFile = NULL;
+static uint8_t *g_fileBuffer = NULL;
+static size_t g_fileBufferSize = 0;
+
+#if FUZZ_SECTION_TARGET
+
+static struct fuzzsection g_seedSections[255];
+static unsigned g_seedSectionsQuantity = 0;
+static unsigned g_targetSection = 0;
+
+static int loadSeedMap (void)
+{
+   struct cce_buffer *map = fuzzCreateSeedMap();
+   size_t size;
+   int result = cceWriteMap2Ddynamic(map, g_mapPath);
+   cceFreeMap2Ddynamic(map);
+   if (result != 0 || (g_seedFile = fuzzReadFile(g_mapPath, &size)) == NULL || (g_seedSectionsQuantity = fuzzSplitCCF(g_seedFile, size, g_seedSections)) == 0)
+   {
+      fputs("Seed map can't be written or parsed\n", stderr);
+      return -1;
+   }
+   const uint32_t uid = cceNameToUID(fuzzSectionNames[CCE_FUZZ_TARGET]);
+   for (g_targetSection = 0; g_targetSection < g_seedSectionsQuantity && g_seedSections[g_targetSection].uid != uid; ++g_targetSection);
+   if (g_targetSection == g_seedSectionsQuantity)
+   {
+      fprintf(stderr, "Seed map has no %s section\n", fuzzSectionNames[CCE_FUZZ_TARGET]);
+      return -1;
+   }
+   return 0;
+}
+
+#endif // FUZZ_SECTION_TARGET
+
+static int fuzzInit (void)
+{
+#if CCE_FUZZ_TARGET == FUZZ_TARGET_INI
+   g_workingDirectory = cceGetCurrentPath(0);
+   return (g_workingDirectory != NULL) - 1;
+#else
+   if (fuzzInitEngine() != 0 || (g_mapPath = fuzzGetTemporaryPath("fuzz.c2m")) == NULL)
+      return -1;
+#if FUZZ_SECTION_TARGET
+   return loadSeedMap();
+#else
+   return 0;
+#endif // FUZZ_SECTION_TARGET
+#endif // CCE_FUZZ_TARGET == FUZZ_TARGET_INI
+}
+
+static void fuzzTerminate (void)
+{
+#if CCE_FUZZ_TARGET != FUZZ_TARGET_INI
+   fuzzTerminateEngine();
+#endif // CCE_FUZZ_TARGET != FUZZ_TARGET_INI
+   free(g_mapPath);
+   free(g_workingDirectory);
+   free(g_seedFile);
+   free(g_fileBuffer);
+}
+
+#if CCE_FUZZ_TARGET != FUZZ_TARGET_INI
+
+// Returns 1 if input is accepted by both loaders
+static int loadMap (const uint8_t *data, size_t size)
+{
+   if (fuzzWriteFile(g_mapPath, data, size) != 0)
+   {
+      fprintf(stderr, "%s can't be written\n", g_mapPath);
+      abort();
+   }
+   struct cce_buffer *map = cceLoadMap2D(g_mapPath);
+   int loaded = (map != NULL);
+   cceFreeMap2D(map);
+   map = cceLoadMap2Ddynamic(g_mapPath);
+   loaded &= (map != NULL);
+   cceFreeMap2Ddynamic(map);
+   return loaded;
+}
+
+#endif // CCE_FUZZ_TARGET != FUZZ_TARGET_INI
+
+#if FUZZ_SECTION_TARGET
+
+static int loadSection (const uint8_t *data, size_t size)
+{
+   if (size < FUZZ_SECTION_INPUT_HEADER_SIZE || size - FUZZ_SECTION_INPUT_HEADER_SIZE > UINT32_MAX)
+      return 0;
+   struct fuzzsection sections[255];
+   memcpy(sections, g_seedSections, g_seedSectionsQuantity * sizeof(struct fuzzsection));
+   sections[g_targetSection].sectionSize = data[0] | (uint16_t)(data[1] << 8);
+   sections[g_targetSection].data = data + FUZZ_SECTION_INPUT_HEADER_SIZE;
+   sections[g_targetSection].size = (uint32_t)(size - FUZZ_SECTION_INPUT_HEADER_SIZE);
+   size_t fileSize = fuzzJoinCCF(sections, g_seedSectionsQuantity, NULL);
+   if (fileSize > g_fileBufferSize)
+      g_fileBuffer = realloc(g_fileBuffer, g_fileBufferSize = fileSize);
+   fuzzJoinCCF(sections, g_seedSectionsQuantity, g_fileBuffer);
+   return loadMap(g_fileBuffer, fileSize);
+}
+
+#endif // FUZZ_SECTION_TARGET
+
+#if CCE_FUZZ_TARGET == FUZZ_TARGET_INI
+
+// Null backend has no OpenGL context, so the renderer requested by input is overridden
+static const char g_iniOverride[] = "\n[Map2D]\nrenderer = software\n";
+
+static int loadINI (const uint8_t *data, size_t size)
+{
+   char *path = fuzzGetTemporaryPath("game.ini");
+   if (path == NULL)
+      abort();
+   if (size + sizeof(g_iniOverride) > g_fileBufferSize)
+      g_fileBuffer = realloc(g_fileBuffer, g_fileBufferSize = size + sizeof(g_iniOverride));
+   memcpy(g_fileBuffer, data, size);
+   memcpy(g_fileBuffer + size, g_iniOverride, sizeof(g_iniOverride) - 1);
+   if (fuzzWriteFile(path, g_fileBuffer, size + sizeof(g_iniOverride) - 1) != 0)
+   {
+      fprintf(stderr, "%s can't be written\n", path);
+      abort();
+   }
+   cceSetBackend("null");
+   cceaLoadActionsPlugin();
+   cceLoadMap2Dplugin();
+   // On failure cceInit terminates whatever it has initialized
+   int loaded = (cceInit(path) == 0);
+   if (loaded)
+      cceTerminate();
+   cceTerminateTemporaryDirectory();
+   cceSetCurrentPath(g_workingDirectory); // Input may change it
+   free(path);
+   return loaded;
+}
+
+#endif // CCE_FUZZ_TARGET == FUZZ_TARGET_INI
+
+static int fuzzOne (const uint8_t *data, size_t size)
+{
+#if CCE_FUZZ_TARGET == FUZZ_TARGET_CCF
+   return loadMap(data, size);
+#elif CCE_FUZZ_TARGET == FUZZ_TARGET_INI
+   return loadINI(data, size);
+#else
+   return loadSection(data, size);
+#endif // CCE_FUZZ_TARGET
+}
+
+#ifdef CCE_FUZZ_LIBFUZZER
+
+int LLVMFuzzerInitialize (int *argc, char ***argv)
+{
+   CCE_UNUSED(argc);
+   CCE_UNUSED(argv);
+   if (fuzzInit() != 0)
+      abort();
+   atexit(fuzzTerminate);
+   return 0;
+}
+
+int LLVMFuzzerTestOneInput (const uint8_t *data, size_t size)
+{
+   fuzzOne(data, size);
+   return 0;
+}
+
+#else
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif // defined(_WIN32)
+
+struct fuzzinput
+{
+   uint8_t *data;
+   size_t size;
+};
+
+CCE_ARRAY(g_inputs, static struct fuzzinput, static size_t);
+
+static void addInput (const char *path)
+{
+   struct fuzzinput input;
+   if ((input.data = fuzzReadFile(path, &input.size)) == NULL)
+   {
+      fprintf(stderr, "%s can't be read\n", path);
+      return;
+   }
+   if (g_inputsQuantity >= g_inputsAllocated)
+   {
+      g_inputsAllocated = g_inputsAllocated * 2u + 16u;
+      g_inputs = realloc(g_inputs, g_inputsAllocated * sizeof(struct fuzzinput));
+   }
+   g_inputs[g_inputsQuantity++] = input;
+}
+
+// Corpus directories are flat, subdirectories are not visited
+static void addInputs (char *path)
+{
+   if (!cceIsDirectory(path))
+   {
+      addInput(path);
+      return;
+   }
+   size_t pathLength = strlen(path);
+#if defined(_WIN32)
+   char *pattern = malloc(pathLength + 3u);
+   memcpy(pattern, path, pathLength);
+   memcpy(pattern + pathLength, "\\*", 3u);
+   WIN32_FIND_DATAA entry;
+   HANDLE directory = FindFirstFileA(pattern, &entry);
+   free(pattern);
+   if (directory == INVALID_HANDLE_VALUE)
+      return;
+   do
+   {
+      if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+         continue;
+      const char *name = entry.cFileName;
+#else
+   DIR *directory = opendir(path);
+   if (directory == NULL)
+      return;
+   for (struct dirent *entry; (entry = readdir(directory)) != NULL;)
+   {
+      const char *name = entry->d_name;
+      if (name[0] == '.')
+         continue;
+#endif // defined(_WIN32)
+      size_t nameLength = strlen(name);
+      char *filePath = malloc(pathLength + nameLength + 2u);
+      memcpy(filePath, path, pathLength);
+      filePath[pathLength] = cceNativePathDelimiter;
+      memcpy(filePath + pathLength + 1, name, nameLength + 1);
+      if (!cceIsDirectory(filePath))
+         addInput(filePath);
+      free(filePath);
+#if defined(_WIN32)
+   }
+   while (FindNextFileA(directory, &entry));
+   FindClose(directory);
+#else
+   }
+   closedir(directory);
+#endif // defined(_WIN32)
+}
+
+int main (int argc, char **argv)
+{
+   unsigned long rounds = 1;
+   double minimalRate = 0.0;
+   int i = 1;
+   for (; i < argc && argv[i][0] == '-'; i += 2)
+   {
+      if (i + 1 < argc && strcmp(argv[i], "-runs") == 0)
+         rounds = strtoul(argv[i + 1], NULL, 10);
+      else if (i + 1 < argc && strcmp(argv[i], "-min-rate") == 0)
+         minimalRate = strtod(argv[i + 1], NULL);
+      else
+         break;
+   }
+   if (i >= argc || rounds == 0)
+   {
+      printf("Usage: %s [-runs ROUNDS] [-min-rate FILES_PER_SECOND] FILE_OR_DIRECTORY...\n"
+             "Every input is loaded ROUNDS times (1 by default), throughput is reported. Exits with 1 if it's below FILES_PER_SECOND.\n", argv[0]);
+      return 2;
+   }
+   for (; i < argc; ++i)
+      addInputs(argv[i]);
+   if (g_inputsQuantity == 0)
+   {
+      fputs("No inputs\n", stderr);
+      return 2;
+   }
+   if (fuzzInit() != 0)
+      return 2;
+
+   size_t loaded = 0, bytes = 0;
+   uint64_t start = cceGetMonotonicTimeNs();
+   for (unsigned long round = 0; round < rounds; ++round)
+   {
+      for (struct fuzzinput *iterator = g_inputs, *end = g_inputs + g_inputsQuantity; iterator < end; ++iterator)
+      {
+         loaded += (size_t) fuzzOne(iterator->data, iterator->size);
+         bytes += iterator->size;
+      }
+   }
+   double seconds = (double)(cceGetMonotonicTimeNs() - start) * 1e-9;
+   double files = (double) g_inputsQuantity * (double) rounds;
+   double rate = (seconds > 0.0) ? files / seconds : 0.0;
+   printf("%s: %zu inputs, %zu of %.0f loads accepted, %.1f files/sec, %.2f MiB/sec\n", fuzzTargetNames[CCE_FUZZ_TARGET], (size_t) g_inputsQuantity, loaded, files,
+          rate, (seconds > 0.0) ? (double) bytes / seconds / (1024.0 * 1024.0) : 0.0);
+
+   fuzzTerminate();
+   for (struct fuzzinput *iterator = g_inputs, *end = g_inputs + g_inputsQuantity; iterator < end; ++iterator)
+      free(iterator->data);
+   free(g_inputs);
+   if (rate < minimalRate)
+   {
+      fprintf(stderr, "%s: throughput is below %.1f files/sec\n", fuzzTargetNames[CCE_FUZZ_TARGET], minimalRate);
+      return 1;
+   }
+   return 0;
+}
+
+#endif // CCE_FUZZ_LIBFUZZER
@@ -0,0 +1,100 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cce/engine_common.h>
+#include <cce/os_interaction.h>
+#include <cce/plugins/map2D/map2D.h>
+
+#include "fuzz.h"
+
+/* Writes seed corpus of map targets into CORPUS_DIRECTORY/<target>/ (directories have to exist):
+ * the map test2 creates stored with and without compression, and its sections in the format section targets expect */
+
+static int writeSeed (const char *directory, const char *target, const char *name, const void *prefix, size_t prefixSize, const void *data, size_t size)
+{
+   size_t directoryLength = strlen(directory), targetLength = strlen(target), nameLength = strlen(name);
+   char *path = malloc(directoryLength + targetLength + nameLength + 3u);
+   memcpy(path, directory, directoryLength);
+   path[directoryLength] = '/';
+   memcpy(path + directoryLength + 1, target, targetLength);
+   path[directoryLength + 1 + targetLength] = '/';
+   memcpy(path + directoryLength + targetLength + 2, name, nameLength + 1);
+   uint8_t *seed = malloc(prefixSize + size + 1);
+   if (prefixSize > 0)
+      memcpy(seed, prefix, prefixSize);
+   memcpy(seed + prefixSize, data, size);
+   int result = fuzzWriteFile(path, seed, prefixSize + size);
+   if (result != 0)
+      fprintf(stderr, "%s can't be written\n", path);
+   free(seed);
+   free(path);
+   return result;
+}
+
+// Map is written by the engine, so the corpus follows the current file format
+static uint8_t* storeMap (struct cce_buffer *map, uint8_t codec, size_t *size)
+{
+   char *path = fuzzGetTemporaryPath("seed.c2m");
+   cceSetMap2Dcompression(codec);
+   uint8_t *data = (cceWriteMap2Ddynamic(map, path) == 0) ? fuzzReadFile(path, size) : NULL;
+   cceSetMap2Dcompression(CCE_CCF_CODEC_NONE);
+   remove(path);
+   free(path);
+   return data;
+}
+
+int main (int argc, char **argv)
+{
+   if (argc != 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))
+   {
+      printf("Usage: %s CORPUS_DIRECTORY\nSeeds are written into ccf, m2dres, m2drend and actions subdirectories.\n", argv[0]);
+      return 2 * (argc != 2);
+   }
+   if (fuzzInitEngine() != 0)
+      return 2;
+   struct cce_buffer *map = fuzzCreateSeedMap();
+   size_t size, compressedSize;
+   uint8_t *data = storeMap(map, CCE_CCF_CODEC_NONE, &size);
+   uint8_t *compressed = storeMap(map, CCE_CCF_CODEC_LZ, &compressedSize);
+   cceFreeMap2Ddynamic(map);
+   struct fuzzsection sections[255];
+   unsigned sectionsQuantity = (data != NULL) ? fuzzSplitCCF(data, size, sections) : 0;
+   int result = -(sectionsQuantity == 0 || compressed == NULL);
+   if (result != 0)
+   {
+      fputs("Seed map can't be written or parsed\n", stderr);
+      goto END;
+   }
+   result |= writeSeed(argv[1], fuzzTargetNames[FUZZ_TARGET_CCF], "test2.c2m", NULL, 0, data, size);
+   result |= writeSeed(argv[1], fuzzTargetNames[FUZZ_TARGET_CCF], "test2-lz.c2m", NULL, 0, compressed, compressedSize);
+   for (unsigned target = FUZZ_TARGET_RESOURCES; target <= FUZZ_TARGET_ACTIONS; ++target)
+   {
+      const uint32_t uid = cceNameToUID(fuzzSectionNames[target]);
+      for (const struct fuzzsection *iterator = sections, *end = sections + sectionsQuantity; iterator < end; ++iterator)
+      {
+         if (iterator->uid != uid)
+            continue;
+         const uint8_t sectionSize[FUZZ_SECTION_INPUT_HEADER_SIZE] = {(uint8_t) iterator->sectionSize, (uint8_t)(iterator->sectionSize >> 8)};
+         result |= writeSeed(argv[1], fuzzTargetNames[target], "test2", sectionSize, sizeof(sectionSize), iterator->data, iterator->size);
+      }
+   }
+
+END:
+   free(data);
+   free(compressed);
+   fuzzTerminateEngine();
+   return -result;
+}
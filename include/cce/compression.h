@@ -0,0 +1,47 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cce_exports.h"
+
+/* LZ4-compatible block format: sequences of literals followed by back references (up to 64 KiB back).
+ * Made for engine's files, favours decompression speed over ratio */
+
+#define cceGetCompressLZbound(size) ((size) + (size) / 255u + 16u)
+// Largest size block of given compressed size can unpack to (every extra length byte adds at most 255 bytes of output)
+#define cceGetDecompressLZbound(size) ((uint64_t)(size) * 255u)
+
+/* Returns compressed size or 0 if result doesn't fit into dstCapacity */
+CCE_API size_t cceCompressLZ (const void *src, size_t srcSize, void *dst, size_t dstCapacity);
+/* dstSize has to be exact decompressed size, returns -1 on corrupted data */
+CCE_API int    cceDecompressLZ (const void *src, size_t srcSize, void *dst, size_t dstSize);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // COMPRESSION_H
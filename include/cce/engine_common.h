@@ -151,15 +151,58 @@ struct cce_collider_cirND_X_Y
 
 CCE_API uint32_t cceGetFrameDeltaTime    (void);
 CCE_API uint32_t cceGetFrameCurrentTime  (void);
+/* Nanosecond variants, read from the same clock sample as the ones above. Do not quantize at high refresh rates */
+CCE_API uint64_t cceGetFrameDeltaTimeNs   (void);
+CCE_API uint64_t cceGetFrameCurrentTimeNs (void);
+/* Fixed timestep: tickRate (ticks per second, 0 - off) in game.ini or cceSetTickRate. cceUpdate runs update callbacks once per
+ * tick of elapsed time, at most maxTicksPerUpdate (5 by default) times - the rest is dropped. Frame time above advances by one tick
+ * during each of them and by all ticks of the frame after cceUpdate. Interpolation is the part of the next tick already elapsed:
+ * state to draw is previous + (current - previous) * interpolation. It is 1 without fixed timestep */
+CCE_API void     cceSetTickRate (uint16_t ticksPerSecond);
+CCE_API uint16_t cceGetTickRate (void);
+// Ticks since cceInit, increased before update callbacks of the tick run
+CCE_API uint64_t cceGetTicksQuantity (void);
+CCE_API float    cceGetTickInterpolation (void);
 
 #define CCE_INI_CALLBACK_FREE_DATA 0x1
 #define CCE_INI_CALLBACK_DO_NOT_INIT 0x2
+// Init doesn't need the main thread (no graphics context or window), it may run on a worker thread alongside init of other plugins
+#define CCE_INI_CALLBACK_THREAD_SAFE_INIT 0x10
+
+#define CCE_PLUGIN_STAGE_INI_CALLBACK 0
+#define CCE_PLUGIN_STAGE_INIT         1
+#define CCE_PLUGIN_STAGE_POSTINIT     2
+#define CCE_PLUGIN_STAGE_TERMINATE    3
+#define CCE_PLUGIN_STAGES_QUANTITY    4
+#define CCE_PLUGIN_STAGE_NOT_RUN      UINT16_MAX
+
+/* Measured by cceInit and cceTerminate for every registered plugin, backend is the first one. Stage of ini callback covers all its calls.
+ * Heap is the net change of heap memory in use (allocated minus freed) by the whole process during the stage, so allocations of other threads
+ * are counted too. It is 0 where the platform doesn't report it (glibc and macOS do) or malloc is replaced (e.g. by sanitizers) */
+struct cce_pluginstats
+{
+   uint64_t timeNs[CCE_PLUGIN_STAGES_QUANTITY];
+   int64_t  heapBytes[CCE_PLUGIN_STAGES_QUANTITY];
+   uint32_t uid;
+   uint32_t iniKeys;
+   uint16_t order[CCE_PLUGIN_STAGES_QUANTITY]; // Position among plugins which ran the stage, CCE_PLUGIN_STAGE_NOT_RUN if it wasn't run
+};
 
 /* Handles overflow of cceGetMonotonicTime. Maximum delay is 24.8 days */
 #define cceIsTimeout(time, timeout) ((sizeof(time) == 4) ? (timeout) - (time) - 1 >= 0x7FFFFFFF : timeout <= time)
 
 CCE_API int cceRegisterPlugin (uint32_t uid, void *data, int (*iniCallback)(void*, const char*, const char*), int (*init)(void*), int (*postinit)(void), void (*term)(void), uint8_t flags);
+/* Plugin is initialized (init and postinit) after the backend and the plugins it depends on, and terminated before them. Has to be called
+ * after registration of the plugin and before cceInit. Plugins which declare nothing are initialized in registration order: they also wait
+ * for every CCE_INI_CALLBACK_THREAD_SAFE_INIT plugin registered before them. Declaring dependencies (even none) lifts that, so thread-safe
+ * plugins only run in parallel with ones which declared dependencies or were registered before them.
+ * cceInit fails if dependency isn't registered or initialized, or dependencies form a cycle */
+CCE_API int cceSetPluginDependencies (uint32_t uid, const uint32_t *dependencies, uint16_t dependenciesQuantity);
 CCE_API uint16_t            cceRegisterUpdateCallback (void (*callback)(void));
+/* Callback is run by the job system (see jobs.h) together with parallel callbacks registered next to it, unless one writes
+ * what another reads or writes. Sets are bit masks of game-defined data, ordinary callbacks are treated as accessing all of it.
+ * Parallel callback must not register callbacks or call engine functions which aren't thread-safe */
+CCE_API uint16_t            cceRegisterParallelUpdateCallback (void (*callback)(void), uint64_t readSet, uint64_t writeSet);
 CCE_API void                cceEnableUpdateCallback (uint16_t callbackID);
 CCE_API void                cceDisableUpdateCallback (uint16_t callbackID);
 CCE_API CCE_PURE_FN uint8_t cceCheckPlugin (uint32_t uid);
@@ -167,9 +210,15 @@ CCE_API CCE_PURE_FN uint8_t cceIsPluginLoading (uint32_t uid);
 CCE_API void                cceSetAxisChangeCallback (void (*callback)(int8_t, int8_t), cce_enum axePair);
 CCE_API void                cceSetButtonCallback (void (*callback)(uint16_t buttonState, uint16_t diff));
 CCE_API void                cceSetKeyCallback (void (*callback)(cce_enum key, cce_enum state));
+// "glfw" (default) or "null" (headless). Must be called before cceInit, CCE_BACKEND environment variable takes precedence
+CCE_API int                 cceSetBackend (const char *lowercasename);
 CCE_API int                 cceInit (const char *path);
 CCE_API void                cceUpdate (void);
 CCE_API void                cceTerminate (void);
+/* Stats of the last cceInit, terminate stage is filled by cceTerminate. Valid until the next cceInit, NULL before the first one.
+ * cceTerminate logs them to stdout if game.ini has logPluginStats = true (in the section-less part) */
+CCE_API const struct cce_pluginstats* cceGetPluginStats (uint16_t *quantity);
+CCE_API void                cceLogPluginStats (void);
 
 CCE_API CCE_CONST_FN union cce_color cceHSVtoRGB (union cce_color color);
 CCE_API CCE_CONST_FN union cce_color cceHSLtoRGB (union cce_color color);
@@ -200,9 +249,9 @@ CCE_API CCE_CONST_FN union cce_color cceRGBtoHCL (union cce_color color);
    (cce__checkCollisionRect(element1, element2, x) && cce__checkCollisionRect(element1, element2, y) && cce__checkCollisionRect(element1, element2, z) && cce__checkCollisionRect(element1, element2, w))
    
 #define cce__getCirPosDiff(element1, element2, comp) (element1.position.comp - element2.position.comp)
-#define cce__getCirPosDiffSqC2(element1, element2) CCE_POW2(cce__getCirPosDiff(element1, element2, x)) + CCE_POW2(cce__getCirPosDiff(element1, element2, y))
-#define cce__getCirPosDiffSqC3(element1, element2) cce__getCirPosDiffSqC2(element1, element2) + CCE_POW2(cce__getCirPosDiff(element1, element2, z))
-#define cce__getCirPosDiffSqC4(element1, element2) cce__getCirPosDiffSqC3(element1, element2) + CCE_POW2(cce__getCirPosDiff(element1, element2, w))
+#define cce__getCirPosDiffSqC2(element1, element2) (CCE_POW2(cce__getCirPosDiff(element1, element2, x)) + CCE_POW2(cce__getCirPosDiff(element1, element2, y)))
+#define cce__getCirPosDiffSqC3(element1, element2) (cce__getCirPosDiffSqC2(element1, element2) + CCE_POW2(cce__getCirPosDiff(element1, element2, z)))
+#define cce__getCirPosDiffSqC4(element1, element2) (cce__getCirPosDiffSqC3(element1, element2) + CCE_POW2(cce__getCirPosDiff(element1, element2, w)))
 
 #define cceCheckCollisionCir1D(element1, element2) (cce__getCirPosDiff(element1, element2, x) *2 < element1.diameter + element2.diameter)
 #define cceCheckCollisionCir2D(element1, element2) (cce__getCirPosDiffSqC2(element1, element2)*4 < CCE_POW2(element1.diameter + element2.diameter))
@@ -218,6 +267,42 @@ CCE_API CCE_CONST_FN union cce_color cceRGBtoHCL (union cce_color color);
 #define cceCheckCollisionCirRect4D(circle, rect) (cce__getCircleSquareDistanceSq(circle, rect, x) + cce__getCircleSquareDistanceSq(circle, rect, y) + \
                                                   cce__getCircleSquareDistanceSq(circle, rect, z) + cce__getCircleSquareDistanceSq(circle, rect, w) < CCE_POW2(circle.diameter))
 
+/* Batched collision checks: one collider against structure-of-arrays batch of quantity colliders. Result is bitmask (bit i of mask[i / 32]
+ * is set if batch element i collides), mask must have (quantity + 31) / 32 elements. Results are the same as of the macros above
+ * (circle checks are computed without overflow, so large coordinates are also handled) on every implementation */
+struct cce_rect2Dbatch_16_16
+{
+   const int16_t  *positionX;
+   const int16_t  *positionY;
+   const uint16_t *sizeX;
+   const uint16_t *sizeY;
+};
+
+struct cce_cir2Dbatch_16_16
+{
+   const int16_t  *positionX;
+   const int16_t  *positionY;
+   const uint16_t *diameter;
+};
+
+#define CCE_COLLISION_BATCH_AUTO   0x0 // Best implementation supported by CPU, chosen per kernel
+#define CCE_COLLISION_BATCH_SCALAR 0x1 // Reference implementation
+#define CCE_COLLISION_BATCH_SSE2   0x2
+#define CCE_COLLISION_BATCH_AVX2   0x3
+#define CCE_COLLISION_BATCH_NEON   0x4
+
+/* Returns selected implementation, CCE_COLLISION_BATCH_SCALAR if requested one is not supported by CPU or build.
+ * cceInit selects CCE_COLLISION_BATCH_AUTO, scalar one is used before that. Mustn't be called while batches are checked on other threads */
+CCE_API uint8_t  cceSetCollisionBatchImplementation (uint8_t implementation);
+CCE_API void     cceCheckCollisionRect2DBatch (struct cce_collider_rect2D_16_16 rect, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask);
+CCE_API void     cceCheckCollisionCir2DBatch (struct cce_collider_cir2D_16_16 circle, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask);
+// Circle against batch of rectangles
+CCE_API void     cceCheckCollisionCirRect2DBatch (struct cce_collider_cir2D_16_16 circle, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask);
+// Rectangle against batch of circles
+CCE_API void     cceCheckCollisionRectCir2DBatch (struct cce_collider_rect2D_16_16 rect, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask);
+// Writes indices of set bits of mask in ascending order, returns their quantity. indices must fit quantity elements
+CCE_API uint32_t cceCollisionMaskToIndices (const uint32_t *mask, uint32_t quantity, uint32_t *indices);
+
 #define cceColorToRGB(color) \
 (((color.rgb.type & 0xE0) == CCE_COLOR_RGB) ? color              : ((color.rgb.type & 0xE0) == CCE_COLOR_HSV) ? cceHSVtoRGB(color) : \
  ((color.rgb.type & 0xE0) == CCE_COLOR_HSL) ? cceHSLtoRGB(color) : cceHCLtoRGB(color))
@@ -267,6 +352,45 @@ CCE_API extern const char *cceBackend;
 #define CCE_AXISPAIR_RSTICK 2
 #define CCE_AXISPAIR_TRIGGERS 3
 
+// code - key (CCE_KEY_*), value - 1 if pressed, 0 if released
+#define CCE_INPUT_EVENT_KEY    0x0
+// code - bit of the button (CCE_BUTTON_* is 1 << code), value - 1 if pressed, 0 if released
+#define CCE_INPUT_EVENT_BUTTON 0x1
+// code - axis (CCE_AXISPAIR_* * 2 + 0 for horizontal or 1 for vertical), value - new axis value
+#define CCE_INPUT_EVENT_AXIS   0x2
+// code is 0, value - 1 if gamepad is connected, 0 if disconnected
+#define CCE_INPUT_EVENT_CONNECTION 0x3
+
+// Key events. Gamepads are numbered from 1, keys bound to buttons and axes change the gamepad they are bound to
+#define CCE_INPUT_KEYBOARD 0
+
+struct cce_inputevent
+{
+   uint64_t timeNs; // Clock of cceGetFrameCurrentTimeNs, when the backend received the event
+   int16_t  value;
+   uint8_t  code;
+   uint8_t  type;
+   uint8_t  gamepad;
+};
+
+/* Every input change is queued in order, unlike bitfields and callbacks which only see the state at cceUpdate. The queue keeps
+ * the newest CCE_INPUT_EVENTS_CAPACITY events, events are removed by reading. Returns quantity of events written */
+#define CCE_INPUT_EVENTS_CAPACITY 256u
+CCE_API uint32_t cceReadInputEvents (struct cce_inputevent *events, uint32_t eventsMax);
+
+/* Gamepad N gets physical gamepads in order of connection (one per number) and keys bound in [Controls] (gamepad 1) or [PlayerN]
+ * section, which also sets deadzone of the gamepad. Callbacks set by cceSetButtonCallback and cceSetAxisChangeCallback see
+ * gamepads merged: buttons pressed on any of them and the strongest value of every axis. State is updated by cceUpdate */
+#define CCE_GAMEPADS_MAX 4u
+CCE_API CCE_PURE_FN uint16_t cceGetGamepadButtons (uint8_t gamepad);
+CCE_API CCE_PURE_FN int8_t   cceGetGamepadAxis (uint8_t gamepad, uint8_t axis);
+// Physical gamepad only, keys bound to the gamepad work regardless
+CCE_API CCE_PURE_FN uint8_t  cceIsGamepadConnected (uint8_t gamepad);
+CCE_API void                 cceSetGamepadButtonCallback (void (*callback)(uint8_t gamepad, uint16_t buttonState, uint16_t diff));
+CCE_API void                 cceSetGamepadAxisChangeCallback (void (*callback)(uint8_t gamepad, int8_t x, int8_t y), cce_enum axisPair);
+// Gamepads connected by cceInit are reported by the first cceUpdate
+CCE_API void                 cceSetGamepadConnectionCallback (void (*callback)(uint8_t gamepad, uint8_t connected));
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
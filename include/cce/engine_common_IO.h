@@ -39,18 +39,51 @@ struct cce_buffer
    uint32_t __pad; // Pad to uint64_t (to avoid misaligned reads down the line)
 };
 
+// Set in cce_buffer.flags when section data may point into memory mapped file (see cceLoadBinaryCCFmapped)
+#define CCE_BUFFER_MAPPED 0x1
+
+// Per-section codecs of CCF files
+#define CCE_CCF_CODEC_NONE 0
+#define CCE_CCF_CODEC_LZ   1
+
+// Function set flags of cceSetFileIOchecksums
+#define CCE_CCF_WRITE_CHECKSUMS  0x1
+#define CCE_CCF_VERIFY_CHECKSUMS 0x2
+
+// Read position inside memory mapped file. Mapping is private (copy-on-write), so loaders may patch data in place
+struct cce_mappedcursor
+{
+   uint8_t *position;
+   uint8_t *end;
+};
+
 typedef int     (*cce_freadfun)(void *buffer, uint16_t sectionSize, struct cce_buffer *info, FILE *file);
 typedef uint16_t (*cce_fwritefun)(void *buffer, struct cce_buffer *info, FILE *file);
 typedef void    (*cce_dataparsefun)(void *buffer, struct cce_buffer *info);
+typedef int     (*cce_mreadfun)(void *buffer, uint16_t sectionSize, struct cce_buffer *info, struct cce_mappedcursor *cursor);
 
 CCE_API FILE*              cceMoveFileContent (FILE *file, long offset, int position, size_t size);
+/* Bytes between the current position and the end of file, -1 if file can't seek. Loaders check sizes read from file against it
+ * before allocating memory for them */
+CCE_API long               cceGetFileRemainingSize (FILE *file);
 CCE_API uint16_t           cceGetFileIOfunctionSet (void);
 CCE_API ptrdiff_t          cceGetFunctionBufferOffset (uint32_t functionUID, uint16_t functionSetID);
 CCE_API int                cceRegisterFileIOcallbacks (uint16_t functionSet, uint32_t functionUID, cce_freadfun onLoad, cce_dataparsefun onFree, cce_dataparsefun onCreate, cce_fwritefun onWrite, size_t bufferSize);
+CCE_API int                cceRegisterFileIOmappedReader (uint16_t functionSet, uint32_t functionUID, cce_mreadfun onLoadMapped);
+/* Sections of files written with this function set are compressed by codec when that makes them smaller.
+ * Such files can be loaded with any function set */
+CCE_API void               cceSetFileIOcompression (uint16_t functionSet, uint8_t codec);
+/* Flags (CCE_CCF_*_CHECKSUMS) of files written and loaded with this function set, none by default. Without CCE_CCF_WRITE_CHECKSUMS
+ * uncompressed files keep legacy header. cceLoadBinaryCCF verifies every checksum it finds, cceLoadBinaryCCFmapped only with
+ * CCE_CCF_VERIFY_CHECKSUMS, since that reads the whole mapping */
+CCE_API void               cceSetFileIOchecksums (uint16_t functionSet, uint8_t flags);
 CCE_API struct cce_buffer* cceSetBufferSectionQuantity (struct cce_buffer *buffer, uint8_t newSectionsQuantity);
 CCE_API struct cce_buffer* cceCreateBuffer (uint8_t sectionsQuantity, uint16_t functionSetID);
 CCE_API void               cceFreeBuffer (struct cce_buffer *buffer);
 CCE_API struct cce_buffer* cceLoadBinaryCCF (char *path, uint16_t functionSetID);
+/* Same as cceLoadBinaryCCF, but the file is memory mapped and sections with mapped reader may reference it without copying.
+ * Sections without one are read from file. Mapping is released by cceFreeBuffer */
+CCE_API struct cce_buffer* cceLoadBinaryCCFmapped (char *path, uint16_t functionSetID);
 CCE_API int                cceWriteBinaryCCF (struct cce_buffer *buffer, char *path);
 
 #define CCE_GET_FUNCTION_BUFFER(_cce_buf, _uid)  ((cce_void*)(_cce_buf) + cceGetFunctionBufferOffset(_uid, (_cce_buf)->loadingFunctionBlockID))
@@ -34,8 +34,14 @@ extern "C"
 
 extern const uint8_t *const cce__flags;
 extern uint32_t cce__currentTime, cce__deltaTime;
+extern uint64_t cce__currentTimeNs, cce__deltaTimeNs;
+
+struct cce_ini_keys;
 
 CCE_API void cce__loadKeyboardBindingsBackendPlugin (int (*loadKeysFn)(void*), struct cce_ini_keys *buffer);
+void cce__terminateFileIO (void);
+void cce__terminateProfiler (void);
+void cce__terminateJobs (void);
 CCE_API void cce__registerBackend (const char *lowercasename, void *data, int (*iniCallback)(void*, const char*, const char*), int (*init)(void*), int (*postinit)(void), void (*term)(void), uint8_t flags);
 
 extern struct cce_backend_data
@@ -49,11 +55,60 @@ cce__engineBackend;
 #define cce__toFullscreen() cce__engineBackend.toFullscreen()
 #define cce__toWindow() cce__engineBackend.toWindow()
 
-extern uint8_t  cce__axesPairChanged;
-extern int8_t   cce__axes[8];
-extern uint16_t cce__buttonsBitField;
-extern uint16_t cce__buttonsBitFieldDiff;
+/* Input state of gamepads written by backends and applied to the game by cceUpdate. Gamepads are numbered from 1 as in events,
+ * setters queue input events too */
+struct cce__gamepad
+{
+   uint16_t buttons;     // As the game sees them
+   uint16_t buttonsDiff; // Changes not applied yet
+   int8_t   axes[8];
+   uint8_t  axesPairChanged;
+   uint8_t  connected;
+   uint8_t  connectionChanged;
+};
+
+extern struct cce__gamepad cce__gamepads[CCE_GAMEPADS_MAX];
 extern void (*cce__keyCallback)(cce_enum key, cce_enum state);
+void cce__setGamepadButton (uint8_t gamepad, uint8_t button, uint8_t pressed);
+void cce__setGamepadButtons (uint8_t gamepad, uint16_t buttons);
+void cce__setGamepadAxis (uint8_t gamepad, uint8_t axis, int8_t value);
+void cce__setGamepadConnected (uint8_t gamepad, uint8_t connected);
+
+/* Physical gamepad in the common layout (the one of GLFW and SDL), mapped to buttons and axes of the gamepad number with its
+ * deadzone, only changes are applied. Headless backend drives it the same way as GLFW one */
+#define CCE_GAMEPAD_LAYOUT_BUTTONS 15u
+#define CCE_GAMEPAD_LAYOUT_AXES    6u
+
+struct cce__gamepadstate
+{
+   uint8_t buttons[CCE_GAMEPAD_LAYOUT_BUTTONS]; // A, B, X, Y, L, R, back, start, guide, left stick, right stick, D-pad up, right, down, left
+   float   axes[CCE_GAMEPAD_LAYOUT_AXES];       // Left stick x, y, right stick x, y, left and right triggers (-1 is released)
+};
+
+void cce__updateGamepad (uint8_t gamepad, const struct cce__gamepadstate *state);
+// Mapping is reset on connection, on disconnection gamepad is released
+void cce__plugGamepad (uint8_t gamepad, uint8_t connected);
+// Physical connection, cceIsGamepadConnected reports the played back one during playback
+uint8_t cce__isGamepadPlugged (uint8_t gamepad);
+// Live input continues from the played back state
+void cce__syncGamepadsMapping (void);
+void cce__setGamepadsMapping (const struct cce_ini_keys *keys);
+void cce__pushInputEvent (uint8_t type, uint8_t code, int16_t value, uint8_t gamepad);
+void cce__queueInputEvent (const struct cce_inputevent *event);
+void cce__resetFrameState (uint64_t clockNs);
+
+#define CCE_REPLAY_OFF       0u
+#define CCE_REPLAY_RECORDING 1u
+#define CCE_REPLAY_PLAYING   2u
+
+extern uint8_t cce__replayMode;
+// Clock of frame time and input events: monotonic clock, shifted after playback to continue the played back one
+uint64_t cce__getReplayTimeNs (void);
+uint64_t cce__getReplayClock (void);
+void cce__recordInputEvent (const struct cce_inputevent *event);
+void cce__playInputEvents (void);
+int  cce__getReplayRandomSeed (void *buffer, size_t bufferSize, int (*getRandomSeed)(void *buffer, size_t bufferSize));
+void cce__terminateReplay (void);
 
 extern struct cce_u16vec2 cce__gameResolution;
 
@@ -0,0 +1,70 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_COMMON_NULL_H
+#define ENGINE_COMMON_NULL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stdint.h>
+
+#include "engine_common.h"
+
+/* Headless backend: no window, no graphics context. Selected with cceSetBackend("null") or CCE_BACKEND=null environment variable.
+ * Input is fed from script set by cceSetScriptedInput and queued as input events. Buttons and axes are set on the gamepad directly,
+ * physical gamepad input goes through the same mapping (deadzone, D-pad and triggers) as the one of GLFW backend */
+
+// value - new buttons bitfield (CCE_BUTTON_*)
+#define CCE_SCRIPTED_INPUT_BUTTONS   0x0
+// index - axis (0-7, CCE_AXISPAIR_* * 2 + 0 for horizontal or 1 for vertical), value - axis value (int8_t)
+#define CCE_SCRIPTED_INPUT_AXIS      0x1
+// value - key (CCE_KEY_*), index - key state (1 - pressed, 0 - released), passed to callback set by cceSetKeyCallback
+#define CCE_SCRIPTED_INPUT_KEY       0x2
+// cceEngineShouldTerminate starts returning 1
+#define CCE_SCRIPTED_INPUT_TERMINATE 0x3
+// value - 1 to connect physical gamepad, 0 to disconnect it
+#define CCE_SCRIPTED_INPUT_CONNECTION      0x4
+// Physical gamepad, value - pressed buttons, bit N is button N of GLFW gamepad layout (A, B, X, Y, L, R, back, start, guide,
+// left stick, right stick, D-pad up, right, down, left)
+#define CCE_SCRIPTED_INPUT_GAMEPAD_BUTTONS 0x5
+// Physical gamepad, index - axis of GLFW gamepad layout (left stick x, y, right stick x, y, left and right triggers),
+// value - axis value (int16_t, INT16_MAX is 1.0)
+#define CCE_SCRIPTED_INPUT_GAMEPAD_AXIS    0x6
+
+struct cce_scriptedinput
+{
+   uint32_t frame; // Number of cceUpdate call (starting from 0) during which input is applied
+   uint16_t value;
+   uint8_t  type;
+   uint8_t  index;
+   uint8_t  gamepad; // 1 - CCE_GAMEPADS_MAX, 0 is gamepad 1 too
+};
+
+// input MUST be sorted by frame. Array is copied. Can be called before cceInit
+CCE_API void     cceSetScriptedInput (const struct cce_scriptedinput *input, uint32_t inputQuantity);
+// Number of cceUpdate calls since cceInit
+CCE_API uint32_t cceGetScriptedInputFrame (void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // ENGINE_COMMON_NULL_H
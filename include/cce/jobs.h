@@ -0,0 +1,58 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stdint.h>
+
+#include "cce_exports.h"
+
+/* Job system: one worker per logical processor except the one of the main thread, started by the first call of
+ * cceSubmitJobs or cceGetJobWorkersQuantity (from any thread) and stopped by cceTerminate.
+ * Every worker keeps its own deque of jobs and steals the oldest ones from other deques when it runs out of them.
+ * Jobs may submit other jobs and wait for them. With no workers (single processor) jobs run inside cceSubmitJobs */
+
+struct cce_job
+{
+   void (*fn)(void *data);
+   void  *data;
+};
+
+// Has to be zero-initialized and outlive jobs submitted with it. Value must be read only by cceWaitForJobCounter
+struct cce_jobcounter
+{
+   uint32_t value; // Jobs submitted with the counter which haven't finished yet
+};
+
+// Counter may be NULL, if jobs aren't waited for. Jobs are copied, so the array may be reused after the call
+CCE_API void     cceSubmitJobs (const struct cce_job *jobs, uint32_t quantity, struct cce_jobcounter *counter);
+// Runs queued jobs (not only the counted ones) until counter reaches zero
+CCE_API void     cceWaitForJobCounter (struct cce_jobcounter *counter);
+CCE_API uint32_t cceGetJobWorkersQuantity (void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // JOBS_H
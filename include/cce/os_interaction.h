@@ -43,6 +43,10 @@ extern "C"
 
 CCE_API char*    cceCreateNewPathFromOldPath (const char *oldPath, const char *appendPath, size_t freeSpaceToLeave);
 CCE_API void     cceTruncateFile (FILE *file, size_t size);
+/* Flushes stream and waits until the data reaches the storage device */
+CCE_API int      cceFlushFileToDisk (FILE *file);
+/* Atomically replaces destination with source (destination may exist) */
+CCE_API int      cceReplaceFile (const char *source, const char *destination);
 CCE_API char*    cceGetAbsolutePath (const char *path, size_t spaceToLeave);
 CCE_API int      cceSetCurrentPath (const char *path);
 CCE_API char*    cceGetDirectory (char *path, size_t bufferSize);
@@ -54,9 +58,18 @@ CCE_API char*    cceGetTemporaryDirectory (size_t spaceToLeave);
 CCE_API void     cceTerminateTemporaryDirectory (void);
 CCE_API uint8_t  cceIsDirectory (char *path);
 CCE_API int      cceGetRandomSeed (void *buffer, size_t bufferSize);
+/* Maps whole file privately: writes to mapped memory are copy-on-write and never reach the file. Returns NULL for empty files */
+CCE_API void*    cceMapFile (const char *path, size_t *size);
+CCE_API void     cceUnmapFile (void *data, size_t size);
+/* Read-only stream over memory block, which has to outlive it */
+CCE_API FILE*    cceOpenMemoryAsFile (void *data, size_t size);
 /* Has millisecond precision, overflows every 49.7 days. */
 CCE_API uint32_t cceGetMonotonicTime (void);
+/* Nanoseconds since engine start from the most precise monotonic clock (never coarse one). Same origin as cceGetMonotonicTime */
+CCE_API uint64_t cceGetMonotonicTimeNs (void);
 int              cce__iniOsInteraction ();
+// Bytes of heap memory in use, 0 if platform doesn't report it
+uint64_t         cce__getHeapBytesInUse (void);
 
 #ifdef __cplusplus
 }
@@ -157,6 +157,19 @@ struct cceaTerminateEngine
 
 CCE_API extern uint32_t cceaBasicActionUIDs[16];
 
+#define CCEA_POOL_SIZE_CLASSES 5
+
+// Delayed actions are allocated from pool of 16, 32, 64, 128 and 256-byte blocks
+struct cceaPoolStatistics
+{
+   uint32_t blockSize[CCEA_POOL_SIZE_CLASSES];
+   uint32_t inUse[CCEA_POOL_SIZE_CLASSES];
+   uint32_t highWaterMark[CCEA_POOL_SIZE_CLASSES];
+   uint32_t reserved[CCEA_POOL_SIZE_CLASSES]; // Blocks taken from the system, both used and free
+   uint32_t oversizedInUse;                   // Bigger than the largest block, allocated with malloc
+   uint32_t oversizedHighWaterMark;
+};
+
 #define CCEA_EVENT_LOAD 0
 #define CCEA_EVENT_FREE 1
 #define CCEA_EVENT_WRITE 2
@@ -172,11 +185,18 @@ CCE_API void  cceaInvokeEvent (uint32_t eventUID, uint32_t count, struct cce_buf
 CCE_API void  cceaAddActionOnEvent (uint32_t eventUID, uint32_t actionSubsUID, struct cceaAction *action, struct cce_buffer *map);
 CCE_API void  cceaRemoveActionOnEvent (uint32_t eventUID, uint32_t actionSubsUID, struct cce_buffer *map);
 CCE_API void  cceaLoadActionsPlugin  (void);
-// Expects POINTERS to actions, not actions themselves
+// Expects POINTERS to actions, not actions themselves. Result is allocated with malloc, caller releases it with free
 CCE_API void* cceaActionRunnerCreateDynamic (uint32_t runActionsID, uint32_t runActionsStructSize, uint32_t actionsQuantity, ...);
+CCE_API void  cceaGetPoolStatistics (struct cceaPoolStatistics *statistics);
 CCE_API void  cceaRegisterActionsFileIOFunctions (uint16_t functionSetID);
 
+/* Actions (delayed ones, ones on events and ones run with cceaRunAction) must be run on the main thread only:
+ * plugin state isn't synchronized, parallel update callbacks must not run them */
 CCE_API void  cceaRunDelayedActions (struct cce_buffer *map);
+/* Map time is advanced by nanosecond frame delta, keeping sub-millisecond remainder between frames. Off by default.
+ * The setting is process-wide, not per map: it applies to every map and survives cceTerminate. Call it from the main thread */
+CCE_API void     cceaSetPreciseTiming (uint8_t enable);
+CCE_API uint64_t cceaGetMapTimeNs (struct cce_buffer *map);
 
 #define CCEA_ACTION_SIZE_VARIABLE 0
 
@@ -25,3 +25,5 @@ CCE_API void     ccea__addActionsOnEvent (uint32_t eventUID, uint32_t actionSubs
 CCE_API void     ccea__fromHostEndianActionsArray (struct cceaAction *actions, uint32_t totalActionsSize);
 CCE_API void     ccea__toHostEndianActionsArray (struct cceaAction *actions, uint32_t totalActionsSize);
 CCE_API uint8_t  ccea__doActionsSwapFromHostEndian (void);
+// Timeouts of delayed actions are not moved, used by tests to put map time next to the edge of uint32_t range
+CCE_API void     ccea__setMapTime (struct cce_buffer *map, uint32_t time);
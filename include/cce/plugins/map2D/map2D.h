@@ -135,6 +135,20 @@ struct cce_dynamiccollisioninfo
    uint32_t                  collidersAllocated;
 };
 
+struct cce_broadphase2D;
+
+struct cce_broadphasecandidate2D
+{
+   uint32_t positionID; // Index in element position array of broadphase layer
+   uint32_t collider;   // Index in cce_collisioninfo colliders
+};
+
+struct cce_broadphasepair2D
+{
+   struct cce_broadphasecandidate2D a;
+   struct cce_broadphasecandidate2D b;
+};
+
 struct cce_usedtexinfo
 {
    uint16_t *texturesMapDependsOn;
@@ -157,6 +171,10 @@ CCE_API uint16_t cceLoadTexture (char *path, uint8_t usersQuantity);
 CCE_API struct cce_buffer* cceLoadMap2D (char *path);
 CCE_API struct cce_buffer* cceLoadMap2Ddynamic (char *path);
 CCE_API int  cceWriteMap2Ddynamic (struct cce_buffer *map, char *path);
+/* Codec (CCE_CCF_CODEC_*) for sections written by cceWriteMap2Ddynamic, none by default */
+CCE_API void cceSetMap2Dcompression (uint8_t codec);
+/* Checksum flags (CCE_CCF_*_CHECKSUMS) of maps written by cceWriteMap2Ddynamic and loaded by cceLoadMap2D, none by default */
+CCE_API void cceSetMap2Dchecksums (uint8_t flags);
 CCE_API struct cce_buffer* cceCreateMap2Ddynamic (void);
 CCE_API void cceSetCameraPosition (struct cce_i16vec2 position);
 CCE_API void cceSetViewRotation (uint8_t normalizedAngle);
@@ -166,6 +184,10 @@ CCE_API struct cce_elementposition* cceGetElementsPosition (uint8_t layer, uint1
 CCE_API int cceSetElementsPositionsUpdated (struct cce_elementpositionarray *elementPositions);
 CCE_API struct cce_element* cceGetElements (uint16_t ID, uint16_t quantity, struct cce_buffer *map);
 CCE_API int cceSetElementsUpdated (struct cce_renderinginfo *info);
+/* Cheaper alternatives to cceSetElementsPositionsUpdated/cceSetElementsUpdated: only given range is uploaded at next draw.
+ * Close ranges are merged, too many ranges fall back to whole buffer upload */
+CCE_API int cceSetElementsPositionsRangeUpdated (uint8_t layer, uint32_t positionID, uint32_t quantity, struct cce_buffer *map);
+CCE_API int cceSetElementsRangeUpdated (uint16_t ID, uint16_t quantity, struct cce_buffer *map);
 CCE_API int cceSetRenderingLayersQuantity (uint8_t layersQuantity, struct cce_buffer *map);
 CCE_API struct cce_renderinginfo* cceGetRenderingInfo (struct cce_buffer *map);
 CCE_API struct cce_dynamicrenderinginfo* cceGetDynamicRenderingInfo (struct cce_buffer *map);
@@ -174,6 +196,55 @@ CCE_API void* cceGetResource (uint8_t resource, struct cce_buffer *map);
 
 CCE_API extern const struct cce_u16vec2 *const cceTextureSize;
 
+// Last frame drawn by software renderer ([Map2D] renderer = software): RGBA8, game resolution, top row first. NULL if other renderer is used
+CCE_API const struct cce_u8vec4* cceGetMap2DFramebuffer (void);
+
+/* Broadphase over colliders of one map layer. cce_collidermap2D.element is element ID (textureDataID - 1 of element position),
+ * collider position is relative to element. Queries and cceGetBroadphasePairs2D write at most candidatesMax/pairsMax entries
+ * and return total number found, so too small buffer can be resized and query repeated */
+CCE_API struct cce_broadphase2D* cceCreateBroadphase2D (uint8_t cellSizeLog2);
+CCE_API void     cceFreeBroadphase2D (struct cce_broadphase2D *broadphase);
+// colliders MUST stay valid while broadphase is used
+CCE_API int      cceBuildBroadphaseMap2D (struct cce_broadphase2D *broadphase, const struct cce_collisioninfo *colliders, uint8_t layer, struct cce_buffer *map);
+// Call after element positions obtained by cceGetElementsPosition were changed, with the same positionID and quantity
+CCE_API int      cceUpdateBroadphaseMap2D (struct cce_broadphase2D *broadphase, uint32_t positionID, uint32_t quantity);
+CCE_API uint32_t cceQueryBroadphaseAABB2D (struct cce_broadphase2D *broadphase, struct cce_collider_rect2D_32_32 box,
+                                           struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax);
+CCE_API uint32_t cceQueryBroadphasePoint2D (struct cce_broadphase2D *broadphase, struct cce_i32vec2 point,
+                                            struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax);
+CCE_API uint32_t cceQueryBroadphaseCircle2D (struct cce_broadphase2D *broadphase, struct cce_collider_cir2D_32_32 circle,
+                                             struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax);
+// Segment from origin to end, candidates are roughly ordered by distance from origin
+CCE_API uint32_t cceQueryBroadphaseRay2D (struct cce_broadphase2D *broadphase, struct cce_i32vec2 origin, struct cce_i32vec2 end,
+                                          struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax);
+// Overlapping bounding boxes of colliders belonging to different element positions, every pair is reported once
+CCE_API uint32_t cceGetBroadphasePairs2D (struct cce_broadphase2D *broadphase, struct cce_broadphasepair2D *pairs, uint32_t pairsMax);
+
+struct cce_texturedecoder;
+
+struct cce_decodedtexture
+{
+   void    *data; // RGBA8, top row first. NULL if file can't be decoded
+   char    *path;
+   uint32_t userID;
+   uint16_t width, height;
+};
+
+/* Pool of threads decoding image files to RGBA8. Map2D uses one internally ([Map2D] textureDecodingThreads, 0 - decode on the
+ * main thread), textures are shown as cceGenDummyTextureRGBA8 checkerboard until their decoding finishes.
+ * Decoded textures are collected in completion order and must be released with cceFreeDecodedTexture */
+CCE_API struct cce_texturedecoder* cceCreateTextureDecoder (uint8_t threadsQuantity);
+CCE_API void     cceFreeTextureDecoder (struct cce_texturedecoder *decoder);
+CCE_API int      cceQueueTextureDecoding (struct cce_texturedecoder *decoder, const char *path, uint32_t userID);
+// Never blocks, returns quantity of textures written
+CCE_API uint32_t cceCollectDecodedTextures (struct cce_texturedecoder *decoder, struct cce_decodedtexture *textures, uint32_t texturesMax);
+// Queued, being decoded and not yet collected
+CCE_API uint32_t cceGetPendingTexturesQuantity (struct cce_texturedecoder *decoder);
+// Blocks until every queued texture is decoded, they still have to be collected
+CCE_API void     cceWaitTextureDecoder (struct cce_texturedecoder *decoder);
+CCE_API void     cceFreeDecodedTexture (struct cce_decodedtexture *texture);
+CCE_API void*    cceGenDummyTextureRGBA8 (uint16_t width, uint16_t height);
+
 #define cceFreeMap2D(map)        cceFreeBuffer(map)
 #define cceFreeMap2Ddynamic(map) cceFreeBuffer(map)
 
@@ -0,0 +1,78 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stdint.h>
+
+#include "cce_exports.h"
+#include "config.h"
+
+/* Zones are recorded only when engine is built with CCE_PROFILER (cmake -DCCE_PROFILER=ON), otherwise the macros expand to nothing.
+ * Every thread records into its own ring buffer (the oldest zones are overwritten), cceWriteProfilerTrace stores all of them
+ * in Chrome trace format (chrome://tracing, Perfetto). Zone names have to outlive the trace - string literals are expected.
+ *
+ * CCE_PROFILE_SCOPE("name") statement;                  - zone around one statement or block, it must not be left with return/break/goto
+ * CCE_PROFILE_SCOPE_ID("name", id) statement;           - same, id is shown in zone arguments
+ * CCE_PROFILE_BEGIN(zone); ... CCE_PROFILE_END(zone, "name"); - zone around code with several exits, END is needed on each of them */
+
+#define CCE_PROFILER_NO_ID UINT32_MAX
+
+#ifdef CCE_PROFILER
+
+#define CCE__PROFILE_CONCAT2(a, b) a ## b
+#define CCE__PROFILE_CONCAT(a, b) CCE__PROFILE_CONCAT2(a, b)
+#define CCE__PROFILE_VARIABLE(name) CCE__PROFILE_CONCAT(cce__profile ## name, __LINE__)
+
+#define CCE_PROFILE_SCOPE_ID(name, id) \
+for (uint64_t CCE__PROFILE_VARIABLE(Start) = cce__beginProfilerZone(), CCE__PROFILE_VARIABLE(Once) = 1; CCE__PROFILE_VARIABLE(Once); \
+     CCE__PROFILE_VARIABLE(Once) = 0, cce__endProfilerZone(name, (id), CCE__PROFILE_VARIABLE(Start)))
+#define CCE_PROFILE_SCOPE(name) CCE_PROFILE_SCOPE_ID(name, CCE_PROFILER_NO_ID)
+#define CCE_PROFILE_BEGIN(zone) uint64_t zone = cce__beginProfilerZone()
+#define CCE_PROFILE_END(zone, name) cce__endProfilerZone(name, CCE_PROFILER_NO_ID, zone)
+
+#else
+
+#define CCE_PROFILE_SCOPE_ID(name, id)
+#define CCE_PROFILE_SCOPE(name)
+#define CCE_PROFILE_BEGIN(zone)
+#define CCE_PROFILE_END(zone, name)
+
+#endif // CCE_PROFILER
+
+// Returns 0 when profiling is stopped, such zone isn't recorded
+CCE_API uint64_t cce__beginProfilerZone (void);
+CCE_API void     cce__endProfilerZone (const char *name, uint32_t id, uint64_t start);
+/* Recording is off until started, so zones cost one check. Start, stop and write are meant to be called from the main thread
+ * while other threads don't record zones (e.g. between frames). Starting again discards recorded zones */
+CCE_API void     cceStartProfiling (void);
+CCE_API void     cceStopProfiling (void);
+// Returns -1 if file can't be written or engine is built without profiler
+CCE_API int      cceWriteProfilerTrace (const char *path);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // PROFILER_H
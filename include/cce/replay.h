@@ -0,0 +1,48 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stdint.h>
+
+#include "cce_exports.h"
+
+/* Recording stores input events, clock readings of cceUpdate and results of cceGetRandomSeed into a binary log, playback feeds
+ * them back instead of live ones, so that the same game (and game.ini) goes through the same frames bit-exactly. Playback isn't
+ * tied to wall clock, frames run as fast as they are called. Frame time and input state at the start of recording are restored
+ * by playback, the game has to be in the same state at both points too (e.g. right after cceInit). Playback stops at the end
+ * of the log or when the game asks for seeds differently than it did while recording (desync). Both report gamepads connected at
+ * their start, after playback live input continues from the played back state */
+
+CCE_API int     cceStartRecording (const char *path);
+CCE_API void    cceStopRecording (void);
+CCE_API int     cceStartPlayback (const char *path);
+CCE_API void    cceStopPlayback (void);
+CCE_API uint8_t cceIsPlayingBack (void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // REPLAY_H
@@ -293,6 +293,26 @@ CCE_API size_t                 cceStringToUppercase (char *str);
 CCE_API void                   cceMemoryToUppercase (char *str, size_t size);
 CCE_API CCE_NOALIAS_FN uint8_t cceStringToBool      (const char *str);
 
+struct cce_range
+{
+   uint32_t begin;
+   uint32_t end; // Exclusive
+};
+
+struct cce_rangearray
+{
+   struct cce_range *data;
+   uint32_t          dataQuantity;
+   uint32_t          dataAllocated;
+};
+
+/* Adds [begin, end) to sorted array of disjoint ranges. Ranges which overlap or are separated by at most mergeGap are merged,
+ * so that e.g. one bigger upload is done instead of several small ones. Returns quantity of ranges */
+CCE_API uint32_t cceAddRange (struct cce_rangearray *ranges, uint32_t begin, uint32_t end, uint32_t mergeGap);
+
+/* CRC-32C (Castagnoli) of data. Pass 0 as crc for the first block and the previous result to continue over several blocks */
+CCE_API CCE_NOALIAS_FN uint32_t cceCRC32C (uint32_t crc, const void *data, size_t size);
+
 #define cceFastCosInt8(x) cceFastSinInt8(x + 64u)
 
 #define CCE__STRING_TO_SXVECY(sign, signUpper, uIfUnsigned, bits, comp) \
@@ -0,0 +1,175 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/cce/compression.h"
+#include "../include/cce/utils.h"
+
+#define CCE_LZ_MIN_MATCH 4u
+#define CCE_LZ_MAX_OFFSET 65535u
+#define CCE_LZ_LAST_LITERALS 5u  // Format requires last 5 bytes to be literals
+#define CCE_LZ_MATCH_LIMIT 12u   // and last match to start 12 bytes before the end
+#define CCE_LZ_HASH_BITS 12u
+
+static inline uint32_t read32 (const uint8_t *data)
+{
+   uint32_t result;
+   memcpy(&result, data, sizeof(uint32_t));
+   return result;
+}
+
+static inline uint32_t hashSequence (uint32_t sequence)
+{
+   return (sequence * 2654435761u) >> (32u - CCE_LZ_HASH_BITS);
+}
+
+// Lengths which don't fit into token's nibble are continued with bytes, 255 meaning "more follows"
+static inline uint8_t* writeLength (uint8_t *dst, const uint8_t *dstEnd, size_t length)
+{
+   for (; length >= 255u; length -= 255u)
+   {
+      if (dst >= dstEnd)
+         return NULL;
+      *dst++ = 255u;
+   }
+   if (dst >= dstEnd)
+      return NULL;
+   *dst++ = (uint8_t) length;
+   return dst;
+}
+
+static uint8_t* writeSequence (uint8_t *dst, const uint8_t *dstEnd, const uint8_t *literals, size_t literalsLength, size_t offset, size_t matchLength)
+{
+   if (dst >= dstEnd)
+      return NULL;
+   uint8_t *token = dst++;
+   *token = (uint8_t)(CCE_MIN(literalsLength, 15u) << 4);
+   if (literalsLength >= 15u && (dst = writeLength(dst, dstEnd, literalsLength - 15u)) == NULL)
+      return NULL;
+   if ((size_t)(dstEnd - dst) < literalsLength)
+      return NULL;
+   memcpy(dst, literals, literalsLength);
+   dst += literalsLength;
+   if (matchLength == 0)
+      return dst;
+   if (dstEnd - dst < 2)
+      return NULL;
+   *dst++ = (uint8_t) offset;
+   *dst++ = (uint8_t)(offset >> 8);
+   matchLength -= CCE_LZ_MIN_MATCH;
+   *token |= (uint8_t) CCE_MIN(matchLength, 15u);
+   if (matchLength >= 15u)
+      dst = writeLength(dst, dstEnd, matchLength - 15u);
+   return dst;
+}
+
+CCE_API size_t cceCompressLZ (const void *src, size_t srcSize, void *dst, size_t dstCapacity)
+{
+   const uint8_t *input = src, *inputEnd = input + srcSize;
+   const uint8_t *anchor = input;
+   uint8_t *output = dst, *outputEnd = output + dstCapacity;
+   if (srcSize > CCE_LZ_MATCH_LIMIT)
+   {
+      // Positions are relative to input, so zero-initialized table points to the beginning which is checked anyway
+      uint32_t table[1u << CCE_LZ_HASH_BITS] = {0};
+      const uint8_t *matchLimit = inputEnd - CCE_LZ_MATCH_LIMIT;
+      const uint8_t *copyLimit  = inputEnd - CCE_LZ_LAST_LITERALS;
+      const uint8_t *iterator   = input;
+      while (iterator < matchLimit)
+      {
+         uint32_t sequence = read32(iterator);
+         uint32_t *entry = table + hashSequence(sequence);
+         const uint8_t *reference = input + *entry;
+         *entry = (uint32_t)(iterator - input);
+         if (reference >= iterator || (size_t)(iterator - reference) > CCE_LZ_MAX_OFFSET || read32(reference) != sequence)
+         {
+            ++iterator;
+            continue;
+         }
+         size_t length = CCE_LZ_MIN_MATCH;
+         while (iterator + length < copyLimit && reference[length] == iterator[length])
+            ++length;
+         output = writeSequence(output, outputEnd, anchor, iterator - anchor, iterator - reference, length);
+         if (output == NULL)
+            return 0;
+         iterator += length;
+         anchor = iterator;
+      }
+   }
+   output = writeSequence(output, outputEnd, anchor, inputEnd - anchor, 0, 0);
+   return (output == NULL) ? 0 : (size_t)(output - (uint8_t*) dst);
+}
+
+CCE_API int cceDecompressLZ (const void *src, size_t srcSize, void *dst, size_t dstSize)
+{
+   const uint8_t *input = src, *inputEnd = input + srcSize;
+   uint8_t *output = dst, *outputEnd = output + dstSize;
+   while (input < inputEnd)
+   {
+      uint8_t token = *input++;
+      size_t length = token >> 4;
+      if (length == 15u)
+      {
+         uint8_t byte;
+         do
+         {
+            if (input >= inputEnd)
+               return -1;
+            byte = *input++;
+            length += byte;
+         }
+         while (byte == 255u);
+      }
+      if ((size_t)(inputEnd - input) < length || (size_t)(outputEnd - output) < length)
+         return -1;
+      memcpy(output, input, length);
+      input += length;
+      output += length;
+      if (input == inputEnd)
+         break; // Last sequence has no match
+      
+      if (inputEnd - input < 2)
+         return -1;
+      size_t offset = input[0] | ((size_t) input[1] << 8);
+      input += 2;
+      if (offset == 0 || offset > (size_t)(output - (uint8_t*) dst))
+         return -1;
+      length = token & 0xF;
+      if (length == 15u)
+      {
+         uint8_t byte;
+         do
+         {
+            if (input >= inputEnd)
+               return -1;
+            byte = *input++;
+            length += byte;
+         }
+         while (byte == 255u);
+      }
+      length += CCE_LZ_MIN_MATCH;
+      if ((size_t)(outputEnd - output) < length)
+         return -1;
+      // Match may overlap the output being written (repeating pattern), so it's copied byte by byte
+      for (const uint8_t *match = output - offset, *end = output + length; output < end; ++output, ++match)
+         *output = *match;
+   }
+   return (output == outputEnd) - 1;
+}
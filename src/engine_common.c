@@ -32,25 +32,34 @@
 #include "../include/cce/utils.h"
 #include "../include/cce/os_interaction.h"
 #include "../include/cce/endianess.h"
+#include "../include/cce/jobs.h"
+#include "../include/cce/profiler.h"
 
 #include "../include/cce/engine_common_internal.h"
+#include "platform/threads.h"
 
 #define CCE_CALLBACK_ENABLED  0x1
 #define CCE_CALLBACK_DISABLED 0x0
+#define CCE_CALLBACK_PARALLEL 0x2
 
 struct iniCallbackData
 {
    int (*fn)(void*, const char*, const char*);
    int (*init)(void*);
    int (*postInit)(void);
+   void (*term)(void);
    void *data;
+   uint32_t *dependencies;
    uint64_t uid;
+   uint16_t dependenciesQuantity;
    uint8_t flags;
 };
 
 struct updateCallbackData
 {
    void (*fn)(void);
+   uint64_t readSet;
+   uint64_t writeSet;
    uint8_t flags;
 };
 
@@ -66,22 +75,44 @@ uint16_t terminationCallbacksQuantity = 1;
 uint16_t terminationCallbacksAllocated = 0;
 
 CCE_ARRAY(updateCallbacks, struct updateCallbackData, uint16_t);
+// Batch of parallel update callbacks without conflicts, collected by cceUpdate
+CCE_ARRAY(updateJobs, struct cce_job, uint16_t);
 
 #define CCE_INI_CALLBACK_TO_BE_INITIALIZED 0x4
 #define CCE_INI_CALLBACK_NO_TERMINATION_CALLBACK 0x8
+#define CCE_INI_CALLBACK_DEPENDENCIES_DECLARED 0x20
 
 struct cce_backend_data cce__engineBackend;
 uint32_t cce__currentTime = 0, cce__deltaTime = 0;
+uint64_t cce__currentTimeNs = 0, cce__deltaTimeNs = 0;
+
+#define CCE_DEFAULT_MAX_TICKS_PER_UPDATE 5u
+
+// Fixed timestep is off while tickNs is 0. Lag is clock time not yet simulated by ticks
+static uint64_t clockNs;
+static uint64_t tickNs;
+static uint64_t tickLagNs;
+static uint64_t ticksQuantity;
+static float    tickInterpolation = 1.0f;
+static uint16_t tickRate;
+static uint16_t maxTicksPerUpdate = CCE_DEFAULT_MAX_TICKS_PER_UPDATE;
 
 struct cce_u16vec2 cce__gameResolution;
-uint16_t cce__buttonsBitFieldDiff;
-uint16_t cce__buttonsBitField;
-uint8_t  cce__axesPairChanged;
-int8_t   cce__axes[8];
+struct cce__gamepad cce__gamepads[CCE_GAMEPADS_MAX];
+// Gamepads merged for callbacks which don't take gamepad number
+static uint16_t buttonsBitField;
+static int8_t   axes[8];
 static void (*moveCallbacks[4])(int8_t, int8_t);
 static void (*buttonsCallback)(uint16_t, uint16_t);
+static void (*gamepadMoveCallbacks[4])(uint8_t, int8_t, int8_t);
+static void (*gamepadButtonsCallback)(uint8_t, uint16_t, uint16_t);
+static void (*gamepadConnectionCallback)(uint8_t, uint8_t);
 void (*cce__keyCallback)(cce_enum key, cce_enum state);
 
+// Events are pushed by backend callbacks and read by the game, both on the main thread (GLFW calls back from glfwPollEvents)
+static struct cce_inputevent inputEvents[CCE_INPUT_EVENTS_CAPACITY];
+static uint32_t              inputEventsFirst, inputEventsEnd; // Wrap around, capacity is a power of two
+
 CCE_API uint8_t (*cceEngineShouldTerminate) (void);
 CCE_API void (*cceSetEngineShouldTerminate) (uint8_t);
 CCE_API void (*cceScreenUpdate) (void);
@@ -91,6 +122,19 @@ jmp_buf g_jumpOnIniFailure;
 #endif
 uint16_t commonIniCallbackID;
 uint8_t  ignoreUninitializedPlugins;
+uint8_t  logPluginStats;
+
+// Indexed as iniCallbacks, kept after termination so that terminate stage can be read
+static struct cce_pluginstats *pluginStats = NULL;
+static uint16_t pluginStatsQuantity = 0;
+static uint16_t pluginStagesRun[CCE_PLUGIN_STAGES_QUANTITY];
+
+// Start of the measured plugin stage, after it ends - its duration and heap change
+struct pluginstage
+{
+   uint64_t time;
+   uint64_t heap;
+};
 
 CCE_API void cceSetAxisChangeCallback (void (*callback)(int8_t, int8_t), cce_enum axePair)
 {
@@ -107,15 +151,180 @@ CCE_API void cceSetKeyCallback (void (*callback)(cce_enum key, cce_enum state))
    cce__keyCallback = callback;
 }
 
+CCE_API void cceSetGamepadButtonCallback (void (*callback)(uint8_t gamepad, uint16_t buttonState, uint16_t diff))
+{
+   gamepadButtonsCallback = callback;
+}
+
+CCE_API void cceSetGamepadAxisChangeCallback (void (*callback)(uint8_t gamepad, int8_t x, int8_t y), cce_enum axisPair)
+{
+   gamepadMoveCallbacks[axisPair] = callback;
+}
+
+CCE_API void cceSetGamepadConnectionCallback (void (*callback)(uint8_t gamepad, uint8_t connected))
+{
+   gamepadConnectionCallback = callback;
+}
+
+CCE_API uint16_t cceGetGamepadButtons (uint8_t gamepad)
+{
+   return (gamepad > 0 && gamepad <= CCE_GAMEPADS_MAX) ? cce__gamepads[gamepad - 1].buttons : 0;
+}
+
+CCE_API int8_t cceGetGamepadAxis (uint8_t gamepad, uint8_t axis)
+{
+   return (gamepad > 0 && gamepad <= CCE_GAMEPADS_MAX && axis < 8u) ? cce__gamepads[gamepad - 1].axes[axis] : 0;
+}
+
+CCE_API uint8_t cceIsGamepadConnected (uint8_t gamepad)
+{
+   return (gamepad > 0 && gamepad <= CCE_GAMEPADS_MAX) ? cce__gamepads[gamepad - 1].connected : 0;
+}
+
+// Press and release within one frame cancel each other out in the diff, both are queued as events
+void cce__setGamepadButton (uint8_t gamepad, uint8_t button, uint8_t pressed)
+{
+   struct cce__gamepad *pad = cce__gamepads + (gamepad - 1);
+   const uint16_t bit = 1u << button;
+   pad->buttonsDiff &= ~bit;
+   pad->buttonsDiff |= (-(uint16_t)(pressed != 0) & bit) ^ (pad->buttons & bit);
+   cce__pushInputEvent(CCE_INPUT_EVENT_BUTTON, button, pressed != 0, gamepad);
+}
+
+void cce__setGamepadButtons (uint8_t gamepad, uint16_t buttons)
+{
+   struct cce__gamepad *pad = cce__gamepads + (gamepad - 1);
+   for (uint16_t changed = buttons ^ pad->buttons ^ pad->buttonsDiff, bit = 0; changed != 0; changed >>= 1, ++bit)
+   {
+      if (changed & 1u)
+         cce__pushInputEvent(CCE_INPUT_EVENT_BUTTON, (uint8_t) bit, (buttons >> bit) & 1u, gamepad);
+   }
+   pad->buttonsDiff = buttons ^ pad->buttons;
+}
+
+void cce__setGamepadAxis (uint8_t gamepad, uint8_t axis, int8_t value)
+{
+   struct cce__gamepad *pad = cce__gamepads + (gamepad - 1);
+   pad->axes[axis] = value;
+   pad->axesPairChanged |= 1u << (axis >> 1);
+   cce__pushInputEvent(CCE_INPUT_EVENT_AXIS, axis, value, gamepad);
+}
+
+void cce__setGamepadConnected (uint8_t gamepad, uint8_t connected)
+{
+   struct cce__gamepad *pad = cce__gamepads + (gamepad - 1);
+   pad->connected = connected;
+   pad->connectionChanged = 1;
+   cce__pushInputEvent(CCE_INPUT_EVENT_CONNECTION, 0, connected, gamepad);
+}
+
+// The strongest value of the axis, so that idle gamepads don't hide the used one
+static int8_t mergeGamepadsAxis (uint8_t axis)
+{
+   int8_t value = 0;
+   for (const struct cce__gamepad *iterator = cce__gamepads, *end = cce__gamepads + CCE_GAMEPADS_MAX; iterator < end; ++iterator)
+   {
+      if (CCE_ABS((int) iterator->axes[axis]) > CCE_ABS((int) value))
+         value = iterator->axes[axis];
+   }
+   return value;
+}
+
+static void applyGamepadsInput (void)
+{
+   uint16_t buttons = 0;
+   uint8_t axesPairChanged = 0;
+   for (uint8_t gamepad = 1; gamepad <= CCE_GAMEPADS_MAX; ++gamepad)
+   {
+      struct cce__gamepad *pad = cce__gamepads + (gamepad - 1);
+      if (pad->connectionChanged)
+      {
+         pad->connectionChanged = 0;
+         if (gamepadConnectionCallback != NULL)
+            CCE_PROFILE_SCOPE_ID("gamepadConnectionCallback", gamepad) gamepadConnectionCallback(gamepad, pad->connected);
+      }
+      if (pad->buttonsDiff != 0)
+      {
+         pad->buttons ^= pad->buttonsDiff;
+         if (gamepadButtonsCallback != NULL)
+            CCE_PROFILE_SCOPE_ID("gamepadButtonsCallback", gamepad) gamepadButtonsCallback(gamepad, pad->buttons, pad->buttonsDiff);
+         pad->buttonsDiff = 0;
+      }
+      buttons |= pad->buttons;
+      for (uint8_t pair = 0; pair < 4u; ++pair)
+      {
+         if (((pad->axesPairChanged >> pair) & 1u) && gamepadMoveCallbacks[pair] != NULL)
+            CCE_PROFILE_SCOPE_ID("gamepadMoveCallback", pair) gamepadMoveCallbacks[pair](gamepad, pad->axes[pair * 2u], pad->axes[pair * 2u + 1u]);
+      }
+      axesPairChanged |= pad->axesPairChanged;
+      pad->axesPairChanged = 0;
+   }
+   if (buttons != buttonsBitField)
+   {
+      const uint16_t diff = buttons ^ buttonsBitField;
+      buttonsBitField = buttons;
+      if (buttonsCallback != NULL)
+         CCE_PROFILE_SCOPE("buttonsCallback") buttonsCallback(buttonsBitField, diff);
+   }
+   for (uint8_t pair = 0; axesPairChanged != 0; ++pair, axesPairChanged >>= 1)
+   {
+      if (!(axesPairChanged & 1u))
+         continue;
+      axes[pair * 2u] = mergeGamepadsAxis(pair * 2u);
+      axes[pair * 2u + 1u] = mergeGamepadsAxis(pair * 2u + 1u);
+      if (moveCallbacks[pair] != NULL)
+         CCE_PROFILE_SCOPE_ID("moveCallback", pair) moveCallbacks[pair](axes[pair * 2u], axes[pair * 2u + 1u]);
+   }
+}
+
+// The oldest event is dropped when queue is full, so that the newest ones agree with the current input state
+void cce__queueInputEvent (const struct cce_inputevent *event)
+{
+   if (inputEventsEnd - inputEventsFirst >= CCE_INPUT_EVENTS_CAPACITY)
+      ++inputEventsFirst;
+   inputEvents[(inputEventsEnd++) & (CCE_INPUT_EVENTS_CAPACITY - 1u)] = *event;
+}
+
+// Live input is ignored during playback, recorded events are queued instead
+void cce__pushInputEvent (uint8_t type, uint8_t code, int16_t value, uint8_t gamepad)
+{
+   if (cce__replayMode == CCE_REPLAY_PLAYING)
+      return;
+   const struct cce_inputevent event = {cce__getReplayTimeNs(), value, code, type, gamepad};
+   if (cce__replayMode == CCE_REPLAY_RECORDING)
+      cce__recordInputEvent(&event);
+   cce__queueInputEvent(&event);
+}
+
+CCE_API uint32_t cceReadInputEvents (struct cce_inputevent *events, uint32_t eventsMax)
+{
+   const uint32_t quantity = CCE_MIN(eventsMax, inputEventsEnd - inputEventsFirst);
+   for (uint32_t i = 0; i < quantity; ++i)
+      events[i] = inputEvents[(inputEventsFirst + i) & (CCE_INPUT_EVENTS_CAPACITY - 1u)];
+   inputEventsFirst += quantity;
+   return quantity;
+}
+
 CCE_API uint16_t cceRegisterUpdateCallback (void (*callback)(void))
 {
    if (updateCallbacksQuantity >= updateCallbacksAllocated)
       CCE_REALLOC_ARRAY(updateCallbacks, updateCallbacksQuantity + 1);
    updateCallbacks[updateCallbacksQuantity].fn = callback;
+   updateCallbacks[updateCallbacksQuantity].readSet  = UINT64_MAX;
+   updateCallbacks[updateCallbacksQuantity].writeSet = UINT64_MAX;
    updateCallbacks[updateCallbacksQuantity].flags = CCE_CALLBACK_ENABLED;
    return updateCallbacksQuantity++;
 }
 
+CCE_API uint16_t cceRegisterParallelUpdateCallback (void (*callback)(void), uint64_t readSet, uint64_t writeSet)
+{
+   uint16_t callbackID = cceRegisterUpdateCallback(callback);
+   updateCallbacks[callbackID].readSet  = readSet;
+   updateCallbacks[callbackID].writeSet = writeSet;
+   updateCallbacks[callbackID].flags |= CCE_CALLBACK_PARALLEL;
+   return callbackID;
+}
+
 CCE_API void cceEnableUpdateCallback (uint16_t callbackID)
 {
    assert(callbackID < updateCallbacksQuantity);
@@ -150,11 +359,14 @@ CCE_API int cceRegisterPlugin (uint32_t uid, void *data, int (*iniCallback)(void
       CCE_REALLOC_ARRAY(iniCallbacks, iniCallbacksQuantity + 1);
    }
    iniCallbacks[iniCallbacksQuantity].data          = data;
-   iniCallbacks[iniCallbacksQuantity].fn            = (iniCallbacks != NULL) ? iniCallback : emptyIniCallback;
+   iniCallbacks[iniCallbacksQuantity].fn            = (iniCallback != NULL) ? iniCallback : emptyIniCallback;
    iniCallbacks[iniCallbacksQuantity].flags = flags | (-(init == NULL) & CCE_INI_CALLBACK_DO_NOT_INIT) | (-(term == NULL) & CCE_INI_CALLBACK_NO_TERMINATION_CALLBACK);
    iniCallbacks[iniCallbacksQuantity].init = init;
    iniCallbacks[iniCallbacksQuantity].uid = uid;
    iniCallbacks[iniCallbacksQuantity].postInit = postinit;
+   iniCallbacks[iniCallbacksQuantity].term = term;
+   iniCallbacks[iniCallbacksQuantity].dependencies = NULL;
+   iniCallbacks[iniCallbacksQuantity].dependenciesQuantity = 0;
    if (term != NULL)
    {
       if (terminationCallbacksQuantity >= terminationCallbacksAllocated)
@@ -166,6 +378,32 @@ CCE_API int cceRegisterPlugin (uint32_t uid, void *data, int (*iniCallback)(void
    return 0;
 }
 
+CCE_API int cceSetPluginDependencies (uint32_t uid, const uint32_t *dependencies, uint16_t dependenciesQuantity)
+{
+   // Sorted array is created by cceInit, backend (0) is registered there too
+   uint16_t id = 1;
+   while (iniCallbacks != NULL && id < iniCallbacksQuantity && iniCallbacks[id].uid != uid)
+      ++id;
+   if (iniCallbacks == NULL || id >= iniCallbacksQuantity)
+   {
+      fprintf(stderr, "ENGINE::PLUGIN_DEPENDENCIES::UNREGISTERED_PLUGIN:\nplugin \"%s\" has to be registered before its dependencies are set\n", cceUIDToName(uid));
+      return -1;
+   }
+   struct iniCallbackData *plugin = iniCallbacks + id;
+   free(plugin->dependencies);
+   plugin->dependencies = NULL;
+   plugin->dependenciesQuantity = 0;
+   plugin->flags |= CCE_INI_CALLBACK_DEPENDENCIES_DECLARED;
+   if (dependenciesQuantity == 0)
+      return 0;
+   plugin->dependencies = malloc(dependenciesQuantity * sizeof(uint32_t));
+   if (plugin->dependencies == NULL)
+      return -1;
+   memcpy(plugin->dependencies, dependencies, dependenciesQuantity * sizeof(uint32_t));
+   plugin->dependenciesQuantity = dependenciesQuantity;
+   return 0;
+}
+
 CCE_API void cce__registerBackend (const char *lowercasename, void *data, int (*iniCallback)(void*, const char*, const char*), int (*init)(void*), int (*postInit)(void), void (*term)(void), uint8_t flags)
 {
    if (iniCallbacksQuantity > iniCallbacksAllocated)
@@ -175,6 +413,9 @@ CCE_API void cce__registerBackend (const char *lowercasename, void *data, int (*
    iniCallbacks[0].flags = flags | (-(init == NULL) & CCE_INI_CALLBACK_DO_NOT_INIT) | (-(term == NULL) & CCE_INI_CALLBACK_NO_TERMINATION_CALLBACK);
    iniCallbacks[0].init = init;
    iniCallbacks[0].postInit = postInit;
+   iniCallbacks[0].term = term;
+   iniCallbacks[0].dependencies = NULL;
+   iniCallbacks[0].dependenciesQuantity = 0;
    iniCallbacks[0].uid = cceNameToUID("window");
    if (term != NULL)
    {
@@ -195,32 +436,162 @@ CCE_API CCE_PURE_FN uint32_t cceGetFrameCurrentTime (void)
    return cce__currentTime;
 }
 
+CCE_API CCE_PURE_FN uint64_t cceGetFrameDeltaTimeNs (void)
+{
+   return cce__deltaTimeNs;
+}
+
+CCE_API CCE_PURE_FN uint64_t cceGetFrameCurrentTimeNs (void)
+{
+   return cce__currentTimeNs;
+}
+
+CCE_API void cceSetTickRate (uint16_t ticksPerSecond)
+{
+   tickRate = ticksPerSecond;
+   tickNs = (ticksPerSecond > 0) ? 1000000000u / ticksPerSecond : 0;
+   tickLagNs = 0;
+   tickInterpolation = 1.0f;
+}
+
+CCE_API CCE_PURE_FN uint16_t cceGetTickRate (void)
+{
+   return tickRate;
+}
+
+CCE_API CCE_PURE_FN uint64_t cceGetTicksQuantity (void)
+{
+   return ticksQuantity;
+}
+
+CCE_API CCE_PURE_FN float cceGetTickInterpolation (void)
+{
+   return tickInterpolation;
+}
+
+// Both clocks come from one reading, so millisecond deltas summed over frames stay equal to nanosecond ones rounded down
+static void advanceFrameTime (uint64_t currentTimeNs)
+{
+   uint32_t currentTime   = (uint32_t)(currentTimeNs / 1000000u);
+   cce__deltaTimeNs       = currentTimeNs - cce__currentTimeNs;
+   cce__currentTimeNs     = currentTimeNs;
+   cce__deltaTime         = currentTime - cce__currentTime;
+   cce__currentTime       = currentTime;
+}
+
+// With fixed timestep frame time is advanced by ticks instead
 void calculateInternalDeltaTime (void)
 {
-   uint32_t currentTime = cceGetMonotonicTime();
-   cce__deltaTime       = currentTime - cce__currentTime;
-   cce__currentTime     = currentTime;
+   uint64_t currentClockNs = cce__getReplayClock();
+   if (tickNs == 0)
+      advanceFrameTime(currentClockNs);
+   else
+      tickLagNs += currentClockNs - clockNs;
+   clockNs = currentClockNs;
+}
+
+/* Frame time as right after cceInit and no pending input, replay starts from this state. Pending changes are applied silently,
+ * connected gamepads are reported by the next cceUpdate and queued as events */
+void cce__resetFrameState (uint64_t currentClockNs)
+{
+   inputEventsFirst = inputEventsEnd;
+   buttonsBitField = 0;
+   for (uint8_t gamepad = 1; gamepad <= CCE_GAMEPADS_MAX; ++gamepad)
+   {
+      struct cce__gamepad *pad = cce__gamepads + (gamepad - 1);
+      pad->buttons ^= pad->buttonsDiff;
+      pad->buttonsDiff = 0;
+      pad->axesPairChanged = 0;
+      pad->connectionChanged = pad->connected;
+      buttonsBitField |= pad->buttons;
+      if (pad->connected)
+      {
+         const struct cce_inputevent event = {currentClockNs, 1, 0, CCE_INPUT_EVENT_CONNECTION, gamepad};
+         cce__queueInputEvent(&event);
+      }
+   }
+   for (uint8_t i = 0; i < 8u; ++i)
+      axes[i] = mergeGamepadsAxis(i);
+   cce__currentTimeNs = currentClockNs;
+   clockNs = cce__currentTimeNs;
+   cce__deltaTimeNs = cce__currentTimeNs;
+   cce__currentTime = (uint32_t)(cce__currentTimeNs / 1000000u);
+   cce__deltaTime = cce__currentTime;
+   tickLagNs = 0;
 }
 
 static void terminateEngineCommon (void)
 {
+   cce__terminateJobs();
+   cce__terminateReplay();
    cceTerminateTemporaryDirectory();
+   cce__terminateFileIO();
+   cce__terminateProfiler();
+   for (uint16_t i = 1; iniCallbacks != NULL && i < iniCallbacksQuantity; ++i)
+      free(iniCallbacks[i].dependencies);
    free(iniCallbacks);   
    free(iniCallbacksSorted);
    free(terminationCallbacks);
    iniCallbacks = NULL;
    iniCallbacksSorted = NULL;
    terminationCallbacks = NULL;
+   free(updateJobs);
+   updateJobs = NULL;
+   updateJobsAllocated = 0;
    iniCallbacksQuantity   = 1;
    iniCallbacksAllocated  = 0;
    terminationCallbacksQuantity = 1;
    terminationCallbacksAllocated = 0;
    cce__currentTime = 0;
    cce__deltaTime = 0;
+   cce__currentTimeNs = 0;
+   cce__deltaTimeNs = 0;
+   cceSetTickRate(0);
+   ticksQuantity = 0;
+   maxTicksPerUpdate = CCE_DEFAULT_MAX_TICKS_PER_UPDATE;
 }
 
 #define CCE_MEMEQ(x, y) (memcmp(x, y, strlen(y)) == 0)
 
+static uint8_t isPluginInitialized (const struct iniCallbackData *plugin)
+{
+   return ((plugin->flags & (CCE_INI_CALLBACK_DO_NOT_INIT | CCE_INI_CALLBACK_TO_BE_INITIALIZED)) == CCE_INI_CALLBACK_TO_BE_INITIALIZED) ||
+            (!ignoreUninitializedPlugins && ((plugin->flags & (CCE_INI_CALLBACK_DO_NOT_INIT)) == 0));
+}
+
+static struct pluginstage beginPluginStage (void)
+{
+   struct pluginstage stage;
+   stage.heap = cce__getHeapBytesInUse();
+   stage.time = cceGetMonotonicTimeNs();
+   return stage;
+}
+
+static void finishPluginStage (struct pluginstage *stage)
+{
+   stage->time = cceGetMonotonicTimeNs() - stage->time;
+   stage->heap = cce__getHeapBytesInUse() - stage->heap;
+}
+
+// Plugins initialized on worker threads record their stats under the lock
+static void recordPluginStage (const struct pluginstage *stage, uint16_t id, uint8_t stageIndex)
+{
+   if (id >= pluginStatsQuantity)
+      return;
+   struct cce_pluginstats *stats = pluginStats + id;
+   stats->timeNs[stageIndex] += stage->time;
+   stats->heapBytes[stageIndex] += (int64_t) stage->heap;
+   stats->iniKeys += (stageIndex == CCE_PLUGIN_STAGE_INI_CALLBACK);
+   if (stats->order[stageIndex] == CCE_PLUGIN_STAGE_NOT_RUN)
+      stats->order[stageIndex] = pluginStagesRun[stageIndex]++;
+}
+
+static void endPluginStage (struct pluginstage *stage, uint16_t id, uint8_t stageIndex)
+{
+   finishPluginStage(stage);
+   recordPluginStage(stage, id, stageIndex);
+}
+
 static int iniCallback (void *data, const char *name, const char *value)
 {
    char buf[27];
@@ -262,18 +633,38 @@ static int iniCallback (void *data, const char *name, const char *value)
       if (CCE_STREQ(it, "plugins"))
          ignoreUninitializedPlugins = cceStringToBool(value);
    }
+   else if (CCE_STREQ(buf, "logpluginstats"))
+   {
+      logPluginStats = cceStringToBool(value);
+   }
+   else if (CCE_STREQ(buf, "tickrate") || CCE_STREQ(buf, "tickspersecond") || CCE_STREQ(buf, "maxticksperupdate"))
+   {
+      char *last;
+      unsigned long number = strtoul(value, &last, 0);
+      if (value == last || number > UINT16_MAX || (number == 0 && buf[0] == 'm'))
+      {
+         fprintf(stderr, "ENGINE::INI::INVALID_TICK_RATE:\n%s is not a valid value of %s\n", value, name);
+         return 0;
+      }
+      if (buf[0] == 'm')
+         maxTicksPerUpdate = (uint16_t) number;
+      else
+         cceSetTickRate((uint16_t) number);
+   }
    return 0;
 }
 
 static int iniHandler (void *data, const char *section, const char *name, const char *value)
 {
    CCE_UNUSED(data);
-   if (section == NULL)
-      return iniCallback(iniCallbacks[commonIniCallbackID].data, name, value);
-   struct iniCallbackData tmp = {.uid = cceNameToUID(section)};
-   uint16_t id;
-   CCE_FIND_UID_FROM_ARRAY(tmp, iniCallbacks, iniCallbacksSorted, iniCallbacksQuantity, struct iniCallbackData, iniCallbackDataCmp, id, \
-                           fprintf(stderr, "ENGINE::INI_PARSE_WARNING:\nUnregistered section %s\n", section); return 1);
+   // inih passes keys before the first section with empty section name
+   uint16_t id = commonIniCallbackID;
+   if (section != NULL && *section != '\0')
+   {
+      struct iniCallbackData tmp = {.uid = cceNameToUID(section)};
+      CCE_FIND_UID_FROM_ARRAY(tmp, iniCallbacks, iniCallbacksSorted, iniCallbacksQuantity, struct iniCallbackData, iniCallbackDataCmp, id, \
+                              fprintf(stderr, "ENGINE::INI_PARSE_WARNING:\nUnregistered section %s\n", section); return 1);
+   }
    char buf[11];
    strncpy(buf, name, 11);
    cceMemoryToLowercase(buf, 10);
@@ -284,7 +675,10 @@ static int iniHandler (void *data, const char *section, const char *name, const
       return 1;
    }
    iniCallbacks[id].flags |= CCE_INI_CALLBACK_TO_BE_INITIALIZED;
-   if (iniCallbacks[id].fn(iniCallbacks[id].data, name, value) != 0)
+   struct pluginstage stage = beginPluginStage();
+   int result = iniCallbacks[id].fn(iniCallbacks[id].data, name, value);
+   endPluginStage(&stage, id, CCE_PLUGIN_STAGE_INI_CALLBACK);
+   if (result != 0)
    {
       printf("nonzero value returned by %s\n", cceUIDToName(iniCallbacks[id].uid));
       #ifdef INIH_LOCAL
@@ -296,6 +690,370 @@ static int iniHandler (void *data, const char *section, const char *name, const
    return 1;
 }
 
+/* <[Plugin initialization]>------------------------------------------------------------------- */
+
+#define PLUGIN_WAITING 0
+#define PLUGIN_RUNNING 1
+#define PLUGIN_DONE    2
+#define PLUGIN_FAILED  3
+
+#define CCE_PLUGIN_INIT_WORKERS_MAX 16u
+
+/* Plugins are initialized after the backend and the plugins they depend on. Ready plugin with the lowest index goes first,
+ * so plugins which declare nothing keep registration order (see isImplicitPluginDependency). Init of plugins flagged CCE_INI_CALLBACK_THREAD_SAFE_INIT is run
+ * by worker threads as well, the rest is run by the main thread only. Mutex is NULL when there are no workers */
+struct pluginscheduler
+{
+   struct cce__mutex *mutex;
+   struct cce__condition *condition;
+   uint16_t *dependents;      // Dependents of plugin i are dependents[dependentsBegin[i]] ... dependents[dependentsBegin[i + 1] - 1]
+   uint16_t *dependentsBegin;
+   uint16_t *waitingFor;      // Dependencies which aren't initialized yet
+   uint16_t *order;           // Plugins in order of initialization
+   uint8_t  *states;
+   uint16_t completed;
+   uint16_t running;
+   uint8_t  failed;
+   uint8_t  finished;
+};
+
+static uint8_t isPluginInitThreadSafe (const struct iniCallbackData *plugin)
+{
+   return (plugin->flags & CCE_INI_CALLBACK_THREAD_SAFE_INIT) || !isPluginInitialized(plugin);
+}
+
+/* Plugins which haven't declared their dependencies may rely on everything registered before them being initialized,
+ * so they wait for thread-safe plugins registered earlier, which may still run on workers */
+static uint8_t isImplicitPluginDependency (uint16_t plugin, uint16_t dependency)
+{
+   return dependency > 0 && dependency < plugin && !(iniCallbacks[plugin].flags & CCE_INI_CALLBACK_DEPENDENCIES_DECLARED) &&
+          (iniCallbacks[dependency].flags & CCE_INI_CALLBACK_THREAD_SAFE_INIT) && isPluginInitialized(iniCallbacks + dependency);
+}
+
+static uint16_t findPluginDependency (uint32_t uid)
+{
+   struct iniCallbackData tmp = {.uid = uid};
+   uint16_t id;
+   CCE_FIND_UID_FROM_ARRAY(tmp, iniCallbacks, iniCallbacksSorted, iniCallbacksQuantity, struct iniCallbackData, iniCallbackDataCmp, id, return UINT16_MAX);
+   return id;
+}
+
+// Walks through dependencies which aren't initialized, every plugin of such kind has one, so the walk ends up in a cycle
+static void reportPluginDependencyCycle (const uint16_t *waitingFor)
+{
+   uint16_t *visited = calloc(iniCallbacksQuantity, sizeof(uint16_t));
+   uint16_t plugin = 0, step = 0;
+   while (waitingFor[plugin] == 0)
+      ++plugin;
+   while (visited != NULL && visited[plugin] == 0)
+   {
+      visited[plugin] = ++step;
+      uint16_t next = plugin;
+      for (const uint32_t *iterator = iniCallbacks[plugin].dependencies, *end = iterator + iniCallbacks[plugin].dependenciesQuantity; iterator < end && next == plugin; ++iterator)
+      {
+         const uint16_t dependency = findPluginDependency(*iterator);
+         if (waitingFor[dependency] != 0)
+            next = dependency;
+      }
+      for (uint16_t dependency = 1; dependency < plugin && next == plugin; ++dependency)
+      {
+         if (isImplicitPluginDependency(plugin, dependency) && waitingFor[dependency] != 0)
+            next = dependency;
+      }
+      plugin = next;
+   }
+   fputs("ENGINE::INIT::PLUGIN_DEPENDENCY_CYCLE:\nplugins depend on each other:", stderr);
+   if (visited != NULL)
+   {
+      // Plugins from the first visit of the repeated one form the cycle
+      const uint16_t cycleStart = visited[plugin];
+      for (uint16_t i = cycleStart; i <= step; ++i)
+      {
+         for (uint16_t j = 0; j < iniCallbacksQuantity; ++j)
+         {
+            if (visited[j] == i)
+               fprintf(stderr, " \"%s\" ->", cceUIDToName(iniCallbacks[j].uid));
+         }
+      }
+      fprintf(stderr, " \"%s\"", cceUIDToName(iniCallbacks[plugin].uid));
+   }
+   fputc('\n', stderr);
+   free(visited);
+}
+
+static int createPluginGraph (struct pluginscheduler *scheduler)
+{
+   const uint16_t quantity = iniCallbacksQuantity;
+   uint16_t *dependenciesFound = calloc(quantity + 1u, sizeof(uint16_t));
+   scheduler->dependentsBegin  = calloc(quantity + 1u, sizeof(uint16_t));
+   scheduler->waitingFor       = calloc(quantity, sizeof(uint16_t));
+   scheduler->order            = malloc(quantity * sizeof(uint16_t));
+   scheduler->states           = calloc(quantity, sizeof(uint8_t));
+   if (dependenciesFound == NULL || scheduler->dependentsBegin == NULL || scheduler->waitingFor == NULL || scheduler->order == NULL || scheduler->states == NULL)
+   {
+      free(dependenciesFound);
+      return -1;
+   }
+   // Everything depends on the backend
+   int result = 0;
+   uint32_t edges = 0;
+   for (uint16_t i = 1; i < quantity; ++i)
+   {
+      scheduler->waitingFor[i] = 1u + iniCallbacks[i].dependenciesQuantity;
+      ++scheduler->dependentsBegin[0];
+      edges += scheduler->waitingFor[i];
+      for (const uint32_t *iterator = iniCallbacks[i].dependencies, *end = iterator + iniCallbacks[i].dependenciesQuantity; iterator < end; ++iterator)
+      {
+         const uint16_t dependency = findPluginDependency(*iterator);
+         if (dependency == UINT16_MAX || (isPluginInitialized(iniCallbacks + i) && !isPluginInitialized(iniCallbacks + dependency)))
+         {
+            char name[80];
+            strncpy(name, cceUIDToName(iniCallbacks[i].uid), sizeof(name) - 1u);
+            name[sizeof(name) - 1u] = '\0';
+            fprintf(stderr, "ENGINE::INIT::PLUGIN_DEPENDENCY_MISSING:\nplugin \"%s\" depends on plugin \"%s\", which is %s\n", name, cceUIDToName(*iterator),
+                    (dependency == UINT16_MAX) ? "not registered" : "not initialized");
+            result = -1;
+            continue;
+         }
+         ++scheduler->dependentsBegin[dependency];
+      }
+      for (uint16_t dependency = 1; dependency < i; ++dependency)
+      {
+         if (!isImplicitPluginDependency(i, dependency))
+            continue;
+         ++scheduler->waitingFor[i];
+         ++scheduler->dependentsBegin[dependency];
+         ++edges;
+      }
+   }
+   scheduler->dependents = malloc((edges + 1u) * sizeof(uint16_t));
+   if (result != 0 || scheduler->dependents == NULL || edges > UINT16_MAX)
+   {
+      free(dependenciesFound);
+      return -1;
+   }
+   // Counts become offsets
+   uint16_t offset = 0;
+   for (uint32_t i = 0; i <= quantity; ++i)
+   {
+      const uint16_t count = scheduler->dependentsBegin[i];
+      scheduler->dependentsBegin[i] = offset;
+      offset += count;
+   }
+   for (uint16_t i = 1; i < quantity; ++i)
+   {
+      scheduler->dependents[scheduler->dependentsBegin[0] + dependenciesFound[0]++] = i;
+      for (const uint32_t *iterator = iniCallbacks[i].dependencies, *end = iterator + iniCallbacks[i].dependenciesQuantity; iterator < end; ++iterator)
+      {
+         const uint16_t dependency = findPluginDependency(*iterator);
+         scheduler->dependents[scheduler->dependentsBegin[dependency] + dependenciesFound[dependency]++] = i;
+      }
+      for (uint16_t dependency = 1; dependency < i; ++dependency)
+      {
+         if (isImplicitPluginDependency(i, dependency))
+            scheduler->dependents[scheduler->dependentsBegin[dependency] + dependenciesFound[dependency]++] = i;
+      }
+   }
+   free(dependenciesFound);
+   // Cycles are found before anything is initialized: plugins which are never ready remain
+   uint16_t *waitingFor = malloc(quantity * sizeof(uint16_t)), *ready = malloc(quantity * sizeof(uint16_t));
+   uint16_t readyQuantity = 0, processed = 0;
+   if (waitingFor == NULL || ready == NULL)
+   {
+      free(waitingFor);
+      free(ready);
+      return -1;
+   }
+   memcpy(waitingFor, scheduler->waitingFor, quantity * sizeof(uint16_t));
+   ready[readyQuantity++] = 0;
+   while (readyQuantity > 0)
+   {
+      const uint16_t plugin = ready[--readyQuantity];
+      ++processed;
+      for (const uint16_t *iterator = scheduler->dependents + scheduler->dependentsBegin[plugin], *end = scheduler->dependents + scheduler->dependentsBegin[plugin + 1u];
+           iterator < end; ++iterator)
+      {
+         if (--waitingFor[*iterator] == 0)
+            ready[readyQuantity++] = *iterator;
+      }
+   }
+   if (processed < quantity)
+   {
+      reportPluginDependencyCycle(waitingFor);
+      result = -1;
+   }
+   free(waitingFor);
+   free(ready);
+   return result;
+}
+
+// Returns plugin to initialize or UINT16_MAX if none is ready. Main thread prefers plugins which can't be initialized by workers
+static uint16_t takeReadyPlugin (struct pluginscheduler *scheduler, uint8_t threadSafeOnly)
+{
+   uint16_t found = UINT16_MAX;
+   if (scheduler->failed)
+      return found;
+   for (uint16_t i = 0; i < iniCallbacksQuantity; ++i)
+   {
+      if (scheduler->states[i] != PLUGIN_WAITING || scheduler->waitingFor[i] != 0)
+         continue;
+      if (!isPluginInitThreadSafe(iniCallbacks + i))
+      {
+         if (threadSafeOnly)
+            continue;
+         found = i;
+         break;
+      }
+      if (found == UINT16_MAX)
+         found = i;
+      if (threadSafeOnly)
+         break;
+   }
+   if (found != UINT16_MAX)
+   {
+      scheduler->states[found] = PLUGIN_RUNNING;
+      ++scheduler->running;
+   }
+   return found;
+}
+
+// Called with scheduler locked, it is unlocked while init runs
+static void runPluginInit (struct pluginscheduler *scheduler, uint16_t plugin)
+{
+   struct iniCallbackData *data = iniCallbacks + plugin;
+   const uint8_t initialized = isPluginInitialized(data);
+   if (scheduler->mutex != NULL)
+      cce__unlockMutex(scheduler->mutex);
+   struct pluginstage stage = beginPluginStage();
+   int result = (initialized) ? data->init(data->data) : 0;
+   finishPluginStage(&stage);
+   if (data->flags & CCE_INI_CALLBACK_FREE_DATA)
+      free(data->data);
+   if (scheduler->mutex != NULL)
+      cce__lockMutex(scheduler->mutex);
+   if (initialized)
+      recordPluginStage(&stage, plugin, CCE_PLUGIN_STAGE_INIT);
+   --scheduler->running;
+   if (result != 0)
+   {
+      fprintf(stderr, "ENGINE::INIT::PLUGIN_INITIALIZATION_FAILURE:\nplugin \"%s\" failed to initialize\n", cceUIDToName(data->uid));
+      scheduler->states[plugin] = PLUGIN_FAILED;
+      scheduler->failed = 1;
+   }
+   else
+   {
+      scheduler->states[plugin] = PLUGIN_DONE;
+      scheduler->order[scheduler->completed++] = plugin;
+      for (const uint16_t *iterator = scheduler->dependents + scheduler->dependentsBegin[plugin], *end = scheduler->dependents + scheduler->dependentsBegin[plugin + 1u];
+           iterator < end; ++iterator)
+         --scheduler->waitingFor[*iterator];
+   }
+   if (scheduler->condition != NULL)
+      cce__broadcastCondition(scheduler->condition);
+}
+
+static void initPluginsWorker (void *data)
+{
+   struct pluginscheduler *scheduler = data;
+   cce__lockMutex(scheduler->mutex);
+   while (!scheduler->finished)
+   {
+      const uint16_t plugin = takeReadyPlugin(scheduler, 1);
+      if (plugin == UINT16_MAX)
+         cce__waitCondition(scheduler->condition, scheduler->mutex);
+      else
+         runPluginInit(scheduler, plugin);
+   }
+   cce__unlockMutex(scheduler->mutex);
+}
+
+static void freePluginScheduler (struct pluginscheduler *scheduler)
+{
+   if (scheduler->condition != NULL)
+      cce__freeCondition(scheduler->condition);
+   if (scheduler->mutex != NULL)
+      cce__freeMutex(scheduler->mutex);
+   free(scheduler->dependents);
+   free(scheduler->dependentsBegin);
+   free(scheduler->waitingFor);
+   free(scheduler->states);
+}
+
+/* Returns plugins in order of initialization, on failure everything initialized is terminated (in reverse order), engine too, and NULL is returned */
+static uint16_t* initPlugins (void)
+{
+   struct pluginscheduler scheduler = {0};
+   struct cce__thread *workers[CCE_PLUGIN_INIT_WORKERS_MAX];
+   uint16_t workersQuantity = 0;
+   if (createPluginGraph(&scheduler) != 0)
+   {
+      scheduler.failed = 1;
+   }
+   else
+   {
+      uint16_t threadSafeQuantity = 0;
+      for (uint16_t i = 0; i < iniCallbacksQuantity; ++i)
+         threadSafeQuantity += isPluginInitialized(iniCallbacks + i) && (iniCallbacks[i].flags & CCE_INI_CALLBACK_THREAD_SAFE_INIT);
+      // Main thread initializes plugins as well
+      const uint32_t threadsQuantity = cce__getHardwareThreadsQuantity() - 1u;
+      workersQuantity = CCE_MIN(CCE_MIN(threadsQuantity, threadSafeQuantity), CCE_PLUGIN_INIT_WORKERS_MAX);
+      if (workersQuantity > 0)
+      {
+         scheduler.mutex = cce__createMutex();
+         scheduler.condition = cce__createCondition();
+         if (scheduler.mutex == NULL || scheduler.condition == NULL)
+            workersQuantity = 0;
+      }
+      for (uint16_t i = 0; i < workersQuantity; ++i)
+      {
+         workers[i] = cce__createThread(initPluginsWorker, &scheduler);
+         if (workers[i] == NULL)
+            workersQuantity = i;
+      }
+   }
+   if (scheduler.mutex != NULL)
+      cce__lockMutex(scheduler.mutex);
+   while (scheduler.failed ? scheduler.running > 0 : scheduler.completed < iniCallbacksQuantity)
+   {
+      const uint16_t plugin = takeReadyPlugin(&scheduler, 0);
+      if (plugin != UINT16_MAX)
+         runPluginInit(&scheduler, plugin);
+      else if (workersQuantity > 0)
+         cce__waitCondition(scheduler.condition, scheduler.mutex);
+      else
+         break; // Unreachable: graph has no cycles, so something is ready when nothing runs
+   }
+   scheduler.finished = 1;
+   if (scheduler.mutex != NULL)
+   {
+      cce__broadcastCondition(scheduler.condition);
+      cce__unlockMutex(scheduler.mutex);
+   }
+   for (uint16_t i = 0; i < workersQuantity; ++i)
+      cce__joinThread(workers[i]);
+   if (!scheduler.failed && scheduler.completed == iniCallbacksQuantity)
+   {
+      freePluginScheduler(&scheduler);
+      return scheduler.order;
+   }
+   // Failed plugin isn't terminated, plugins which haven't been reached still own their data
+   for (uint16_t i = 0; i < iniCallbacksQuantity; ++i)
+   {
+      if ((scheduler.states == NULL || scheduler.states[i] == PLUGIN_WAITING) && (iniCallbacks[i].flags & CCE_INI_CALLBACK_FREE_DATA))
+         free(iniCallbacks[i].data);
+   }
+   while (scheduler.completed > 0)
+   {
+      const struct iniCallbackData *plugin = iniCallbacks + scheduler.order[--scheduler.completed];
+      if (!(plugin->flags & CCE_INI_CALLBACK_NO_TERMINATION_CALLBACK))
+         plugin->term();
+   }
+   free(scheduler.order);
+   freePluginScheduler(&scheduler);
+   terminateEngineCommon();
+   return NULL;
+}
+
 static int parseGameINI (const char *path)
 {
    int result = 0;
@@ -308,6 +1066,17 @@ static int parseGameINI (const char *path)
       iniCallbacksSorted[i] = iniCallbacksSorted[i-1] + 1;
    }
    qsort(iniCallbacksSorted, iniCallbacksQuantity, sizeof(struct iniCallbackData*), iniCallbackDataCmp);
+   free(pluginStats);
+   pluginStats = calloc(iniCallbacksQuantity, sizeof(struct cce_pluginstats));
+   pluginStatsQuantity = (pluginStats != NULL) ? iniCallbacksQuantity : 0;
+   for (uint16_t i = 0; i < pluginStatsQuantity; ++i)
+   {
+      pluginStats[i].uid = (uint32_t) iniCallbacks[i].uid;
+      for (uint8_t stage = 0; stage < CCE_PLUGIN_STAGES_QUANTITY; ++stage)
+         pluginStats[i].order[stage] = CCE_PLUGIN_STAGE_NOT_RUN;
+   }
+   for (uint8_t stage = 0; stage < CCE_PLUGIN_STAGES_QUANTITY; ++stage)
+      pluginStagesRun[stage] = 0;
    FILE* file = fopen(path, "r");
    if (file == NULL)
    {
@@ -320,63 +1089,33 @@ static int parseGameINI (const char *path)
    if (ini_parse_file(file, iniHandler, NULL) == 0)
 #endif
    {
-      uint16_t termsIgnored = 0;
-      uint16_t termLastIgnored = 0;
-      for (uint16_t i = 0, j = 0; i < iniCallbacksQuantity; ++i)
+      uint16_t *order = initPlugins();
+      result = -(order == NULL);
+      if (order != NULL)
       {
-         if ((iniCallbacks[i].flags & (CCE_INI_CALLBACK_DO_NOT_INIT | CCE_INI_CALLBACK_TO_BE_INITIALIZED)) == CCE_INI_CALLBACK_TO_BE_INITIALIZED)
-            result = iniCallbacks[i].init(iniCallbacks[i].data);
-         else if (!ignoreUninitializedPlugins && ((iniCallbacks[i].flags & (CCE_INI_CALLBACK_DO_NOT_INIT)) == 0))
-            result = iniCallbacks[i].init(iniCallbacks[i].data);
-         else if (!(iniCallbacks[i].flags & CCE_INI_CALLBACK_NO_TERMINATION_CALLBACK) && termsIgnored != 0)
+         // Plugins are terminated in reverse order of their initialization
+         uint16_t terminationCallbacksOrdered = 0;
+         for (const uint16_t *iterator = order, *end = order + iniCallbacksQuantity; iterator < end; ++iterator)
          {
-            if (termsIgnored > 0)
-            {
-               memmove(terminationCallbacks + termLastIgnored + 1 - termsIgnored, terminationCallbacks + termLastIgnored + 1, j - termLastIgnored - 1);
-            }
-            terminationCallbacks[j] = NULL;
-            ++termsIgnored;
-            termLastIgnored = j;
+            if (!(iniCallbacks[*iterator].flags & CCE_INI_CALLBACK_NO_TERMINATION_CALLBACK))
+               terminationCallbacks[terminationCallbacksOrdered++] = iniCallbacks[*iterator].term;
          }
-         if (iniCallbacks[i].flags & CCE_INI_CALLBACK_FREE_DATA)
-            free(iniCallbacks[i].data);
-         j += !(iniCallbacks[i].flags & CCE_INI_CALLBACK_NO_TERMINATION_CALLBACK);
-         if (result == 0)
-            continue;
-         fprintf(stderr, "ENGINE::INIT::PLUGIN_INITIALIZATION_FAILURE:\nplugin \"%s\" failed to initialize\n", cceUIDToName(iniCallbacks[i].uid));
-         for (; i < iniCallbacksQuantity; ++i)
+         terminationCallbacksQuantity = terminationCallbacksOrdered;
+         for (const uint16_t *iterator = order, *end = order + iniCallbacksQuantity; iterator < end; ++iterator)
          {
-            if (iniCallbacks[i].flags & CCE_INI_CALLBACK_FREE_DATA)
-               free(iniCallbacks[i].data);
-         }
-         --j;
-         while (j > 0)
-         {
-            --j;
-            if (terminationCallbacks[j] != NULL)
-               terminationCallbacks[j]();
-         }
-         terminateEngineCommon();
-         return -1;
-      }
-      if (termsIgnored != 0)
-      {
-         memmove(terminationCallbacks + termLastIgnored + 1 - termsIgnored, terminationCallbacks + termLastIgnored + 1, terminationCallbacksQuantity - termLastIgnored - 1);
-         terminationCallbacksQuantity -= termsIgnored;
-         terminationCallbacks = realloc(terminationCallbacks, terminationCallbacksQuantity * sizeof(cce_termfun));
-      }
-      for (uint16_t i = 0; i < iniCallbacksQuantity; ++i)
-      {
-         if (iniCallbacks[i].postInit == NULL)
-            continue;
-         if ((iniCallbacks[i].flags & (CCE_INI_CALLBACK_DO_NOT_INIT | CCE_INI_CALLBACK_TO_BE_INITIALIZED)) == CCE_INI_CALLBACK_TO_BE_INITIALIZED)
+            const uint16_t i = *iterator;
+            if (iniCallbacks[i].postInit == NULL || !isPluginInitialized(iniCallbacks + i))
+               continue;
+            struct pluginstage stage = beginPluginStage();
             result = iniCallbacks[i].postInit();
-         else if (!ignoreUninitializedPlugins && ((iniCallbacks[i].flags & (CCE_INI_CALLBACK_DO_NOT_INIT)) == 0))
-            result = iniCallbacks[i].postInit();
-         if (result == 0)
-            continue;
-         fprintf(stderr, "ENGINE::INIT::PLUGIN_INITIALIZATION_FAILURE:\nplugin \"%s\" failed to post initialize\n", cceUIDToName(iniCallbacks[i].uid));
-         cceTerminate();
+            endPluginStage(&stage, i, CCE_PLUGIN_STAGE_POSTINIT);
+            if (result == 0)
+               continue;
+            fprintf(stderr, "ENGINE::INIT::PLUGIN_INITIALIZATION_FAILURE:\nplugin \"%s\" failed to post initialize\n", cceUIDToName(iniCallbacks[i].uid));
+            cceTerminate();
+            break;
+         }
+         free(order);
       }
    }
    else
@@ -408,11 +1147,31 @@ CCE_API CCE_PURE_FN uint8_t cceIsPluginLoading (uint32_t uid)
    struct iniCallbackData tmp = {.uid = uid};
    uint16_t id;
    CCE_FIND_UID_FROM_ARRAY(tmp, iniCallbacks, iniCallbacksSorted, iniCallbacksQuantity, struct iniCallbackData, iniCallbackDataCmp, id, return 0);
-   return ((iniCallbacks[id].flags & (CCE_INI_CALLBACK_DO_NOT_INIT | CCE_INI_CALLBACK_TO_BE_INITIALIZED)) == CCE_INI_CALLBACK_TO_BE_INITIALIZED) ||
-            (!ignoreUninitializedPlugins && ((iniCallbacks[id].flags & (CCE_INI_CALLBACK_DO_NOT_INIT)) == 0));
+   return isPluginInitialized(iniCallbacks + id);
 }
 
 void loadBackend__glfw (void);
+void loadBackend__null (void);
+
+static void (*g_loadBackend)(void) = loadBackend__glfw;
+
+CCE_API int cceSetBackend (const char *lowercasename)
+{
+   if (strcmp(lowercasename, "glfw") == 0)
+   {
+      g_loadBackend = loadBackend__glfw;
+   }
+   else if (strcmp(lowercasename, "null") == 0 || strcmp(lowercasename, "headless") == 0)
+   {
+      g_loadBackend = loadBackend__null;
+   }
+   else
+   {
+      fprintf(stderr, "ENGINE::BACKEND::UNKNOWN_BACKEND:\n%s is not supported, backend is not changed\n", lowercasename);
+      return -1;
+   }
+   return 0;
+}
 
 CCE_API int cceInit (const char *gameINIpath)
 {
@@ -441,59 +1200,190 @@ CCE_API int cceInit (const char *gameINIpath)
    moveCallbacks[2] = NULL;
    moveCallbacks[3] = NULL;
    buttonsCallback  = NULL;
-   cce__buttonsBitField = 0;
-   cce__buttonsBitFieldDiff = 0;
+   for (uint8_t i = 0; i < 4u; ++i)
+      gamepadMoveCallbacks[i] = NULL;
+   gamepadButtonsCallback = NULL;
+   gamepadConnectionCallback = NULL;
+   memset(cce__gamepads, 0, sizeof(cce__gamepads));
+   buttonsBitField = 0;
+   memset(axes, 0, sizeof(axes));
+   inputEventsFirst = inputEventsEnd = 0;
    ignoreUninitializedPlugins = 0;
-   // We have only one backend yet
-   loadBackend__glfw();
+   logPluginStats = 0;
+   cceSetCollisionBatchImplementation(CCE_COLLISION_BATCH_AUTO);
+   {
+      char *backend = getenv("CCE_BACKEND");
+      if (backend != NULL && *backend != '\0')
+         cceSetBackend(backend);
+   }
+   g_loadBackend();
    
    int status = parseGameINI(gameINIpath);
    if (pathFree)
       free((void*)gameINIpath);
    if (status != 0)
        return status;
-   cce__currentTime = cceGetMonotonicTime();
-   cce__deltaTime = cce__currentTime;
+   cce__resetFrameState(cce__getReplayTimeNs());
    return 0;
 }
 
+static void runUpdateCallback (void *data)
+{
+   struct updateCallbackData *callback = data;
+   // Id is the index of the callback in registration order
+   CCE_PROFILE_SCOPE_ID("updateCallback", (uint32_t)(callback - updateCallbacks)) callback->fn();
+}
+
+// The last callback of the batch runs on the main thread instead of waiting idle
+static void runUpdateJobs (void)
+{
+   if (updateJobsQuantity == 0)
+      return;
+   struct cce_jobcounter counter = {0};
+   cceSubmitJobs(updateJobs, updateJobsQuantity - 1u, &counter);
+   runUpdateCallback(updateJobs[updateJobsQuantity - 1u].data);
+   cceWaitForJobCounter(&counter);
+   updateJobsQuantity = 0;
+}
+
+static void runUpdateCallbacks (void)
+{
+   /* Parallel callbacks are batched in registration order until one conflicts with the batch (writes what it reads or writes,
+    * or reads what it writes), ordinary callbacks access everything - they run alone between batches */
+   uint64_t batchReadSet = 0, batchWriteSet = 0;
+   for (struct updateCallbackData *it = updateCallbacks, *end = updateCallbacks + updateCallbacksQuantity; it < end; ++it)
+   {
+      if (!(it->flags & CCE_CALLBACK_ENABLED))
+         continue;
+      if (!(it->flags & CCE_CALLBACK_PARALLEL) || (it->writeSet & (batchReadSet | batchWriteSet)) || (it->readSet & batchWriteSet))
+      {
+         runUpdateJobs();
+         batchReadSet = batchWriteSet = 0;
+      }
+      if (!(it->flags & CCE_CALLBACK_PARALLEL))
+      {
+         runUpdateCallback(it);
+         continue;
+      }
+      if (updateJobsQuantity >= updateJobsAllocated)
+         CCE_REALLOC_ARRAY(updateJobs, updateJobsQuantity + 1);
+      updateJobs[updateJobsQuantity++] = (struct cce_job){runUpdateCallback, it};
+      batchReadSet  |= it->readSet;
+      batchWriteSet |= it->writeSet;
+   }
+   runUpdateJobs();
+}
+
+// Lag above the catch-up limit is dropped, otherwise slow ticks would make every next frame run even more of them
+static void runTicks (void)
+{
+   uint64_t ticks = tickLagNs / tickNs;
+   if (ticks > maxTicksPerUpdate)
+   {
+      ticks = maxTicksPerUpdate;
+      tickLagNs %= tickNs;
+   }
+   else
+   {
+      tickLagNs -= ticks * tickNs;
+   }
+   const uint64_t frameStartNs = cce__currentTimeNs;
+   const uint32_t frameStart = cce__currentTime;
+   for (uint32_t i = 0; i < ticks; ++i)
+   {
+      ++ticksQuantity;
+      advanceFrameTime(cce__currentTimeNs + tickNs);
+      CCE_PROFILE_SCOPE_ID("tick", i) runUpdateCallbacks();
+   }
+   // After cceUpdate frame delta covers all ticks, as frame-based code (e.g. delayed actions) expects
+   cce__deltaTimeNs = cce__currentTimeNs - frameStartNs;
+   cce__deltaTime   = cce__currentTime - frameStart;
+   tickInterpolation = (float) tickLagNs / (float) tickNs;
+}
+
 CCE_API void cceUpdate (void)
 {
-   cce__engineBackend.engineUpdate();
-   calculateInternalDeltaTime();
-   if (cce__buttonsBitFieldDiff != 0)
+   CCE_PROFILE_BEGIN(updateZone);
+   if (cce__replayMode == CCE_REPLAY_PLAYING)
    {
-      cce__buttonsBitField ^= cce__buttonsBitFieldDiff;
-      if (buttonsCallback != NULL)
-         buttonsCallback(cce__buttonsBitField, cce__buttonsBitFieldDiff);
-      cce__buttonsBitFieldDiff = 0;
+      // Backend still processes window events, but input it reports is replaced with the recorded one
+      struct cce__gamepad gamepads[CCE_GAMEPADS_MAX];
+      memcpy(gamepads, cce__gamepads, sizeof(gamepads));
+      void (*keyCallback)(cce_enum, cce_enum) = cce__keyCallback;
+      cce__keyCallback = NULL;
+      CCE_PROFILE_SCOPE("engineUpdate") cce__engineBackend.engineUpdate();
+      cce__keyCallback = keyCallback;
+      memcpy(cce__gamepads, gamepads, sizeof(gamepads));
+      CCE_PROFILE_SCOPE("playInputEvents") cce__playInputEvents();
    }
-   if (cce__axesPairChanged != 0)
+   else
    {
-      void (**moveCallbackIt)(int8_t, int8_t) = moveCallbacks;
-      for (int8_t *it = cce__axes, *end = cce__axes + 8; it < end; it += 2, ++moveCallbackIt, cce__axesPairChanged >>= 1)
-         if ((cce__axesPairChanged & 1) && *moveCallbackIt != NULL)
-            (*moveCallbackIt)(it[0], it[1]);
+      CCE_PROFILE_SCOPE("engineUpdate") cce__engineBackend.engineUpdate();
    }
-   for (struct updateCallbackData *it = updateCallbacks, *end = updateCallbacks + updateCallbacksQuantity; it < end; ++it)
+   CCE_PROFILE_SCOPE("calculateInternalDeltaTime") calculateInternalDeltaTime();
+   applyGamepadsInput();
+   if (tickNs == 0)
+      runUpdateCallbacks();
+   else
+      runTicks();
+   CCE_PROFILE_END(updateZone, "cceUpdate");
+}
+
+// Termination callbacks don't keep plugin they belong to, it's found by the callback
+static uint16_t findTerminatingPlugin (cce_termfun term)
+{
+   for (uint16_t i = 0; i < iniCallbacksQuantity; ++i)
    {
-      if (it->flags & CCE_CALLBACK_ENABLED)
-         it->fn();
+      if (iniCallbacks[i].term == term)
+         return i;
    }
+   return UINT16_MAX;
 }
 
 CCE_API void cceTerminate (void)
 {
+   cce__terminateJobs(); // Queued jobs may use plugins, so they're finished first
    cce_termfun *it = terminationCallbacks + terminationCallbacksQuantity; // from last to first
    do
    {
       --it;
+      struct pluginstage stage = beginPluginStage();
       (*it)();
+      endPluginStage(&stage, findTerminatingPlugin(*it), CCE_PLUGIN_STAGE_TERMINATE);
    }
    while (it > terminationCallbacks);
+   if (logPluginStats)
+      cceLogPluginStats();
    terminateEngineCommon();
 }
 
+CCE_API const struct cce_pluginstats* cceGetPluginStats (uint16_t *quantity)
+{
+   *quantity = pluginStatsQuantity;
+   return pluginStats;
+}
+
+CCE_API void cceLogPluginStats (void)
+{
+   static const char *const stageNames[CCE_PLUGIN_STAGES_QUANTITY] = {"ini callback", "init", "postinit", "terminate"};
+   puts("ENGINE::PLUGIN_STATS:\nplugin                order  stage          time, ms  process-wide heap change, bytes");
+   for (const struct cce_pluginstats *stats = pluginStats, *end = pluginStats + pluginStatsQuantity; stats < end; ++stats)
+   {
+      // Backend is registered under "window" section, its name is more telling
+      const char *name = (stats == pluginStats && cceBackend != NULL) ? cceBackend : cceUIDToName(stats->uid);
+      for (uint8_t stage = 0; stage < CCE_PLUGIN_STAGES_QUANTITY; ++stage)
+      {
+         if (stats->order[stage] == CCE_PLUGIN_STAGE_NOT_RUN)
+            continue;
+         printf("%-21s %5u  %-12s %10.3f %+32lld", name, (unsigned) stats->order[stage], stageNames[stage],
+                (double) stats->timeNs[stage] / 1000000.0, (long long) stats->heapBytes[stage]);
+         if (stage == CCE_PLUGIN_STAGE_INI_CALLBACK)
+            printf("  (%u keys)", (unsigned) stats->iniKeys);
+         putchar('\n');
+      }
+   }
+}
+
 /* <[Color conversions]>------------------------------------------------------------------------- */
 
 #define HSV_TO_RGB(color, result, chromaInit, chromaExp, lightnessExp) \
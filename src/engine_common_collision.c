@@ -0,0 +1,585 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/cce/engine_common.h"
+#include "../include/cce/utils.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CCE_BATCH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CCE_BATCH_AVX2 1
+#define CCE_TARGET_AVX2 __attribute__ ((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define CCE_BATCH_AVX2 1
+#define CCE_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define CCE_BATCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Every kernel processes whole blocks of its width starting from 0, sets bits of mask (which is zeroed beforehand) and returns
+ * quantity of processed elements. The rest is processed by scalar kernel. Circle checks use doubles on SIMD paths: all
+ * intermediate values are below 2^40, so they are exact and match 64-bit integer scalar path */
+
+struct cce_collisionbatchfuns
+{
+   uint32_t (*rect2D)(struct cce_collider_rect2D_16_16, const struct cce_rect2Dbatch_16_16*, uint32_t, uint32_t*);
+   uint32_t (*cir2D)(struct cce_collider_cir2D_16_16, const struct cce_cir2Dbatch_16_16*, uint32_t, uint32_t*);
+   uint32_t (*cirRect2D)(struct cce_collider_cir2D_16_16, const struct cce_rect2Dbatch_16_16*, uint32_t, uint32_t*);
+   uint32_t (*rectCir2D)(struct cce_collider_rect2D_16_16, const struct cce_cir2Dbatch_16_16*, uint32_t, uint32_t*);
+};
+
+/* Scalar */
+
+static inline uint8_t rect2DElement (struct cce_collider_rect2D_16_16 rect, const struct cce_rect2Dbatch_16_16 *batch, uint32_t i)
+{
+   const struct cce_collider_rect2D_16_16 other = {{batch->positionX[i], batch->positionY[i]}, {batch->sizeX[i], batch->sizeY[i]}};
+   return cceCheckCollisionRect2D(rect, other);
+}
+
+static inline uint8_t cir2DElement (struct cce_collider_cir2D_16_16 circle, const struct cce_cir2Dbatch_16_16 *batch, uint32_t i)
+{
+   const int64_t dx = (int32_t) circle.position.x - batch->positionX[i], dy = (int32_t) circle.position.y - batch->positionY[i];
+   const int64_t diameters = (int32_t) circle.diameter + batch->diameter[i];
+   return (dx * dx + dy * dy) * 4 < diameters * diameters;
+}
+
+static inline int64_t circleRectDistanceSq (int32_t center, int32_t position, int32_t size)
+{
+   const int64_t distance = center - CCE_CLAMP(center, position * 2, (position + size) * 2);
+   return distance * distance;
+}
+
+// Same as cceCheckCollisionCirRect2D
+static inline uint8_t cirRect2D (int32_t positionX, int32_t positionY, int32_t diameter, int32_t rectX, int32_t rectY, int32_t sizeX, int32_t sizeY)
+{
+   return circleRectDistanceSq(positionX * 2 + diameter, rectX, sizeX) + circleRectDistanceSq(positionY * 2 + diameter, rectY, sizeY) < (int64_t) diameter * diameter;
+}
+
+static inline uint8_t cirRect2DElement (struct cce_collider_cir2D_16_16 circle, const struct cce_rect2Dbatch_16_16 *batch, uint32_t i)
+{
+   return cirRect2D(circle.position.x, circle.position.y, circle.diameter, batch->positionX[i], batch->positionY[i], batch->sizeX[i], batch->sizeY[i]);
+}
+
+static inline uint8_t rectCir2DElement (struct cce_collider_rect2D_16_16 rect, const struct cce_cir2Dbatch_16_16 *batch, uint32_t i)
+{
+   return cirRect2D(batch->positionX[i], batch->positionY[i], batch->diameter[i], rect.position.x, rect.position.y, rect.size.x, rect.size.y);
+}
+
+#define SCALAR_BATCH(name, Name, colliderType, batchType) \
+static uint32_t batch ## Name ## __scalar (struct colliderType collider, const struct batchType *batch, uint32_t quantity, uint32_t *mask) \
+{ \
+   for (uint32_t i = 0; i < quantity; ++i) \
+      mask[i >> 5] |= (uint32_t) name ## Element(collider, batch, i) << (i & 31); \
+   return quantity; \
+}
+
+SCALAR_BATCH(rect2D,    Rect2D,    cce_collider_rect2D_16_16, cce_rect2Dbatch_16_16)
+SCALAR_BATCH(cir2D,     Cir2D,     cce_collider_cir2D_16_16,  cce_cir2Dbatch_16_16)
+SCALAR_BATCH(cirRect2D, CirRect2D, cce_collider_cir2D_16_16,  cce_rect2Dbatch_16_16)
+SCALAR_BATCH(rectCir2D, RectCir2D, cce_collider_rect2D_16_16, cce_cir2Dbatch_16_16)
+
+// Set only by cceSetCollisionBatchImplementation (called by cceInit), so batch checks on other threads never write it
+static struct cce_collisionbatchfuns g_batchFunctions = {batchRect2D__scalar, batchCir2D__scalar, batchCirRect2D__scalar, batchRectCir2D__scalar};
+
+/* SSE2, 8 elements per iteration */
+
+#ifdef CCE_BATCH_SSE2
+#define SSE2_I16_LO(v) _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)
+#define SSE2_I16_HI(v) _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)
+#define SSE2_U16_LO(v) _mm_unpacklo_epi16(v, _mm_setzero_si128())
+#define SSE2_U16_HI(v) _mm_unpackhi_epi16(v, _mm_setzero_si128())
+#define SSE2_LOAD(ptr, i) _mm_loadu_si128((const __m128i*)((ptr) + (i)))
+
+static inline uint32_t rect4__sse2 (__m128i minX, __m128i minY, __m128i maxX, __m128i maxY, __m128i x, __m128i y, __m128i sizeX, __m128i sizeY)
+{
+   // minX < x + sizeX && maxX > x, same for y
+   __m128i result = _mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(x, sizeX), minX), _mm_cmpgt_epi32(maxX, x));
+   result = _mm_and_si128(result, _mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(y, sizeY), minY), _mm_cmpgt_epi32(maxY, y)));
+   return (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(result));
+}
+
+static uint32_t batchRect2D__sse2 (struct cce_collider_rect2D_16_16 rect, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m128i minX = _mm_set1_epi32(rect.position.x), minY = _mm_set1_epi32(rect.position.y);
+   const __m128i maxX = _mm_set1_epi32(rect.position.x + rect.size.x), maxY = _mm_set1_epi32(rect.position.y + rect.size.y);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const __m128i x = SSE2_LOAD(batch->positionX, i), y = SSE2_LOAD(batch->positionY, i);
+      const __m128i sizeX = SSE2_LOAD(batch->sizeX, i), sizeY = SSE2_LOAD(batch->sizeY, i);
+      uint32_t bits = rect4__sse2(minX, minY, maxX, maxY, SSE2_I16_LO(x), SSE2_I16_LO(y), SSE2_U16_LO(sizeX), SSE2_U16_LO(sizeY));
+      bits |= rect4__sse2(minX, minY, maxX, maxY, SSE2_I16_HI(x), SSE2_I16_HI(y), SSE2_U16_HI(sizeX), SSE2_U16_HI(sizeY)) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+// 4 int32 lanes -> 4 bits of (dx^2 + dy^2) * scale < limit^2, computed as 2 pairs of doubles
+static inline uint32_t distanceLess4__sse2 (__m128i dx, __m128i dy, __m128d scale, __m128i limit)
+{
+   uint32_t bits = 0;
+   for (uint8_t half = 0; half < 2; ++half)
+   {
+      const __m128d x = _mm_cvtepi32_pd(dx), y = _mm_cvtepi32_pd(dy), l = _mm_cvtepi32_pd(limit);
+      const __m128d distance = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)), scale);
+      bits |= (uint32_t) _mm_movemask_pd(_mm_cmplt_pd(distance, _mm_mul_pd(l, l))) << (half * 2);
+      dx = _mm_shuffle_epi32(dx, 0xEE);
+      dy = _mm_shuffle_epi32(dy, 0xEE);
+      limit = _mm_shuffle_epi32(limit, 0xEE);
+   }
+   return bits;
+}
+
+static uint32_t batchCir2D__sse2 (struct cce_collider_cir2D_16_16 circle, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m128i positionX = _mm_set1_epi32(circle.position.x), positionY = _mm_set1_epi32(circle.position.y);
+   const __m128i diameter = _mm_set1_epi32(circle.diameter);
+   const __m128d scale = _mm_set1_pd(4.0);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const __m128i x = SSE2_LOAD(batch->positionX, i), y = SSE2_LOAD(batch->positionY, i), d = SSE2_LOAD(batch->diameter, i);
+      uint32_t bits = distanceLess4__sse2(_mm_sub_epi32(positionX, SSE2_I16_LO(x)), _mm_sub_epi32(positionY, SSE2_I16_LO(y)), scale,
+                                          _mm_add_epi32(diameter, SSE2_U16_LO(d)));
+      bits |= distanceLess4__sse2(_mm_sub_epi32(positionX, SSE2_I16_HI(x)), _mm_sub_epi32(positionY, SSE2_I16_HI(y)), scale,
+                                  _mm_add_epi32(diameter, SSE2_U16_HI(d))) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+// Doubled circle center is clamped to doubled rectangle, as in cceCheckCollisionCirRect2D
+static inline uint32_t cirRect4__sse2 (__m128i centerX, __m128i centerY, __m128i diameter, __m128i minX, __m128i minY, __m128i maxX, __m128i maxY)
+{
+   uint32_t bits = 0;
+   for (uint8_t half = 0; half < 2; ++half)
+   {
+      const __m128d cx = _mm_cvtepi32_pd(centerX), cy = _mm_cvtepi32_pd(centerY), d = _mm_cvtepi32_pd(diameter);
+      const __m128d dx = _mm_sub_pd(cx, _mm_min_pd(_mm_max_pd(cx, _mm_cvtepi32_pd(minX)), _mm_cvtepi32_pd(maxX)));
+      const __m128d dy = _mm_sub_pd(cy, _mm_min_pd(_mm_max_pd(cy, _mm_cvtepi32_pd(minY)), _mm_cvtepi32_pd(maxY)));
+      const __m128d distance = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+      bits |= (uint32_t) _mm_movemask_pd(_mm_cmplt_pd(distance, _mm_mul_pd(d, d))) << (half * 2);
+      centerX = _mm_shuffle_epi32(centerX, 0xEE);
+      centerY = _mm_shuffle_epi32(centerY, 0xEE);
+      diameter = _mm_shuffle_epi32(diameter, 0xEE);
+      minX = _mm_shuffle_epi32(minX, 0xEE);
+      minY = _mm_shuffle_epi32(minY, 0xEE);
+      maxX = _mm_shuffle_epi32(maxX, 0xEE);
+      maxY = _mm_shuffle_epi32(maxY, 0xEE);
+   }
+   return bits;
+}
+
+static uint32_t batchCirRect2D__sse2 (struct cce_collider_cir2D_16_16 circle, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m128i centerX = _mm_set1_epi32(circle.position.x * 2 + circle.diameter), centerY = _mm_set1_epi32(circle.position.y * 2 + circle.diameter);
+   const __m128i diameter = _mm_set1_epi32(circle.diameter);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const __m128i x = SSE2_LOAD(batch->positionX, i), y = SSE2_LOAD(batch->positionY, i);
+      const __m128i sizeX = SSE2_LOAD(batch->sizeX, i), sizeY = SSE2_LOAD(batch->sizeY, i);
+      __m128i minX = SSE2_I16_LO(x), minY = SSE2_I16_LO(y);
+      uint32_t bits = cirRect4__sse2(centerX, centerY, diameter, _mm_add_epi32(minX, minX), _mm_add_epi32(minY, minY),
+                                     _mm_slli_epi32(_mm_add_epi32(minX, SSE2_U16_LO(sizeX)), 1), _mm_slli_epi32(_mm_add_epi32(minY, SSE2_U16_LO(sizeY)), 1));
+      minX = SSE2_I16_HI(x);
+      minY = SSE2_I16_HI(y);
+      bits |= cirRect4__sse2(centerX, centerY, diameter, _mm_add_epi32(minX, minX), _mm_add_epi32(minY, minY),
+                             _mm_slli_epi32(_mm_add_epi32(minX, SSE2_U16_HI(sizeX)), 1), _mm_slli_epi32(_mm_add_epi32(minY, SSE2_U16_HI(sizeY)), 1)) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+static uint32_t batchRectCir2D__sse2 (struct cce_collider_rect2D_16_16 rect, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m128i minX = _mm_set1_epi32(rect.position.x * 2), minY = _mm_set1_epi32(rect.position.y * 2);
+   const __m128i maxX = _mm_set1_epi32((rect.position.x + rect.size.x) * 2), maxY = _mm_set1_epi32((rect.position.y + rect.size.y) * 2);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const __m128i x = SSE2_LOAD(batch->positionX, i), y = SSE2_LOAD(batch->positionY, i), d = SSE2_LOAD(batch->diameter, i);
+      __m128i diameter = SSE2_U16_LO(d);
+      uint32_t bits = cirRect4__sse2(_mm_add_epi32(_mm_slli_epi32(SSE2_I16_LO(x), 1), diameter), _mm_add_epi32(_mm_slli_epi32(SSE2_I16_LO(y), 1), diameter),
+                                     diameter, minX, minY, maxX, maxY);
+      diameter = SSE2_U16_HI(d);
+      bits |= cirRect4__sse2(_mm_add_epi32(_mm_slli_epi32(SSE2_I16_HI(x), 1), diameter), _mm_add_epi32(_mm_slli_epi32(SSE2_I16_HI(y), 1), diameter),
+                             diameter, minX, minY, maxX, maxY) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+#endif // CCE_BATCH_SSE2
+
+/* AVX2, 16 elements per iteration */
+
+#ifdef CCE_BATCH_AVX2
+#define AVX2_I16(v, half) _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, half))
+#define AVX2_U16(v, half) _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, half))
+#define AVX2_LOAD(ptr, i) _mm256_loadu_si256((const __m256i*)((ptr) + (i)))
+
+static inline CCE_TARGET_AVX2 uint32_t rect8__avx2 (__m256i minX, __m256i minY, __m256i maxX, __m256i maxY, __m256i x, __m256i y, __m256i sizeX, __m256i sizeY)
+{
+   __m256i result = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(x, sizeX), minX), _mm256_cmpgt_epi32(maxX, x));
+   result = _mm256_and_si256(result, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(y, sizeY), minY), _mm256_cmpgt_epi32(maxY, y)));
+   return (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(result));
+}
+
+static CCE_TARGET_AVX2 uint32_t batchRect2D__avx2 (struct cce_collider_rect2D_16_16 rect, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m256i minX = _mm256_set1_epi32(rect.position.x), minY = _mm256_set1_epi32(rect.position.y);
+   const __m256i maxX = _mm256_set1_epi32(rect.position.x + rect.size.x), maxY = _mm256_set1_epi32(rect.position.y + rect.size.y);
+   const uint32_t end = quantity & ~15u;
+   for (uint32_t i = 0; i < end; i += 16)
+   {
+      const __m256i x = AVX2_LOAD(batch->positionX, i), y = AVX2_LOAD(batch->positionY, i);
+      const __m256i sizeX = AVX2_LOAD(batch->sizeX, i), sizeY = AVX2_LOAD(batch->sizeY, i);
+      uint32_t bits = rect8__avx2(minX, minY, maxX, maxY, AVX2_I16(x, 0), AVX2_I16(y, 0), AVX2_U16(sizeX, 0), AVX2_U16(sizeY, 0));
+      bits |= rect8__avx2(minX, minY, maxX, maxY, AVX2_I16(x, 1), AVX2_I16(y, 1), AVX2_U16(sizeX, 1), AVX2_U16(sizeY, 1)) << 8;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+static inline CCE_TARGET_AVX2 uint32_t distanceLess8__avx2 (__m256i dx, __m256i dy, __m256d scale, __m256i limit)
+{
+   uint32_t bits = 0;
+   for (uint8_t half = 0; half < 2; ++half)
+   {
+      const __m128i dx4 = half ? _mm256_extracti128_si256(dx, 1) : _mm256_castsi256_si128(dx);
+      const __m128i dy4 = half ? _mm256_extracti128_si256(dy, 1) : _mm256_castsi256_si128(dy);
+      const __m128i limit4 = half ? _mm256_extracti128_si256(limit, 1) : _mm256_castsi256_si128(limit);
+      const __m256d x = _mm256_cvtepi32_pd(dx4), y = _mm256_cvtepi32_pd(dy4), l = _mm256_cvtepi32_pd(limit4);
+      const __m256d distance = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)), scale);
+      bits |= (uint32_t) _mm256_movemask_pd(_mm256_cmp_pd(distance, _mm256_mul_pd(l, l), _CMP_LT_OQ)) << (half * 4);
+   }
+   return bits;
+}
+
+static CCE_TARGET_AVX2 uint32_t batchCir2D__avx2 (struct cce_collider_cir2D_16_16 circle, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m256i positionX = _mm256_set1_epi32(circle.position.x), positionY = _mm256_set1_epi32(circle.position.y);
+   const __m256i diameter = _mm256_set1_epi32(circle.diameter);
+   const __m256d scale = _mm256_set1_pd(4.0);
+   const uint32_t end = quantity & ~15u;
+   for (uint32_t i = 0; i < end; i += 16)
+   {
+      const __m256i x = AVX2_LOAD(batch->positionX, i), y = AVX2_LOAD(batch->positionY, i), d = AVX2_LOAD(batch->diameter, i);
+      uint32_t bits = distanceLess8__avx2(_mm256_sub_epi32(positionX, AVX2_I16(x, 0)), _mm256_sub_epi32(positionY, AVX2_I16(y, 0)), scale,
+                                          _mm256_add_epi32(diameter, AVX2_U16(d, 0)));
+      bits |= distanceLess8__avx2(_mm256_sub_epi32(positionX, AVX2_I16(x, 1)), _mm256_sub_epi32(positionY, AVX2_I16(y, 1)), scale,
+                                  _mm256_add_epi32(diameter, AVX2_U16(d, 1))) << 8;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+// Integer clamp is exact in 32 bits, only squares need doubles
+static inline CCE_TARGET_AVX2 uint32_t cirRect8__avx2 (__m256i centerX, __m256i centerY, __m256i diameter, __m256i minX, __m256i minY, __m256i maxX, __m256i maxY)
+{
+   const __m256i dx = _mm256_sub_epi32(centerX, _mm256_min_epi32(_mm256_max_epi32(centerX, minX), maxX));
+   const __m256i dy = _mm256_sub_epi32(centerY, _mm256_min_epi32(_mm256_max_epi32(centerY, minY), maxY));
+   return distanceLess8__avx2(dx, dy, _mm256_set1_pd(1.0), diameter);
+}
+
+static CCE_TARGET_AVX2 uint32_t batchCirRect2D__avx2 (struct cce_collider_cir2D_16_16 circle, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m256i centerX = _mm256_set1_epi32(circle.position.x * 2 + circle.diameter), centerY = _mm256_set1_epi32(circle.position.y * 2 + circle.diameter);
+   const __m256i diameter = _mm256_set1_epi32(circle.diameter);
+   const uint32_t end = quantity & ~15u;
+   for (uint32_t i = 0; i < end; i += 16)
+   {
+      const __m256i x = AVX2_LOAD(batch->positionX, i), y = AVX2_LOAD(batch->positionY, i);
+      const __m256i sizeX = AVX2_LOAD(batch->sizeX, i), sizeY = AVX2_LOAD(batch->sizeY, i);
+      uint32_t bits = 0;
+      for (uint8_t half = 0; half < 2; ++half)
+      {
+         const __m256i minX = half ? AVX2_I16(x, 1) : AVX2_I16(x, 0), minY = half ? AVX2_I16(y, 1) : AVX2_I16(y, 0);
+         const __m256i width = half ? AVX2_U16(sizeX, 1) : AVX2_U16(sizeX, 0), height = half ? AVX2_U16(sizeY, 1) : AVX2_U16(sizeY, 0);
+         bits |= cirRect8__avx2(centerX, centerY, diameter, _mm256_slli_epi32(minX, 1), _mm256_slli_epi32(minY, 1),
+                                _mm256_slli_epi32(_mm256_add_epi32(minX, width), 1), _mm256_slli_epi32(_mm256_add_epi32(minY, height), 1)) << (half * 8);
+      }
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+static CCE_TARGET_AVX2 uint32_t batchRectCir2D__avx2 (struct cce_collider_rect2D_16_16 rect, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const __m256i minX = _mm256_set1_epi32(rect.position.x * 2), minY = _mm256_set1_epi32(rect.position.y * 2);
+   const __m256i maxX = _mm256_set1_epi32((rect.position.x + rect.size.x) * 2), maxY = _mm256_set1_epi32((rect.position.y + rect.size.y) * 2);
+   const uint32_t end = quantity & ~15u;
+   for (uint32_t i = 0; i < end; i += 16)
+   {
+      const __m256i x = AVX2_LOAD(batch->positionX, i), y = AVX2_LOAD(batch->positionY, i), d = AVX2_LOAD(batch->diameter, i);
+      uint32_t bits = 0;
+      for (uint8_t half = 0; half < 2; ++half)
+      {
+         const __m256i diameter = half ? AVX2_U16(d, 1) : AVX2_U16(d, 0);
+         const __m256i centerX = _mm256_add_epi32(_mm256_slli_epi32(half ? AVX2_I16(x, 1) : AVX2_I16(x, 0), 1), diameter);
+         const __m256i centerY = _mm256_add_epi32(_mm256_slli_epi32(half ? AVX2_I16(y, 1) : AVX2_I16(y, 0), 1), diameter);
+         bits |= cirRect8__avx2(centerX, centerY, diameter, minX, minY, maxX, maxY) << (half * 8);
+      }
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+static uint8_t isAVX2Supported (void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] < 7)
+      return 0;
+   __cpuid(info, 1);
+   // OSXSAVE and AVX, then OS must save YMM registers
+   if ((info[2] & 0x18000000) != 0x18000000 || (_xgetbv(0) & 0x6) != 0x6)
+      return 0;
+   __cpuidex(info, 7, 0);
+   return (info[1] & 0x20) != 0;
+#else
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif // CCE_BATCH_AVX2
+
+/* NEON (AArch64 only: doubles and horizontal add are needed), 8 elements per iteration */
+
+#ifdef CCE_BATCH_NEON
+static const uint32_t g_laneBits32[4] = {1, 2, 4, 8};
+static const uint64_t g_laneBits64[2] = {1, 2};
+
+static inline uint32_t rect4__neon (int32x4_t minX, int32x4_t minY, int32x4_t maxX, int32x4_t maxY, int32x4_t x, int32x4_t y, int32x4_t sizeX, int32x4_t sizeY)
+{
+   uint32x4_t result = vandq_u32(vcgtq_s32(vaddq_s32(x, sizeX), minX), vcgtq_s32(maxX, x));
+   result = vandq_u32(result, vandq_u32(vcgtq_s32(vaddq_s32(y, sizeY), minY), vcgtq_s32(maxY, y)));
+   return vaddvq_u32(vandq_u32(result, vld1q_u32(g_laneBits32)));
+}
+
+static uint32_t batchRect2D__neon (struct cce_collider_rect2D_16_16 rect, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const int32x4_t minX = vdupq_n_s32(rect.position.x), minY = vdupq_n_s32(rect.position.y);
+   const int32x4_t maxX = vdupq_n_s32(rect.position.x + rect.size.x), maxY = vdupq_n_s32(rect.position.y + rect.size.y);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const int16x8_t x = vld1q_s16(batch->positionX + i), y = vld1q_s16(batch->positionY + i);
+      const uint16x8_t sizeX = vld1q_u16(batch->sizeX + i), sizeY = vld1q_u16(batch->sizeY + i);
+      uint32_t bits = rect4__neon(minX, minY, maxX, maxY, vmovl_s16(vget_low_s16(x)), vmovl_s16(vget_low_s16(y)),
+                                  vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(sizeX))), vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(sizeY))));
+      bits |= rect4__neon(minX, minY, maxX, maxY, vmovl_s16(vget_high_s16(x)), vmovl_s16(vget_high_s16(y)),
+                          vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(sizeX))), vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(sizeY)))) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+static inline uint32_t distanceLess2__neon (int32x2_t dx, int32x2_t dy, float64x2_t scale, int32x2_t limit)
+{
+   const float64x2_t x = vcvtq_f64_s64(vmovl_s32(dx)), y = vcvtq_f64_s64(vmovl_s32(dy)), l = vcvtq_f64_s64(vmovl_s32(limit));
+   const float64x2_t distance = vmulq_f64(vaddq_f64(vmulq_f64(x, x), vmulq_f64(y, y)), scale);
+   return (uint32_t) vaddvq_u64(vandq_u64(vcltq_f64(distance, vmulq_f64(l, l)), vld1q_u64(g_laneBits64)));
+}
+
+static inline uint32_t distanceLess4__neon (int32x4_t dx, int32x4_t dy, float64x2_t scale, int32x4_t limit)
+{
+   return distanceLess2__neon(vget_low_s32(dx), vget_low_s32(dy), scale, vget_low_s32(limit)) |
+          distanceLess2__neon(vget_high_s32(dx), vget_high_s32(dy), scale, vget_high_s32(limit)) << 2;
+}
+
+static uint32_t batchCir2D__neon (struct cce_collider_cir2D_16_16 circle, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const int32x4_t positionX = vdupq_n_s32(circle.position.x), positionY = vdupq_n_s32(circle.position.y);
+   const int32x4_t diameter = vdupq_n_s32(circle.diameter);
+   const float64x2_t scale = vdupq_n_f64(4.0);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const int16x8_t x = vld1q_s16(batch->positionX + i), y = vld1q_s16(batch->positionY + i);
+      const uint16x8_t d = vld1q_u16(batch->diameter + i);
+      uint32_t bits = distanceLess4__neon(vsubq_s32(positionX, vmovl_s16(vget_low_s16(x))), vsubq_s32(positionY, vmovl_s16(vget_low_s16(y))), scale,
+                                          vaddq_s32(diameter, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(d)))));
+      bits |= distanceLess4__neon(vsubq_s32(positionX, vmovl_s16(vget_high_s16(x))), vsubq_s32(positionY, vmovl_s16(vget_high_s16(y))), scale,
+                                  vaddq_s32(diameter, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(d))))) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+static inline uint32_t cirRect4__neon (int32x4_t centerX, int32x4_t centerY, int32x4_t diameter, int32x4_t minX, int32x4_t minY, int32x4_t maxX, int32x4_t maxY)
+{
+   const int32x4_t dx = vsubq_s32(centerX, vminq_s32(vmaxq_s32(centerX, minX), maxX));
+   const int32x4_t dy = vsubq_s32(centerY, vminq_s32(vmaxq_s32(centerY, minY), maxY));
+   return distanceLess4__neon(dx, dy, vdupq_n_f64(1.0), diameter);
+}
+
+static uint32_t batchCirRect2D__neon (struct cce_collider_cir2D_16_16 circle, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const int32x4_t centerX = vdupq_n_s32(circle.position.x * 2 + circle.diameter), centerY = vdupq_n_s32(circle.position.y * 2 + circle.diameter);
+   const int32x4_t diameter = vdupq_n_s32(circle.diameter);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const int16x8_t x = vld1q_s16(batch->positionX + i), y = vld1q_s16(batch->positionY + i);
+      const uint16x8_t sizeX = vld1q_u16(batch->sizeX + i), sizeY = vld1q_u16(batch->sizeY + i);
+      int32x4_t minX = vmovl_s16(vget_low_s16(x)), minY = vmovl_s16(vget_low_s16(y));
+      uint32_t bits = cirRect4__neon(centerX, centerY, diameter, vshlq_n_s32(minX, 1), vshlq_n_s32(minY, 1),
+                                     vshlq_n_s32(vaddq_s32(minX, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(sizeX)))), 1),
+                                     vshlq_n_s32(vaddq_s32(minY, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(sizeY)))), 1));
+      minX = vmovl_s16(vget_high_s16(x));
+      minY = vmovl_s16(vget_high_s16(y));
+      bits |= cirRect4__neon(centerX, centerY, diameter, vshlq_n_s32(minX, 1), vshlq_n_s32(minY, 1),
+                             vshlq_n_s32(vaddq_s32(minX, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(sizeX)))), 1),
+                             vshlq_n_s32(vaddq_s32(minY, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(sizeY)))), 1)) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+
+static uint32_t batchRectCir2D__neon (struct cce_collider_rect2D_16_16 rect, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   const int32x4_t minX = vdupq_n_s32(rect.position.x * 2), minY = vdupq_n_s32(rect.position.y * 2);
+   const int32x4_t maxX = vdupq_n_s32((rect.position.x + rect.size.x) * 2), maxY = vdupq_n_s32((rect.position.y + rect.size.y) * 2);
+   const uint32_t end = quantity & ~7u;
+   for (uint32_t i = 0; i < end; i += 8)
+   {
+      const int16x8_t x = vld1q_s16(batch->positionX + i), y = vld1q_s16(batch->positionY + i);
+      const uint16x8_t d = vld1q_u16(batch->diameter + i);
+      int32x4_t diameter = vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(d)));
+      uint32_t bits = cirRect4__neon(vaddq_s32(vshlq_n_s32(vmovl_s16(vget_low_s16(x)), 1), diameter), vaddq_s32(vshlq_n_s32(vmovl_s16(vget_low_s16(y)), 1), diameter),
+                                     diameter, minX, minY, maxX, maxY);
+      diameter = vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(d)));
+      bits |= cirRect4__neon(vaddq_s32(vshlq_n_s32(vmovl_s16(vget_high_s16(x)), 1), diameter), vaddq_s32(vshlq_n_s32(vmovl_s16(vget_high_s16(y)), 1), diameter),
+                             diameter, minX, minY, maxX, maxY) << 4;
+      mask[i >> 5] |= bits << (i & 31);
+   }
+   return end;
+}
+#endif // CCE_BATCH_NEON
+
+#define SET_BATCH_FUNCTIONS(suffix) \
+g_batchFunctions.rect2D = batchRect2D__ ## suffix; \
+g_batchFunctions.cir2D = batchCir2D__ ## suffix; \
+g_batchFunctions.cirRect2D = batchCirRect2D__ ## suffix; \
+g_batchFunctions.rectCir2D = batchRectCir2D__ ## suffix
+
+CCE_API uint8_t cceSetCollisionBatchImplementation (uint8_t implementation)
+{
+   switch (implementation)
+   {
+      case CCE_COLLISION_BATCH_AUTO:
+#if defined(CCE_BATCH_AVX2)
+         if (isAVX2Supported())
+            return cceSetCollisionBatchImplementation(CCE_COLLISION_BATCH_AVX2);
+#endif
+#if defined(CCE_BATCH_SSE2)
+         implementation = cceSetCollisionBatchImplementation(CCE_COLLISION_BATCH_SSE2);
+         // SSE2 circle-rectangle kernel isn't faster than scalar one (bench), so scalar one is kept for it
+         g_batchFunctions.cirRect2D = batchCirRect2D__scalar;
+         return implementation;
+#elif defined(CCE_BATCH_NEON)
+         return cceSetCollisionBatchImplementation(CCE_COLLISION_BATCH_NEON);
+#else
+         break;
+#endif
+#ifdef CCE_BATCH_SSE2
+      case CCE_COLLISION_BATCH_SSE2:
+         SET_BATCH_FUNCTIONS(sse2);
+         return CCE_COLLISION_BATCH_SSE2;
+#endif
+#ifdef CCE_BATCH_AVX2
+      case CCE_COLLISION_BATCH_AVX2:
+         if (!isAVX2Supported())
+            break;
+         SET_BATCH_FUNCTIONS(avx2);
+         return CCE_COLLISION_BATCH_AVX2;
+#endif
+#ifdef CCE_BATCH_NEON
+      case CCE_COLLISION_BATCH_NEON:
+         SET_BATCH_FUNCTIONS(neon);
+         return CCE_COLLISION_BATCH_NEON;
+#endif
+      default:
+         break;
+   }
+   SET_BATCH_FUNCTIONS(scalar);
+   return CCE_COLLISION_BATCH_SCALAR;
+}
+
+#define RUN_BATCH(function, collider, batch, quantity, mask) \
+do \
+{ \
+   memset(mask, 0, ((quantity + 31) >> 5) * sizeof(uint32_t)); \
+   uint32_t processed = g_batchFunctions.function(collider, batch, quantity, mask); \
+   for (; processed < quantity; ++processed) \
+   { \
+      mask[processed >> 5] |= (uint32_t) function ## Element(collider, batch, processed) << (processed & 31); \
+   } \
+} \
+while (0)
+
+CCE_API void cceCheckCollisionRect2DBatch (struct cce_collider_rect2D_16_16 rect, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   RUN_BATCH(rect2D, rect, batch, quantity, mask);
+}
+
+CCE_API void cceCheckCollisionCir2DBatch (struct cce_collider_cir2D_16_16 circle, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   RUN_BATCH(cir2D, circle, batch, quantity, mask);
+}
+
+CCE_API void cceCheckCollisionCirRect2DBatch (struct cce_collider_cir2D_16_16 circle, const struct cce_rect2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   RUN_BATCH(cirRect2D, circle, batch, quantity, mask);
+}
+
+CCE_API void cceCheckCollisionRectCir2DBatch (struct cce_collider_rect2D_16_16 rect, const struct cce_cir2Dbatch_16_16 *batch, uint32_t quantity, uint32_t *mask)
+{
+   RUN_BATCH(rectCir2D, rect, batch, quantity, mask);
+}
+
+CCE_API uint32_t cceCollisionMaskToIndices (const uint32_t *mask, uint32_t quantity, uint32_t *indices)
+{
+   uint32_t found = 0;
+   for (uint32_t word = 0, words = (quantity + 31) >> 5; word < words; ++word)
+   {
+      uint32_t bits = mask[word];
+      if (word == words - 1 && (quantity & 31))
+         bits &= (1u << (quantity & 31)) - 1;
+      while (bits != 0)
+      {
+         indices[found++] = (word << 5) | CCE_LOWEST_BIT_INDEX(bits);
+         bits &= bits - 1;
+      }
+   }
+   return found;
+}
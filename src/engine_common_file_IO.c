@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "../include/cce/compression.h"
 #include "../include/cce/engine_common.h"
 #include "../include/cce/engine_common_IO.h"
 #include "../include/cce/endianess.h"
@@ -36,33 +37,91 @@ struct cce_IO_function_set
    cce_dataparsefun *freeingFunctions;
    cce_dataparsefun *creatingFunctions;
    cce_fwritefun    *writingFunctions;
+   cce_mreadfun     *mappedReadingFunctions;
    size_t           *readingFunctionsDataBufferOffsets;
    uint32_t        (*sectionUIDs);
    uint32_t        **sectionUIDsSorted;
    uint16_t          readingFunctionsQuantity;
    uint16_t          readingFunctionsAllocated;
+   uint8_t           codec;
+   uint8_t           checksums;
 };
 
 CCE_ARRAY(IOfunctionSet, static struct cce_IO_function_set, static uint16_t);
 
+// Placed right before cce_buffer loaded by cceLoadBinaryCCFmapped
+struct cce_mappedfile
+{
+   void  *data;
+   size_t size;
+};
+
+#define CCE_MOVE_CHUNK_SIZE 65536u
+#define CCE_CCF_WRITE_BUFFER_SIZE 262144u
+
+/* Versioned header: 0, version, loaders, then little-endian arrays of uids, section sizes, stored and unpacked byte sizes,
+ * CRC-32C of stored bytes (all uint32_t) and codecs (uint8_t). Version 2 has no checksums.
+ * Legacy header (loaders, uids, uint16_t section sizes) only begins with 0 when the file is empty */
+#define CCE_CCF_VERSION 3u
+#define CCE_CCF_UNCHECKED_VERSION 2u
+#define CCE_CCF_SECTION_HEADER_SIZE (5u * sizeof(uint32_t) + sizeof(uint8_t))
+#define CCE_CCF_UNCHECKED_SECTION_HEADER_SIZE (4u * sizeof(uint32_t) + sizeof(uint8_t))
+#define CCE_CCF_LEGACY_SECTION_HEADER_SIZE (sizeof(uint32_t) + sizeof(uint16_t))
+#define CCE_CCF_MAX_HEADER_SIZE (3u + 255u * CCE_CCF_SECTION_HEADER_SIZE)
+#define CCE_CCF_MIN_COMPRESSED_SIZE 64u
+#define CCE_CCF_CHECK_CHUNK_SIZE 65536u
+
+struct cce_ccfheader
+{
+   uint32_t storedSizes[255];
+   uint32_t rawSizes[255];
+   uint32_t checksums[255];
+   uint16_t sectionSizes[255];
+   uint16_t ids[255];
+   uint8_t  codecs[255];
+   uint8_t  loaders;
+   uint8_t  headSize;
+   uint8_t  version; // 0 for legacy header
+};
+
+/* Moves size bytes from the current position to the one set by offset and position (as in fseek, SEEK_CUR is relative to the current position).
+ * Overlapping ranges are handled, file position is left after the moved content */
 CCE_API FILE* cceMoveFileContent (FILE *file, long offset, int position, size_t size)
 {
-   char buffer[1024];
-   long readOffset = ftell(file) + (size & 1023);
-   fread(buffer, sizeof(char), size & 1023, file);
+   long readOffset = ftell(file);
    fseek(file, offset, position);
-   long writeOffset = ftell(file) + (size & 1023);
-   fwrite(buffer, sizeof(char), size & 1023, file);
-   for (size_t i = 0, end = size >> 10; i < end; ++i, readOffset += size, writeOffset += size)
+   long writeOffset = ftell(file);
+   if (size == 0 || readOffset == writeOffset)
+      return file;
+   char *buffer = malloc(CCE_MIN(size, CCE_MOVE_CHUNK_SIZE));
+   // Content moved forward is copied from its end, so no chunk is overwritten before it's read
+   long direction = (writeOffset > readOffset) ? -1 : 1;
+   size_t done = 0;
+   while (done < size)
    {
-      fseek(file, readOffset, SEEK_SET);
-      fread(buffer, sizeof(char), 1024, file);
-      fseek(file, writeOffset, SEEK_SET);
-      fwrite(buffer, sizeof(char), 1024, file);
+      size_t chunk = CCE_MIN(size - done, CCE_MOVE_CHUNK_SIZE);
+      long chunkOffset = (direction > 0) ? (long) done : (long)(size - done - chunk);
+      fseek(file, readOffset + chunkOffset, SEEK_SET);
+      fread(buffer, sizeof(char), chunk, file);
+      fseek(file, writeOffset + chunkOffset, SEEK_SET);
+      fwrite(buffer, sizeof(char), chunk, file);
+      done += chunk;
    }
+   free(buffer);
+   fseek(file, writeOffset + (long) size, SEEK_SET);
    return file;
 }
 
+CCE_API long cceGetFileRemainingSize (FILE *file)
+{
+   long position = ftell(file);
+   if (position < 0 || fseek(file, 0, SEEK_END) != 0)
+      return -1;
+   long end = ftell(file);
+   fseek(file, position, SEEK_SET);
+   return end - position;
+}
+
 CCE_API uint16_t cceGetFileIOfunctionSet (void)
 {
    if (IOfunctionSetQuantity >= IOfunctionSetAllocated)
@@ -73,13 +132,36 @@ CCE_API uint16_t cceGetFileIOfunctionSet (void)
    IOfunctionSet[IOfunctionSetQuantity].freeingFunctions  =                 malloc( IOfunctionSet[IOfunctionSetQuantity].readingFunctionsAllocated * sizeof(cce_dataparsefun*));
    IOfunctionSet[IOfunctionSetQuantity].creatingFunctions =                 malloc( IOfunctionSet[IOfunctionSetQuantity].readingFunctionsAllocated * sizeof(cce_dataparsefun*));
    IOfunctionSet[IOfunctionSetQuantity].writingFunctions  =                 malloc( IOfunctionSet[IOfunctionSetQuantity].readingFunctionsAllocated * sizeof(cce_fwritefun*));
+   IOfunctionSet[IOfunctionSetQuantity].mappedReadingFunctions =            malloc( IOfunctionSet[IOfunctionSetQuantity].readingFunctionsAllocated * sizeof(cce_mreadfun*));
    IOfunctionSet[IOfunctionSetQuantity].readingFunctionsDataBufferOffsets = malloc((IOfunctionSet[IOfunctionSetQuantity].readingFunctionsAllocated + 1) * sizeof(size_t));
    IOfunctionSet[IOfunctionSetQuantity].sectionUIDs =                       malloc( IOfunctionSet[IOfunctionSetQuantity].readingFunctionsAllocated * sizeof(uint64_t));
    IOfunctionSet[IOfunctionSetQuantity].sectionUIDsSorted =                 malloc( IOfunctionSet[IOfunctionSetQuantity].readingFunctionsAllocated * sizeof(uint64_t*));
    IOfunctionSet[IOfunctionSetQuantity].readingFunctionsDataBufferOffsets[0] = 0;
+   IOfunctionSet[IOfunctionSetQuantity].codec = CCE_CCF_CODEC_NONE;
+   IOfunctionSet[IOfunctionSetQuantity].checksums = 0;
    return IOfunctionSetQuantity++;
 }
 
+// Function sets are registered again by plugins on every cceInit
+void cce__terminateFileIO (void)
+{
+   for (struct cce_IO_function_set *iterator = IOfunctionSet, *end = IOfunctionSet + IOfunctionSetQuantity; iterator < end; ++iterator)
+   {
+      free(iterator->readingFunctions);
+      free(iterator->freeingFunctions);
+      free(iterator->creatingFunctions);
+      free(iterator->writingFunctions);
+      free(iterator->mappedReadingFunctions);
+      free(iterator->readingFunctionsDataBufferOffsets);
+      free(iterator->sectionUIDs);
+      free(iterator->sectionUIDsSorted);
+   }
+   free(IOfunctionSet);
+   IOfunctionSet = NULL;
+   IOfunctionSetQuantity = 0;
+   IOfunctionSetAllocated = 0;
+}
+
 CCE_API ptrdiff_t cceGetFunctionBufferOffset (uint32_t functionUID, uint16_t functionSetID)
 {
    struct cce_IO_function_set *currentFunctions = IOfunctionSet + functionSetID;
@@ -105,6 +187,7 @@ CCE_API int cceRegisterFileIOcallbacks (uint16_t functionSet, uint32_t functionU
       currentFunctions->freeingFunctions  = realloc(currentFunctions->freeingFunctions,  currentFunctions->readingFunctionsAllocated * sizeof(cce_dataparsefun*));
       currentFunctions->creatingFunctions = realloc(currentFunctions->creatingFunctions, currentFunctions->readingFunctionsAllocated * sizeof(cce_dataparsefun*));
       currentFunctions->writingFunctions  = realloc(currentFunctions->writingFunctions,  currentFunctions->readingFunctionsAllocated * sizeof(cce_fwritefun*));
+      currentFunctions->mappedReadingFunctions = realloc(currentFunctions->mappedReadingFunctions, currentFunctions->readingFunctionsAllocated * sizeof(cce_mreadfun*));
       currentFunctions->readingFunctionsDataBufferOffsets = realloc(currentFunctions->readingFunctionsDataBufferOffsets, (currentFunctions->readingFunctionsAllocated + 1) * sizeof(size_t));
       CCE_REALLOC_UID_ARRAY(currentFunctions->sectionUIDs, currentFunctions->sectionUIDsSorted, currentFunctions->readingFunctionsQuantity, currentFunctions->readingFunctionsAllocated);
    }
@@ -112,17 +195,45 @@ CCE_API int cceRegisterFileIOcallbacks (uint16_t functionSet, uint32_t functionU
    currentFunctions->freeingFunctions[currentFunctions->readingFunctionsQuantity]  = onFree;
    currentFunctions->creatingFunctions[currentFunctions->readingFunctionsQuantity] = onCreate;
    currentFunctions->writingFunctions[currentFunctions->readingFunctionsQuantity]  = onWrite;
+   currentFunctions->mappedReadingFunctions[currentFunctions->readingFunctionsQuantity] = NULL;
    currentFunctions->readingFunctionsDataBufferOffsets[currentFunctions->readingFunctionsQuantity + 1] = bufferSize + currentFunctions->readingFunctionsDataBufferOffsets[currentFunctions->readingFunctionsQuantity];
    CCE_INSERT_INTO_UID_ARRAY(functionUID, currentFunctions->sectionUIDs, currentFunctions->sectionUIDsSorted, currentFunctions->readingFunctionsQuantity);
    ++currentFunctions->readingFunctionsQuantity;
    return 0;
 }
 
+CCE_API int cceRegisterFileIOmappedReader (uint16_t functionSet, uint32_t functionUID, cce_mreadfun onLoadMapped)
+{
+   assert(functionSet < IOfunctionSetQuantity);
+   struct cce_IO_function_set *currentFunctions = IOfunctionSet + functionSet;
+   uint16_t id;
+   CCE_FIND_FROM_UID_ARRAY(functionUID, currentFunctions->sectionUIDs, currentFunctions->sectionUIDsSorted, currentFunctions->readingFunctionsQuantity, id,
+                           fprintf(stderr, "ENGINE::FILE_IO::SECTION_NOT_FOUND:\nMapped reader can't be registered for section %s (uid: %u) without other callbacks\n",
+                                   cceUIDToName(functionUID), functionUID); return -1);
+   currentFunctions->mappedReadingFunctions[id] = onLoadMapped;
+   return 0;
+}
+
+CCE_API void cceSetFileIOcompression (uint16_t functionSet, uint8_t codec)
+{
+   assert(functionSet < IOfunctionSetQuantity && codec <= CCE_CCF_CODEC_LZ);
+   IOfunctionSet[functionSet].codec = codec;
+}
+
+CCE_API void cceSetFileIOchecksums (uint16_t functionSet, uint8_t flags)
+{
+   assert(functionSet < IOfunctionSetQuantity);
+   IOfunctionSet[functionSet].checksums = flags;
+}
+
 CCE_API struct cce_buffer* cceSetBufferSectionQuantity (struct cce_buffer *buffer, uint8_t newSectionsQuantity)
 {
    uint8_t oldSectionsQuantity = buffer->sectionsQuantity;
    size_t size = IOfunctionSet[buffer->loadingFunctionBlockID].readingFunctionsDataBufferOffsets[newSectionsQuantity];
-   buffer = realloc(buffer, sizeof(struct cce_buffer) + size);
+   if (buffer->flags & CCE_BUFFER_MAPPED)
+      buffer = (struct cce_buffer*)((struct cce_mappedfile*) realloc((struct cce_mappedfile*) buffer - 1, sizeof(struct cce_mappedfile) + sizeof(struct cce_buffer) + size) + 1);
+   else
+      buffer = realloc(buffer, sizeof(struct cce_buffer) + size);
    if (newSectionsQuantity > oldSectionsQuantity)
    {
       size_t *offsets = IOfunctionSet[buffer->loadingFunctionBlockID].readingFunctionsDataBufferOffsets + oldSectionsQuantity;
@@ -143,6 +254,7 @@ CCE_API struct cce_buffer* cceCreateBuffer (uint8_t sectionsQuantity, uint16_t f
    size_t size = IOfunctionSet[functionSetID].readingFunctionsDataBufferOffsets[sectionsQuantity];
    struct cce_buffer *buffer = malloc(sizeof(struct cce_buffer) + size);
    buffer->sectionsQuantity = sectionsQuantity;
+   buffer->flags = 0;
    buffer->loadingFunctionBlockID = functionSetID;
    size_t *offsets = IOfunctionSet[functionSetID].readingFunctionsDataBufferOffsets;
    for (cce_dataparsefun *iterator = IOfunctionSet[functionSetID].creatingFunctions, *end = iterator + sectionsQuantity; iterator < end;
@@ -166,9 +278,159 @@ CCE_API void cceFreeBuffer (struct cce_buffer *buffer)
       
       (*fun)((cce_void*)(buffer + 1) + *offsets, buffer);
    }
+   if (buffer->flags & CCE_BUFFER_MAPPED)
+   {
+      struct cce_mappedfile *mapped = (struct cce_mappedfile*) buffer - 1;
+      cceUnmapFile(mapped->data, mapped->size);
+      free(mapped);
+      return;
+   }
    free(buffer);
 }
 
+static size_t getCCFheaderSize (uint8_t version, uint8_t loaders)
+{
+   switch (version)
+   {
+      case CCE_CCF_VERSION:           return 3u + loaders * CCE_CCF_SECTION_HEADER_SIZE;
+      case CCE_CCF_UNCHECKED_VERSION: return 3u + loaders * CCE_CCF_UNCHECKED_SECTION_HEADER_SIZE;
+      default:                        return 1u + loaders * CCE_CCF_LEGACY_SECTION_HEADER_SIZE;
+   }
+}
+
+// Returns header size, 0 if header is truncated or refers to unknown sections
+static size_t parseCCFheader (struct cce_ccfheader *header, const uint8_t *data, size_t available, struct cce_IO_function_set *functions)
+{
+   if (available == 0)
+      return 0;
+   header->version = (available >= 3u && data[0] == 0 && (data[1] == CCE_CCF_VERSION || data[1] == CCE_CCF_UNCHECKED_VERSION)) ? data[1] : 0;
+   header->loaders = data[header->version ? 2u : 0u];
+   uint8_t loaders = header->loaders;
+   size_t size = getCCFheaderSize(header->version, loaders);
+   if (available < size)
+   {
+      fprintf(stderr, "ENGINE::FILE_IO::CORRUPTED_HEADER:\nHeader is truncated\n");
+      return 0;
+   }
+   
+   uint32_t uids[255];
+   const uint8_t *iterator = data + (header->version ? 3u : 1u);
+   memcpy(uids, iterator, loaders * sizeof(uint32_t));
+   iterator += loaders * sizeof(uint32_t);
+   if (header->version)
+   {
+      uint32_t sectionSizes[255];
+      memcpy(sectionSizes, iterator, loaders * sizeof(uint32_t));
+      iterator += loaders * sizeof(uint32_t);
+      memcpy(header->storedSizes, iterator, loaders * sizeof(uint32_t));
+      iterator += loaders * sizeof(uint32_t);
+      memcpy(header->rawSizes, iterator, loaders * sizeof(uint32_t));
+      iterator += loaders * sizeof(uint32_t);
+      if (header->version == CCE_CCF_VERSION)
+      {
+         memcpy(header->checksums, iterator, loaders * sizeof(uint32_t));
+         iterator += loaders * sizeof(uint32_t);
+      }
+      memcpy(header->codecs, iterator, loaders * sizeof(uint8_t));
+      if (cceEndianess == CCE_BIG_ENDIAN)
+      {
+         cceLittleEndianToBigEndianArrayInt32(uids, loaders);
+         cceLittleEndianToBigEndianArrayInt32(sectionSizes, loaders);
+         cceLittleEndianToBigEndianArrayInt32(header->storedSizes, loaders);
+         cceLittleEndianToBigEndianArrayInt32(header->rawSizes, loaders);
+         cceLittleEndianToBigEndianArrayInt32(header->checksums, loaders);
+      }
+      for (unsigned i = 0; i < loaders; ++i)
+      {
+         // Section sizes are passed to loaders as uint16_t
+         if (header->codecs[i] == CCE_CCF_CODEC_LZ && header->rawSizes[i] > cceGetDecompressLZbound(header->storedSizes[i]))
+         {
+            fprintf(stderr, "ENGINE::FILE_IO::CORRUPTED_HEADER:\nSection %s (uid: %u) can't unpack %u bytes into %u\n", cceUIDToName(uids[i]), uids[i],
+                    header->storedSizes[i], header->rawSizes[i]);
+            return 0;
+         }
+         if (sectionSizes[i] > UINT16_MAX || header->codecs[i] > CCE_CCF_CODEC_LZ)
+         {
+            fprintf(stderr, "ENGINE::FILE_IO::UNSUPPORTED_SECTION:\nSection %s (uid: %u) has size %u and codec %u\n", cceUIDToName(uids[i]), uids[i],
+                    sectionSizes[i], header->codecs[i]);
+            return 0;
+         }
+         header->sectionSizes[i] = sectionSizes[i];
+      }
+   }
+   else
+   {
+      memcpy(header->sectionSizes, iterator, loaders * sizeof(uint16_t));
+      memset(header->storedSizes, 0, loaders * sizeof(uint32_t));
+      memset(header->codecs, CCE_CCF_CODEC_NONE, loaders * sizeof(uint8_t));
+   }
+   header->headSize = 0;
+   for (unsigned i = 0; i < loaders; ++i)
+   {
+      CCE_FIND_FROM_UID_ARRAY(uids[i], functions->sectionUIDs, functions->sectionUIDsSorted, functions->readingFunctionsQuantity, header->ids[i], return 0);
+      header->headSize = CCE_MAX(header->headSize, header->ids[i] + 1);
+   }
+   return size;
+}
+
+static int reportChecksumMismatch (const struct cce_ccfheader *header, unsigned section, uint32_t checksum)
+{
+   fprintf(stderr, "ENGINE::FILE_IO::CORRUPTED_SECTION:\nSection %u has checksum %08X, header expects %08X\n", section, checksum, header->checksums[section]);
+   return -1;
+}
+
+// Checks that every section of versioned file is complete and (if header has checksums) matches its CRC-32C, file position is kept
+static int verifyCCFsections (const struct cce_ccfheader *header, FILE *file, long offset)
+{
+   if (header->version == 0)
+      return 0;
+   long position = ftell(file);
+   uint8_t *chunk = malloc(CCE_CCF_CHECK_CHUNK_SIZE);
+   int result = 0;
+   fseek(file, offset, SEEK_SET);
+   for (unsigned i = 0; i < header->loaders && result == 0; ++i)
+   {
+      uint32_t checksum = 0;
+      for (uint32_t left = header->storedSizes[i]; left > 0;)
+      {
+         size_t toRead = CCE_MIN(left, CCE_CCF_CHECK_CHUNK_SIZE);
+         if (fread(chunk, sizeof(uint8_t), toRead, file) != toRead)
+         {
+            fprintf(stderr, "ENGINE::FILE_IO::CORRUPTED_SECTION:\nSection %u is truncated\n", i);
+            result = -1;
+            break;
+         }
+         checksum = cceCRC32C(checksum, chunk, toRead);
+         left -= toRead;
+      }
+      if (result == 0 && header->version == CCE_CCF_VERSION && checksum != header->checksums[i])
+         result = reportChecksumMismatch(header, i, checksum);
+   }
+   free(chunk);
+   fseek(file, position, SEEK_SET);
+   return result;
+}
+
+// Compressed sections are unpacked into memory and given to stream reader as a file
+static int readCompressedSection (cce_freadfun reader, void *data, uint16_t sectionSize, struct cce_buffer *buffer,
+                                  const uint8_t *stored, uint32_t storedSize, uint32_t rawSize)
+{
+   uint8_t *raw = malloc(rawSize);
+   FILE *file;
+   int result = -1;
+   if (cceDecompressLZ(stored, storedSize, raw, rawSize) != 0)
+   {
+      fprintf(stderr, "ENGINE::FILE_IO::CORRUPTED_SECTION:\nCompressed section can't be unpacked\n");
+   }
+   else if ((file = cceOpenMemoryAsFile(raw, rawSize)) != NULL)
+   {
+      result = reader(data, sectionSize, buffer, file);
+      fclose(file);
+   }
+   free(raw);
+   return result;
+}
+
 CCE_API struct cce_buffer* cceLoadBinaryCCF (char *path, uint16_t functionSetID)
 {
    assert(functionSetID < IOfunctionSetQuantity);
@@ -178,27 +440,23 @@ CCE_API struct cce_buffer* cceLoadBinaryCCF (char *path, uint16_t functionSetID)
       return NULL;
    }
    struct cce_IO_function_set *currentFunctions = IOfunctionSet + functionSetID;
-   uint8_t headSize, loaders;
+   struct cce_ccfheader header;
    uint8_t errorLoader = 0;
    struct cce_buffer *buffer = NULL;
-   fread(&loaders, sizeof(uint8_t), 1, file);
-   uint16_t sectionSizes[255];
    uint8_t  sectionsInitialized[255] = {0};
-   uint16_t ids[255];
-   headSize = 0;
+   long offset;
    {
-      uint32_t uids[255] = {0};
-      fread(uids, sizeof(uint32_t), loaders, file);
-      fread(sectionSizes, sizeof(uint16_t), loaders, file);
-      for (unsigned i = 0; i < loaders; ++i)
+      uint8_t headerData[CCE_CCF_MAX_HEADER_SIZE];
+      size_t available = fread(headerData, sizeof(uint8_t), CCE_CCF_MAX_HEADER_SIZE, file);
+      if ((offset = parseCCFheader(&header, headerData, available, currentFunctions)) == 0 || verifyCCFsections(&header, file, offset) != 0)
       {
-         CCE_FIND_FROM_UID_ARRAY(uids[i], currentFunctions->sectionUIDs, currentFunctions->sectionUIDsSorted, \
-                                 currentFunctions->readingFunctionsQuantity, ids[i], fclose(file); return NULL);
-         headSize = CCE_MAX(headSize, ids[i] + 1);
+         fclose(file);
+         return NULL;
       }
+      fseek(file, offset, SEEK_SET);
    }
-   size_t size = currentFunctions->readingFunctionsDataBufferOffsets[headSize];
-   if (headSize == 0)
+   size_t size = currentFunctions->readingFunctionsDataBufferOffsets[header.headSize];
+   if (header.headSize == 0)
    {
       fclose(file);
       buffer = calloc(1, sizeof(struct cce_buffer));
@@ -206,22 +464,40 @@ CCE_API struct cce_buffer* cceLoadBinaryCCF (char *path, uint16_t functionSetID)
       return buffer;
    }
    buffer = calloc(1, sizeof(struct cce_buffer) + size);
-   buffer->sectionsQuantity = headSize;
+   buffer->sectionsQuantity = header.headSize;
    buffer->loadingFunctionBlockID = functionSetID;
    size_t *offsets = currentFunctions->readingFunctionsDataBufferOffsets;
    cce_void *data = (cce_void*)(buffer + 1);
    
-   for (unsigned i = 0; i < loaders; ++i)
+   for (unsigned i = 0; i < header.loaders; ++i)
    {
-      sectionsInitialized[ids[i]] = 1;
-      if ((currentFunctions->readingFunctions[ids[i]])(data + offsets[ids[i]], sectionSizes[i], buffer, file) == 0)
+      uint16_t id = header.ids[i];
+      sectionsInitialized[id] = 1;
+      int status;
+      // Versioned files know where each section begins, legacy ones are read sequentially
+      if (header.version)
+         fseek(file, offset, SEEK_SET);
+      if (header.codecs[i] == CCE_CCF_CODEC_NONE)
+      {
+         status = (currentFunctions->readingFunctions[id])(data + offsets[id], header.sectionSizes[i], buffer, file);
+      }
+      else
+      {
+         uint8_t *stored = malloc(header.storedSizes[i]);
+         status = (fread(stored, sizeof(uint8_t), header.storedSizes[i], file) == header.storedSizes[i]) ?
+                  readCompressedSection(currentFunctions->readingFunctions[id], data + offsets[id], header.sectionSizes[i], buffer,
+                                        stored, header.storedSizes[i], header.rawSizes[i]) : -1;
+         free(stored);
+      }
+      offset += header.storedSizes[i];
+      if (status == 0)
          continue;
       
-      errorLoader = ids[i];
+      errorLoader = id;
       goto ERROR;
    }
    fclose(file);
-   for (unsigned i = 0; i < headSize; ++i)
+   for (unsigned i = 0; i < header.headSize; ++i)
    {
       if (sectionsInitialized[i] != 0 || currentFunctions->creatingFunctions[i] == NULL)
          continue;
@@ -241,49 +517,242 @@ ERROR:
    return NULL;
 }
 
+CCE_API struct cce_buffer* cceLoadBinaryCCFmapped (char *path, uint16_t functionSetID)
+{
+   assert(functionSetID < IOfunctionSetQuantity);
+   size_t fileSize;
+   uint8_t *fileData = cceMapFile(path, &fileSize);
+   if (fileData == NULL)
+      return cceLoadBinaryCCF(path, functionSetID); // Missing files, empty files and file systems which can't be mapped
+   
+   struct cce_IO_function_set *currentFunctions = IOfunctionSet + functionSetID;
+   struct cce_ccfheader header;
+   uint8_t errorLoader = 0;
+   uint8_t sectionsInitialized[255] = {0};
+   FILE *file = NULL;
+   size_t offset = parseCCFheader(&header, fileData, fileSize, currentFunctions);
+   if (offset == 0)
+   {
+      cceUnmapFile(fileData, fileSize);
+      return NULL;
+   }
+   size_t size = currentFunctions->readingFunctionsDataBufferOffsets[header.headSize];
+   if (header.headSize == 0)
+   {
+      cceUnmapFile(fileData, fileSize);
+      struct cce_buffer *buffer = calloc(1, sizeof(struct cce_buffer));
+      buffer->sectionsQuantity = 0;
+      return buffer;
+   }
+   struct cce_mappedfile *mapped = calloc(1, sizeof(struct cce_mappedfile) + sizeof(struct cce_buffer) + size);
+   mapped->data = fileData;
+   mapped->size = fileSize;
+   struct cce_buffer *buffer = (struct cce_buffer*)(mapped + 1);
+   buffer->sectionsQuantity = header.headSize;
+   buffer->flags = CCE_BUFFER_MAPPED;
+   buffer->loadingFunctionBlockID = functionSetID;
+   size_t *offsets = currentFunctions->readingFunctionsDataBufferOffsets;
+   cce_void *data = (cce_void*)(buffer + 1);
+   struct cce_mappedcursor cursor = {fileData + offset, fileData + fileSize};
+   // Checksums would make every page of the mapping be read, so they are only verified on request
+   const uint8_t verify = (header.version == CCE_CCF_VERSION && (currentFunctions->checksums & CCE_CCF_VERIFY_CHECKSUMS));
+   
+   for (unsigned i = 0; i < header.loaders; ++i)
+   {
+      uint16_t id = header.ids[i];
+      sectionsInitialized[id] = 1;
+      int status;
+      if (header.version)
+      {
+         if (fileSize - offset < header.storedSizes[i])
+         {
+            fprintf(stderr, "ENGINE::FILE_IO::CORRUPTED_SECTION:\nSection %u is truncated\n", i);
+            errorLoader = id;
+            goto ERROR;
+         }
+         uint32_t checksum;
+         if (verify && (checksum = cceCRC32C(0, fileData + offset, header.storedSizes[i])) != header.checksums[i])
+         {
+            reportChecksumMismatch(&header, i, checksum);
+            errorLoader = id;
+            goto ERROR;
+         }
+         cursor = (struct cce_mappedcursor){fileData + offset, fileData + offset + header.storedSizes[i]};
+         offset += header.storedSizes[i];
+      }
+      if (header.codecs[i] != CCE_CCF_CODEC_NONE)
+      {
+         status = readCompressedSection(currentFunctions->readingFunctions[id], data + offsets[id], header.sectionSizes[i], buffer,
+                                        cursor.position, header.storedSizes[i], header.rawSizes[i]);
+      }
+      else if (currentFunctions->mappedReadingFunctions[id] != NULL)
+      {
+         status = (currentFunctions->mappedReadingFunctions[id])(data + offsets[id], header.sectionSizes[i], buffer, &cursor);
+      }
+      else if (file != NULL || (file = fopen(path, "rb")) != NULL)
+      {
+         // Section can only be streamed, so it continues from the same place in file
+         fseek(file, cursor.position - fileData, SEEK_SET);
+         status = (currentFunctions->readingFunctions[id])(data + offsets[id], header.sectionSizes[i], buffer, file);
+         cursor.position = fileData + ftell(file);
+      }
+      else
+      {
+         status = -1;
+      }
+      if (status == 0)
+         continue;
+      
+      errorLoader = id;
+      goto ERROR;
+   }
+   if (file != NULL)
+      fclose(file);
+   for (unsigned i = 0; i < header.headSize; ++i)
+   {
+      if (sectionsInitialized[i] != 0 || currentFunctions->creatingFunctions[i] == NULL)
+         continue;
+      currentFunctions->creatingFunctions[i](data + offsets[i], buffer);
+   }
+   return buffer;
+ERROR:
+   if (file != NULL)
+      fclose(file);
+   for (cce_dataparsefun *fun = currentFunctions->freeingFunctions, *end = currentFunctions->freeingFunctions + errorLoader;
+        fun < end; ++fun, ++offsets)
+   {
+      (*fun)(data + *offsets, buffer);
+   }
+   cceUnmapFile(fileData, fileSize);
+   free(mapped);
+   return NULL;
+}
+
 CCE_API int cceWriteBinaryCCF (struct cce_buffer *buffer, char *path)
 {
-   FILE *file = fopen(path, "wb+");
+   // File is written next to the target and replaces it only when complete, so failed save never leaves half-written file
+   size_t pathLength = strlen(path);
+   char *tmpPath = malloc(pathLength + sizeof(".tmp"));
+   memcpy(tmpPath, path, pathLength);
+   memcpy(tmpPath + pathLength, ".tmp", sizeof(".tmp"));
+   FILE *file = fopen(tmpPath, "wb+");
    if (file == NULL)
    {
+      free(tmpPath);
       return -1;
    }
+   setvbuf(file, NULL, _IOFBF, CCE_CCF_WRITE_BUFFER_SIZE);
    struct cce_IO_function_set *currentFunctions = IOfunctionSet + buffer->loadingFunctionBlockID;
-   uint16_t sectionSizes[255] = {0};
+   uint32_t uids[255], sectionSizes[255], storedSizes[255], rawSizes[255], checksums[255];
+   uint8_t  codecs[255];
    uint8_t headSize = buffer->sectionsQuantity;
-   fseek(file, (headSize) * (sizeof(uint16_t) + sizeof(uint32_t)) + sizeof(uint8_t), SEEK_SET);
+   const uint8_t compress = (currentFunctions->codec != CCE_CCF_CODEC_NONE);
+   const uint8_t checksum = (currentFunctions->checksums & CCE_CCF_WRITE_CHECKSUMS) != 0;
+   // Files without compression and checksums keep legacy header which older versions of the engine can read
+   const uint8_t version = checksum ? CCE_CCF_VERSION : compress ? CCE_CCF_UNCHECKED_VERSION : 0;
+   long reservedHeaderSize = getCCFheaderSize(version, headSize);
+   fseek(file, reservedHeaderSize, SEEK_SET);
    size_t *offsets = currentFunctions->readingFunctionsDataBufferOffsets;
-   size_t bytesWritten = 0;
-   uint16_t *sectionSizesIt = sectionSizes;
+   uint8_t *scratch = NULL;
+   size_t scratchSize = 0;
    
-   for (cce_fwritefun *fun = currentFunctions->writingFunctions, *end = currentFunctions->writingFunctions + buffer->sectionsQuantity;
-        fun < end; ++fun, ++sectionSizesIt, ++offsets)
+   for (unsigned i = 0; i < headSize; ++i, ++offsets)
    {
-      *sectionSizesIt = (*fun)((cce_void*)(buffer + 1) + *offsets, buffer, file);
-   }
-   bytesWritten = ftell(file) - headSize * (sizeof(uint16_t) + 8 * sizeof(char)) - sizeof(uint8_t);
-   fseek(file, (headSize + 1) * sizeof(uint8_t), SEEK_SET);
-   uint32_t uids[255];
-   {
-      unsigned zeroSum = 0;
-      for (unsigned i = 0; i < headSize; ++i)
+      long begin = ftell(file);
+      sectionSizes[i] = (currentFunctions->writingFunctions[i])((cce_void*)(buffer + 1) + *offsets, buffer, file);
+      long end = ftell(file);
+      rawSizes[i] = storedSizes[i] = end - begin;
+      codecs[i] = CCE_CCF_CODEC_NONE;
+      checksums[i] = 0;
+      const uint8_t compressSection = (compress && rawSizes[i] >= CCE_CCF_MIN_COMPRESSED_SIZE);
+      if (sectionSizes[i] == 0 || rawSizes[i] == 0 || !(checksum || compressSection))
+         continue;
+      
+      // Section is read back to be checksummed and replaced with compressed one if that's smaller
+      if (scratchSize < 2u * rawSizes[i])
+         scratch = realloc(scratch, scratchSize = 2u * rawSizes[i]);
+      fseek(file, begin, SEEK_SET);
+      if (fread(scratch, sizeof(uint8_t), rawSizes[i], file) != rawSizes[i])
       {
-         uids[i - zeroSum] = currentFunctions->sectionUIDs[i];
-         sectionSizes[i - zeroSum] = sectionSizes[i];
-         zeroSum += (sectionSizes[i] == 0);
+         fseek(file, end, SEEK_SET);
+         continue;
       }
-      
-      if (zeroSum > 0)
+      size_t compressedSize = compressSection ? cceCompressLZ(scratch, rawSizes[i], scratch + rawSizes[i], rawSizes[i] - 1u) : 0;
+      if (compressedSize == 0)
       {
-         headSize -= zeroSum;
-         cceMoveFileContent(file, zeroSum * (sizeof(uint16_t) + 8 * sizeof(char)), SEEK_CUR, bytesWritten);
-         cceTruncateFile(file, bytesWritten + sizeof(uint8_t) + headSize * (sizeof(uint16_t) + 8 * sizeof(char)));
+         checksums[i] = checksum ? cceCRC32C(0, scratch, rawSizes[i]) : 0;
+         fseek(file, end, SEEK_SET);
+         continue;
       }
+      fseek(file, begin, SEEK_SET);
+      fwrite(scratch + rawSizes[i], sizeof(uint8_t), compressedSize, file);
+      storedSizes[i] = compressedSize;
+      checksums[i] = checksum ? cceCRC32C(0, scratch + rawSizes[i], compressedSize) : 0;
+      codecs[i] = currentFunctions->codec;
+   }
+   free(scratch);
+   long bodySize = ftell(file) - reservedHeaderSize;
+   uint8_t sectionsWritten = 0;
+   for (unsigned i = 0; i < headSize; ++i)
+   {
+      if (sectionSizes[i] == 0)
+         continue;
+      uids[sectionsWritten] = currentFunctions->sectionUIDs[i];
+      sectionSizes[sectionsWritten] = sectionSizes[i];
+      storedSizes[sectionsWritten] = storedSizes[i];
+      rawSizes[sectionsWritten] = rawSizes[i];
+      checksums[sectionsWritten] = checksums[i];
+      codecs[sectionsWritten] = codecs[i];
+      ++sectionsWritten;
    }
+   long headerSize = getCCFheaderSize(version, sectionsWritten);
+   if (headerSize != reservedHeaderSize)
+   {
+      // Sections with nothing to store left unused space in the header
+      fseek(file, reservedHeaderSize, SEEK_SET);
+      cceMoveFileContent(file, headerSize, SEEK_SET, bodySize);
+   }
+   // Compressed sections may leave stale bytes behind the end
+   fflush(file);
+   cceTruncateFile(file, headerSize + bodySize);
    fseek(file, 0, SEEK_SET);
-   fwrite(&headSize, sizeof(uint8_t), 1, file);
-   fwrite(uids, sizeof(uint32_t), headSize, file);
-   fwrite(sectionSizes, sizeof(uint16_t), headSize, file);
-   fclose(file);
-   return 0;
+   if (version)
+   {
+      uint8_t head[3] = {0, version, sectionsWritten};
+      fwrite(head, sizeof(uint8_t), 3, file);
+      if (cceEndianess == CCE_BIG_ENDIAN)
+      {
+         cceBigEndianToLittleEndianArrayInt32(uids, sectionsWritten);
+         cceBigEndianToLittleEndianArrayInt32(sectionSizes, sectionsWritten);
+         cceBigEndianToLittleEndianArrayInt32(storedSizes, sectionsWritten);
+         cceBigEndianToLittleEndianArrayInt32(rawSizes, sectionsWritten);
+         cceBigEndianToLittleEndianArrayInt32(checksums, sectionsWritten);
+      }
+      fwrite(uids, sizeof(uint32_t), sectionsWritten, file);
+      fwrite(sectionSizes, sizeof(uint32_t), sectionsWritten, file);
+      fwrite(storedSizes, sizeof(uint32_t), sectionsWritten, file);
+      fwrite(rawSizes, sizeof(uint32_t), sectionsWritten, file);
+      if (checksum)
+         fwrite(checksums, sizeof(uint32_t), sectionsWritten, file);
+      fwrite(codecs, sizeof(uint8_t), sectionsWritten, file);
+   }
+   else
+   {
+      uint16_t legacySectionSizes[255];
+      for (unsigned i = 0; i < sectionsWritten; ++i)
+         legacySectionSizes[i] = sectionSizes[i];
+      fwrite(&sectionsWritten, sizeof(uint8_t), 1, file);
+      fwrite(uids, sizeof(uint32_t), sectionsWritten, file);
+      fwrite(legacySectionSizes, sizeof(uint16_t), sectionsWritten, file);
+   }
+   
+   int result = (ferror(file) == 0 && cceFlushFileToDisk(file) == 0) - 1;
+   result = (fclose(file) == 0 && result == 0 && cceReplaceFile(tmpPath, path) == 0) - 1;
+   if (result != 0)
+   {
+      fprintf(stderr, "ENGINE::FILE_IO::WRITE_ERROR:\nFailed to write %s, previous file is left intact\n", path);
+      remove(tmpPath);
+   }
+   free(tmpPath);
+   return result;
 }
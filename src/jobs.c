@@ -0,0 +1,266 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/cce/jobs.h"
+#include "../include/cce/profiler.h"
+#include "../include/cce/utils.h"
+
+#include "../include/cce/engine_common_internal.h"
+#include "platform/threads.h"
+
+/* Deques are ring buffers with their own locks (engine has no atomics, so they aren't lock-free): owner pushes and pops
+ * the newest jobs at the bottom, thieves take the oldest ones from the top. Deque 0 is shared by threads which aren't workers.
+ * Counters, the submission generation and termination are guarded by the common mutex, all sleeping threads wait on one condition */
+
+#define CCE_JOB_WORKERS_MAX 64u
+#define CCE_JOB_DEQUE_INITIAL_SIZE 64u
+
+struct queuedjob
+{
+   struct cce_job         job;
+   struct cce_jobcounter *counter;
+};
+
+struct jobdeque
+{
+   struct cce__mutex *mutex;
+   struct queuedjob  *jobs;
+   uint32_t top;
+   uint32_t bottom;
+   uint32_t allocated; // Power of two, indices wrap around
+};
+
+static struct
+{
+   struct cce__mutex     *mutex;
+   struct cce__condition *wake; // Jobs are submitted, counter reaches zero or workers are terminated
+   struct cce__thread    *workers[CCE_JOB_WORKERS_MAX];
+   struct jobdeque        deques[CCE_JOB_WORKERS_MAX + 1u];
+   uint32_t generation; // Incremented by every submission, so that thread going to sleep doesn't miss jobs queued while it searched
+   uint32_t workersQuantity;
+   uint8_t  started;
+   uint8_t  terminate;
+}
+g_jobs;
+
+static CCE_THREAD_LOCAL uint32_t t_deque; // Index of the deque of worker, 0 for other threads
+
+static void pushJob (struct jobdeque *deque, struct queuedjob job)
+{
+   if (deque->bottom - deque->top >= deque->allocated)
+   {
+      uint32_t allocated = (deque->allocated > 0) ? deque->allocated * 2u : CCE_JOB_DEQUE_INITIAL_SIZE;
+      struct queuedjob *jobs = malloc(allocated * sizeof(struct queuedjob));
+      for (uint32_t i = deque->top; i != deque->bottom; ++i)
+         jobs[i & (allocated - 1u)] = deque->jobs[i & (deque->allocated - 1u)];
+      free(deque->jobs);
+      deque->jobs = jobs;
+      deque->allocated = allocated;
+   }
+   deque->jobs[(deque->bottom++) & (deque->allocated - 1u)] = job;
+}
+
+static uint8_t popJob (struct jobdeque *deque, struct queuedjob *job, uint8_t steal)
+{
+   cce__lockMutex(deque->mutex);
+   uint8_t found = (deque->top != deque->bottom);
+   if (found)
+      *job = steal ? deque->jobs[(deque->top++) & (deque->allocated - 1u)] : deque->jobs[(--deque->bottom) & (deque->allocated - 1u)];
+   cce__unlockMutex(deque->mutex);
+   return found;
+}
+
+// Own deque first, then the others starting from the next one, so that thieves spread over victims
+static uint8_t takeJob (struct queuedjob *job)
+{
+   const uint32_t dequesQuantity = g_jobs.workersQuantity + 1u;
+   if (popJob(g_jobs.deques + t_deque, job, 0))
+      return 1;
+   for (uint32_t i = 1; i < dequesQuantity; ++i)
+   {
+      if (popJob(g_jobs.deques + (t_deque + i) % dequesQuantity, job, 1))
+         return 1;
+   }
+   return 0;
+}
+
+static void runJob (const struct queuedjob *job)
+{
+   CCE_PROFILE_SCOPE("job") job->job.fn(job->job.data);
+   if (job->counter == NULL)
+      return;
+   cce__lockMutex(g_jobs.mutex);
+   if (--(job->counter->value) == 0)
+      cce__broadcastCondition(g_jobs.wake);
+   cce__unlockMutex(g_jobs.mutex);
+}
+
+// Queued jobs are finished before worker exits on termination
+static void jobWorker (void *data)
+{
+   t_deque = (uint32_t)(uintptr_t) data;
+   struct queuedjob job;
+   cce__lockMutex(g_jobs.mutex);
+   for (;;)
+   {
+      const uint32_t generation = g_jobs.generation;
+      cce__unlockMutex(g_jobs.mutex);
+      while (takeJob(&job))
+         runJob(&job);
+      cce__lockMutex(g_jobs.mutex);
+      if (g_jobs.terminate && generation == g_jobs.generation)
+         break;
+      while (!g_jobs.terminate && generation == g_jobs.generation)
+         cce__waitCondition(g_jobs.wake, g_jobs.mutex);
+   }
+   cce__unlockMutex(g_jobs.mutex);
+}
+
+static void freeJobs (void)
+{
+   if (g_jobs.workersQuantity > 0)
+   {
+      cce__lockMutex(g_jobs.mutex);
+      g_jobs.terminate = 1;
+      cce__broadcastCondition(g_jobs.wake);
+      cce__unlockMutex(g_jobs.mutex);
+      for (struct cce__thread **iterator = g_jobs.workers, **end = g_jobs.workers + g_jobs.workersQuantity; iterator < end; ++iterator)
+         cce__joinThread(*iterator);
+   }
+   for (struct jobdeque *iterator = g_jobs.deques, *end = g_jobs.deques + CCE_JOB_WORKERS_MAX + 1u; iterator < end; ++iterator)
+   {
+      cce__freeMutex(iterator->mutex);
+      free(iterator->jobs);
+   }
+   cce__freeCondition(g_jobs.wake);
+   cce__freeMutex(g_jobs.mutex);
+   memset(&g_jobs, 0, sizeof(g_jobs));
+}
+
+static void startWorkers (void)
+{
+   g_jobs.started = 1;
+   const uint32_t workersQuantity = CCE_MIN(cce__getHardwareThreadsQuantity() - 1u, CCE_JOB_WORKERS_MAX);
+   if (workersQuantity == 0)
+      return;
+   g_jobs.mutex = cce__createMutex();
+   g_jobs.wake = cce__createCondition();
+   uint8_t failed = (g_jobs.mutex == NULL || g_jobs.wake == NULL);
+   for (struct jobdeque *iterator = g_jobs.deques, *end = g_jobs.deques + workersQuantity + 1u; iterator < end && !failed; ++iterator)
+   {
+      iterator->mutex = cce__createMutex();
+      failed = (iterator->mutex == NULL);
+   }
+   if (failed)
+   {
+      fputs("ENGINE::JOBS::SYNCHRONIZATION_FAILURE:\nCan't create mutex or condition variable, jobs will run on submission\n", stderr);
+      freeJobs();
+      g_jobs.started = 1;
+      return;
+   }
+   // Workers steal from each other, so their quantity has to be known before the first one starts
+   g_jobs.workersQuantity = workersQuantity;
+   uint32_t started = 0;
+   for (; started < workersQuantity; ++started)
+   {
+      g_jobs.workers[started] = cce__createThread(jobWorker, (void*)(uintptr_t)(started + 1u));
+      if (g_jobs.workers[started] == NULL)
+         break;
+   }
+   if (started < workersQuantity)
+   {
+      fprintf(stderr, "ENGINE::JOBS::THREAD_CREATION_FAILURE:\nOnly %u of %u workers are started\n", started, workersQuantity);
+      g_jobs.workersQuantity = started;
+   }
+}
+
+/* Any thread which isn't a worker may be the first to submit, so start and termination are serialized by the static mutex.
+ * Workers exist only after the start and are joined by termination, so they skip it (and can't deadlock with termination) */
+static void startJobs (void)
+{
+   if (t_deque != 0)
+      return;
+   struct cce__mutex *mutex = cce__getStaticMutex();
+   cce__lockMutex(mutex);
+   if (!g_jobs.started)
+      startWorkers();
+   cce__unlockMutex(mutex);
+}
+
+CCE_API void cceSubmitJobs (const struct cce_job *jobs, uint32_t quantity, struct cce_jobcounter *counter)
+{
+   startJobs();
+   if (g_jobs.workersQuantity == 0)
+   {
+      for (const struct cce_job *iterator = jobs, *end = jobs + quantity; iterator < end; ++iterator)
+         CCE_PROFILE_SCOPE("job") iterator->fn(iterator->data);
+      return;
+   }
+   struct jobdeque *deque = g_jobs.deques + t_deque;
+   cce__lockMutex(g_jobs.mutex);
+   if (counter != NULL)
+      counter->value += quantity;
+   cce__lockMutex(deque->mutex);
+   for (const struct cce_job *iterator = jobs, *end = jobs + quantity; iterator < end; ++iterator)
+      pushJob(deque, (struct queuedjob){*iterator, counter});
+   cce__unlockMutex(deque->mutex);
+   ++(g_jobs.generation);
+   cce__broadcastCondition(g_jobs.wake);
+   cce__unlockMutex(g_jobs.mutex);
+}
+
+CCE_API void cceWaitForJobCounter (struct cce_jobcounter *counter)
+{
+   if (g_jobs.workersQuantity == 0)
+      return;
+   struct queuedjob job;
+   cce__lockMutex(g_jobs.mutex);
+   while (counter->value != 0)
+   {
+      const uint32_t generation = g_jobs.generation;
+      cce__unlockMutex(g_jobs.mutex);
+      const uint8_t found = takeJob(&job);
+      if (found)
+         runJob(&job);
+      cce__lockMutex(g_jobs.mutex);
+      // Counted jobs are being run by other threads
+      while (!found && counter->value != 0 && generation == g_jobs.generation)
+         cce__waitCondition(g_jobs.wake, g_jobs.mutex);
+   }
+   cce__unlockMutex(g_jobs.mutex);
+}
+
+CCE_API uint32_t cceGetJobWorkersQuantity (void)
+{
+   startJobs();
+   return g_jobs.workersQuantity;
+}
+
+void cce__terminateJobs (void)
+{
+   struct cce__mutex *mutex = cce__getStaticMutex();
+   cce__lockMutex(mutex);
+   if (g_jobs.started)
+      freeJobs();
+   cce__unlockMutex(mutex);
+}
@@ -0,0 +1,136 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../include/cce/engine_common.h"
+#include "../../include/cce/engine_common_keyboard.h"
+#include "../../include/cce/utils.h"
+
+#include "../../include/cce/engine_common_internal.h"
+
+#define CCE_DPAD_BUTTONS (CCE_BUTTON_DPAD_UP | CCE_BUTTON_DPAD_RIGHT | CCE_BUTTON_DPAD_DOWN | CCE_BUTTON_DPAD_LEFT)
+
+static struct gamepadmapping
+{
+   float    deadzone;
+   int8_t   keyAxisValue;               // D-pad moves its axis pair as keys bound to it do
+   int8_t   axes[CCE_GAMEPAD_LAYOUT_AXES]; // Mapped values of the last update
+   uint16_t buttons;
+   uint8_t  connected;                  // Physical gamepad, playback doesn't change it
+}
+g_mappings[CCE_GAMEPADS_MAX];
+
+static const uint8_t g_axesOffsets[CCE_GAMEPAD_LAYOUT_AXES] = {0, 1, 4, 5, 6, 7};
+
+// Called on initialization, gamepads state is reset by cceInit too
+void cce__setGamepadsMapping (const struct cce_ini_keys *keys)
+{
+   for (struct gamepadmapping *iterator = g_mappings, *end = g_mappings + CCE_GAMEPADS_MAX; iterator < end; ++iterator, ++keys)
+   {
+      iterator->deadzone = keys->deadzone;
+      iterator->keyAxisValue = keys->keyAxisValue;
+      memset(iterator->axes, 0, sizeof(iterator->axes));
+      iterator->buttons = 0;
+      iterator->connected = 0;
+   }
+}
+
+void cce__updateGamepad (uint8_t gamepad, const struct cce__gamepadstate *state)
+{
+   static const uint16_t bits[CCE_GAMEPAD_LAYOUT_BUTTONS] = {CCE_BUTTON_A, CCE_BUTTON_B, CCE_BUTTON_X, CCE_BUTTON_Y, CCE_BUTTON_L, CCE_BUTTON_R,
+                                                             CCE_BUTTON_BACK, CCE_BUTTON_START, 0, CCE_BUTTON_STICK_L, CCE_BUTTON_STICK_R,
+                                                             CCE_BUTTON_DPAD_UP, CCE_BUTTON_DPAD_RIGHT, CCE_BUTTON_DPAD_DOWN, CCE_BUTTON_DPAD_LEFT}; // guide button is ignored
+   const uint8_t *offsets = g_axesOffsets;
+   struct gamepadmapping *mapping = g_mappings + (gamepad - 1);
+   const float deadzone = mapping->deadzone, maxValueDeadzoneCorrected = INT8_MAX / (1.0f - deadzone);
+   const int8_t keyAxisValue = mapping->keyAxisValue;
+   uint16_t buttons = 0;
+   for (uint8_t i = 0; i < CCE_GAMEPAD_LAYOUT_BUTTONS; ++i)
+      buttons |= -(state->buttons[i] != 0) & bits[i];
+   for (uint8_t i = 0; i < 4u; ++i)
+   {
+      const float value = state->axes[i];
+      const int8_t axis = (CCE_ABS(value) > deadzone) ? (value - (1 - ((signbit(value) != 0) << 1)) * deadzone) * maxValueDeadzoneCorrected : 0;
+      if (axis == mapping->axes[i])
+         continue;
+      cce__setGamepadAxis(gamepad, offsets[i], axis);
+      mapping->axes[i] = axis;
+   }
+   if ((buttons ^ mapping->buttons) & CCE_DPAD_BUTTONS)
+   {
+      cce__setGamepadAxis(gamepad, 2u, (-((buttons & CCE_BUTTON_DPAD_LEFT) != 0) & -keyAxisValue) + (-((buttons & CCE_BUTTON_DPAD_RIGHT) != 0) & keyAxisValue));
+      cce__setGamepadAxis(gamepad, 3u, (-((buttons & CCE_BUTTON_DPAD_DOWN) != 0) & -keyAxisValue) + (-((buttons & CCE_BUTTON_DPAD_UP)    != 0) & keyAxisValue));
+   }
+   for (uint8_t i = 4u; i < CCE_GAMEPAD_LAYOUT_AXES; ++i)
+   {
+      const int8_t axis = state->axes[i] * INT8_MAX;
+      buttons |= -(axis > 0) & ((i == 4u) ? CCE_TRIGGER_L : CCE_TRIGGER_R);
+      if (axis == mapping->axes[i])
+         continue;
+      cce__setGamepadAxis(gamepad, offsets[i], axis);
+      mapping->axes[i] = axis;
+   }
+   for (uint16_t changed = buttons ^ mapping->buttons, bit = 0; changed != 0; changed >>= 1, ++bit)
+   {
+      if (changed & 1u)
+         cce__setGamepadButton(gamepad, (uint8_t) bit, (buttons >> bit) & 1u);
+   }
+   mapping->buttons = buttons;
+}
+
+void cce__plugGamepad (uint8_t gamepad, uint8_t connected)
+{
+   struct gamepadmapping *mapping = g_mappings + (gamepad - 1);
+   mapping->connected = connected;
+   if (connected)
+   {
+      // The first update reports the whole state of the gamepad
+      memset(mapping->axes, 0, sizeof(mapping->axes));
+      mapping->buttons = 0;
+   }
+   else
+   {
+      const struct cce__gamepadstate released = {.axes = {0.0f, 0.0f, 0.0f, 0.0f, -1.0f, -1.0f}};
+      cce__updateGamepad(gamepad, &released);
+   }
+   cce__setGamepadConnected(gamepad, connected);
+}
+
+uint8_t cce__isGamepadPlugged (uint8_t gamepad)
+{
+   return g_mappings[gamepad - 1].connected;
+}
+
+/* After playback mappings take the state the game sees, so that the next update reports what differs on physical gamepads.
+ * Gamepads plugged or unplugged during playback are reported right away */
+void cce__syncGamepadsMapping (void)
+{
+   for (uint8_t gamepad = 1; gamepad <= CCE_GAMEPADS_MAX; ++gamepad)
+   {
+      struct gamepadmapping *mapping = g_mappings + (gamepad - 1);
+      const struct cce__gamepad *pad = cce__gamepads + (gamepad - 1);
+      mapping->buttons = pad->buttons ^ pad->buttonsDiff;
+      for (uint8_t i = 0; i < CCE_GAMEPAD_LAYOUT_AXES; ++i)
+         mapping->axes[i] = pad->axes[g_axesOffsets[i]];
+      if (mapping->connected != pad->connected)
+         cce__plugGamepad(gamepad, mapping->connected);
+   }
+}
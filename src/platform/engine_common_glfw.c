@@ -59,6 +59,7 @@ struct key_glfw
 {
    int16_t key;
    uint8_t fn;
+   uint8_t gamepad;
 };
 
 #define BUTTON_A 0
@@ -91,11 +92,9 @@ struct key_glfw
 static struct key_glfw *g_keys;
 static uint8_t          g_keysQuantity;
 
+static uint8_t g_joystickGamepads[GLFW_JOYSTICK_LAST + 1]; // Gamepad number of the joystick, 0 if it isn't mapped
 static uint8_t g_gamepads;
-static uint16_t g_lastButtonsState;
-static int8_t gamepadAxes[6];
-static float g_deadzone, g_maxValueDeadzoneCorrected;
-static int8_t g_keyWeight;
+static int8_t  g_keyWeights[CCE_GAMEPADS_MAX];
 
 static uint8_t cceKeyFromGLFWkey (int16_t key);
 static int16_t cceKeyToGLFWkey (uint8_t key);
@@ -107,74 +106,45 @@ static int keycompare (const void *_a, const void *_b)
    return (a->key > b->key) - (a->key < b->key);
 }
 
-// Accounts for deadzone
-#define getGamepadAxisValue(val) ((CCE_ABS(val) > g_deadzone) ? ((val - (1 - ((signbit(val) != 0) << 1)) * g_deadzone) * g_maxValueDeadzoneCorrected) : 0)
-
-// This code is terrible
 static void processGamepads (void)
 {
-   GLFWgamepadstate gamepad;
-   memset(gamepad.axes, 0, 6 * sizeof(float));
-   uint16_t buttonsState = 0;
-   for (uint8_t gamepadNum = 0, i = GLFW_JOYSTICK_1; gamepadNum < g_gamepads; ++i)
+   for (int jid = GLFW_JOYSTICK_1; jid <= GLFW_JOYSTICK_LAST; ++jid)
    {
-      const uint16_t bits[15] = {CCE_BUTTON_A, CCE_BUTTON_B, CCE_BUTTON_X, CCE_BUTTON_Y, CCE_BUTTON_L, CCE_BUTTON_R, CCE_BUTTON_BACK, CCE_BUTTON_START,
-                                 0, CCE_BUTTON_STICK_L, CCE_BUTTON_STICK_R, CCE_BUTTON_DPAD_UP, CCE_BUTTON_DPAD_RIGHT, CCE_BUTTON_DPAD_DOWN, CCE_BUTTON_DPAD_LEFT}; // guide button is ignored
-      const uint16_t *bit = bits;
-      GLFWgamepadstate tmp;
-      if (glfwGetGamepadState(GLFW_JOYSTICK_1, &tmp) == GLFW_FALSE)
+      GLFWgamepadstate state;
+      if (g_joystickGamepads[jid] == 0 || glfwGetGamepadState(jid, &state) == GLFW_FALSE)
          continue;
-      ++gamepadNum;
-      for (unsigned char *it = tmp.buttons, *end = tmp.buttons + GLFW_GAMEPAD_BUTTON_LAST + 1; it < end; ++it, ++bit)
-      {
-         buttonsState |= -(*it) & *bit;
-      }
-      for (float *it = tmp.axes, *jit = gamepad.axes, *end = tmp.axes + GLFW_GAMEPAD_AXIS_LAST + 1; it < end; ++it, ++jit)
-      {
-         *jit += *it;
-      }
+      struct cce__gamepadstate gamepad;
+      memcpy(gamepad.buttons, state.buttons, sizeof(gamepad.buttons));
+      memcpy(gamepad.axes, state.axes, sizeof(gamepad.axes));
+      cce__updateGamepad(g_joystickGamepads[jid], &gamepad);
    }
-   const uint8_t offsets[6] = {0, 1, 4, 5, 6, 7};
-   const uint8_t *offset = offsets;
-   int8_t *lastAxeIt = gamepadAxes;
-   int8_t axis;
-   const uint16_t bits[2] = {CCE_TRIGGER_L, CCE_TRIGGER_R};
-   const uint16_t *bit = bits;
-   for (float *it = gamepad.axes, *end = gamepad.axes + 4; it < end; ++it, ++offset, ++lastAxeIt)
-   {
-      axis = getGamepadAxisValue(*it);
-      if (axis == *lastAxeIt)
-         continue;
-      cce__axes[*offset] = axis;
-      cce__axesPairChanged |= 1 << (*offset >> 1);
-      *lastAxeIt = axis;
-   }
-   if ((buttonsState ^ g_lastButtonsState) & (CCE_BUTTON_DPAD_UP | CCE_BUTTON_DPAD_RIGHT | CCE_BUTTON_DPAD_DOWN | CCE_BUTTON_DPAD_LEFT))
-   {
-      cce__axes[2] = (-((buttonsState & CCE_BUTTON_DPAD_LEFT) == CCE_BUTTON_DPAD_LEFT) & -g_keyWeight) + (-((buttonsState & CCE_BUTTON_DPAD_RIGHT) == CCE_BUTTON_DPAD_RIGHT) & g_keyWeight);
-      cce__axes[3] = (-((buttonsState & CCE_BUTTON_DPAD_DOWN) == CCE_BUTTON_DPAD_DOWN) & -g_keyWeight) + (-((buttonsState & CCE_BUTTON_DPAD_UP)    == CCE_BUTTON_DPAD_UP)    & g_keyWeight);
-      cce__axesPairChanged |= 0x2;
-   }
-   for (float *it = gamepad.axes + 4, *end = gamepad.axes + 6; it < end; ++it, ++offset, ++lastAxeIt, ++bit)
+}
+
+// Connected gamepads get free numbers in order of connection, the ones which don't fit wait for a free number
+static void mapJoysticks (void)
+{
+   for (int jid = GLFW_JOYSTICK_1; jid <= GLFW_JOYSTICK_LAST && g_gamepads < CCE_GAMEPADS_MAX; ++jid)
    {
-      axis = *it * INT8_MAX;
-      buttonsState |= -(axis > 0) & *bit;
-      if (axis == *lastAxeIt)
+      if (g_joystickGamepads[jid] != 0 || glfwJoystickIsGamepad(jid) == GLFW_FALSE)
          continue;
-      cce__axes[*offset] = axis;
-      cce__axesPairChanged |= 1 << (*offset >> 1);
-      *lastAxeIt = axis;
+      uint8_t gamepad = 1;
+      while (cce__isGamepadPlugged(gamepad))
+         ++gamepad;
+      g_joystickGamepads[jid] = gamepad;
+      ++g_gamepads;
+      cce__plugGamepad(gamepad, 1);
    }
-   cce__buttonsBitFieldDiff |= buttonsState ^ g_lastButtonsState;
-   g_lastButtonsState = buttonsState;
 }
 
 static void joystickCallback__glfw (int jid, int event)
 {
-   if (glfwJoystickIsGamepad(jid) == GLFW_TRUE)
+   if (event == GLFW_DISCONNECTED && g_joystickGamepads[jid] != 0)
    {
-      g_gamepads += (((event & (GLFW_CONNECTED | GLFW_DISCONNECTED)) << 1) - 3);
+      cce__plugGamepad(g_joystickGamepads[jid], 0);
+      g_joystickGamepads[jid] = 0;
+      --g_gamepads;
    }
+   mapJoysticks();
 }
 
 static void engineUpdate__glfw (void)
@@ -400,11 +370,16 @@ static void keyCallback (GLFWwindow *window, int key, int scancode, int action,
    CCE_UNUSED(scancode);
    if (action == GLFW_REPEAT)
       return;
-   struct key_glfw tofind = {key, 0};
+   cce__pushInputEvent(CCE_INPUT_EVENT_KEY, cceKeyFromGLFWkey(key), action, CCE_INPUT_KEYBOARD);
+   struct key_glfw tofind = {key, 0, 0};
    struct key_glfw *keySt = (struct key_glfw*)bsearch(&tofind, g_keys, g_keysQuantity, sizeof(struct key_glfw), keycompare);
-   if (keySt != NULL)
+   // Key may be bound on several gamepads
+   while (keySt != NULL && keySt > g_keys && keySt[-1].key == key)
+      --keySt;
+   for (const struct key_glfw *end = g_keys + g_keysQuantity; keySt != NULL && keySt < end && keySt->key == key; ++keySt)
    {
-      uint16_t buttonfn = keySt->fn;
+      const uint8_t buttonfn = keySt->fn, gamepad = keySt->gamepad;
+      const int8_t keyWeight = (gamepad > 0) ? g_keyWeights[gamepad - 1] : 0;
       switch (buttonfn)
       {
          case KEY_FULLSCREEN:
@@ -417,8 +392,7 @@ static void keyCallback (GLFWwindow *window, int key, int scancode, int action,
             break;
          case TRIGGER_L:
          case TRIGGER_R:
-            cce__axes[6 + (buttonfn - TRIGGER_L)] = (-action & (g_keyWeight * 2)) - g_keyWeight;
-            cce__axesPairChanged |= 0x8;
+            cce__setGamepadAxis(gamepad, 6 + (buttonfn - TRIGGER_L), (-action & (keyWeight * 2)) - keyWeight);
             // fallthrough
          case BUTTON_A:
          case BUTTON_B:
@@ -430,15 +404,13 @@ static void keyCallback (GLFWwindow *window, int key, int scancode, int action,
          case BUTTON_STICK_R:
          case BUTTON_BACK:
          case BUTTON_START:
-            cce__buttonsBitFieldDiff &= ~(1 << buttonfn);
-            cce__buttonsBitFieldDiff |= (-action & (1 << buttonfn)) ^ cce__buttonsBitField;
+            cce__setGamepadButton(gamepad, buttonfn, action);
             break;
          case DPAD_LEFT:
          case DPAD_RIGHT:
          case DPAD_DOWN:
          case DPAD_UP:
-            cce__buttonsBitFieldDiff &= ~(1 << (buttonfn - 5));
-            cce__buttonsBitFieldDiff |= (-action & (1 << (buttonfn - 5))) ^ cce__buttonsBitField;
+            cce__setGamepadButton(gamepad, buttonfn - 5, action);
             // fallthrough
          case LEFT_STICK_LEFT:
          case LEFT_STICK_RIGHT:
@@ -448,8 +420,7 @@ static void keyCallback (GLFWwindow *window, int key, int scancode, int action,
          case RIGHT_STICK_RIGHT:
          case RIGHT_STICK_DOWN:
          case RIGHT_STICK_UP:
-            cce__axes[((buttonfn + 1) >> 1) - 7] = ((1 - ((buttonfn & 1) << 1)) * g_keyWeight) & -action;
-            cce__axesPairChanged |= 1 << ((((buttonfn + 1) >> 1) - 7) >> 1);
+            cce__setGamepadAxis(gamepad, ((buttonfn + 1) >> 1) - 7, ((1 - ((buttonfn & 1) << 1)) * keyWeight) & -action);
             break;
       }
    }
@@ -563,6 +534,7 @@ int initEngine__glfw (void *data)
    glfwSwapInterval((vals->flags & CCE_VERTICAL_SYNC) > 0);
    glfwSetJoystickCallback(joystickCallback__glfw);
    g_gamepads = 0;
+   memset(g_joystickGamepads, 0, sizeof(g_joystickGamepads));
    g_flags = vals->flags & CCE_SCALING;
    
    cce__engineBackend.toWindow = toWindow__glfw;
@@ -650,68 +622,63 @@ ERROR:
    return 0;
 }
 
+// data holds bindings of every gamepad, see cce__loadKeyboardBindingsBackendPlugin
 static int loadKeys__glfw (void *data)
 {
    struct cce_ini_keys *keys = data;
    g_keysQuantity = 0;
-   for (uint8_t *it = (uint8_t*)&keys->stickL.x, *end = (uint8_t*)&keys->start.y + 1; it < end; ++it)
+   for (uint8_t gamepad = 0; gamepad < CCE_GAMEPADS_MAX; ++gamepad)
    {
-      g_keysQuantity += (*it != CCE_KEY_UNKNOWN && *it != 0);
+      for (uint8_t *it = (uint8_t*)&keys[gamepad].stickL.x, *end = (uint8_t*)&keys[gamepad].start.y + 1; it < end; ++it)
+      {
+         g_keysQuantity += (*it != CCE_KEY_UNKNOWN && *it != 0);
+      }
    }
    g_keysQuantity += 2;
    g_keys = malloc((g_keysQuantity) * sizeof(struct key_glfw));
    struct key_glfw *jit = g_keys;
-   uint8_t *key;
+   for (uint8_t gamepad = 1; gamepad <= CCE_GAMEPADS_MAX; ++gamepad, ++keys)
    {
-      uint8_t keyButtons[] = {LEFT_STICK_LEFT,  LEFT_STICK_RIGHT,  LEFT_STICK_UP,  LEFT_STICK_DOWN, DPAD_LEFT, DPAD_RIGHT, DPAD_DOWN, DPAD_UP,
-                              RIGHT_STICK_LEFT, RIGHT_STICK_RIGHT, RIGHT_STICK_DOWN, RIGHT_STICK_UP};
-      key = keyButtons;
-      for (uint8_t *it = (uint8_t*)&keys->stickL.x, *end = (uint8_t*)&keys->buttonA.x; it < end; ++key, ++it)
+      uint8_t *key;
       {
-         if (*it == CCE_KEY_UNKNOWN || *it == 0)
-            continue;
-         jit->key = cceKeyToGLFWkey(*it);
-         jit->fn = *key;
-         ++jit;
+         uint8_t keyButtons[] = {LEFT_STICK_LEFT,  LEFT_STICK_RIGHT,  LEFT_STICK_UP,  LEFT_STICK_DOWN, DPAD_LEFT, DPAD_RIGHT, DPAD_DOWN, DPAD_UP,
+                                 RIGHT_STICK_LEFT, RIGHT_STICK_RIGHT, RIGHT_STICK_DOWN, RIGHT_STICK_UP};
+         key = keyButtons;
+         for (uint8_t *it = (uint8_t*)&keys->stickL.x, *end = (uint8_t*)&keys->buttonA.x; it < end; ++key, ++it)
+         {
+            if (*it == CCE_KEY_UNKNOWN || *it == 0)
+               continue;
+            *jit++ = (struct key_glfw){cceKeyToGLFWkey(*it), *key, gamepad};
+         }
       }
-   }
-   uint8_t keyButtons[] = {BUTTON_A, BUTTON_B, BUTTON_X, BUTTON_Y, BUTTON_L, BUTTON_R, TRIGGER_L, TRIGGER_R, BUTTON_STICK_L, BUTTON_STICK_R, BUTTON_BACK, BUTTON_START};
-   key = keyButtons;
-   for (uint8_t *it = (uint8_t*)&keys->buttonA.x, *end = (uint8_t*)&keys->start.y + 1; it < end; ++key)
-   {
-      for (uint8_t *end2 = it + 2; it < end2; ++it)
+      uint8_t keyButtons[] = {BUTTON_A, BUTTON_B, BUTTON_X, BUTTON_Y, BUTTON_L, BUTTON_R, TRIGGER_L, TRIGGER_R, BUTTON_STICK_L, BUTTON_STICK_R, BUTTON_BACK, BUTTON_START};
+      key = keyButtons;
+      for (uint8_t *it = (uint8_t*)&keys->buttonA.x, *end = (uint8_t*)&keys->start.y + 1; it < end; ++key)
       {
-         if (*it == CCE_KEY_UNKNOWN || *it == 0)
-            continue;
-         jit->key = cceKeyToGLFWkey(*it);
-         jit->fn = *key;
-         ++jit;
+         for (uint8_t *end2 = it + 2; it < end2; ++it)
+         {
+            if (*it == CCE_KEY_UNKNOWN || *it == 0)
+               continue;
+            *jit++ = (struct key_glfw){cceKeyToGLFWkey(*it), *key, gamepad};
+         }
       }
+      g_keyWeights[gamepad - 1] = keys->keyAxisValue;
    }
-   g_keys[g_keysQuantity - 2] = (struct key_glfw){GLFW_KEY_F4, KEY_FULLSCREEN};
-   g_keys[g_keysQuantity - 1] = (struct key_glfw){GLFW_KEY_F11, KEY_FULLSCREEN};
+   g_keys[g_keysQuantity - 2] = (struct key_glfw){GLFW_KEY_F4, KEY_FULLSCREEN, 0};
+   g_keys[g_keysQuantity - 1] = (struct key_glfw){GLFW_KEY_F11, KEY_FULLSCREEN, 0};
    qsort(g_keys, g_keysQuantity, sizeof(struct key_glfw), keycompare);
-   g_keyWeight = keys->keyAxisValue;
-   g_deadzone = keys->deadzone;
-   g_maxValueDeadzoneCorrected = INT8_MAX / (1.0f - keys->deadzone);
-   for (int it = GLFW_JOYSTICK_1, end = GLFW_JOYSTICK_LAST + 1; it < end; ++it)
-   {
-      g_gamepads += glfwJoystickIsGamepad(it) == GLFW_TRUE;
-   }
+   mapJoysticks();
    return 0;
 }
 
 void loadBackend__glfw (void)
 {
-   struct cce_ini_keys *keys = malloc(sizeof(struct cce_ini_keys) + sizeof(struct glfw_properties));
-   struct glfw_properties *props = (struct glfw_properties*)(keys + 1);
+   struct cce_ini_keys *keys = malloc(CCE_GAMEPADS_MAX * sizeof(struct cce_ini_keys) + sizeof(struct glfw_properties));
+   struct glfw_properties *props = (struct glfw_properties*)(keys + CCE_GAMEPADS_MAX);
    props->windowName = NULL;
    props->resolution = (struct cce_u16vec2){640, 480};
    props->flags = 0;
    cce__registerBackend("glfw", props, iniCallback__glfw, initEngine__glfw, NULL, terminateEngine__glfw, 0);
-   memset(&keys->stickL.x, 0, (uint8_t*)&keys->start.y - (uint8_t*)&keys->stickL.x + 1);
-   keys->deadzone = 0.2f;
-   keys->keyAxisValue = INT8_MAX;
    cce__loadKeyboardBindingsBackendPlugin(loadKeys__glfw, keys);
 }
 
@@ -28,6 +28,8 @@
 #include "../../include/cce/utils.h"
 #include "../../include/cce/engine_common_keyboard.h"
 
+#include "../../include/cce/engine_common_internal.h"
+
 // If y is string literal, all optimizing compilers will optimize strlen call away. x must be at least as big as y (or buffer overrun will happen).
 #define CCE_MEMEQ(x,y) (memcmp(x, y, strlen(y)) == 0)
 
@@ -1014,7 +1016,30 @@ int keyIniCallback(void *data, const char *name, const char *value)
    return 0;
 }
 
+static int (*g_loadKeysFn)(void*);
+
+static int loadKeys (void *data)
+{
+   cce__setGamepadsMapping(data);
+   return g_loadKeysFn(data);
+}
+
+/* buffer holds bindings of CCE_GAMEPADS_MAX gamepads: [Controls] section is gamepad 1, [Player2] and so on are the rest.
+ * Only the first one has init callback, all sections are parsed before it */
 CCE_API void cce__loadKeyboardBindingsBackendPlugin (int (*loadKeysFn)(void*), struct cce_ini_keys *buffer)
 {
-   cceRegisterPlugin(cceNameToUID("controls"), buffer, keyIniCallback, loadKeysFn, NULL, NULL, CCE_INI_CALLBACK_FREE_DATA);
+   char section[] = "playerN";
+   g_loadKeysFn = loadKeysFn;
+   for (uint8_t i = 0; i < CCE_GAMEPADS_MAX; ++i)
+   {
+      memset(&buffer[i].stickL.x, 0, (uint8_t*)&buffer[i].start.y - (uint8_t*)&buffer[i].stickL.x + 1);
+      buffer[i].deadzone = 0.2f;
+      buffer[i].keyAxisValue = INT8_MAX;
+   }
+   cceRegisterPlugin(cceNameToUID("controls"), buffer, keyIniCallback, loadKeys, NULL, NULL, CCE_INI_CALLBACK_FREE_DATA);
+   for (uint8_t i = 1; i < CCE_GAMEPADS_MAX; ++i)
+   {
+      section[sizeof(section) - 2u] = '1' + i;
+      cceRegisterPlugin(cceNameToUID(section), buffer + i, keyIniCallback, NULL, NULL, NULL, 0);
+   }
 }
@@ -0,0 +1,192 @@
+/*
+    Conservative Creator's Engine - open source engine for making games.
+    Copyright (C) 2020-2023 Andrey Gaivoronskiy
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../include/cce/engine_common.h"
+#include "../../include/cce/engine_common_null.h"
+#include "../../include/cce/utils.h"
+#include "../../include/cce/engine_common_keyboard.h"
+
+#include "../../include/cce/engine_common_internal.h"
+
+static struct cce_scriptedinput *g_input = NULL;
+static uint32_t                  g_inputQuantity = 0;
+static uint32_t                  g_inputPosition;
+static uint32_t                  g_frame;
+static uint8_t                   g_shouldTerminate;
+static struct cce__gamepadstate  g_gamepads[CCE_GAMEPADS_MAX];
+
+struct null_properties
+{
+   struct cce_u16vec2 resolution;
+};
+
+CCE_API void cceSetScriptedInput (const struct cce_scriptedinput *input, uint32_t inputQuantity)
+{
+   free(g_input);
+   g_input = NULL;
+   g_inputQuantity = 0;
+   g_inputPosition = 0;
+   if (inputQuantity == 0)
+      return;
+   g_input = malloc(inputQuantity * sizeof(struct cce_scriptedinput));
+   memcpy(g_input, input, inputQuantity * sizeof(struct cce_scriptedinput));
+   g_inputQuantity = inputQuantity;
+   // Input which should have been applied already is skipped
+   while (g_inputPosition < g_inputQuantity && g_input[g_inputPosition].frame < g_frame)
+      ++g_inputPosition;
+}
+
+CCE_API uint32_t cceGetScriptedInputFrame (void)
+{
+   return g_frame;
+}
+
+static void engineUpdate__null (void)
+{
+   for (struct cce_scriptedinput *iterator = g_input + g_inputPosition, *end = g_input + g_inputQuantity; iterator < end && iterator->frame <= g_frame; ++iterator, ++g_inputPosition)
+   {
+      const uint8_t gamepad = (iterator->gamepad > 0) ? iterator->gamepad : 1u;
+      if (gamepad > CCE_GAMEPADS_MAX && iterator->type != CCE_SCRIPTED_INPUT_KEY && iterator->type != CCE_SCRIPTED_INPUT_TERMINATE)
+      {
+         fprintf(stderr, "ENGINE::BACKEND::NULL::UNKNOWN_GAMEPAD:\nInput for gamepad %u on frame %u is ignored\n", gamepad, iterator->frame);
+         continue;
+      }
+      struct cce__gamepadstate *state = g_gamepads + (gamepad - 1);
+      switch (iterator->type)
+      {
+         case CCE_SCRIPTED_INPUT_BUTTONS:
+            // Several inputs of one frame collapse in the bitfield, but each of them is queued as events
+            cce__setGamepadButtons(gamepad, iterator->value);
+            break;
+         case CCE_SCRIPTED_INPUT_AXIS:
+            cce__setGamepadAxis(gamepad, iterator->index & 0x7, (int8_t) iterator->value);
+            break;
+         case CCE_SCRIPTED_INPUT_CONNECTION:
+            memset(state->buttons, 0, sizeof(state->buttons));
+            for (uint8_t i = 0; i < CCE_GAMEPAD_LAYOUT_AXES; ++i)
+               state->axes[i] = (i < 4u) ? 0.0f : -1.0f;
+            cce__plugGamepad(gamepad, iterator->value != 0);
+            break;
+         case CCE_SCRIPTED_INPUT_GAMEPAD_BUTTONS:
+            for (uint8_t i = 0; i < CCE_GAMEPAD_LAYOUT_BUTTONS; ++i)
+               state->buttons[i] = (iterator->value >> i) & 1u;
+            cce__updateGamepad(gamepad, state);
+            break;
+         case CCE_SCRIPTED_INPUT_GAMEPAD_AXIS:
+            state->axes[CCE_MIN(iterator->index, CCE_GAMEPAD_LAYOUT_AXES - 1u)] = CCE_MAX((int16_t) iterator->value, -INT16_MAX) / (float) INT16_MAX;
+            cce__updateGamepad(gamepad, state);
+            break;
+         case CCE_SCRIPTED_INPUT_KEY:
+            cce__pushInputEvent(CCE_INPUT_EVENT_KEY, (uint8_t) iterator->value, iterator->index, CCE_INPUT_KEYBOARD);
+            if (cce__keyCallback != NULL)
+               cce__keyCallback((cce_enum) iterator->value, iterator->index);
+            break;
+         case CCE_SCRIPTED_INPUT_TERMINATE:
+            g_shouldTerminate = 1;
+            break;
+         default:
+            fprintf(stderr, "ENGINE::BACKEND::NULL::UNKNOWN_SCRIPTED_INPUT:\nInput type %u on frame %u is ignored\n", iterator->type, iterator->frame);
+      }
+   }
+   ++g_frame;
+}
+
+static void toFullscreen__null (void)
+{
+   return;
+}
+
+static void toWindow__null (void)
+{
+   return;
+}
+
+static uint8_t engineShouldTerminate__null (void)
+{
+   return g_shouldTerminate;
+}
+
+static void setEngineShouldTerminate__null (uint8_t value)
+{
+   g_shouldTerminate = value;
+}
+
+static void screenUpdate__null (void)
+{
+   return;
+}
+
+static int initEngine__null (void *data)
+{
+   struct null_properties *vals = data;
+   g_frame = 0;
+   g_inputPosition = 0;
+   g_shouldTerminate = 0;
+   memset(g_gamepads, 0, sizeof(g_gamepads));
+   cce__engineBackend.toWindow = toWindow__null;
+   cce__engineBackend.toFullscreen = toFullscreen__null;
+   cce__engineBackend.engineUpdate = engineUpdate__null;
+   cceEngineShouldTerminate = engineShouldTerminate__null;
+   cceSetEngineShouldTerminate = setEngineShouldTerminate__null;
+   cceScreenUpdate = screenUpdate__null;
+   cce__gameResolution = vals->resolution;
+   return 0;
+}
+
+static void terminateEngine__null (void)
+{
+   free(g_input);
+   g_input = NULL;
+   g_inputQuantity = 0;
+}
+
+static int iniCallback__null (void *data, const char *name, const char *value)
+{
+   struct null_properties *vals = data;
+   char buf[24];
+   strncpy(buf, name, 24);
+   cceMemoryToLowercase(buf, 23);
+   // Everything else in [Window] section does not make sense without window - it is silently ignored, so the same game.ini can be used
+   if (CCE_STREQ(buf, "gameres") || CCE_STREQ(buf, "res") || CCE_STREQ(buf, "gameresolution") || CCE_STREQ(buf, "resolution") || CCE_STREQ(buf, "virtualresolution"))
+   {
+      vals->resolution = cceStringToU16Vec2(value);
+   }
+   return 0;
+}
+
+static int loadKeys__null (void *data)
+{
+   // Scripted input bypasses key bindings, deadzones are applied by gamepad mapping
+   CCE_UNUSED(data);
+   return 0;
+}
+
+void loadBackend__null (void)
+{
+   struct cce_ini_keys *keys = malloc(CCE_GAMEPADS_MAX * sizeof(struct cce_ini_keys) + sizeof(struct null_properties));
+   struct null_properties *props = (struct null_properties*)(keys + CCE_GAMEPADS_MAX);
+   props->resolution = (struct cce_u16vec2){640, 480};
+   cce__registerBackend("null", props, iniCallback__null, initEngine__null, NULL, terminateEngine__null, 0);
+   cce__loadKeyboardBindingsBackendPlugin(loadKeys__null, keys);
+}
@@ -28,6 +28,8 @@
 #include "../../include/cce/os_interaction.h"
 #include "../../include/cce/utils.h"
 
+#include "../../include/cce/engine_common_internal.h"
+
 #if defined(CCE_TMPDIR_NAME_TEMPLATE)
 
 #ifndef CCE_TMPDIR_NAME_TEMPLATE_SIZE
@@ -112,7 +114,7 @@ static uint8_t doClockCoarseHaveEnoughPrecision;
 
 #include <sys/random.h>
 
-CCE_API int cceGetRandomSeed (void *buffer, size_t bufferSize)
+static int getRandomSeed (void *buffer, size_t bufferSize)
 {
    return (getrandom(buffer, bufferSize, 0) == (ssize_t)bufferSize) - 1;
 }
@@ -125,13 +127,21 @@ CCE_API uint32_t cceGetMonotonicTime (void)
    return (tp.tv_sec - engineStartTimeSec) * 1000 + tp.tv_nsec / 1000000;
 }
 
+CCE_API uint64_t cceGetMonotonicTimeNs (void)
+{
+   struct timespec tp;
+   clock_gettime(CLOCK_MONOTONIC, &tp);
+   return (uint64_t)(tp.tv_sec - engineStartTimeSec) * 1000000000u + tp.tv_nsec;
+}
+
 #define CCE_INI_TIME() \
 do \
 { \
    struct timespec tp; \
    clock_getres(CLOCK_MONOTONIC_COARSE, &tp); \
    doClockCoarseHaveEnoughPrecision = tp.tv_nsec <= 1000000 && tp.tv_sec == 0; \
-   engineStartTimeSec = cceGetMonotonicTime(); \
+   clock_gettime(CLOCK_MONOTONIC, &tp); \
+   engineStartTimeSec = tp.tv_sec; \
 } \
 while (0)
 
@@ -146,6 +156,12 @@ CCE_API uint32_t cceGetMonotonicTime (void)
    return (time - engineStartTimeSec) * timebase.numer / (timebase.denom * 1000000);
 }
 
+CCE_API uint64_t cceGetMonotonicTimeNs (void)
+{
+   uint64_t time = mach_absolute_time() - engineStartTimeSec;
+   return time / timebase.denom * timebase.numer + time % timebase.denom * timebase.numer / timebase.denom;
+}
+
 #define CCE_INI_TIME() \
 (void) mach_timebase_info(&timebase); \
 engineStartTimeSec = mach_absolute_time()
@@ -159,15 +175,23 @@ CCE_API uint32_t cceGetMonotonicTime (void)
    return (tp.tv_sec - engineStartTimeSec) * 1000 + tp.tv_nsec / 1000000;
 }
 
+CCE_API uint64_t cceGetMonotonicTimeNs (void)
+{
+   struct timespec tp;
+   clock_gettime(CLOCK_MONOTONIC, &tp);
+   return (uint64_t)(tp.tv_sec - engineStartTimeSec) * 1000000000u + tp.tv_nsec;
+}
+
 #define CCE_INI_TIME() \
 do \
 { \
    struct timespec tp; \
    if (clock_gettime(CLOCK_MONOTONIC, &tp) != 0) \
-   {
+   { \
       fputs("ENGINE::OS_INTERACTION::MONOTONIC_CLOCKS_UNAVAILABLE:\nThe system does not support monotonic clocks required for engine operation\n", stderr); \
       return -1; \
    } \
+   engineStartTimeSec = tp.tv_sec; \
 } \
 while (0)
 
@@ -181,11 +205,45 @@ int cce__iniOsInteraction ()
    return 0;
 }
 
+#if defined(__GLIBC__)
+
+#include <malloc.h>
+
+uint64_t cce__getHeapBytesInUse (void)
+{
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+   struct mallinfo2 info = mallinfo2();
+#else
+   struct mallinfo info = mallinfo();
+#endif // glibc 2.33
+   return (uint64_t) info.uordblks + (uint64_t) info.hblkhd;
+}
+
+#elif defined(__APPLE__) && defined(__MACH__)
+
+#include <malloc/malloc.h>
+
+uint64_t cce__getHeapBytesInUse (void)
+{
+   malloc_statistics_t statistics;
+   malloc_zone_statistics(NULL, &statistics);
+   return statistics.size_in_use;
+}
+
+#else
+
+uint64_t cce__getHeapBytesInUse (void)
+{
+   return 0;
+}
+
+#endif // if __GLIBC__ elif MAC_OS
+
 #if !defined(linux) || !defined(__linux) || !defined(__linux__)
 
 #include <fcntl.h>
 
-CCE_API int cceGetRandomSeed (void *buffer, size_t bufferSize)
+static int getRandomSeed (void *buffer, size_t bufferSize)
 {
    int fd = open("/dev/urandom", O_RDONLY);
    if (fd < 0)
@@ -201,6 +259,49 @@ CCE_API void cceTruncateFile (FILE *file, size_t size)
    ftruncate(fileno(file), size);
 }
 
+CCE_API int cceFlushFileToDisk (FILE *file)
+{
+   return (fflush(file) == 0 && fsync(fileno(file)) == 0) - 1;
+}
+
+CCE_API int cceReplaceFile (const char *source, const char *destination)
+{
+   return rename(source, destination);
+}
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+CCE_API void* cceMapFile (const char *path, size_t *size)
+{
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return NULL;
+   struct stat st;
+   if (fstat(fd, &st) != 0 || st.st_size <= 0)
+   {
+      close(fd);
+      return NULL;
+   }
+   void *result = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd); // Mapping stays valid
+   if (result == MAP_FAILED)
+      return NULL;
+   *size = st.st_size;
+   return result;
+}
+
+CCE_API void cceUnmapFile (void *data, size_t size)
+{
+   munmap(data, size);
+}
+
+CCE_API FILE* cceOpenMemoryAsFile (void *data, size_t size)
+{
+   return fmemopen(data, size, "rb");
+}
+
 CCE_API char* cceGetAbsolutePath (const char *path, size_t spaceToLeave)
 {
    char *result = realpath(path, NULL);
@@ -443,6 +544,11 @@ CCE_API void cceDeleteDirectory (const char *path)
 LARGE_INTEGER performanceCounterFrequency;
 LARGE_INTEGER engineStartTime;
 
+uint64_t cce__getHeapBytesInUse (void)
+{
+   return 0;
+}
+
 static void printSystemError (char *message)
 {
    DWORD error = GetLastError();
@@ -480,6 +586,15 @@ CCE_API cceGetMonotonicTime (void)
    #endif
 }
 
+CCE_API uint64_t cceGetMonotonicTimeNs (void)
+{
+   LARGE_INTEGER time;
+   QueryPerformanceCounter(&time);
+   uint64_t ticks = time.QuadPart - engineStartTime.QuadPart, frequency = performanceCounterFrequency.QuadPart;
+   // Split, so that multiplication does not overflow after few hours of running
+   return ticks / frequency * 1000000000u + ticks % frequency * 1000000000u / frequency;
+}
+
 int cce__iniOsInteraction ()
 {
    QueryPerformanceFrequency(&performanceCounterFrequency);
@@ -487,7 +602,7 @@ int cce__iniOsInteraction ()
    return 0;
 }
 
-CCE_API int cceGetRandomSeed (void *buffer, size_t bufferSize)
+static int getRandomSeed (void *buffer, size_t bufferSize)
 {
    HCRYPTPROV cryptProvider = NULL;
    const char *containerName = "CCEKeyContainer";
@@ -509,6 +624,60 @@ CCE_API void cceTruncateFile (FILE *file, size_t size)
    fseek(file, position, SEEK_SET);
 }
 
+CCE_API int cceFlushFileToDisk (FILE *file)
+{
+   return (fflush(file) == 0 && FlushFileBuffers((HANDLE) _get_osfhandle(_fileno(file))) != 0) - 1;
+}
+
+CCE_API int cceReplaceFile (const char *source, const char *destination)
+{
+   return (MoveFileExA(source, destination, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0) - 1;
+}
+
+CCE_API void* cceMapFile (const char *path, size_t *size)
+{
+   HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (file == INVALID_HANDLE_VALUE)
+      return NULL;
+   LARGE_INTEGER fileSize;
+   if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+   {
+      CloseHandle(file);
+      return NULL;
+   }
+   HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+   CloseHandle(file);
+   if (mapping == NULL)
+      return NULL;
+   void *result = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+   CloseHandle(mapping); // View keeps mapping object alive
+   if (result == NULL)
+      return NULL;
+   *size = (size_t) fileSize.QuadPart;
+   return result;
+}
+
+CCE_API void cceUnmapFile (void *data, size_t size)
+{
+   CCE_UNUSED(size);
+   UnmapViewOfFile(data);
+}
+
+CCE_API FILE* cceOpenMemoryAsFile (void *data, size_t size)
+{
+   // No memory streams in Windows CRT, so data goes through temporary file (deleted on close)
+   FILE *file = tmpfile();
+   if (file == NULL)
+      return NULL;
+   if (fwrite(data, sizeof(char), size, file) != size)
+   {
+      fclose(file);
+      return NULL;
+   }
+   rewind(file);
+   return file;
+}
+
 CCE_API char* cceGetAbsolutePath (const char *path, size_t spaceToLeave)
 {
    char *result = malloc(MAX_PATH * sizeof(char));
@@ -648,7 +817,7 @@ CCE_API char* cceGetTemporaryDirectory (size_t spaceToLeave)
       ++tmpPathLength;
       *(tmpPath + tmpPathLength) = '\0';
       uint32_t ID;
-      cceGetRandomSeed(&ID, 3);
+      getRandomSeed(&ID, 3);
       cceConvertIntToBase64String(ID, tmpPath + (tmpPathLength - 6u - 1u - 2u), 6u);
       CreateDirectoryA(tmpPath, NULL);
    }
@@ -735,3 +904,9 @@ CCE_API void cceDeleteDirectory (const char *aPath)
 }
 
 #endif // WINDOWS_SYSTEM
+
+// Seeds given to the game are recorded and played back with its input, internal ones (e.g. temporary directory name) aren't
+CCE_API int cceGetRandomSeed (void *buffer, size_t bufferSize)
+{
+   return cce__getReplayRandomSeed(buffer, bufferSize, getRandomSeed);
+}
@@ -0,0 +1,269 @@
+/*
+    Conservative Creator's Engine - open source engine for making games.
+    Copyright (C) 2020-2023 Andrey Gaivoronskiy
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include "platforms.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "threads.h"
+
+struct cce__threadstart
+{
+   void (*function)(void*);
+   void  *data;
+};
+
+#ifdef POSIX_SYSTEM
+
+#include <pthread.h>
+
+struct cce__thread
+{
+   pthread_t               thread;
+   struct cce__threadstart start;
+};
+
+struct cce__mutex
+{
+   pthread_mutex_t mutex;
+};
+
+struct cce__condition
+{
+   pthread_cond_t condition;
+};
+
+static void* threadStart (void *data)
+{
+   struct cce__threadstart *start = data;
+   start->function(start->data);
+   return NULL;
+}
+
+struct cce__thread* cce__createThread (void (*function)(void*), void *data)
+{
+   struct cce__thread *thread = malloc(sizeof(struct cce__thread));
+   thread->start = (struct cce__threadstart){function, data};
+   if (pthread_create(&thread->thread, NULL, threadStart, &thread->start) != 0)
+   {
+      free(thread);
+      return NULL;
+   }
+   return thread;
+}
+
+void cce__joinThread (struct cce__thread *thread)
+{
+   pthread_join(thread->thread, NULL);
+   free(thread);
+}
+
+struct cce__mutex* cce__createMutex (void)
+{
+   struct cce__mutex *mutex = malloc(sizeof(struct cce__mutex));
+   if (pthread_mutex_init(&mutex->mutex, NULL) != 0)
+   {
+      free(mutex);
+      return NULL;
+   }
+   return mutex;
+}
+
+void cce__lockMutex (struct cce__mutex *mutex)
+{
+   pthread_mutex_lock(&mutex->mutex);
+}
+
+void cce__unlockMutex (struct cce__mutex *mutex)
+{
+   pthread_mutex_unlock(&mutex->mutex);
+}
+
+void cce__freeMutex (struct cce__mutex *mutex)
+{
+   if (mutex == NULL)
+      return;
+   pthread_mutex_destroy(&mutex->mutex);
+   free(mutex);
+}
+
+struct cce__mutex* cce__getStaticMutex (void)
+{
+   static struct cce__mutex mutex = {PTHREAD_MUTEX_INITIALIZER};
+   return &mutex;
+}
+
+struct cce__condition* cce__createCondition (void)
+{
+   struct cce__condition *condition = malloc(sizeof(struct cce__condition));
+   if (pthread_cond_init(&condition->condition, NULL) != 0)
+   {
+      free(condition);
+      return NULL;
+   }
+   return condition;
+}
+
+void cce__waitCondition (struct cce__condition *condition, struct cce__mutex *mutex)
+{
+   pthread_cond_wait(&condition->condition, &mutex->mutex);
+}
+
+void cce__signalCondition (struct cce__condition *condition)
+{
+   pthread_cond_signal(&condition->condition);
+}
+
+void cce__broadcastCondition (struct cce__condition *condition)
+{
+   pthread_cond_broadcast(&condition->condition);
+}
+
+void cce__freeCondition (struct cce__condition *condition)
+{
+   if (condition == NULL)
+      return;
+   pthread_cond_destroy(&condition->condition);
+   free(condition);
+}
+
+uint32_t cce__getHardwareThreadsQuantity (void)
+{
+   #ifdef _SC_NPROCESSORS_ONLN
+   long quantity = sysconf(_SC_NPROCESSORS_ONLN);
+   return (quantity > 0) ? (uint32_t) quantity : 1u;
+   #else
+   return 1u;
+   #endif // _SC_NPROCESSORS_ONLN
+}
+
+#elif defined(WINDOWS_SYSTEM)
+
+#include <windows.h>
+#include <process.h>
+
+struct cce__thread
+{
+   HANDLE                  thread;
+   struct cce__threadstart start;
+};
+
+struct cce__mutex
+{
+   SRWLOCK lock;
+};
+
+struct cce__condition
+{
+   CONDITION_VARIABLE condition;
+};
+
+static unsigned __stdcall threadStart (void *data)
+{
+   struct cce__threadstart *start = data;
+   start->function(start->data);
+   return 0u;
+}
+
+struct cce__thread* cce__createThread (void (*function)(void*), void *data)
+{
+   struct cce__thread *thread = malloc(sizeof(struct cce__thread));
+   thread->start = (struct cce__threadstart){function, data};
+   // _beginthreadex instead of CreateThread, so that C runtime is initialized for the thread
+   thread->thread = (HANDLE) _beginthreadex(NULL, 0u, threadStart, &thread->start, 0u, NULL);
+   if (thread->thread == NULL)
+   {
+      free(thread);
+      return NULL;
+   }
+   return thread;
+}
+
+void cce__joinThread (struct cce__thread *thread)
+{
+   WaitForSingleObject(thread->thread, INFINITE);
+   CloseHandle(thread->thread);
+   free(thread);
+}
+
+struct cce__mutex* cce__createMutex (void)
+{
+   struct cce__mutex *mutex = malloc(sizeof(struct cce__mutex));
+   InitializeSRWLock(&mutex->lock);
+   return mutex;
+}
+
+void cce__lockMutex (struct cce__mutex *mutex)
+{
+   AcquireSRWLockExclusive(&mutex->lock);
+}
+
+void cce__unlockMutex (struct cce__mutex *mutex)
+{
+   ReleaseSRWLockExclusive(&mutex->lock);
+}
+
+void cce__freeMutex (struct cce__mutex *mutex)
+{
+   free(mutex);
+}
+
+struct cce__mutex* cce__getStaticMutex (void)
+{
+   static struct cce__mutex mutex = {SRWLOCK_INIT};
+   return &mutex;
+}
+
+struct cce__condition* cce__createCondition (void)
+{
+   struct cce__condition *condition = malloc(sizeof(struct cce__condition));
+   InitializeConditionVariable(&condition->condition);
+   return condition;
+}
+
+void cce__waitCondition (struct cce__condition *condition, struct cce__mutex *mutex)
+{
+   SleepConditionVariableSRW(&condition->condition, &mutex->lock, INFINITE, 0u);
+}
+
+void cce__signalCondition (struct cce__condition *condition)
+{
+   WakeConditionVariable(&condition->condition);
+}
+
+void cce__broadcastCondition (struct cce__condition *condition)
+{
+   WakeAllConditionVariable(&condition->condition);
+}
+
+void cce__freeCondition (struct cce__condition *condition)
+{
+   free(condition);
+}
+
+uint32_t cce__getHardwareThreadsQuantity (void)
+{
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return (info.dwNumberOfProcessors > 0) ? (uint32_t) info.dwNumberOfProcessors : 1u;
+}
+
+#endif // POSIX_SYSTEM elif WINDOWS_SYSTEM
@@ -0,0 +1,68 @@
+/*
+    Conservative Creator's Engine - open source engine for making games.
+    Copyright (C) 2020-2023 Andrey Gaivoronskiy
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+/* Minimal portable threading used by engine internals (pthreads or Win32). All objects are opaque and heap-allocated,
+ * so that platform headers don't leak into the rest of the engine. Create functions return NULL on failure */
+
+#ifdef _MSC_VER
+#define CCE_THREAD_LOCAL __declspec(thread)
+#else
+#define CCE_THREAD_LOCAL __thread
+#endif // _MSC_VER
+
+struct cce__thread;
+struct cce__mutex;
+struct cce__condition;
+
+struct cce__thread*    cce__createThread (void (*function)(void*), void *data);
+void                   cce__joinThread (struct cce__thread *thread);
+
+struct cce__mutex*     cce__createMutex (void);
+void                   cce__lockMutex (struct cce__mutex *mutex);
+void                   cce__unlockMutex (struct cce__mutex *mutex);
+void                   cce__freeMutex (struct cce__mutex *mutex);
+// Process-wide mutex which needs no creation, for lazy initialization of other objects. Must not be freed
+struct cce__mutex*     cce__getStaticMutex (void);
+
+struct cce__condition* cce__createCondition (void);
+// Mutex must be locked, it is released while waiting and locked again before return. Spurious wakeups are possible
+void                   cce__waitCondition (struct cce__condition *condition, struct cce__mutex *mutex);
+void                   cce__signalCondition (struct cce__condition *condition);
+void                   cce__broadcastCondition (struct cce__condition *condition);
+void                   cce__freeCondition (struct cce__condition *condition);
+
+// Logical processors available to the process, at least 1
+uint32_t               cce__getHardwareThreadsQuantity (void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // THREADS_H
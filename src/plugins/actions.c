@@ -23,28 +23,56 @@
 #include <string.h>
 #include <math.h>
 
-#include <listlib.h>
-
 #include "../../include/cce/engine_common.h"
 #include "../../include/cce/engine_common_IO.h"
 #include "../../include/cce/utils.h"
 #include "../../include/cce/endianess.h"
+#include "../../include/cce/profiler.h"
 #include "../../include/cce/plugins/actions.h"
 #include "../../include/cce/plugins/actions_internal.h"
 
 CCE_ARRAY_STRUCT(cce_uidsResizable,    uint32_t, uint32_t);
 CCE_ARRAY_STRUCT(cce_actionsResizable, struct cceaAction, uint32_t);
 
+// Action stream with UIDs already resolved: running it is a loop of indirect calls
+struct ccea_compiledaction
+{
+   ccea_actionfun handler;
+   uint32_t       offset;
+};
+
+CCE_ARRAY_STRUCT(ccea_compiledActions, struct ccea_compiledaction, uint32_t);
+
+// Precedes every delayed action in its pool block
+struct ccea_delayednode
+{
+   ccea_actionfun              handler;
+   struct ccea_compiledActions payload; // Actions run by periodic and repeated actions, offsets are relative to the delayed action
+};
+
+struct ccea_delayedentry
+{
+   struct cceaDelayedDynamicAction *action;
+   uint32_t                         timeout;
+   uint32_t                         sequence; // Actions due on the same tick run in the order they were delayed
+};
+
+// Binary min-heap ordered by (timeout, sequence)
+CCE_ARRAY_STRUCT(ccea_delayedHeap, struct ccea_delayedentry, uint32_t);
+
 struct ccea_actioninfo
 {
-   struct list                      delayedActions;
+   struct ccea_delayedHeap          delayedActions;
+   uint32_t                         delayedActionsSequence;
    uint32_t                         currentMapTime;
+   uint32_t                         currentMapTimeRemainderNs; // Used only with precise timing, not stored
    uint16_t                         eventsQuantity;
    
    // Slow linear-time performance for insertion and deletion. 
    // The only way to improve it (I found) is to use binary trees (not yet implemented). At least it is cache-friendly...
    struct cce_uidsResizable    *actionSubsUIDs;
    struct cce_actionsResizable *onEventActions;
+   struct ccea_compiledActions *onEventCompiled; // Empty when corresponding onEventActions were changed, compiled again on the next invocation
 };
 
 struct ccea_runActionsDelayed
@@ -74,6 +102,7 @@ struct ccea_runActionsDelayedRepeated
 
 #define CCE_ACTIONS_SWAPPING_FROM_HOST_ENDIAN 0x1
 #define CCE_ACTIONS_INITIALIZING 0x2
+#define CCE_ACTIONS_PRECISE_TIME 0x4
 
 CCE_ARRAY(g_actions, static ccea_actionfun, static uint32_t);
 static void   (**g_endianSwapActions)(void*) = NULL;
@@ -94,6 +123,175 @@ CCE_API uint32_t cceaPluginUID = 0;
 static uint32_t **g_eventUIDsSorted = NULL;
 static uint8_t g_flags;
 
+// Delayed action being run by cceaRunDelayedActions, lets run*Actions use its compiled payload.
+// Not synchronized: actions may be run only on the main thread (see cceaRunDelayedActions)
+static struct cceaDelayedDynamicAction *g_firingNode = NULL;
+
+static inline void runCompiledActions (const struct ccea_compiledActions *compiled, cce_void *actions, uint32_t count, struct cce_buffer *state)
+{
+   for (const struct ccea_compiledaction *iterator = compiled->data, *end = compiled->data + compiled->dataQuantity; iterator < end; ++iterator)
+   {
+      iterator->handler(actions + iterator->offset, count, state);
+   }
+}
+
+#define RUN_DELAYED_PAYLOAD(params, paramsSize, count, state) \
+if ((void*)(params) == (void*)g_firingNode && ((struct ccea_delayednode*)g_firingNode - 1)->payload.data != NULL) \
+   runCompiledActions(&((struct ccea_delayednode*)g_firingNode - 1)->payload, (cce_void*)(params), count, state); \
+else \
+   ccea__runActions((struct cceaAction*)((cce_void*)(params) + (paramsSize)), (params)->totalSize - (paramsSize), count, state)
+
+/* Size-class pool for delayed action nodes: blocks are recycled instead of being returned to malloc.
+ * Every block is preceded by a header with its size class, so it can be released without knowing its size */
+#define CCEA_POOL_SMALLEST_BLOCK  16u
+#define CCEA_POOL_BLOCKS_PER_SLAB 64u
+#define CCEA_POOL_OVERSIZED       0xFFu
+
+struct ccea_poolheader
+{
+   uint32_t sizeClass;
+   uint32_t __pad; // Keeps blocks 8-byte aligned
+};
+
+struct ccea_pool
+{
+   void    *freeList;
+   void   **slabs;
+   uint32_t slabsQuantity;
+   uint32_t slabsAllocated;
+   uint32_t inUse;
+   uint32_t highWaterMark;
+};
+
+static struct ccea_pool g_pools[CCEA_POOL_SIZE_CLASSES];
+static uint32_t g_oversizedInUse, g_oversizedHighWaterMark;
+
+static void* poolAlloc (size_t size)
+{
+   uint32_t sizeClass = 0;
+   while (sizeClass < CCEA_POOL_SIZE_CLASSES && ((size_t) CCEA_POOL_SMALLEST_BLOCK << sizeClass) < size)
+      ++sizeClass;
+   struct ccea_poolheader *header;
+   if (sizeClass >= CCEA_POOL_SIZE_CLASSES)
+   {
+      header = malloc(sizeof(struct ccea_poolheader) + size);
+      header->sizeClass = CCEA_POOL_OVERSIZED;
+      ++g_oversizedInUse;
+      g_oversizedHighWaterMark = CCE_MAX(g_oversizedHighWaterMark, g_oversizedInUse);
+      return header + 1;
+   }
+   struct ccea_pool *pool = g_pools + sizeClass;
+   if (pool->freeList == NULL)
+   {
+      const size_t stride = sizeof(struct ccea_poolheader) + ((size_t) CCEA_POOL_SMALLEST_BLOCK << sizeClass);
+      cce_void *slab = malloc(stride * CCEA_POOL_BLOCKS_PER_SLAB);
+      if (pool->slabsQuantity >= pool->slabsAllocated)
+         CCE_REALLOC_ARRAY(pool->slabs, pool->slabsQuantity + 1);
+      pool->slabs[pool->slabsQuantity++] = slab;
+      for (uint32_t i = CCEA_POOL_BLOCKS_PER_SLAB; i > 0; --i)
+      {
+         cce_void *block = slab + stride * (i - 1);
+         *(void**)((struct ccea_poolheader*) block + 1) = pool->freeList;
+         pool->freeList = block;
+      }
+   }
+   header = pool->freeList;
+   pool->freeList = *(void**)(header + 1);
+   header->sizeClass = sizeClass;
+   ++pool->inUse;
+   pool->highWaterMark = CCE_MAX(pool->highWaterMark, pool->inUse);
+   return header + 1;
+}
+
+static void poolFree (void *data)
+{
+   if (data == NULL)
+      return;
+   struct ccea_poolheader *header = (struct ccea_poolheader*) data - 1;
+   if (header->sizeClass == CCEA_POOL_OVERSIZED)
+   {
+      --g_oversizedInUse;
+      free(header);
+      return;
+   }
+   struct ccea_pool *pool = g_pools + header->sizeClass;
+   *(void**) data = pool->freeList;
+   pool->freeList = header;
+   --pool->inUse;
+}
+
+static void terminatePools (void)
+{
+   for (struct ccea_pool *pool = g_pools, *end = g_pools + CCEA_POOL_SIZE_CLASSES; pool < end; ++pool)
+   {
+      for (void **slab = pool->slabs, **slabsEnd = pool->slabs + pool->slabsQuantity; slab < slabsEnd; ++slab)
+      {
+         free(*slab);
+      }
+      free(pool->slabs);
+   }
+   memset(g_pools, 0, sizeof(g_pools));
+   g_oversizedInUse = g_oversizedHighWaterMark = 0;
+}
+
+CCE_API void cceaGetPoolStatistics (struct cceaPoolStatistics *statistics)
+{
+   for (uint32_t i = 0; i < CCEA_POOL_SIZE_CLASSES; ++i)
+   {
+      statistics->blockSize[i] = CCEA_POOL_SMALLEST_BLOCK << i;
+      statistics->inUse[i] = g_pools[i].inUse;
+      statistics->highWaterMark[i] = g_pools[i].highWaterMark;
+      statistics->reserved[i] = g_pools[i].slabsQuantity * CCEA_POOL_BLOCKS_PER_SLAB;
+   }
+   statistics->oversizedInUse = g_oversizedInUse;
+   statistics->oversizedHighWaterMark = g_oversizedHighWaterMark;
+}
+
+static inline uint8_t delayedEntryPrecedes (const struct ccea_delayedentry *a, const struct ccea_delayedentry *b)
+{
+   // Both comparisons tolerate wrapping of map time and sequence numbers
+   if (a->timeout != b->timeout)
+      return (int32_t)(a->timeout - b->timeout) < 0;
+   return (int32_t)(a->sequence - b->sequence) < 0;
+}
+
+static void pushDelayedAction (struct ccea_actioninfo *actionInfo, struct cceaDelayedDynamicAction *action, uint32_t sequence)
+{
+   struct ccea_delayedHeap *heap = &actionInfo->delayedActions;
+   if (heap->dataQuantity >= heap->dataAllocated)
+      CCE_REALLOC_ARRAY(heap->data, heap->dataQuantity + 1);
+   struct ccea_delayedentry entry = {action, action->timeout, sequence};
+   uint32_t position = heap->dataQuantity++;
+   while (position > 0)
+   {
+      uint32_t parent = (position - 1) >> 1;
+      if (!delayedEntryPrecedes(&entry, heap->data + parent))
+         break;
+      heap->data[position] = heap->data[parent];
+      position = parent;
+   }
+   heap->data[position] = entry;
+}
+
+static struct ccea_delayedentry popDelayedAction (struct ccea_actioninfo *actionInfo)
+{
+   struct ccea_delayedHeap *heap = &actionInfo->delayedActions;
+   struct ccea_delayedentry top = heap->data[0];
+   struct ccea_delayedentry last = heap->data[--heap->dataQuantity];
+   uint32_t position = 0;
+   for (uint32_t child = 1; child < heap->dataQuantity; child = (position << 1) + 1)
+   {
+      if (child + 1 < heap->dataQuantity && delayedEntryPrecedes(heap->data + child + 1, heap->data + child))
+         ++child;
+      if (!delayedEntryPrecedes(heap->data + child, &last))
+         break;
+      heap->data[position] = heap->data[child];
+      position = child;
+   }
+   heap->data[position] = last;
+   return top;
+}
+
 static void runActions (void *data, uint32_t count, struct cce_buffer *state)
 {
    struct cceaRunActions *params = data;
@@ -125,7 +323,7 @@ static void runPeriodicActions (void *data, uint32_t count, struct cce_buffer *s
    uint32_t currentTime = ((struct ccea_actioninfo*)CCE_GET_FUNCTION_BUFFER(state, cceaPluginUID))->currentMapTime;
    count *= (currentTime - params->timeout) / params->delay + 1;
    params->timeout = currentTime - (currentTime - params->timeout) % params->delay + params->delay;
-   ccea__runActions((struct cceaAction*)(params + 1), params->totalSize - sizeof(struct ccea_runActionsPeriodic), count, state);
+   RUN_DELAYED_PAYLOAD(params, sizeof(struct ccea_runActionsPeriodic), count, state);
 }
 
 static void runRepeatedlyDelayedActions (void *data, uint32_t count, struct cce_buffer *state)
@@ -135,7 +333,7 @@ static void runRepeatedlyDelayedActions (void *data, uint32_t count, struct cce_
    count *= CCE_MIN((currentTime - params->timeout) / params->delay + 1, params->repeatsLeft);
    if (count < params->repeatsLeft)
       params->timeout = currentTime - (currentTime - params->timeout) % params->delay + params->delay;
-   ccea__runActions((struct cceaAction*)(params + 1), params->totalSize - sizeof(struct ccea_runActionsDelayedRepeated), count, state);
+   RUN_DELAYED_PAYLOAD(params, sizeof(struct ccea_runActionsDelayedRepeated), count, state);
    params->repeatsLeft -= count;
 }
 
@@ -184,6 +382,119 @@ do \
 } \
 while (0)
 
+// Unlike UID_TO_ID, stops at the first empty slot, so UIDs read from files which were never registered are reported instead of looping
+static uint8_t findActionID (uint32_t UID, uint32_t *ID)
+{
+   uint32_t id = cceUIDToHash(UID, g_actionsAllocated);
+   for (uint32_t probes = 0; probes < g_actionsAllocated && g_actionUIDs[id] != 0; ++probes)
+   {
+      if (g_actionUIDs[id] == UID)
+      {
+         *ID = id;
+         return 1;
+      }
+      if (++id >= g_actionsAllocated)
+         id = 0;
+   }
+   return 0;
+}
+
+// Checks that every action of the stream is registered and ends within it. Parameters of actions (including nested streams) are not checked
+static uint8_t isActionStreamValid (const cce_void *actions, uint32_t totalActionsSize)
+{
+   for (uint32_t offset = 0, size; offset < totalActionsSize; offset += size)
+   {
+      uint32_t left = totalActionsSize - offset, UID, ID;
+      if (left < sizeof(uint32_t))
+         return 0;
+      memcpy(&UID, actions + offset, sizeof(uint32_t));
+      if (!findActionID(UID, &ID))
+      {
+         fprintf(stderr, "ENGINE::ACTIONS_PLUGIN::ACTION_NOT_FOUND:\nCan't find action %s (uid: %u)\n", cceUIDToName(UID), UID);
+         return 0;
+      }
+      size = g_actionSizes[ID];
+      if (size == 0)
+      {
+         if (left < sizeof(struct cceaDynamicAction))
+            return 0;
+         memcpy(&size, actions + offset + offsetof(struct cceaDynamicAction, size), sizeof(uint32_t));
+         if (size < sizeof(struct cceaDynamicAction))
+            return 0;
+      }
+      if (size > left)
+         return 0;
+   }
+   return 1;
+}
+
+// With compiled == NULL only counts actions
+static uint32_t compileActions (const cce_void *actions, uint32_t totalActionsSize, uint32_t baseOffset, struct ccea_compiledaction *compiled)
+{
+   uint32_t quantity = 0, actionID;
+   for (uint32_t offset = 0; offset < totalActionsSize; offset += (g_actionSizes[actionID] == 0) ? ((const struct cceaDynamicAction*)(actions + offset))->size : g_actionSizes[actionID])
+   {
+      UID_TO_ID(((const struct cceaAction*)(actions + offset))->UID, actionID);
+      if (compiled != NULL)
+         compiled[quantity] = (struct ccea_compiledaction){g_actions[actionID], baseOffset + offset};
+      ++quantity;
+   }
+   return quantity;
+}
+
+static void compileEventActions (struct ccea_actioninfo *actionInfo, uint32_t eventID)
+{
+   struct ccea_compiledActions *compiled = actionInfo->onEventCompiled + eventID;
+   const cce_void *actions = (const cce_void*) actionInfo->onEventActions[eventID].data;
+   const uint32_t size = actionInfo->onEventActions[eventID].dataQuantity;
+   uint32_t quantity = compileActions(actions, size, 0, NULL);
+   if (quantity > compiled->dataAllocated)
+      CCE_REALLOC_ARRAY(compiled->data, quantity);
+   compiled->dataQuantity = compileActions(actions, size, 0, compiled->data);
+}
+
+static void pushDelayedAction (struct ccea_actioninfo *actionInfo, struct cceaDelayedDynamicAction *action, uint32_t sequence);
+
+static struct cceaDelayedDynamicAction* allocateDelayedAction (uint32_t size)
+{
+   struct ccea_delayednode *node = poolAlloc(sizeof(struct ccea_delayednode) + size);
+   node->payload = (struct ccea_compiledActions){NULL, 0, 0};
+   return (struct cceaDelayedDynamicAction*)(node + 1);
+}
+
+static void freeDelayedAction (struct cceaDelayedDynamicAction *action)
+{
+   struct ccea_delayednode *node = (struct ccea_delayednode*) action - 1;
+   poolFree(node->payload.data);
+   poolFree(node);
+}
+
+// Resolves handler once. Actions of periodic and repeated actions are resolved too: unlike delayed ones they are run more than once
+static void queueDelayedAction (struct ccea_actioninfo *actionInfo, struct cceaDelayedDynamicAction *action)
+{
+   struct ccea_delayednode *node = (struct ccea_delayednode*) action - 1;
+   uint32_t actionID;
+   UID_TO_ID(action->UID, actionID);
+   node->handler = g_actions[actionID];
+   uint32_t payloadOffset = 0;
+   if (action->UID == cceaBasicActionUIDs[CCEA_RUN_PERIODIC_ACTIONS])
+      payloadOffset = sizeof(struct ccea_runActionsPeriodic);
+   else if (action->UID == cceaBasicActionUIDs[CCEA_RUN_REPEATED_ACTIONS])
+      payloadOffset = sizeof(struct ccea_runActionsDelayedRepeated);
+   if (payloadOffset != 0)
+   {
+      const cce_void *payload = (const cce_void*) action + payloadOffset;
+      const uint32_t payloadSize = ((struct cceaActionRunner*) action)->totalSize - payloadOffset;
+      node->payload.dataQuantity = node->payload.dataAllocated = compileActions(payload, payloadSize, payloadOffset, NULL);
+      if (node->payload.dataQuantity > 0)
+      {
+         node->payload.data = poolAlloc(node->payload.dataQuantity * sizeof(struct ccea_compiledaction));
+         compileActions(payload, payloadSize, payloadOffset, node->payload.data);
+      }
+   }
+   pushDelayedAction(actionInfo, action, actionInfo->delayedActionsSequence++);
+}
+
 static void addActionsOnEvent (void *data, uint32_t count, struct cce_buffer *state)
 {
    struct cceaAddActionsOnEvent *params = data;
@@ -244,9 +555,9 @@ static void appendListOfRunDelayedAction (void *data, uint32_t count, struct cce
       if (size == 0)
          fprintf(stderr, "ENGINE::ACTIONS_PLUGIN::INFINITE_LOOP: action (uid: %u) has 0 size. Something went very wrong...", action->UID), abort();
       #endif
-      void *node = llnodealloc(size, LL_SINGLELINKED);
+      struct cceaDelayedDynamicAction *node = allocateDelayedAction(size);
       memcpy(node, action, size);
-      llappendchain(&actionInfo->delayedActions, node);
+      queueDelayedAction(actionInfo, node);
    }
 }
 
@@ -358,13 +669,15 @@ while (0)
 
 CCE_API void ccea__runActions (struct cceaAction *actions, uint32_t totalActionsSize, uint32_t count, struct cce_buffer *state)
 {
+   CCE_PROFILE_BEGIN(zone);
    cce_void *action;
    uint32_t actionID;
-   for (uint32_t size = 0; size < totalActionsSize; size += (g_actionSizes[actionID] == 0) ? ((struct cceaDynamicAction*)actions)->size : g_actionSizes[actionID])
+   for (uint32_t size = 0; size < totalActionsSize; size += (g_actionSizes[actionID] == 0) ? ((struct cceaDynamicAction*)action)->size : g_actionSizes[actionID])
    {
       action = ((cce_void*)actions) + size;
       EXEC_ACTION_GET_ID(action, count, state, actionID);
    }
+   CCE_PROFILE_END(zone, "ccea__runActions");
 }
 
 CCE_API void cceaRunAction (struct cceaAction *action, uint32_t count, struct cce_buffer *state)
@@ -508,6 +821,7 @@ CCE_API void* cceaRunActionsCreateDynamic (uint32_t runActionsUID, uint32_t runA
       totalSize += actionsSize[i];
    }
    va_end(argcp);
+   // Caller owns the result and frees it, so it mustn't come from the pool (which is released with the plugin)
    cce_void *runActions = malloc(totalSize);
    *(uint32_t*)runActions = runActionsUID;
    *(uint32_t*)(runActions + sizeof(uint32_t)) = totalSize;
@@ -518,6 +832,7 @@ CCE_API void* cceaRunActionsCreateDynamic (uint32_t runActionsUID, uint32_t runA
       memcpy(pos, action, actionsSize[i]);
    }
    va_end(args);
+   free(actionsSize);
    return runActions;
 }
 
@@ -538,7 +853,13 @@ CCE_API void cceaInvokeEvent (uint32_t eventUID, uint32_t count, struct cce_buff
    uint32_t eventID;
    CCE_FIND_FROM_UID_ARRAY(eventUID, g_eventUIDs, g_eventUIDsSorted, g_eventUIDsQuantity, eventID, 
                            fprintf(stderr, "ENGINE::ACTIONS_PLUGIN::EVENT_NOT_FOUND:\nCan't find event %s (uid: %u)\n", cceUIDToName(eventUID), eventUID); return);
-   ccea__runActions(actionInfo->onEventActions[eventID].data, actionInfo->onEventActions[eventID].dataQuantity, count, map);
+   if (actionInfo->onEventCompiled[eventID].dataQuantity == 0)
+   {
+      if (actionInfo->onEventActions[eventID].dataQuantity == 0)
+         return;
+      compileEventActions(actionInfo, eventID);
+   }
+   runCompiledActions(actionInfo->onEventCompiled + eventID, (cce_void*) actionInfo->onEventActions[eventID].data, count, map);
 }
 
 CCE_API void ccea__addActionsOnEvent (uint32_t eventUID, uint32_t actionSubsUID, uint32_t totalActionsSize, struct cceaAction *actions, struct cceaActionRunner *wrapper, struct cce_buffer *map)
@@ -554,6 +875,7 @@ CCE_API void ccea__addActionsOnEvent (uint32_t eventUID, uint32_t actionSubsUID,
    if (actionsOnEvent->dataQuantity + size / sizeof(struct cceaAction)  > actionsOnEvent->dataAllocated)
       CCE_REALLOC_ARRAY(actionsOnEvent->data, actionsOnEvent->dataQuantity + size / sizeof(struct cceaAction));
    actionInfo->actionSubsUIDs[eventID].data[actionInfo->actionSubsUIDs[eventID].dataQuantity++] = actionSubsUID;
+   actionInfo->onEventCompiled[eventID].dataQuantity = 0;
    cce_void *it = ((cce_void*)actionsOnEvent->data) + actionsOnEvent->dataQuantity;
    if (wrapper != NULL)
    {
@@ -589,7 +911,8 @@ CCE_API void cceaRemoveActionOnEvent (uint32_t eventUID, uint32_t actionSubsUID,
       if (actionSubsID >= actionInfo->actionSubsUIDs[eventID].dataQuantity)
          return;
    }
-   memmove(actionInfo->actionSubsUIDs[eventID].data + actionSubsID, actionInfo->actionSubsUIDs[eventID].data + actionSubsID + 1, --actionInfo->actionSubsUIDs[eventID].dataQuantity - actionSubsID);
+   memmove(actionInfo->actionSubsUIDs[eventID].data + actionSubsID, actionInfo->actionSubsUIDs[eventID].data + actionSubsID + 1,
+           (--actionInfo->actionSubsUIDs[eventID].dataQuantity - actionSubsID) * sizeof(uint32_t));
    uint32_t offset = 0;
    struct cce_actionsResizable *actions = &actionInfo->onEventActions[eventID];
    for (uint32_t i = 0; i < actionSubsID; ++i)
@@ -604,58 +927,117 @@ CCE_API void cceaRemoveActionOnEvent (uint32_t eventUID, uint32_t actionSubsUID,
    UID_TO_ID(action->UID, actionID);
    uint32_t size = g_actionSizes[actionID] == 0 ? action->size : g_actionSizes[actionID];
    memmove(((cce_void*)actions->data) + offset, ((cce_void*)actions->data) + offset + size, (actions->dataQuantity -= size) - offset);
+   actionInfo->onEventCompiled[eventID].dataQuantity = 0;
 }
 
 CCE_API void ccea__delayDynamicAction (uint32_t UID, uint32_t timeout, void *data, uint32_t dataSize, struct cce_buffer *map)
 {
    struct ccea_actioninfo *actionInfo = (struct ccea_actioninfo*)CCE_GET_FUNCTION_BUFFER(map, cceaPluginUID);
-   struct cceaDelayedDynamicAction *action = llnodealloc(sizeof(struct cceaDelayedDynamicAction) + dataSize, LL_SINGLELINKED);
+   struct cceaDelayedDynamicAction *action = allocateDelayedAction(sizeof(struct cceaDelayedDynamicAction) + dataSize);
    action->UID = UID;
    action->timeout = timeout;
    action->size = sizeof(struct cceaDelayedDynamicAction) + dataSize;
    memcpy(action + 1, data, dataSize);
-   llappendchain(&actionInfo->delayedActions, action);
+   queueDelayedAction(actionInfo, action);
 }
 
 CCE_API void cceaRunDelayedActions (struct cce_buffer *map)
 {
+   CCE_PROFILE_BEGIN(zone);
    struct ccea_actioninfo *actionInfo = (struct ccea_actioninfo*)CCE_GET_FUNCTION_BUFFER(map, cceaPluginUID);
-   uint32_t currentTime = (actionInfo->currentMapTime += cceGetFrameDeltaTime());
-   struct list *delayedActions = &actionInfo->delayedActions;
-   // TODO: sort delayedActions according to remaining time
-   void *node = delayedActions->chain, *prevnode = NULL;
-   while (node != NULL)
-   {
-      struct cceaDelayedDynamicAction *action = node;
-      if (cceIsTimeout(currentTime, action->timeout))
-      {
-         EXEC_ACTION(action, 1, map);
-         if (cceIsTimeout(currentTime, action->timeout))
-         {
-            node = LL_NEXT(node);
-            llnodefree(llpullnodep(delayedActions, prevnode), LL_SINGLELINKED);
-            continue;
-         }
-      }
-      prevnode = node;
-      node = LL_NEXT(node);
+   uint32_t currentTime;
+   if (g_flags & CCE_ACTIONS_PRECISE_TIME)
+   {
+      // Sub-millisecond part is carried over instead of being dropped with each frame
+      uint64_t elapsed = actionInfo->currentMapTimeRemainderNs + cceGetFrameDeltaTimeNs();
+      actionInfo->currentMapTimeRemainderNs = elapsed % 1000000u;
+      currentTime = (actionInfo->currentMapTime += (uint32_t)(elapsed / 1000000u));
    }
+   else
+   {
+      currentTime = (actionInfo->currentMapTime += cceGetFrameDeltaTime());
+   }
+   struct ccea_delayedHeap *delayedActions = &actionInfo->delayedActions;
+   // Actions which move their timeout forward (periodic and repeated ones) are put back, the rest are removed
+   while (delayedActions->dataQuantity > 0 && cceIsTimeout(currentTime, delayedActions->data[0].timeout))
+   {
+      struct ccea_delayedentry entry = popDelayedAction(actionInfo);
+      g_firingNode = entry.action;
+      ((struct ccea_delayednode*) entry.action - 1)->handler(entry.action, 1, map);
+      g_firingNode = NULL;
+      if (cceIsTimeout(currentTime, entry.action->timeout))
+         freeDelayedAction(entry.action);
+      else
+         pushDelayedAction(actionInfo, entry.action, entry.sequence);
+   }
+   CCE_PROFILE_END(zone, "cceaRunDelayedActions");
 }
 
+CCE_API void cceaSetPreciseTiming (uint8_t enable)
+{
+   g_flags = (g_flags & ~CCE_ACTIONS_PRECISE_TIME) | (-(enable != 0) & CCE_ACTIONS_PRECISE_TIME);
+}
+
+CCE_API uint64_t cceaGetMapTimeNs (struct cce_buffer *map)
+{
+   struct ccea_actioninfo *actionInfo = (struct ccea_actioninfo*)CCE_GET_FUNCTION_BUFFER(map, cceaPluginUID);
+   return (uint64_t) actionInfo->currentMapTime * 1000000u + actionInfo->currentMapTimeRemainderNs;
+}
+
+CCE_API void ccea__setMapTime (struct cce_buffer *map, uint32_t time)
+{
+   struct ccea_actioninfo *actionInfo = (struct ccea_actioninfo*)CCE_GET_FUNCTION_BUFFER(map, cceaPluginUID);
+   actionInfo->currentMapTime = time;
+   actionInfo->currentMapTimeRemainderNs = 0;
+}
+
+static int compareDelayedEntries (const void *a, const void *b)
+{
+   return delayedEntryPrecedes(b, a) - delayedEntryPrecedes(a, b);
+}
+
+static void releaseActions (struct ccea_actioninfo *map)
+{
+   for (struct ccea_delayedentry *iterator = map->delayedActions.data, *end = map->delayedActions.data + map->delayedActions.dataQuantity; iterator < end; ++iterator)
+   {
+      freeDelayedAction(iterator->action);
+   }
+   free(map->delayedActions.data);
+   for (uint16_t i = 0; i < map->eventsQuantity; ++i)
+   {
+      free(map->actionSubsUIDs[i].data);
+      free(map->onEventActions[i].data);
+      free(map->onEventCompiled[i].data);
+   }
+   free(map->actionSubsUIDs);
+   free(map->onEventActions);
+   free(map->onEventCompiled);
+}
+
+/* Every size read from the file is checked against the rest of it before memory is allocated and every action stream is checked
+ * before anything runs it, so corrupted section fails to load instead of reading garbage */
 int loadActions (void *buffer, uint16_t sectionSize, struct cce_buffer *info, FILE *file)
 {
    struct ccea_actioninfo *map = buffer;
-   fread(&map->currentMapTime, sizeof(uint32_t), 1, file);
-   // 8K of stack memory! May not run well on some platforms with small stack sizes.
-   uint32_t uids[0xFF];
-   fread(uids, sizeof(uint32_t), sectionSize, file);
+   map->currentMapTimeRemainderNs = 0;
    map->actionSubsUIDs = calloc(g_eventUIDsQuantity, sizeof(struct cce_uidsResizable));
+   map->onEventActions = calloc(g_eventUIDsQuantity, sizeof(struct cce_actionsResizable));
+   map->onEventCompiled = calloc(g_eventUIDsQuantity, sizeof(struct ccea_compiledActions));
+   map->delayedActions = (struct ccea_delayedHeap){NULL, 0, 0};
+   map->delayedActionsSequence = 0;
+   map->eventsQuantity = g_eventUIDsQuantity;
+   uint32_t *uids = malloc(sectionSize * sizeof(uint32_t) + 1);
+   uint8_t *eventLoaded = calloc(g_eventUIDsQuantity + 1, sizeof(uint8_t));
+   if (fread(&map->currentMapTime, sizeof(uint32_t), 1, file) != 1 || fread(uids, sizeof(uint32_t), sectionSize, file) != sectionSize)
+      goto CORRUPTED;
    for (uint32_t i = 0; i < sectionSize; ++i)
    {
       uint32_t size, eventID;
-      fread(&size, sizeof(uint32_t), 1, file);
       CCE_FIND_FROM_UID_ARRAY(uids[i], g_eventUIDs, g_eventUIDsSorted, g_eventUIDsQuantity, eventID, 
-                              fprintf(stderr, "ENGINE::ACTIONS_PLUGIN::EVENT_NOT_FOUND:\nCan't find event %s (uid: %u)\n", cceUIDToName(uids[i]), uids[i]); return -1);
+                              fprintf(stderr, "ENGINE::ACTIONS_PLUGIN::EVENT_NOT_FOUND:\nCan't find event %s (uid: %u)\n", cceUIDToName(uids[i]), uids[i]); goto ERROR);
+      if (eventLoaded[eventID] || fread(&size, sizeof(uint32_t), 1, file) != 1 || (uint64_t) size * sizeof(uint32_t) > (uint64_t) cceGetFileRemainingSize(file))
+         goto CORRUPTED;
+      eventLoaded[eventID] = 1;
       uids[i] = eventID;
       map->actionSubsUIDs[eventID].dataAllocated = (map->actionSubsUIDs[eventID].dataQuantity = size);
       if (size == 0)
@@ -664,83 +1046,79 @@ int loadActions (void *buffer, uint16_t sectionSize, struct cce_buffer *info, FI
          continue;
       }
       map->actionSubsUIDs[eventID].data = malloc(size * sizeof(uint32_t));
-      fread(map->actionSubsUIDs[eventID].data, sizeof(uint32_t), size, file);
+      if (fread(map->actionSubsUIDs[eventID].data, sizeof(uint32_t), size, file) != size)
+         goto CORRUPTED;
    }
-   map->onEventActions = calloc(g_eventUIDsQuantity, sizeof(struct cce_actionsResizable));
-   map->delayedActions = LL_LIST_INIT(LL_SINGLELINKED);
    for (uint32_t i = 0; i < sectionSize; ++i)
    {
       uint32_t size;
-      uint32_t UID = 0;
-      fread(&size, sizeof(uint32_t), 1, file);
-      if (g_eventUIDs[i] == cceaBasicEventsUIDs[0] && (fread(&UID, sizeof(uint32_t), 1, file), UID) == cceaBasicActionUIDs[CCEA_APPEND_LIST_OF_RUNDELAYED_ACTIONS])
-      {
-         uint32_t delayedActionsSize;
-         fread(&delayedActionsSize, sizeof(uint32_t), 1, file);
-         struct cceaDynamicAction *actions = malloc(delayedActionsSize);
-         actions->UID = UID;
-         actions->size = delayedActionsSize;
-         fread(actions + 1, delayedActionsSize - sizeof(struct cceaAppendListOfRunDelayedActions), 1, file);
-         EXEC_ACTION(actions, 1, info);
-         size -= delayedActionsSize;
-         map->onEventActions[uids[i]].dataAllocated = map->onEventActions[uids[i]].dataQuantity = size;
-         if (size == 0 || size > delayedActionsSize)
-         {
-            free(actions);
-            if (size == 0)
-               continue;
-            map->onEventActions[uids[i]].data = malloc(size);
-         }
-         else
-         {
-            map->onEventActions[uids[i]].data = realloc(actions, size);
-         }
-         fread(map->onEventActions[uids[i]].data, size, 1, file);
-         continue;
-      }
+      if (fread(&size, sizeof(uint32_t), 1, file) != 1 || size > (uint64_t) cceGetFileRemainingSize(file))
+         goto CORRUPTED;
+      struct cce_actionsResizable *onEvent = map->onEventActions + uids[i];
+      onEvent->dataAllocated = onEvent->dataQuantity = size;
       if (size == 0)
       {
-         map->onEventActions[uids[i]].dataAllocated = map->onEventActions[uids[i]].dataQuantity = size;
-         map->onEventActions[uids[i]].data = NULL;
+         onEvent->data = NULL;
          continue;
       }
-      if (UID != 0)
+      onEvent->data = malloc(size);
+      if (fread(onEvent->data, size, 1, file) != 1)
+         goto CORRUPTED;
+      
+      // Delayed actions of saved map are stored as the first action of load event
+      struct cceaAppendListOfRunDelayedActions *delayed = (struct cceaAppendListOfRunDelayedActions*) onEvent->data;
+      if (g_eventUIDs[uids[i]] == cceaBasicEventsUIDs[0] && size >= sizeof(struct cceaAppendListOfRunDelayedActions) &&
+          delayed->UID == cceaBasicActionUIDs[CCEA_APPEND_LIST_OF_RUNDELAYED_ACTIONS])
       {
-         size -= sizeof(uint32_t);
-         fseek(file, -sizeof(uint32_t), SEEK_CUR);
+         uint32_t delayedActionsSize = delayed->totalSize;
+         if (delayedActionsSize < sizeof(struct cceaAppendListOfRunDelayedActions) || delayedActionsSize > size ||
+             !isActionStreamValid((cce_void*)(delayed + 1), delayedActionsSize - sizeof(struct cceaAppendListOfRunDelayedActions)))
+            goto CORRUPTED;
+         EXEC_ACTION(delayed, 1, info);
+         onEvent->dataAllocated = onEvent->dataQuantity = (size -= delayedActionsSize);
+         memmove(onEvent->data, (cce_void*) onEvent->data + delayedActionsSize, size);
+         if (size == 0)
+         {
+            free(onEvent->data);
+            onEvent->data = NULL;
+            continue;
+         }
       }
-      map->onEventActions[uids[i]].dataAllocated = map->onEventActions[uids[i]].dataQuantity = size;
-      map->onEventActions[uids[i]].data = malloc(size);
-      fread(map->onEventActions[uids[i]].data, size, 1, file);
+      if (!isActionStreamValid((cce_void*) onEvent->data, size))
+         goto CORRUPTED;
    }
-   map->eventsQuantity = g_eventUIDsQuantity;
+   free(uids);
+   free(eventLoaded);
    cceaInvokeEvent(cceaBasicEventsUIDs[0], 1, info);
    return 0;
+   
+CORRUPTED:
+   fprintf(stderr, "ENGINE::ACTIONS_PLUGIN::CORRUPTED_SECTION:\nActions section is truncated or its sizes don't match\n");
+ERROR:
+   free(uids);
+   free(eventLoaded);
+   releaseActions(map);
+   return -1;
 }
 
 void createActions (void *buffer, struct cce_buffer *info)
 {
    CCE_UNUSED(info);
    struct ccea_actioninfo *map = buffer;
-   map->delayedActions = LL_LIST_INIT(LL_SINGLELINKED);
+   map->delayedActions = (struct ccea_delayedHeap){NULL, 0, 0};
+   map->delayedActionsSequence = 0;
    map->eventsQuantity = g_eventUIDsQuantity;
    map->actionSubsUIDs = calloc(g_eventUIDsQuantity, sizeof(struct cce_uidsResizable));
    map->onEventActions = calloc(g_eventUIDsQuantity, sizeof(struct cce_actionsResizable));
+   map->onEventCompiled = calloc(g_eventUIDsQuantity, sizeof(struct ccea_compiledActions));
    map->currentMapTime = 0;
+   map->currentMapTimeRemainderNs = 0;
 }
 
 void freeActions (void *buffer, struct cce_buffer *info)
 {
    cceaInvokeEvent(g_eventUIDs[1], 1, info);
-   struct ccea_actioninfo *map = buffer;
-   llrmlist(&map->delayedActions);
-   for (uint16_t i = 0; i < map->eventsQuantity; ++i)
-   {
-      free(map->actionSubsUIDs[i].data);
-      free(map->onEventActions[i].data);
-   }
-   free(map->actionSubsUIDs);
-   free(map->onEventActions);
+   releaseActions(buffer);
 }
 
 uint16_t storeActions (void *buffer, struct cce_buffer *info, FILE *file)
@@ -751,32 +1129,38 @@ uint16_t storeActions (void *buffer, struct cce_buffer *info, FILE *file)
    uint16_t eventsQuantity = 0, i = 0;
    for (struct cce_actionsResizable *it = map->onEventActions; i < map->eventsQuantity; ++it, ++i)
    {
-      if (it->dataQuantity == 0 && !(g_eventUIDs[i] == cceaBasicEventsUIDs[CCEA_EVENT_LOAD] && map->delayedActions.size > 0))
+      if (it->dataQuantity == 0 && !(g_eventUIDs[i] == cceaBasicEventsUIDs[CCEA_EVENT_LOAD] && map->delayedActions.dataQuantity > 0))
          continue;
       ++eventsQuantity;
       fwrite(&g_eventUIDs[i], sizeof(uint32_t), 1, file);
    }
    for (i = 0; i < map->eventsQuantity; ++i)
    {
-      if (map->actionSubsUIDs[i].dataQuantity == 0 && !(g_eventUIDs[i] == cceaBasicEventsUIDs[CCEA_EVENT_LOAD] && map->delayedActions.size > 0))
+      if (map->actionSubsUIDs[i].dataQuantity == 0 && !(g_eventUIDs[i] == cceaBasicEventsUIDs[CCEA_EVENT_LOAD] && map->delayedActions.dataQuantity > 0))
          continue;
       fwrite(&map->actionSubsUIDs[i].dataQuantity, sizeof(uint32_t), 1, file);
       fwrite(map->actionSubsUIDs[i].data, sizeof(uint32_t), map->actionSubsUIDs[i].dataQuantity, file);
    }
    for (i = 0; i < map->eventsQuantity; ++i)
    {
-      if (g_eventUIDs[i] == cceaBasicEventsUIDs[CCEA_EVENT_LOAD] && map->delayedActions.size > 0)
+      if (g_eventUIDs[i] == cceaBasicEventsUIDs[CCEA_EVENT_LOAD] && map->delayedActions.dataQuantity > 0)
       {
          uint32_t totalSize = sizeof(struct cceaAppendListOfRunDelayedActions);
          fseek(file, sizeof(uint32_t) + sizeof(struct cceaAppendListOfRunDelayedActions), SEEK_CUR);
-         for (struct cceaDelayedDynamicAction *node = map->delayedActions.chain; node != NULL; node = LL_NEXT(node))
+         // Stored in firing order, so actions due on the same tick keep their order after loading
+         struct ccea_delayedentry *sorted = malloc(map->delayedActions.dataQuantity * sizeof(struct ccea_delayedentry));
+         memcpy(sorted, map->delayedActions.data, map->delayedActions.dataQuantity * sizeof(struct ccea_delayedentry));
+         qsort(sorted, map->delayedActions.dataQuantity, sizeof(struct ccea_delayedentry), compareDelayedEntries);
+         for (struct ccea_delayedentry *iterator = sorted, *end = sorted + map->delayedActions.dataQuantity; iterator < end; ++iterator)
          {
+            struct cceaDelayedDynamicAction *node = iterator->action;
             uint32_t ID;
             UID_TO_ID(node->UID, ID);
             uint32_t size = g_actionSizes[ID] == 0 ? node->size : g_actionSizes[ID];
             fwrite(node, size, 1, file);
             totalSize += size;
          }
+         free(sorted);
          fseek(file, -(int32_t)sizeof(uint32_t) - ((int32_t)totalSize), SEEK_CUR);
          {
             uint32_t size = totalSize + map->onEventActions[i].dataQuantity;
@@ -853,17 +1237,33 @@ static int postInitActions (void)
    return 0;
 }
 
+// Everything is reset, so the plugin can be loaded again by the next cceInit
 static void terminateActions (void)
 {
    free(g_actions);
    free(g_endianSwapActions);
+   free(g_actionSizes);
+   free(g_actionUIDs);
+   free(g_eventUIDs);
+   free(g_eventUIDsSorted);
+   g_actions = NULL;
+   g_endianSwapActions = NULL;
+   g_actionSizes = NULL;
+   g_actionUIDs = NULL;
+   g_eventUIDs = NULL;
+   g_eventUIDsSorted = NULL;
+   g_actionsQuantity = g_actionsAllocated = 0;
+   g_eventUIDsQuantity = g_eventUIDsAllocated = 0;
+   g_flags &= CCE_ACTIONS_PRECISE_TIME;
+   terminatePools();
 }
 
 CCE_API void cceaLoadActionsPlugin (void)
 {
    if (cceaPluginUID == 0)
       cceaPluginUID = cceNameToUID("cceacde");
-   cceRegisterPlugin(cceaPluginUID, NULL, NULL, initActions, postInitActions, terminateActions, 0);
+   // Init only fills tables of this plugin, so it runs alongside initialization of the renderer
+   cceRegisterPlugin(cceaPluginUID, NULL, NULL, initActions, postInitActions, terminateActions, CCE_INI_CALLBACK_THREAD_SAFE_INIT);
    g_flags |= CCE_ACTIONS_INITIALIZING;
 }
 
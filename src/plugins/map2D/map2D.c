@@ -36,8 +36,10 @@
 #include "../../../include/cce/engine_common_IO.h"
 #include "../../../include/cce/utils.h"
 #include "../../../include/cce/os_interaction.h"
+#include "../../../include/cce/profiler.h"
 
 #include "../../external/stb_image.h"
+#include "../../platform/threads.h"
 #include "../../../include/cce/plugins/map2D/map2D.h"
 #include "map2D_internal.h"
 
@@ -45,18 +47,46 @@ static struct cce_u16vec2               g_textureSize = {0, 0};
 CCE_API const struct cce_u16vec2 *const cceTextureSize = &g_textureSize;
 CCE_ARRAY(g_textures, static struct cce_loadedtextures, static uint16_t);
 static uint16_t                         g_textureBufferSize;
-CCE_ARRAY(g_texturesEmpty, static struct cce_loadedtextures*, static uint16_t);
+CCE_ARRAY(g_texturesEmpty, static uint16_t, static uint16_t); // Stack of free slots, ones >= g_texturesQuantity are stale and skipped
+
+// Open addressing (linear probing) over texture paths, so that shared textures are found in O(1) when maps are loaded
+struct cce_texturebucket
+{
+   uint32_t hash;
+   uint16_t texture; // Index + 1, 0 - empty bucket
+};
+
+static struct cce_texturebucket        *g_textureBuckets;
+static uint32_t                         g_textureBucketsMask;
+static uint32_t                         g_textureBucketsUsed;
 static struct cce_layer                *g_renderingLayers;
 static uint8_t                          g_renderingLayersQuantity;
 static size_t                           g_renderingDataSize;
 struct cce_rendereringfuns              cce__renderingFunctions;
 
+#define CCE_RENDERER_DEFAULT  0
+#define CCE_RENDERER_OPENGL   1
+#define CCE_RENDERER_SOFTWARE 2
+
+static uint8_t g_renderer = CCE_RENDERER_DEFAULT;
+
+#define CCE_TEXTURE_DECODING_THREADS_AUTO -1
+#define CCE_TEXTURE_DECODING_THREADS_MAX_AUTO 4
+
+static struct cce_texturedecoder *g_textureDecoder = NULL;
+static int16_t                    g_textureDecodingThreads = CCE_TEXTURE_DECODING_THREADS_AUTO;
+static uint32_t                   g_texturesDecoding = 0;
+
 static char  *texturesPath = NULL;
 static size_t texturesPathLength = 0;
 
 uint16_t cce__pixelsPerCoordinate;
 uint8_t  cce__viewRotationAngle;
 struct cce_i16vec2 cce__cameraPosition;
+struct cce__renderingcamera cce__renderingCameraPosition;
+// Position before the first change during the tick cameraTick
+static struct cce_i16vec2 g_previousCameraPosition;
+static uint64_t           g_cameraTick;
 
 cce_flag cce__map2Dflags;
 static void cce__updateTexturesArray (void);
@@ -73,9 +103,24 @@ CCE_API void cceSetViewRotation (uint8_t normalizedAngle)
 
 CCE_API void cceSetCameraPosition (struct cce_i16vec2 position)
 {
+   const uint64_t tick = cceGetTicksQuantity();
+   if (g_cameraTick != tick)
+   {
+      g_previousCameraPosition = cce__cameraPosition;
+      g_cameraTick = tick;
+   }
    cce__cameraPosition = position;
 }
 
+// Camera which didn't move during the last tick is drawn where it is
+static void interpolateCamera (void)
+{
+   const struct cce_i16vec2 previous = (g_cameraTick == cceGetTicksQuantity()) ? g_previousCameraPosition : cce__cameraPosition;
+   const float interpolation = cceGetTickInterpolation();
+   cce__renderingCameraPosition.x = previous.x + (cce__cameraPosition.x - previous.x) * interpolation;
+   cce__renderingCameraPosition.y = previous.y + (cce__cameraPosition.y - previous.y) * interpolation;
+}
+
 static int loadCallback (void *data, const char *name, const char *value)
 {
    CCE_UNUSED(data);
@@ -103,6 +148,35 @@ static int loadCallback (void *data, const char *name, const char *value)
       cce__map2Dflags &= ~CCE_RETURN_NULL_ON_MAP_LOADING_FAILURE;
       cce__map2Dflags |= ((cceStringToBool(value) - 1) & CCE_RETURN_NULL_ON_MAP_LOADING_FAILURE);
    }
+   else if (CCE_STREQ(buf, "renderer"))
+   {
+      char renderer[16] = {0};
+      strncpy(renderer, value, 15);
+      cceMemoryToLowercase(renderer, 15);
+      if (CCE_STREQ(renderer, "opengl") || CCE_STREQ(renderer, "gl"))
+      {
+         g_renderer = CCE_RENDERER_OPENGL;
+      }
+      else if (CCE_STREQ(renderer, "software") || CCE_STREQ(renderer, "cpu"))
+      {
+         g_renderer = CCE_RENDERER_SOFTWARE;
+      }
+      else
+      {
+         fprintf(stderr, "MAP2D::INI::UNKNOWN_RENDERER:\n%s is not a known renderer, default one is used\n", value);
+      }
+   }
+   else if (CCE_STREQ(buf, "texdecodingthreads") || CCE_STREQ(buf, "texturedecodingthreads"))
+   {
+      char *last;
+      long threads = strtol(value, &last, 0);
+      if (value == last || threads < 0 || threads > UINT8_MAX)
+      {
+         fprintf(stderr, "MAP2D::INI::INVALID_THREADS_QUANTITY:\n%s is not a valid number of texture decoding threads\n", value);
+         return 0;
+      }
+      g_textureDecodingThreads = threads;
+   }
    else if (CCE_STREQ(buf, "pxpercoord") || CCE_STREQ(buf, "pixelspercoordinate") || CCE_STREQ(buf, "pxpercell") || CCE_STREQ(buf, "pixelspercell"))
    {
       char *last;
@@ -128,11 +202,70 @@ CCE_API void cceSetRenderingLayerMap2D (uint8_t layer, uint8_t mapLayer, struct
    g_renderingLayers[layer].flags = map->loadingFunctionBlockID == cce__dynamicMapFunctionSet;
 }
 
+static void queueTextureDecoding (struct cce_loadedtextures *texture)
+{
+   const uint16_t position = texture - g_textures;
+   texture->flags |= CCE_LOADEDTEXTURES_DECODING;
+   ++(texture->decodingTicket);
+   ++g_texturesDecoding;
+   const uint32_t userID = ((uint32_t) texture->decodingTicket << 16) | position;
+   if (!cceIsPathAbsolute(texture->path) && texturesPath != NULL)
+   {
+      size_t length = strlen(texture->path);
+      char *path = malloc(texturesPathLength + length + 1);
+      memcpy(path, texturesPath, texturesPathLength);
+      memcpy(path + texturesPathLength, texture->path, length + 1);
+      cceQueueTextureDecoding(g_textureDecoder, path, userID);
+      free(path);
+   }
+   else
+   {
+      cceQueueTextureDecoding(g_textureDecoder, texture->path, userID);
+   }
+}
+
+// Uploads textures finished by decoding threads, the rest keep showing checkerboard
+static void applyDecodedTextures (void)
+{
+   struct cce_decodedtexture decoded[16];
+   uint32_t decodedQuantity;
+   while ((decodedQuantity = cceCollectDecodedTextures(g_textureDecoder, decoded, 16u)) > 0)
+   {
+      g_texturesDecoding -= decodedQuantity;
+      for (struct cce_decodedtexture *iterator = decoded, *end = decoded + decodedQuantity; iterator < end; ++iterator)
+      {
+         const uint16_t position = iterator->userID & 0xFFFF;
+         struct cce_loadedtextures *texture = g_textures + position;
+         if (position < g_texturesQuantity && (texture->flags & CCE_LOADEDTEXTURES_DECODING) && texture->decodingTicket == (iterator->userID >> 16))
+         {
+            texture->flags &= ~CCE_LOADEDTEXTURES_DECODING;
+            if (iterator->data != NULL && texture->dependantMapsQuantity > 0u)
+            {
+               if (iterator->width > g_textureSize.x || iterator->height > g_textureSize.y)
+               {
+                  fprintf(stderr, "ENGINE::TEXTURE::APPLYING_ERROR:\n%s is bigger then texture buffer allocated for it. The texture were truncated\n", iterator->path);
+               }
+               cce__loadTexture(iterator->data, iterator->width, iterator->height, position);
+               texture->size.x = iterator->width;
+               texture->size.y = iterator->height;
+            }
+         }
+         cceFreeDecodedTexture(iterator);
+      }
+   }
+}
+
 CCE_API void cceRenderMap2D (void)
 {
-   if (cce__map2Dflags & CCE_LOADEDTEXTURES_TOBELOADED)
-      cce__updateTexturesArray();
-   cce__drawMap2D(g_renderingLayers, g_renderingLayersQuantity);
+   CCE_PROFILE_SCOPE("cceRenderMap2D")
+   {
+      if (cce__map2Dflags & CCE_LOADEDTEXTURES_TOBELOADED)
+         CCE_PROFILE_SCOPE("updateTexturesArray") cce__updateTexturesArray();
+      if (g_texturesDecoding > 0)
+         CCE_PROFILE_SCOPE("applyDecodedTextures") applyDecodedTextures();
+      interpolateCamera();
+      CCE_PROFILE_SCOPE("drawMap2D") cce__drawMap2D(g_renderingLayers, g_renderingLayersQuantity);
+   }
 }
 
 CCE_API void cceSetTexturesPath (const char *path)
@@ -240,44 +373,31 @@ CCE_API void* cceGenDummyTextureRGBA8 (uint16_t width, uint16_t height)
 
 static void cce__updateTexturesArray (void)
 {
-   {
-      struct cce_loadedtextures *iterator = g_textures + g_texturesQuantity;
-      do
-      {
-         --iterator;
-      }
-      while (iterator > g_textures && iterator->dependantMapsQuantity == 0u);
-      size_t newTexturesQuantity = CCE_MAX(iterator - g_textures, 0);
-      struct cce_loadedtextures **jiterator = g_texturesEmpty;
-      for (struct cce_loadedtextures **end = g_texturesEmpty + g_texturesEmptyQuantity; jiterator < end && (size_t)(*jiterator - g_textures) >= (g_texturesQuantity - newTexturesQuantity); ++jiterator)
-      {
-         
-      }
-      size_t emptyTexturesIgnore = jiterator - g_texturesEmpty;
-      g_texturesEmptyQuantity -= emptyTexturesIgnore;
-      g_texturesQuantity -= newTexturesQuantity;
-      if (emptyTexturesIgnore != 0)
-      {
-         memmove(g_texturesEmpty, g_texturesEmpty + emptyTexturesIgnore, g_texturesEmptyQuantity);
-         CCE_REALLOC_ARRAY(g_texturesEmpty, g_texturesEmptyQuantity);
-         CCE_REALLOC_ARRAY(g_textures, g_texturesQuantity);
-      }
-   }
-   const uint8_t arrayResized = g_texturesAllocated >= g_textureBufferSize;
+   while (g_texturesQuantity > 0 && g_textures[g_texturesQuantity - 1].dependantMapsQuantity == 0u)
+      --g_texturesQuantity;
+   // Only grows, so that loading a map doesn't copy every already loaded texture
+   const uint8_t arrayResized = g_texturesAllocated > g_textureBufferSize;
    if (arrayResized)
+   {
       cce__reallocateTextureArray(g_texturesAllocated);
+      g_textureBufferSize = g_texturesAllocated;
+   }
    
+   void *dummy = NULL;
    for (struct cce_loadedtextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
    {
       if (iterator->dependantMapsQuantity > 0u)
       {
          if ((iterator->flags & CCE_LOADEDTEXTURES_TOBELOADED))
          {
-            if (loadTexture(iterator->path, iterator - g_textures) != 0)
+            if (g_textureDecoder != NULL)
+               queueTextureDecoding(iterator);
+            if (g_textureDecoder != NULL || loadTexture(iterator->path, iterator - g_textures) != 0)
             {
-               void *data = cceGenDummyTextureRGBA8(g_textureSize.x, g_textureSize.y);
-               cce__loadTexture(data, g_textureSize.x, g_textureSize.y, iterator - g_textures);
-               free(data);
+               // Renderer may flip rows in place, the checkerboard stays a checkerboard anyway
+               if (dummy == NULL)
+                  dummy = cceGenDummyTextureRGBA8(g_textureSize.x, g_textureSize.y);
+               cce__loadTexture(dummy, g_textureSize.x, g_textureSize.y, iterator - g_textures);
             }
             iterator->flags &= ~CCE_LOADEDTEXTURES_TOBELOADED;
          }
@@ -292,6 +412,7 @@ static void cce__updateTexturesArray (void)
          iterator->path = NULL;
       }
    }
+   free(dummy);
    if (arrayResized)
    {
       cce__removeOldArray();
@@ -300,172 +421,150 @@ static void cce__updateTexturesArray (void)
    return;
 }
 
-CCE_API uint16_t cceLoadTexture (char *path, uint8_t usersQuantity)
+// FNV-1a
+static uint32_t hashTexturePath (const char *path)
 {
-   assert(path != NULL);
-   cce__map2Dflags |= CCE_LOADEDTEXTURES_TOBELOADED;
-   for (struct cce_loadedtextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
+   uint32_t hash = 2166136261u;
+   for (; *path != '\0'; ++path)
+   {
+      hash = (hash ^ (uint8_t) *path) * 16777619u;
+   }
+   return hash;
+}
+
+static uint16_t findTexture (const char *path, uint32_t hash)
+{
+   for (uint32_t i = hash & g_textureBucketsMask;; i = (i + 1) & g_textureBucketsMask)
    {
-      if (iterator->dependantMapsQuantity == 0u)
+      const struct cce_texturebucket *bucket = g_textureBuckets + i;
+      if (bucket->texture == 0u)
+         return 0u;
+      if (bucket->hash == hash && strcmp(g_textures[bucket->texture - 1].path, path) == 0)
+         return bucket->texture;
+   }
+}
+
+static void insertTextureBucket (uint16_t texture, uint32_t hash)
+{
+   // Load factor is kept at most 1/2
+   if ((g_textureBucketsUsed + 1) * 2 > g_textureBucketsMask + 1)
+   {
+      struct cce_texturebucket *oldBuckets = g_textureBuckets;
+      const uint32_t oldSize = g_textureBucketsMask + 1;
+      g_textureBucketsMask = oldSize * 2 - 1;
+      g_textureBuckets = calloc(oldSize * 2, sizeof(struct cce_texturebucket));
+      for (struct cce_texturebucket *iterator = oldBuckets, *end = oldBuckets + oldSize; iterator < end; ++iterator)
       {
-         continue;
+         if (iterator->texture == 0u)
+            continue;
+         uint32_t i = iterator->hash & g_textureBucketsMask;
+         while (g_textureBuckets[i].texture != 0u)
+            i = (i + 1) & g_textureBucketsMask;
+         g_textureBuckets[i] = *iterator;
       }
-      if (strcmp(iterator->path, path) == 0)
+      free(oldBuckets);
+   }
+   uint32_t i = hash & g_textureBucketsMask;
+   while (g_textureBuckets[i].texture != 0u)
+      i = (i + 1) & g_textureBucketsMask;
+   g_textureBuckets[i] = (struct cce_texturebucket){hash, texture};
+   ++g_textureBucketsUsed;
+}
+
+// Backward shift deletion, so that probing never needs tombstones
+static void removeTextureBucket (uint16_t texture)
+{
+   uint32_t i = hashTexturePath(g_textures[texture - 1].path) & g_textureBucketsMask;
+   while (g_textureBuckets[i].texture != texture)
+      i = (i + 1) & g_textureBucketsMask;
+   for (uint32_t j = (i + 1) & g_textureBucketsMask; g_textureBuckets[j].texture != 0u; j = (j + 1) & g_textureBucketsMask)
+   {
+      const uint32_t home = g_textureBuckets[j].hash & g_textureBucketsMask;
+      // Entry at j may fill the hole at i only if its home bucket is not inside (i, j]
+      if (((j - home) & g_textureBucketsMask) >= ((j - i) & g_textureBucketsMask))
       {
-         iterator->dependantMapsQuantity += usersQuantity;
-         return iterator - g_textures;
+         g_textureBuckets[i] = g_textureBuckets[j];
+         i = j;
       }
    }
-   struct cce_loadedtextures *current;
-   if (g_texturesEmptyQuantity == 0)
+   g_textureBuckets[i].texture = 0u;
+   --g_textureBucketsUsed;
+}
+
+// Returns texture ID (index + 1), usersQuantity is added to the reference count
+static uint16_t acquireTexture (const char *path, uint8_t usersQuantity)
+{
+   const uint32_t hash = hashTexturePath(path);
+   uint16_t texture = findTexture(path, hash);
+   if (texture != 0u)
+   {
+      g_textures[texture - 1].dependantMapsQuantity += usersQuantity;
+      return texture;
+   }
+   cce__map2Dflags |= CCE_LOADEDTEXTURES_TOBELOADED;
+   uint16_t index = UINT16_MAX;
+   while (g_texturesEmptyQuantity > 0)
    {
-      CCE_REALLOC_ARRAY_ZEROED(g_textures, g_texturesQuantity + 1);
-      current = g_textures + g_texturesQuantity++;
+      index = g_texturesEmpty[--g_texturesEmptyQuantity];
+      if (index < g_texturesQuantity)
+         break;
+      index = UINT16_MAX;
    }
-   else
+   if (index == UINT16_MAX)
    {
-      current = g_texturesEmpty[--g_texturesEmptyQuantity];
+      if (g_texturesQuantity >= g_texturesAllocated)
+         CCE_REALLOC_ARRAY_ZEROED(g_textures, g_texturesQuantity + 1);
+      index = g_texturesQuantity++;
    }
+   struct cce_loadedtextures *current = g_textures + index;
    free(current->path);
    size_t pathLength = strlen(path);
    current->path = malloc((pathLength + 1) * sizeof(char));
    memcpy(current->path, path, pathLength + 1);
+   current->size = (struct cce_u16vec2){0, 0};
    current->dependantMapsQuantity = usersQuantity;
    current->flags = CCE_LOADEDTEXTURES_TOBELOADED;
-   setTextureAttributes(current - g_textures);
-   return current - g_textures + 1;
+   setTextureAttributes(index);
+   insertTextureBucket(index + 1, hash);
+   return index + 1;
+}
+
+static void releaseTexture (uint16_t index)
+{
+   if (--(g_textures[index].dependantMapsQuantity) != 0u)
+      return;
+   removeTextureBucket(index + 1);
+   if (index == g_texturesQuantity - 1)
+   {
+      --g_texturesQuantity;
+      return;
+   }
+   if (g_texturesEmptyQuantity >= g_texturesEmptyAllocated)
+      CCE_REALLOC_ARRAY(g_texturesEmpty, g_texturesEmptyQuantity + 1);
+   g_texturesEmpty[g_texturesEmptyQuantity++] = index;
 }
 
-int stringCompare (const void *a, const void *b)
+CCE_API uint16_t cceLoadTexture (char *path, uint8_t usersQuantity)
 {
-   return strcmp(*(char**)a, *(char**)b);
+   assert(path != NULL);
+   return acquireTexture(path, usersQuantity);
 }
 
-// Creates repeating paths when they are already loaded, then ignores them.
-// Done this way because we need dependency order in texturesMapDependOn to exactly match the order of paths (used when elements load)
+// Repeating paths reference the same texture several times, release does the same amount of decrements
 int cce__loadTextures (void *buffer, struct cce_buffer *info, char **paths)
 {
    assert(buffer);
    CCE_UNUSED(info);
-   cce__map2Dflags |= CCE_LOADEDTEXTURES_TOBELOADED;
    struct cce_usedtexinfo *data = buffer;
-   size_t pathsLength;
-   for (char **iterator = paths;; ++iterator)
-   {
-      if (*iterator != NULL)
-         continue;
-      
-      pathsLength = iterator - paths;
-      break;
-   }
-   char **path;
+   size_t pathsLength = 0;
+   while (paths[pathsLength] != NULL)
+      ++pathsLength;
    data->texturesMapDependsOn = malloc(pathsLength * sizeof(uint16_t));
    data->texturesMapDependsOnQuantity = pathsLength;
    data->texturesMapDependsOnAllocated = pathsLength;
-   uint16_t *depTextureIt = data->texturesMapDependsOn;
-   for (struct cce_loadedtextures *iterator = g_textures, *end = g_textures + g_texturesQuantity; iterator < end; ++iterator)
+   for (size_t i = 0; i < pathsLength; ++i)
    {
-      if (iterator->dependantMapsQuantity == 0)
-         continue;
-      path = (char**) bsearch(&iterator->path, paths, pathsLength, sizeof(char*), stringCompare);
-      if (strcmp(*path, iterator->path) == 0)
-      {
-         setTextureAttributes(iterator - g_textures);
-         ++iterator->dependantMapsQuantity;
-         depTextureIt[(path - paths)] = iterator - g_textures + 1;
-         if (path > paths)
-         {
-            for (char **jiterator = path + 1, **jend = paths + pathsLength; jiterator < jend && *jiterator == *path; ++jiterator)
-            {
-               *jiterator = path[-1];
-            }
-            *path = path[-1];
-         }
-         else
-         {
-            uint16_t repeats = 1;
-            for (char **jiterator = path + 1, **jend = paths + pathsLength; *jiterator == jiterator[-1]; ++jiterator, ++repeats)
-            {
-               if (jiterator >= jend)
-               {
-                  return 0;
-               }
-            }
-            paths += repeats;
-            depTextureIt += repeats;
-            pathsLength -= repeats;
-         }
-      }
-   }
-   char **jiterator = paths, **jend = paths + pathsLength;
-   size_t len;
-   if (g_texturesEmptyQuantity > 0)
-   {
-      struct cce_loadedtextures **iterator = g_texturesEmpty + g_texturesEmptyQuantity, **end = g_texturesEmpty;
-      do
-      {
-         --iterator;
-         len = strlen(*jiterator);
-         free((**iterator).path);
-         (**iterator).path = malloc((len + 1) * sizeof(char));;
-         memcpy((**iterator).path, *jiterator, len + 1);
-         (**iterator).flags |= CCE_LOADEDTEXTURES_TOBELOADED;
-         setTextureAttributes(*iterator - g_textures);
-         (**iterator).dependantMapsQuantity = 1;
-         *depTextureIt = *iterator - g_textures + 1;
-         ++jiterator;
-         ++depTextureIt;
-         if (jiterator >= jend)
-         {
-            g_texturesEmptyQuantity = iterator - g_texturesEmpty;
-            return 0;
-         }
-         if (*jiterator == jiterator[-1])
-         {
-            uint16_t repeats = 1;
-            for (char **kiterator = jiterator + 1, **kend = paths + pathsLength; *kiterator == kiterator[-1]; ++kiterator, ++repeats)
-            {
-               if (kiterator >= kend)
-               {
-                  g_texturesEmptyQuantity = iterator - g_texturesEmpty;
-                  return 0;
-               }
-            }
-            jiterator += repeats;
-            depTextureIt += repeats;
-         }
-      }
-      while (iterator > end);
-      g_texturesEmptyQuantity = 0;
-   }
-   for (uint16_t i = g_texturesQuantity; jiterator < jend; ++i, ++g_texturesQuantity)
-   {
-      if (g_texturesQuantity >= g_texturesAllocated)
-         CCE_REALLOC_ARRAY_ZEROED(g_textures, g_texturesQuantity + 1);
-         
-      len = strlen(*jiterator);
-      free(g_textures[i].path);
-      g_textures[i].path = malloc((len + 1) * sizeof(char));
-      memcpy(g_textures[i].path, *jiterator, len + 1);
-      g_textures[i].flags |= CCE_LOADEDTEXTURES_TOBELOADED;
-      g_textures[i].dependantMapsQuantity = 1;
-      setTextureAttributes(i);
-      *depTextureIt = i + 1;
-      ++jiterator;
-      ++depTextureIt;
-      if (*jiterator == jiterator[-1])
-      {
-         uint16_t repeats = 1;
-         for (char **kiterator = jiterator + 1, **end = paths + pathsLength; *kiterator == kiterator[-1]; ++kiterator, ++repeats)
-         {
-            if (kiterator >= end)
-            {
-               return 0;
-            }
-         }
-         jiterator += repeats;
-         depTextureIt += repeats;
-      }
+      data->texturesMapDependsOn[i] = acquireTexture(paths[i], 1u);
    }
    return 0;
 }
@@ -479,68 +578,27 @@ void cce__createTextures (void *buffer, struct cce_buffer *info)
    data->texturesMapDependsOnAllocated = 0;
 }
 
-int ptrcomp (const void *__a, const void *__b)
-{
-   const uint8_t *a = *(const uint8_t**)__a;
-   const uint8_t *b = *(const uint8_t**)__b;
-   return a - b;
-}
-
 void cce__releaseTextures (void *buffer, struct cce_buffer *info)
 {
    CCE_UNUSED(info);
-   uint16_t textureID;
    struct cce_usedtexinfo *data = buffer;
-   if (data->texturesMapDependsOnQuantity == 0)
-      return;
-   // Iteration from the end to increase likelyhood of freeing last textures first (potentially avoiding expensive move and decreasing it's cost)
-   uint16_t *iterator = data->texturesMapDependsOn + data->texturesMapDependsOnQuantity, *end = data->texturesMapDependsOn;
-   do
+   // Iteration from the end to increase likelyhood of freeing last textures first (they are trimmed instead of becoming holes)
+   for (uint16_t *iterator = data->texturesMapDependsOn + data->texturesMapDependsOnQuantity, *end = data->texturesMapDependsOn; iterator > end;)
    {
       --iterator;
-      textureID = *(iterator) - 1u;
-      --(g_textures[textureID].dependantMapsQuantity);
-      if (g_textures[textureID].dependantMapsQuantity == 0)
-      {
-         if (textureID == g_texturesQuantity - 1)
-         {
-            --g_texturesQuantity;
-            continue;
-         }
-            
-         if (g_texturesEmptyQuantity >= g_texturesEmptyAllocated)
-            CCE_REALLOC_ARRAY(g_texturesEmpty, g_texturesEmptyQuantity + 1);
-         void *tofind = g_textures + textureID - 1;
-         struct cce_loadedtextures **pos = cceBinarySearchFirst(&tofind, g_texturesEmpty, g_texturesEmptyQuantity, sizeof(struct cce_loadedtextures*), ptrcomp);
-         memmove(pos + 1, pos, g_texturesEmptyQuantity - (pos - g_texturesEmpty));
-         *pos = g_textures + textureID;
-      }
+      releaseTexture(*iterator - 1u);
    }
-   while (iterator > end);
    free(data->texturesMapDependsOn);
-   return;
+   data->texturesMapDependsOn = NULL;
+   data->texturesMapDependsOnQuantity = 0;
+   data->texturesMapDependsOnAllocated = 0;
 }
 
 void cce__releaseTexture (uint16_t textureID)
 {
    if (textureID == 0u)
       return;
-   --textureID;
-   if (--(g_textures[textureID].dependantMapsQuantity) == 0)
-   {
-      if (textureID == g_texturesQuantity - 1)
-      {
-         --g_texturesQuantity;
-         return;
-      }
-      if (g_texturesEmptyQuantity >= g_texturesEmptyAllocated)
-         CCE_REALLOC_ARRAY(g_texturesEmpty, g_texturesEmptyQuantity + 1);
-      void *tofind = g_textures + textureID - 1;
-      struct cce_loadedtextures **pos = cceBinarySearchFirst(&tofind, g_texturesEmpty, g_texturesEmptyQuantity, sizeof(struct cce_loadedtextures*), ptrcomp);
-      memmove(pos + 1, pos, g_texturesEmptyQuantity - (pos - g_texturesEmpty));
-      *pos = g_textures + textureID;
-   }
-   return;
+   releaseTexture(textureID - 1u);
 }
 
 int textureCompare (const void *_a, const void *_b)
@@ -566,9 +624,14 @@ char** cce__storeTextures (void *buffer, struct cce_buffer *info)
 }
 
 int initMap2DRenderer__openGL (const struct cce_loadedtextures **textures);
+int initMap2DRenderer__null (const struct cce_loadedtextures **textures);
+int initMap2DRenderer__software (const struct cce_loadedtextures **textures);
 
 static void terminateMap2D (void)
 {
+   cceFreeTextureDecoder(g_textureDecoder);
+   g_textureDecoder = NULL;
+   g_texturesDecoding = 0;
    cce__terminateMap2DRenderer();
    cce__terminateMap2DLoaders();
    for (struct cce_loadedtextures *it = g_textures, *end = g_textures + g_texturesAllocated; it < end; ++it)
@@ -576,11 +639,20 @@ static void terminateMap2D (void)
       free(it->path);
    }
    free(g_textures);
+   free(g_texturesEmpty);
+   free(g_textureBuckets);
+   g_textures = NULL;
+   g_texturesEmpty = NULL;
+   g_textureBuckets = NULL;
+   g_texturesQuantity = 0;
+   g_texturesEmptyQuantity = 0;
    free(texturesPath);
    free(g_renderingLayers);
    texturesPath = NULL;
    texturesPathLength = 0;
    g_textureSize = (struct cce_u16vec2){0, 0};
+   g_renderer = CCE_RENDERER_DEFAULT;
+   g_textureDecodingThreads = CCE_TEXTURE_DECODING_THREADS_AUTO;
 }
 
 static int initMap2D (void *data)
@@ -589,19 +661,37 @@ static int initMap2D (void *data)
    cce__map2Dflags = CCE_INIT;
    
    cce__initMap2DLoaders();
-   if (initMap2DRenderer__openGL((const struct cce_loadedtextures**) &g_textures) != 0)
+   int (*initRenderer)(const struct cce_loadedtextures**);
+   switch (g_renderer)
    {
-      fputs("MAP2D::INIT::RENDERER_FAILURE:\nCan't initialize map2D without renderer\n", stderr);
-      return -1;
+      case CCE_RENDERER_OPENGL:   initRenderer = initMap2DRenderer__openGL;   break;
+      case CCE_RENDERER_SOFTWARE: initRenderer = initMap2DRenderer__software; break;
+      default: initRenderer = (strcmp(cceBackend, "null") == 0) ? initMap2DRenderer__null : initMap2DRenderer__openGL;
+   }
+   if (initRenderer((const struct cce_loadedtextures**) &g_textures) != 0)
+   {
+      if (initRenderer != initMap2DRenderer__openGL || initMap2DRenderer__software((const struct cce_loadedtextures**) &g_textures) != 0)
+      {
+         fputs("MAP2D::INIT::RENDERER_FAILURE:\nCan't initialize map2D without renderer\n", stderr);
+         return -1;
+      }
+      fputs("MAP2D::INIT::RENDERER_FALLBACK:\nOpenGL renderer can't be initialized, software renderer is used\n", stderr);
    }
    cceRegisterMapCustomResourceCallback(cce__loadTextures, cce__releaseTextures, cce__createTextures, cce__storeTextures, sizeof(struct cce_usedtexinfo));
    g_renderingDataSize = cce__getRenderingDataSize();
    
    CCE_ALLOC_ARRAY_ZEROED(g_textures, 1);
    CCE_ALLOC_ARRAY(g_texturesEmpty, 1);
+   g_textureBucketsMask = 63u;
+   g_textureBucketsUsed = 0u;
+   g_textureBuckets = calloc(g_textureBucketsMask + 1, sizeof(struct cce_texturebucket));
    g_textureBufferSize = 0;
    cce__map2Dflags &= ~CCE_INIT;
    g_renderingLayers = calloc(g_renderingLayersQuantity, sizeof(struct cce_layer));
+   if (g_textureDecodingThreads == CCE_TEXTURE_DECODING_THREADS_AUTO)
+      g_textureDecodingThreads = CCE_CLAMP((int32_t) cce__getHardwareThreadsQuantity() - 1, 1, CCE_TEXTURE_DECODING_THREADS_MAX_AUTO);
+   // Failure is not fatal - textures are decoded on the main thread then
+   g_textureDecoder = cceCreateTextureDecoder(g_textureDecodingThreads);
    return 0;
 }
 
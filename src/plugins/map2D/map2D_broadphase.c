@@ -0,0 +1,602 @@
+/*
+    Conservative Creator's Engine - open source engine for making games.
+    Copyright (C) 2020-2023 Andrey Gaivoronskiy
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "map2D_internal.h"
+
+/* Uniform grid stored as spatial hash: cell (x >> cellSizeLog2, y >> cellSizeLog2) is packed into 32-bit key, every proxy is
+ * present in all cells its bounding box touches. Only occupied cells use memory, so map may span whole int16 coordinate range */
+
+#define CCE_BROADPHASE_DEAD_PROXY UINT32_MAX
+#define CCE_BROADPHASE_MIN_BUCKETS 64
+
+struct cce_broadphasecell
+{
+   uint32_t key;
+   uint32_t proxy;
+};
+
+CCE_ARRAY_STRUCT(cce_broadphasebucket, struct cce_broadphasecell, uint32_t);
+
+struct cce_broadphaseproxy
+{
+   struct cce_i32vec2 min; // Inclusive
+   struct cce_i32vec2 max; // Exclusive
+   struct cce_i16vec2 minCell;
+   struct cce_i16vec2 maxCell; // Inclusive
+   uint32_t positionID;
+   uint32_t collider; // CCE_BROADPHASE_DEAD_PROXY if slot is unused
+   uint32_t stamp;
+};
+
+struct cce_broadphaseproxyrange
+{
+   uint32_t first;
+   uint16_t quantity;
+   uint16_t allocated;
+};
+
+struct cce_broadphase2D
+{
+   struct cce_broadphasebucket     *buckets;
+   struct cce_broadphaseproxy      *proxies;
+   uint32_t                         proxiesQuantity;
+   uint32_t                         proxiesAllocated;
+   struct cce_broadphaseproxyrange *positions; // Proxies of element position, indexed by positionID
+   uint32_t                         positionsQuantity;
+   uint32_t                         positionsAllocated;
+   uint32_t                        *elementColliders; // Collider indices grouped by element, elementCollidersStart[element] is start of group
+   uint32_t                        *elementCollidersStart;
+   uint32_t                         elementsQuantity;
+   const struct cce_collisioninfo  *colliders;
+   struct cce_buffer               *map;
+   uint32_t                         bucketsMask;
+   uint32_t                         activeProxies;
+   uint32_t                         stamp;
+   uint8_t                          layer;
+   uint8_t                          cellSizeLog2;
+};
+
+static inline uint32_t cellKey (int16_t x, int16_t y)
+{
+   return ((uint32_t)(uint16_t) x << 16) | (uint16_t) y;
+}
+
+static inline struct cce_broadphasebucket* cellBucket (const struct cce_broadphase2D *broadphase, uint32_t key)
+{
+   key ^= key >> 16;
+   key *= 0x7FEB352Du;
+   key ^= key >> 15;
+   return broadphase->buckets + (key & broadphase->bucketsMask);
+}
+
+// Query coordinates may be out of int16 cell range: they are clamped to the edge cells instead of wrapping around
+static inline int16_t toCell (const struct cce_broadphase2D *broadphase, int32_t coordinate)
+{
+   const int32_t cell = coordinate >> broadphase->cellSizeLog2;
+   return (int16_t) CCE_CLAMP(cell, INT16_MIN, INT16_MAX);
+}
+
+static void insertProxyCells (struct cce_broadphase2D *broadphase, uint32_t proxyID)
+{
+   const struct cce_broadphaseproxy *proxy = broadphase->proxies + proxyID;
+   for (int32_t x = proxy->minCell.x; x <= proxy->maxCell.x; ++x)
+   {
+      for (int32_t y = proxy->minCell.y; y <= proxy->maxCell.y; ++y)
+      {
+         uint32_t key = cellKey(x, y);
+         struct cce_broadphasebucket *bucket = cellBucket(broadphase, key);
+         if (bucket->dataQuantity >= bucket->dataAllocated)
+            CCE_REALLOC_ARRAY(bucket->data, bucket->dataQuantity + 1);
+         bucket->data[bucket->dataQuantity++] = (struct cce_broadphasecell){key, proxyID};
+      }
+   }
+}
+
+static void removeProxyCells (struct cce_broadphase2D *broadphase, uint32_t proxyID)
+{
+   const struct cce_broadphaseproxy *proxy = broadphase->proxies + proxyID;
+   for (int32_t x = proxy->minCell.x; x <= proxy->maxCell.x; ++x)
+   {
+      for (int32_t y = proxy->minCell.y; y <= proxy->maxCell.y; ++y)
+      {
+         uint32_t key = cellKey(x, y);
+         struct cce_broadphasebucket *bucket = cellBucket(broadphase, key);
+         for (struct cce_broadphasecell *iterator = bucket->data, *end = bucket->data + bucket->dataQuantity; iterator < end; ++iterator)
+         {
+            if (iterator->proxy == proxyID && iterator->key == key)
+            {
+               *iterator = *(end - 1);
+               --(bucket->dataQuantity);
+               break;
+            }
+         }
+      }
+   }
+}
+
+static void rehashBroadphase (struct cce_broadphase2D *broadphase, uint32_t expectedProxies)
+{
+   uint32_t bucketsQuantity;
+   uint32_t requested = CCE_MAX(expectedProxies, CCE_BROADPHASE_MIN_BUCKETS);
+   CCE_CEIL_TO_POWER_OF_TWO(requested, bucketsQuantity);
+   if (broadphase->buckets != NULL)
+   {
+      for (struct cce_broadphasebucket *iterator = broadphase->buckets, *end = broadphase->buckets + broadphase->bucketsMask + 1; iterator < end; ++iterator)
+         free(iterator->data);
+   }
+   free(broadphase->buckets);
+   broadphase->buckets = calloc(bucketsQuantity, sizeof(struct cce_broadphasebucket));
+   broadphase->bucketsMask = bucketsQuantity - 1;
+   for (uint32_t i = 0; i < broadphase->proxiesQuantity; ++i)
+   {
+      if (broadphase->proxies[i].collider != CCE_BROADPHASE_DEAD_PROXY)
+         insertProxyCells(broadphase, i);
+   }
+}
+
+/* Bounding box of collider in layer coordinates. Flips are applied as in checkCollisionMap2DnoRotation, rotation is ignored */
+static void computeProxyBounds (struct cce_broadphase2D *broadphase, struct cce_broadphaseproxy *proxy, const struct cce_collidermap2D *collider,
+                                const struct cce_element *element, const struct cce_elementposition *position)
+{
+   int32_t x, y, width, height;
+   if (collider->type == CCE_CIRCLE_COLLIDER)
+   {
+      x = collider->data.circle.position.x;
+      y = collider->data.circle.position.y;
+      width = height = collider->data.circle.diameter;
+   }
+   else
+   {
+      x = collider->data.rectangle.position.x;
+      y = collider->data.rectangle.position.y;
+      width = collider->data.rectangle.size.x;
+      height = collider->data.rectangle.size.y;
+   }
+   if (element->flags & CCE_ELEMENT_FLIP_HORIZONTALLY)
+      x = -x - width;
+   if (element->flags & CCE_ELEMENT_FLIP_VERTICALLY)
+      y = -y - height;
+   proxy->min.x = x + element->position.x + position->position.x;
+   proxy->min.y = y + element->position.y + position->position.y;
+   proxy->max.x = proxy->min.x + width;
+   proxy->max.y = proxy->min.y + height;
+   proxy->minCell.x = toCell(broadphase, proxy->min.x);
+   proxy->minCell.y = toCell(broadphase, proxy->min.y);
+   // Zero-sized colliders still occupy the cell they are in
+   proxy->maxCell.x = toCell(broadphase, CCE_MAX(proxy->max.x - 1, proxy->min.x));
+   proxy->maxCell.y = toCell(broadphase, CCE_MAX(proxy->max.y - 1, proxy->min.y));
+}
+
+static void indexElementColliders (struct cce_broadphase2D *broadphase, uint16_t elementsQuantity)
+{
+   free(broadphase->elementColliders);
+   free(broadphase->elementCollidersStart);
+   broadphase->elementsQuantity = elementsQuantity;
+   broadphase->elementCollidersStart = calloc(elementsQuantity + 1u, sizeof(uint32_t));
+   broadphase->elementColliders = malloc(CCE_MAX(broadphase->colliders->collidersQuantity, 1u) * sizeof(uint32_t));
+   const struct cce_collidermap2D *colliders = broadphase->colliders->colliders;
+   // Counting sort by element, so colliders of element are found without scanning whole collider array
+   for (uint32_t i = 0; i < broadphase->colliders->collidersQuantity; ++i)
+   {
+      if (colliders[i].element < elementsQuantity)
+         ++(broadphase->elementCollidersStart[colliders[i].element + 1]);
+   }
+   for (uint32_t i = 0; i < elementsQuantity; ++i)
+      broadphase->elementCollidersStart[i + 1] += broadphase->elementCollidersStart[i];
+   uint32_t *fill = malloc((elementsQuantity + 1u) * sizeof(uint32_t));
+   memcpy(fill, broadphase->elementCollidersStart, (elementsQuantity + 1u) * sizeof(uint32_t));
+   for (uint32_t i = 0; i < broadphase->colliders->collidersQuantity; ++i)
+   {
+      if (colliders[i].element < elementsQuantity)
+         broadphase->elementColliders[fill[colliders[i].element]++] = i;
+   }
+   free(fill);
+}
+
+static void syncPosition (struct cce_broadphase2D *broadphase, uint32_t positionID, const struct cce_elementposition *position, const struct cce_element *elements)
+{
+   struct cce_broadphaseproxyrange *range = broadphase->positions + positionID;
+   const uint32_t *colliders = NULL;
+   uint16_t collidersQuantity = 0;
+   if (position->textureDataID != 0 && position->textureDataID <= broadphase->elementsQuantity)
+   {
+      uint32_t element = position->textureDataID - 1;
+      colliders = broadphase->elementColliders + broadphase->elementCollidersStart[element];
+      collidersQuantity = broadphase->elementCollidersStart[element + 1] - broadphase->elementCollidersStart[element];
+   }
+   if (collidersQuantity > range->allocated)
+   {
+      for (uint32_t i = range->first, end = range->first + range->quantity; i < end; ++i)
+      {
+         removeProxyCells(broadphase, i);
+         broadphase->proxies[i].collider = CCE_BROADPHASE_DEAD_PROXY;
+      }
+      broadphase->activeProxies -= range->quantity;
+      range->first = broadphase->proxiesQuantity;
+      range->quantity = 0;
+      range->allocated = collidersQuantity;
+      if (broadphase->proxiesQuantity + collidersQuantity > broadphase->proxiesAllocated)
+         CCE_REALLOC_ARRAY(broadphase->proxies, broadphase->proxiesQuantity + collidersQuantity);
+      for (uint32_t i = broadphase->proxiesQuantity, end = broadphase->proxiesQuantity + collidersQuantity; i < end; ++i)
+      {
+         broadphase->proxies[i].collider = CCE_BROADPHASE_DEAD_PROXY;
+         broadphase->proxies[i].stamp = 0;
+      }
+      broadphase->proxiesQuantity += collidersQuantity;
+   }
+   for (uint16_t i = 0; i < collidersQuantity; ++i)
+   {
+      uint32_t proxyID = range->first + i;
+      struct cce_broadphaseproxy *proxy = broadphase->proxies + proxyID;
+      struct cce_broadphaseproxy updated = *proxy;
+      const struct cce_collidermap2D *collider = broadphase->colliders->colliders + colliders[i];
+      computeProxyBounds(broadphase, &updated, collider, elements + collider->element, position);
+      updated.positionID = positionID;
+      updated.collider = colliders[i];
+      if (proxy->collider == CCE_BROADPHASE_DEAD_PROXY)
+      {
+         *proxy = updated;
+         insertProxyCells(broadphase, proxyID);
+         ++(broadphase->activeProxies);
+      }
+      // Moving inside the same cells is the common case and does not touch the grid
+      else if (memcmp(&proxy->minCell, &updated.minCell, sizeof(struct cce_i16vec2) * 2) != 0)
+      {
+         removeProxyCells(broadphase, proxyID);
+         *proxy = updated;
+         insertProxyCells(broadphase, proxyID);
+      }
+      else
+      {
+         *proxy = updated;
+      }
+   }
+   for (uint32_t i = range->first + collidersQuantity, end = range->first + range->quantity; i < end; ++i)
+   {
+      removeProxyCells(broadphase, i);
+      broadphase->proxies[i].collider = CCE_BROADPHASE_DEAD_PROXY;
+      --(broadphase->activeProxies);
+   }
+   range->quantity = collidersQuantity;
+}
+
+CCE_API struct cce_broadphase2D* cceCreateBroadphase2D (uint8_t cellSizeLog2)
+{
+   if (cellSizeLog2 < 2 || cellSizeLog2 > 15)
+   {
+      fprintf(stderr, "MAP2D::BROADPHASE::INVALID_CELL_SIZE:\nCell size must be from 2^2 to 2^15, 2^%u was requested\n", cellSizeLog2);
+      return NULL;
+   }
+   struct cce_broadphase2D *broadphase = calloc(1, sizeof(struct cce_broadphase2D));
+   broadphase->cellSizeLog2 = cellSizeLog2;
+   return broadphase;
+}
+
+CCE_API void cceFreeBroadphase2D (struct cce_broadphase2D *broadphase)
+{
+   if (broadphase == NULL)
+      return;
+   if (broadphase->buckets != NULL)
+   {
+      for (struct cce_broadphasebucket *iterator = broadphase->buckets, *end = broadphase->buckets + broadphase->bucketsMask + 1; iterator < end; ++iterator)
+         free(iterator->data);
+   }
+   free(broadphase->buckets);
+   free(broadphase->proxies);
+   free(broadphase->positions);
+   free(broadphase->elementColliders);
+   free(broadphase->elementCollidersStart);
+   free(broadphase);
+}
+
+CCE_API int cceBuildBroadphaseMap2D (struct cce_broadphase2D *broadphase, const struct cce_collisioninfo *colliders, uint8_t layer, struct cce_buffer *map)
+{
+   assert(broadphase != NULL && colliders != NULL);
+   struct cce_renderinginfo *info = cceGetRenderingInfo(map);
+   struct cce_elementpositionarray *positions = cceGetElementPositionArray(layer, map);
+   if (positions == NULL)
+   {
+      fprintf(stderr, "MAP2D::BROADPHASE::NO_LAYER:\nMap has no layer %u\n", layer);
+      return -1;
+   }
+   broadphase->colliders = colliders;
+   broadphase->map = map;
+   broadphase->layer = layer;
+   broadphase->proxiesQuantity = 0;
+   broadphase->activeProxies = 0;
+   indexElementColliders(broadphase, info->elementsQuantity);
+
+   broadphase->positionsQuantity = positions->dataQuantity;
+   free(broadphase->positions);
+   CCE_ALLOC_ARRAY_ZEROED(broadphase->positions, CCE_MAX(positions->dataQuantity, 1u));
+   // Proxies are laid out before the grid is filled, so that buckets can be sized once
+   uint32_t proxiesQuantity = 0;
+   for (uint32_t i = 0; i < positions->dataQuantity; ++i)
+   {
+      uint16_t textureDataID = positions->data[i].textureDataID;
+      uint16_t quantity = 0;
+      if (textureDataID != 0 && textureDataID <= broadphase->elementsQuantity)
+         quantity = broadphase->elementCollidersStart[textureDataID] - broadphase->elementCollidersStart[textureDataID - 1];
+      broadphase->positions[i] = (struct cce_broadphaseproxyrange){proxiesQuantity, 0, quantity};
+      proxiesQuantity += quantity;
+   }
+   free(broadphase->proxies);
+   CCE_ALLOC_ARRAY(broadphase->proxies, CCE_MAX(proxiesQuantity, 1u));
+   for (uint32_t i = 0; i < proxiesQuantity; ++i)
+   {
+      broadphase->proxies[i].collider = CCE_BROADPHASE_DEAD_PROXY;
+      broadphase->proxies[i].stamp = 0;
+   }
+   broadphase->proxiesQuantity = proxiesQuantity;
+   rehashBroadphase(broadphase, proxiesQuantity);
+   for (uint32_t i = 0; i < positions->dataQuantity; ++i)
+      syncPosition(broadphase, i, positions->data + i, info->elements);
+   return 0;
+}
+
+CCE_API int cceUpdateBroadphaseMap2D (struct cce_broadphase2D *broadphase, uint32_t positionID, uint32_t quantity)
+{
+   assert(broadphase != NULL);
+   if (broadphase->map == NULL)
+      return -1;
+   struct cce_renderinginfo *info = cceGetRenderingInfo(broadphase->map);
+   // Elements could have been added to dynamic map since build
+   if (info->elementsQuantity != broadphase->elementsQuantity)
+      indexElementColliders(broadphase, info->elementsQuantity);
+   // Dynamic map array may have been reallocated by cceGetElementsPosition, so it is fetched every time
+   struct cce_elementpositionarray *positions = cceGetElementPositionArray(broadphase->layer, broadphase->map);
+   if (positions == NULL || positionID >= positions->dataQuantity)
+      return -1;
+   quantity = CCE_MIN(quantity, positions->dataQuantity - positionID);
+   if (positions->dataQuantity > broadphase->positionsQuantity)
+   {
+      if (positions->dataQuantity > broadphase->positionsAllocated)
+         CCE_REALLOC_ARRAY_ZEROED(broadphase->positions, positions->dataQuantity);
+      broadphase->positionsQuantity = positions->dataQuantity;
+   }
+   for (uint32_t i = positionID, end = positionID + quantity; i < end; ++i)
+      syncPosition(broadphase, i, positions->data + i, info->elements);
+   if (broadphase->activeProxies > (broadphase->bucketsMask + 1) * 2)
+      rehashBroadphase(broadphase, broadphase->activeProxies);
+   return 0;
+}
+
+#define CCE_BROADPHASE_OUTPUT(broadphase, proxyID, candidates, candidatesMax, found) \
+do \
+{ \
+   if ((found) < (candidatesMax)) \
+      (candidates)[found] = (struct cce_broadphasecandidate2D){(broadphase)->proxies[proxyID].positionID, (broadphase)->proxies[proxyID].collider}; \
+   ++(found); \
+} \
+while (0)
+
+static inline uint32_t nextStamp (struct cce_broadphase2D *broadphase)
+{
+   if (++(broadphase->stamp) == 0)
+   {
+      for (uint32_t i = 0; i < broadphase->proxiesQuantity; ++i)
+         broadphase->proxies[i].stamp = 0;
+      broadphase->stamp = 1;
+   }
+   return broadphase->stamp;
+}
+
+static inline uint8_t proxyOverlapsBox (const struct cce_broadphaseproxy *proxy, struct cce_i32vec2 min, struct cce_i32vec2 max)
+{
+   return proxy->min.x < max.x && proxy->max.x > min.x && proxy->min.y < max.y && proxy->max.y > min.y;
+}
+
+static uint32_t queryBox (struct cce_broadphase2D *broadphase, struct cce_i32vec2 min, struct cce_i32vec2 max, const struct cce_collider_cir2D_32_32 *circle,
+                          struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax)
+{
+   if (broadphase->buckets == NULL)
+      return 0;
+   uint32_t found = 0;
+   uint32_t stamp = nextStamp(broadphase);
+   int16_t minCellX = toCell(broadphase, min.x), maxCellX = toCell(broadphase, CCE_MAX(max.x - 1, min.x));
+   int16_t minCellY = toCell(broadphase, min.y), maxCellY = toCell(broadphase, CCE_MAX(max.y - 1, min.y));
+   for (int32_t x = minCellX; x <= maxCellX; ++x)
+   {
+      for (int32_t y = minCellY; y <= maxCellY; ++y)
+      {
+         uint32_t key = cellKey(x, y);
+         const struct cce_broadphasebucket *bucket = cellBucket(broadphase, key);
+         for (const struct cce_broadphasecell *iterator = bucket->data, *end = bucket->data + bucket->dataQuantity; iterator < end; ++iterator)
+         {
+            struct cce_broadphaseproxy *proxy = broadphase->proxies + iterator->proxy;
+            if (iterator->key != key || proxy->stamp == stamp)
+               continue;
+            proxy->stamp = stamp;
+            if (!proxyOverlapsBox(proxy, min, max))
+               continue;
+            if (circle != NULL)
+            {
+               // Doubled coordinates keep circle center integer, same as cceCheckCollisionCirRect2D
+               int64_t centerX = (int64_t) circle->position.x * 2 + circle->diameter, centerY = (int64_t) circle->position.y * 2 + circle->diameter;
+               int64_t dx = centerX - CCE_CLAMP(centerX, (int64_t) proxy->min.x * 2, (int64_t) proxy->max.x * 2);
+               int64_t dy = centerY - CCE_CLAMP(centerY, (int64_t) proxy->min.y * 2, (int64_t) proxy->max.y * 2);
+               if (dx * dx + dy * dy >= (int64_t) circle->diameter * circle->diameter)
+                  continue;
+            }
+            CCE_BROADPHASE_OUTPUT(broadphase, iterator->proxy, candidates, candidatesMax, found);
+         }
+      }
+   }
+   return found;
+}
+
+CCE_API uint32_t cceQueryBroadphaseAABB2D (struct cce_broadphase2D *broadphase, struct cce_collider_rect2D_32_32 box,
+                                           struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax)
+{
+   assert(broadphase != NULL);
+   struct cce_i32vec2 max = {box.position.x + (int32_t) box.size.x, box.position.y + (int32_t) box.size.y};
+   return queryBox(broadphase, box.position, max, NULL, candidates, candidatesMax);
+}
+
+CCE_API uint32_t cceQueryBroadphasePoint2D (struct cce_broadphase2D *broadphase, struct cce_i32vec2 point,
+                                            struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax)
+{
+   assert(broadphase != NULL);
+   return queryBox(broadphase, point, (struct cce_i32vec2){point.x + 1, point.y + 1}, NULL, candidates, candidatesMax);
+}
+
+CCE_API uint32_t cceQueryBroadphaseCircle2D (struct cce_broadphase2D *broadphase, struct cce_collider_cir2D_32_32 circle,
+                                             struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax)
+{
+   assert(broadphase != NULL);
+   struct cce_i32vec2 max = {circle.position.x + (int32_t) circle.diameter, circle.position.y + (int32_t) circle.diameter};
+   return queryBox(broadphase, circle.position, max, &circle, candidates, candidatesMax);
+}
+
+/* Slab test of segment origin + t * direction, t in [0, 1] against proxy box. Returns entry t or INFINITY.
+ * Box is half-open like everywhere in broadphase: segment which only touches its max edge doesn't hit it */
+static float segmentEntry (const struct cce_broadphaseproxy *proxy, float originX, float originY, float directionX, float directionY)
+{
+   float tMin = 0.0f, tMax = 1.0f;
+   float tMaxEdge[2] = {INFINITY, INFINITY};
+   const float origin[2] = {originX, originY}, direction[2] = {directionX, directionY};
+   const float boxMin[2] = {(float) proxy->min.x, (float) proxy->min.y}, boxMax[2] = {(float) proxy->max.x, (float) proxy->max.y};
+   for (uint8_t axis = 0; axis < 2; ++axis)
+   {
+      if (direction[axis] == 0.0f)
+      {
+         if (origin[axis] < boxMin[axis] || origin[axis] >= boxMax[axis])
+            return INFINITY;
+         continue;
+      }
+      float t1 = (boxMin[axis] - origin[axis]) / direction[axis];
+      tMaxEdge[axis] = (boxMax[axis] - origin[axis]) / direction[axis];
+      tMin = CCE_MAX(tMin, CCE_MIN(t1, tMaxEdge[axis]));
+      tMax = CCE_MIN(tMax, CCE_MAX(t1, tMaxEdge[axis]));
+      if (tMin > tMax)
+         return INFINITY;
+   }
+   // Any longer overlap has points off max edges, single touching point must not lie on them
+   if (tMin == tMax && (tMin == tMaxEdge[0] || tMin == tMaxEdge[1]))
+      return INFINITY;
+   return tMin;
+}
+
+/* Cells are walked along the segment (Amanatides-Woo), so candidates come out roughly ordered by distance from origin */
+CCE_API uint32_t cceQueryBroadphaseRay2D (struct cce_broadphase2D *broadphase, struct cce_i32vec2 origin, struct cce_i32vec2 end,
+                                          struct cce_broadphasecandidate2D *candidates, uint32_t candidatesMax)
+{
+   assert(broadphase != NULL);
+   if (broadphase->buckets == NULL)
+      return 0;
+   uint32_t found = 0;
+   uint32_t stamp = nextStamp(broadphase);
+   const float cellSize = (float)(1u << broadphase->cellSizeLog2);
+   const float directionX = (float)(end.x - origin.x), directionY = (float)(end.y - origin.y);
+   int32_t x = toCell(broadphase, origin.x), y = toCell(broadphase, origin.y);
+   const int32_t endX = toCell(broadphase, end.x), endY = toCell(broadphase, end.y);
+   const int32_t stepX = (directionX > 0.0f) - (directionX < 0.0f), stepY = (directionY > 0.0f) - (directionY < 0.0f);
+   float tMaxX = INFINITY, tMaxY = INFINITY, tDeltaX = INFINITY, tDeltaY = INFINITY;
+   if (stepX != 0)
+   {
+      tMaxX = (((float)(x + (stepX > 0)) * cellSize) - (float) origin.x) / directionX;
+      tDeltaX = cellSize / fabsf(directionX);
+   }
+   if (stepY != 0)
+   {
+      tMaxY = (((float)(y + (stepY > 0)) * cellSize) - (float) origin.y) / directionY;
+      tDeltaY = cellSize / fabsf(directionY);
+   }
+   uint32_t cellsLeft = abs(endX - x) + abs(endY - y) + 1;
+   for (;;)
+   {
+      uint32_t key = cellKey(x, y);
+      const struct cce_broadphasebucket *bucket = cellBucket(broadphase, key);
+      for (const struct cce_broadphasecell *iterator = bucket->data, *bucketEnd = bucket->data + bucket->dataQuantity; iterator < bucketEnd; ++iterator)
+      {
+         struct cce_broadphaseproxy *proxy = broadphase->proxies + iterator->proxy;
+         if (iterator->key != key || proxy->stamp == stamp)
+            continue;
+         proxy->stamp = stamp;
+         if (segmentEntry(proxy, (float) origin.x, (float) origin.y, directionX, directionY) == INFINITY)
+            continue;
+         CCE_BROADPHASE_OUTPUT(broadphase, iterator->proxy, candidates, candidatesMax, found);
+      }
+      if (--cellsLeft == 0)
+         break;
+      // When segment crosses cell corner, positive step goes first: it leads to the cell which contains the corner
+      if (tMaxX < tMaxY || (tMaxX == tMaxY && stepX > 0))
+      {
+         x += stepX;
+         tMaxX += tDeltaX;
+      }
+      else
+      {
+         y += stepY;
+         tMaxY += tDeltaY;
+      }
+   }
+   return found;
+}
+
+/* Every overlapping pair is reported once: only from the first cell both proxies share (maximum of their minimal cells) */
+CCE_API uint32_t cceGetBroadphasePairs2D (struct cce_broadphase2D *broadphase, struct cce_broadphasepair2D *pairs, uint32_t pairsMax)
+{
+   assert(broadphase != NULL);
+   if (broadphase->buckets == NULL)
+      return 0;
+   uint32_t found = 0;
+   for (uint32_t proxyID = 0; proxyID < broadphase->proxiesQuantity; ++proxyID)
+   {
+      const struct cce_broadphaseproxy *proxy = broadphase->proxies + proxyID;
+      if (proxy->collider == CCE_BROADPHASE_DEAD_PROXY)
+         continue;
+      for (int32_t x = proxy->minCell.x; x <= proxy->maxCell.x; ++x)
+      {
+         for (int32_t y = proxy->minCell.y; y <= proxy->maxCell.y; ++y)
+         {
+            uint32_t key = cellKey(x, y);
+            const struct cce_broadphasebucket *bucket = cellBucket(broadphase, key);
+            for (const struct cce_broadphasecell *iterator = bucket->data, *end = bucket->data + bucket->dataQuantity; iterator < end; ++iterator)
+            {
+               if (iterator->key != key || iterator->proxy <= proxyID)
+                  continue;
+               const struct cce_broadphaseproxy *other = broadphase->proxies + iterator->proxy;
+               // Colliders of one element instance do not collide with each other
+               if (other->positionID == proxy->positionID)
+                  continue;
+               if (CCE_MAX(proxy->minCell.x, other->minCell.x) != x || CCE_MAX(proxy->minCell.y, other->minCell.y) != y)
+                  continue;
+               if (!proxyOverlapsBox(other, proxy->min, proxy->max))
+                  continue;
+               if (found < pairsMax)
+               {
+                  pairs[found].a = (struct cce_broadphasecandidate2D){proxy->positionID, proxy->collider};
+                  pairs[found].b = (struct cce_broadphasecandidate2D){other->positionID, other->collider};
+               }
+               ++found;
+            }
+         }
+      }
+   }
+   return found;
+}
@@ -42,6 +42,8 @@ uint16_t cce__staticMapFunctionSet, cce__dynamicMapFunctionSet;
 ptrdiff_t cce__resourceLoadersOffset, cce__renderingInfoOffset;
 
 static size_t resourceSpaceToBeAllocated;
+static uint8_t mapCompression = CCE_CCF_CODEC_NONE;
+static uint8_t mapChecksums = 0;
 
 CCE_ARRAY(resourceLoadingFunctions, static cce_rloadfun, static uint16_t);
 static cce_dataparsefun *resourceUnloadingFunctions;
@@ -54,6 +56,23 @@ CCE_API void cceSetMap2Dpath (const char *path)
    CCE_SET_PATH(mapPath, mapPathLength, path);
 }
 
+CCE_API void cceSetMap2Dcompression (uint8_t codec)
+{
+   mapCompression = codec;
+   if (resourceLoadingFunctions != NULL) // Initialized
+      cceSetFileIOcompression(cce__dynamicMapFunctionSet, codec);
+}
+
+CCE_API void cceSetMap2Dchecksums (uint8_t flags)
+{
+   mapChecksums = flags;
+   if (resourceLoadingFunctions != NULL) // Initialized
+   {
+      cceSetFileIOchecksums(cce__staticMapFunctionSet, flags);
+      cceSetFileIOchecksums(cce__dynamicMapFunctionSet, flags);
+   }
+}
+
 CCE_API struct cce_buffer* cceCreateMap2Ddynamic (void)
 {
    return cceCreateBuffer(-1, cce__dynamicMapFunctionSet);
@@ -78,15 +97,62 @@ CCE_API uint32_t cceRegisterMapCustomResourceCallback (cce_rloadfun onLoad, cce_
    return resourceLoadingFunctionsQuantity++ | 0x80000000;
 }
 
+// Replaces indices into texture list of the map with texture IDs, fails if element refers to texture outside of the list
+static int remapElementTextures (struct cce_element *elements, uint16_t elementsQuantity, struct cce_buffer *info)
+{
+   struct cce_resourceinfo *resources = (struct cce_resourceinfo*)((cce_void*) info + cce__resourceLoadersOffset);
+   uint16_t *usedTextures = NULL, usedTexturesQuantity = 0;
+   if (resources->resourcesQuantity > 0)
+   {
+      usedTextures = ((struct cce_usedtexinfo*) resources->resourceData)->texturesMapDependsOn;
+      usedTexturesQuantity = ((struct cce_usedtexinfo*) resources->resourceData)->texturesMapDependsOnQuantity;
+   }
+   for (struct cce_element *iterator = elements, *end = elements + elementsQuantity; iterator < end; ++iterator)
+   {
+      if (iterator->textureID == 0)
+         continue;
+      if (iterator->textureID > usedTexturesQuantity)
+      {
+         fprintf(stderr, "ENGINE::MAP2DLOADERS::RENDERING_DATA_LOAD_ERROR:\nElement refers to texture %u, map depends on %u textures.\n",
+                 iterator->textureID, usedTexturesQuantity);
+         return -1;
+      }
+      iterator->textureID = usedTextures[iterator->textureID - 1];
+   }
+   return 0;
+}
+
+static uint8_t isElementsTotalValid (const uint32_t *elementsQuantity, uint16_t layersQuantity, uint32_t elementsTotal)
+{
+   uint64_t sum = 0;
+   for (const uint32_t *iterator = elementsQuantity, *end = elementsQuantity + layersQuantity; iterator < end; ++iterator)
+      sum += *iterator;
+   return sum == elementsTotal;
+}
+
+// Position and texture data ID are stored little-endian, texture data offset group and reserved field are single bytes
+static void positionsToHostEndian (struct cce_elementposition *positions, uint32_t quantity)
+{
+   if (cceEndianess != CCE_BIG_ENDIAN)
+      return;
+   for (struct cce_elementposition *iterator = positions, *end = positions + quantity; iterator < end; ++iterator)
+      cceLittleEndianToBigEndianArrayInt16((uint16_t*) iterator, 3);
+}
+
+// Sizes are checked against the rest of the file before anything is allocated, so corrupted counts can't request gigabytes of memory
 #define LOADELEMENTS(buffer, sectionSize, info, file, elementInfoAlloc, elementsQuantityAlloc) \
-fread(&elementInfoQuantity, sizeof(uint16_t), sectionSize > 0, file); \
+if (sectionSize == 0 || fread(&elementInfoQuantity, sizeof(uint16_t), 1, file) != 1 || fread(&elementsTotal, sizeof(uint32_t), 1, file) != 1) \
+   goto CORRUPTED; \
 elementInfoQuantity = cceLittleEndianToHostEndianInt16(elementInfoQuantity); \
-fread(&elementsTotal,       sizeof(uint32_t), sectionSize > 0, file); \
 elementsTotal = cceLittleEndianToHostEndianInt32(elementsTotal); \
+if ((uint64_t) cceGetFileRemainingSize(file) < sectionSize * sizeof(uint32_t) + elementInfoQuantity * sizeof(struct cce_element) + \
+                                               (uint64_t) elementsTotal * sizeof(struct cce_elementposition)) \
+   goto CORRUPTED; \
 struct cce_element          *elementInfo = elementInfoAlloc; \
 elementsQuantity                         = elementsQuantityAlloc; \
-fread(elementsQuantity,     sizeof(uint32_t), sectionSize,     file); \
-fread(elementInfo, sizeof(struct cce_element), elementInfoQuantity, file); \
+if (fread(elementsQuantity, sizeof(uint32_t), sectionSize, file) != sectionSize || \
+    fread(elementInfo, sizeof(struct cce_element), elementInfoQuantity, file) != elementInfoQuantity) \
+   goto CORRUPTED_ALLOCATED; \
 if (cceEndianess == CCE_BIG_ENDIAN) \
 { \
    cceLittleEndianToBigEndianArrayInt32(elementsQuantity, sectionSize); \
@@ -96,13 +162,10 @@ if (cceEndianess == CCE_BIG_ENDIAN) \
       cceLittleEndianToBigEndianArrayInt16((uint16_t*)iterator + (iterator->textureID == 0) * 2, 4 - (iterator->textureID == 0) * 2); \
    } \
 } \
-if (((struct cce_resourceinfo*)((cce_void*) info + cce__resourceLoadersOffset))->resourcesQuantity > 0) \
-{ \
-   uint16_t *usedTextures = ((struct cce_usedtexinfo*)(((struct cce_resourceinfo*)((cce_void*) info + cce__resourceLoadersOffset))->resourceData))->texturesMapDependsOn; \
-   for (struct cce_element *iterator = elementInfo, *end = elementInfo + elementInfoQuantity; iterator < end; ++iterator) \
-      if (iterator->textureID > 0) \
-         iterator->textureID = usedTextures[iterator->textureID - 1]; \
-}
+if (!isElementsTotalValid(elementsQuantity, sectionSize, elementsTotal) || remapElementTextures(elementInfo, elementInfoQuantity, info) != 0) \
+   goto CORRUPTED_ALLOCATED;
+
+#define CCE_RENDERING_DATA_CORRUPTED_MESSAGE "ENGINE::MAP2DLOADERS::RENDERING_DATA_LOAD_ERROR:\nSection is truncated or its sizes don't match.\n"
 
 static int loadElements (void *buffer, uint16_t sectionSize, struct cce_buffer *info, FILE *file)
 {
@@ -110,6 +173,7 @@ static int loadElements (void *buffer, uint16_t sectionSize, struct cce_buffer *
    uint32_t *elementsQuantity;
    uint32_t elementsTotal;
    uint16_t elementInfoQuantity = 0;
+   map->flags = 0;
    LOADELEMENTS(buffer, sectionSize, info, file, malloc(elementsTotal * sizeof(struct cce_elementposition) + sectionSize * sizeof(struct cce_elementpositionarray)
                 + elementInfoQuantity * sizeof(struct cce_element)), (uint32_t*)(elementInfo + elementInfoQuantity))
    map->positions = (struct cce_elementpositionarray*)elementsQuantity;
@@ -122,12 +186,108 @@ static int loadElements (void *buffer, uint16_t sectionSize, struct cce_buffer *
       iterator[-1].dataAllocated = *qiterator;
       iterator[-1].data = iterator->data - *qiterator;
    }
-   fread(map->positions->data, sizeof(struct cce_elementposition), elementsTotal, file);
+   if (fread(map->positions->data, sizeof(struct cce_elementposition), elementsTotal, file) != elementsTotal)
+      goto CORRUPTED_ALLOCATED;
+   positionsToHostEndian(map->positions->data, elementsTotal);
    map->elements = elementInfo;
    map->elementsQuantity = elementInfoQuantity;
    map->layersQuantity = sectionSize;
    map->data = cce__map2DElementsToRenderingBuffer(map->positions, sectionSize, elementInfo, elementInfoQuantity, elementInfoQuantity);
    return 0;
+   
+CORRUPTED_ALLOCATED:
+   free(elementInfo);
+CORRUPTED:
+   fprintf(stderr, CCE_RENDERING_DATA_CORRUPTED_MESSAGE);
+   return -1;
+}
+
+static int loadElementsMapped (void *buffer, uint16_t sectionSize, struct cce_buffer *info, struct cce_mappedcursor *cursor)
+{
+   struct cce_renderinginfo *map = buffer;
+   uint32_t elementsTotal;
+   uint16_t elementInfoQuantity;
+   uint8_t *quantities = cursor->position + sizeof(uint16_t) + sizeof(uint32_t);
+   map->flags = CCE_ELEMENTS_MAPPED;
+   if (sectionSize == 0 || (size_t)(cursor->end - cursor->position) < sizeof(uint16_t) + sizeof(uint32_t) + sectionSize * sizeof(uint32_t))
+      goto CORRUPTED;
+   memcpy(&elementInfoQuantity, cursor->position, sizeof(uint16_t));
+   memcpy(&elementsTotal, cursor->position + sizeof(uint16_t), sizeof(uint32_t));
+   elementInfoQuantity = cceLittleEndianToHostEndianInt16(elementInfoQuantity);
+   elementsTotal = cceLittleEndianToHostEndianInt32(elementsTotal);
+   uint8_t *elementsData  = quantities + sectionSize * sizeof(uint32_t);
+   if ((size_t)(cursor->end - elementsData) / sizeof(struct cce_element) < elementInfoQuantity)
+      goto CORRUPTED;
+   uint8_t *positionsData = elementsData + elementInfoQuantity * sizeof(struct cce_element);
+   if ((size_t)(cursor->end - positionsData) / sizeof(struct cce_elementposition) < elementsTotal)
+      goto CORRUPTED;
+   {
+      uint64_t sum = 0;
+      for (uint8_t *iterator = quantities, *end = quantities + sectionSize * sizeof(uint32_t); iterator < end; iterator += sizeof(uint32_t))
+      {
+         uint32_t quantity;
+         memcpy(&quantity, iterator, sizeof(uint32_t));
+         sum += cceLittleEndianToHostEndianInt32(quantity);
+      }
+      if (sum != elementsTotal)
+         goto CORRUPTED;
+   }
+   cursor->position = positionsData + elementsTotal * sizeof(struct cce_elementposition);
+   
+   // Both structures consist of 8- and 16-bit fields, so file data is used in place if it's little-endian and 2-byte aligned
+   uint8_t inPlace = cceEndianess == CCE_LITTLE_ENDIAN && ((uintptr_t) elementsData & (sizeof(uint16_t) - 1)) == 0;
+   map->positions = malloc(sectionSize * sizeof(struct cce_elementpositionarray) +
+                           !inPlace * (elementInfoQuantity * sizeof(struct cce_element) + elementsTotal * sizeof(struct cce_elementposition)));
+   struct cce_element *elementInfo;
+   struct cce_elementposition *positions;
+   if (inPlace)
+   {
+      elementInfo = (struct cce_element*) elementsData;
+      positions = (struct cce_elementposition*) positionsData;
+   }
+   else
+   {
+      elementInfo = (struct cce_element*)(map->positions + sectionSize);
+      positions = (struct cce_elementposition*)(elementInfo + elementInfoQuantity);
+      memcpy(elementInfo, elementsData, elementInfoQuantity * sizeof(struct cce_element));
+      memcpy(positions, positionsData, elementsTotal * sizeof(struct cce_elementposition));
+      positionsToHostEndian(positions, elementsTotal);
+      if (cceEndianess == CCE_BIG_ENDIAN)
+      {
+         for (struct cce_element *iterator = elementInfo, *end = elementInfo + elementInfoQuantity; iterator < end; ++iterator)
+         {
+            iterator->textureID = cceLittleEndianToBigEndianInt16(iterator->textureID);
+            cceLittleEndianToBigEndianArrayInt16((uint16_t*)iterator + (iterator->textureID == 0) * 2, 4 - (iterator->textureID == 0) * 2);
+         }
+      }
+   }
+   // Writes only touch pages with element descriptions, position pages stay shared with other processes
+   if (remapElementTextures(elementInfo, elementInfoQuantity, info) != 0)
+   {
+      free(map->positions);
+      map->positions = NULL;
+      map->data = NULL;
+      return -1;
+   }
+   for (struct cce_elementpositionarray *iterator = map->positions, *end = map->positions + sectionSize; iterator < end; ++iterator, quantities += sizeof(uint32_t))
+   {
+      uint32_t quantity;
+      memcpy(&quantity, quantities, sizeof(uint32_t));
+      iterator->dataQuantity = iterator->dataAllocated = cceLittleEndianToHostEndianInt32(quantity);
+      iterator->data = positions;
+      positions += iterator->dataQuantity;
+   }
+   map->elements = elementInfo;
+   map->elementsQuantity = elementInfoQuantity;
+   map->layersQuantity = sectionSize;
+   map->data = cce__map2DElementsToRenderingBuffer(map->positions, sectionSize, elementInfo, elementInfoQuantity, elementInfoQuantity);
+   return 0;
+   
+CORRUPTED:
+   fprintf(stderr, CCE_RENDERING_DATA_CORRUPTED_MESSAGE);
+   map->positions = NULL;
+   map->data = NULL;
+   return -1;
 }
 
 static int loadElementsDynamic (void *buffer, uint16_t sectionSize, struct cce_buffer *info, FILE *file)
@@ -140,18 +300,36 @@ static int loadElementsDynamic (void *buffer, uint16_t sectionSize, struct cce_b
                 malloc(sectionSize * sizeof(struct cce_elementpositionarray)))
    map->positions = (struct cce_elementpositionarray*) elementsQuantity;
    uint32_t *qiterator = elementsQuantity + sectionSize;
+   // Arrays are filled from the end, since quantities are stored at the beginning of the same memory
    for (struct cce_elementpositionarray *iterator = map->positions + sectionSize, *end = map->positions; iterator > end;)
    {
       --iterator, --qiterator;
       iterator->dataQuantity = *qiterator;
-      iterator->data = malloc(CCE_CEIL_TO_POWER_OF_TWO(*qiterator, iterator->dataAllocated) * sizeof(struct cce_elementposition));
-      fread(iterator->data, sizeof(struct cce_elementposition), *qiterator, file);
+      iterator->data = malloc(CCE_CEIL_TO_POWER_OF_TWO(iterator->dataQuantity, iterator->dataAllocated) * sizeof(struct cce_elementposition));
+   }
+   for (struct cce_elementpositionarray *iterator = map->positions, *end = map->positions + sectionSize; iterator < end; ++iterator)
+   {
+      if (fread(iterator->data, sizeof(struct cce_elementposition), iterator->dataQuantity, file) == iterator->dataQuantity)
+      {
+         positionsToHostEndian(iterator->data, iterator->dataQuantity);
+         continue;
+      }
+      for (iterator = map->positions; iterator < end; ++iterator)
+         free(iterator->data);
+      goto CORRUPTED_ALLOCATED;
    }
    map->elements = elementInfo;
    map->elementsQuantity  = elementInfoQuantity;
    map->layersQuantity = sectionSize;
    map->data = cce__map2DElementsToRenderingBuffer(map->positions, sectionSize, elementInfo, elementInfoQuantity, map->elementsAllocated);
    return 0;
+   
+CORRUPTED_ALLOCATED:
+   free(elementInfo);
+   free(elementsQuantity);
+CORRUPTED:
+   fprintf(stderr, CCE_RENDERING_DATA_CORRUPTED_MESSAGE);
+   return -1;
 }
 
 static void createElements (void *buffer, struct cce_buffer *info)
@@ -169,10 +347,12 @@ static void createElements (void *buffer, struct cce_buffer *info)
 
 static void freeElements (void *buffer, struct cce_buffer *info)
 {
-   CCE_UNUSED(info);
    struct cce_renderinginfo *map = buffer;
    cce__deleteMap2DRenderingBuffer(map->data, map->layersQuantity);
-   free(map->elements);
+   CCE_UNUSED(info);
+   // Mapped reader allocates only position arrays (which may be followed by copied data), elements may reside in the file.
+   // Compressed sections of mapped maps are unpacked by stream reader, so the layout is recorded per section
+   free((map->flags & CCE_ELEMENTS_MAPPED) ? (void*) map->positions : (void*) map->elements);
 }
 
 static void freeElementsDynamic (void *buffer, struct cce_buffer *info)
@@ -239,7 +419,7 @@ static uint16_t storeElements (void *buffer, struct cce_buffer *info, FILE *file
       {
          if (*jiterator == iterator->textureID)
          {
-            tmp.textureID = cceHostEndianToLittleEndianInt16(dependantTextures - jiterator + 1);
+            tmp.textureID = cceHostEndianToLittleEndianInt16(jiterator - dependantTextures + 1);
             cceHostEndianToLittleEndianNewArrayInt16((uint16_t*)&tmp.data.texturePosition, (uint16_t*)&iterator->data.texturePosition, 4);
             goto TEXTUREID_SET;
          }
@@ -257,7 +437,8 @@ TEXTUREID_SET:
       {
          for (struct cce_elementposition tmp, *jiterator = iterator->data, *jend = iterator->data + iterator->dataQuantity; jiterator < jend ;++jiterator)
          {
-            cceSwapEndianNewArrayIntN(&tmp, jiterator, 4, 2);
+            tmp = *jiterator;
+            cceHostEndianToLittleEndianArrayInt16((uint16_t*) &tmp, 3);
             fwrite(&tmp, sizeof(struct cce_elementposition), 1, file);
          }
       }
@@ -272,51 +453,60 @@ TEXTUREID_SET:
 static int loadResourcesSection (void *buffer, uint16_t sectionSize, struct cce_buffer *info, FILE *file)
 {
    struct cce_resourceinfo *map = buffer;
-   uint32_t resourceSizes[256]; // VLA support across C compilers is still bad (and most likely wont improve)
-   fread(resourceSizes + 1, sizeof(uint32_t), sectionSize, file);
+   uint32_t *resourceSizes = malloc((sectionSize + 1) * sizeof(uint32_t));
+   if (fread(resourceSizes + 1, sizeof(uint32_t), sectionSize, file) != sectionSize)
+      goto CORRUPTED;
    cceLittleEndianToHostEndianArrayInt32(resourceSizes + 1, sectionSize);
-   resourceSizes[0] = 1;
-   if (sectionSize > resourceLoadingFunctionsQuantity)
+   resourceSizes[0] = 1; // Workaround to avoid out-of-bounds check
+   uint64_t namesSize = 0;
+   for (uint32_t *iterator = resourceSizes + 1, *end = resourceSizes + 1 + sectionSize; iterator < end; ++iterator)
    {
-      for (uint32_t *iterator = resourceSizes + 1 + resourceLoadingFunctionsQuantity, *end = resourceSizes + 1 + sectionSize; iterator < end; ++iterator)
+      if (*iterator != 0 && iterator - resourceSizes > resourceLoadingFunctionsQuantity)
       {
-         if (*iterator != 0)
-         {
-            fprintf(stderr, "ENGINE::MAP2D_LOADING::NONEMPTY_RESOURCE_WITHOUT_LOADER:\nMap2D cannot be loaded because some resource required for map to function does not have corresponding loader\n");
-            return -1;
-         }
+         fprintf(stderr, "ENGINE::MAP2D_LOADING::NONEMPTY_RESOURCE_WITHOUT_LOADER:\nMap2D cannot be loaded because some resource required for map to function does not have corresponding loader\n");
+         free(resourceSizes);
+         return -1;
       }
+      namesSize += *iterator;
+   }
+   // All name lists are read and checked at once, so no resource loader runs on a section which turns out to be broken
+   if (namesSize > (uint64_t) cceGetFileRemainingSize(file))
+      goto CORRUPTED;
+   char *buf = malloc(namesSize + 1), **names;
+   if (fread(buf, sizeof(char), namesSize, file) != namesSize)
+   {
+      free(buf);
+      goto CORRUPTED;
    }
-   uint32_t maxSize = 0;
-   for (uint32_t *iterator = resourceSizes + 1, *end = iterator + sectionSize; iterator < end; ++iterator)
    {
-      maxSize = (*iterator > maxSize) ? *iterator : maxSize;
+      const char *nameList = buf;
+      for (uint32_t *iterator = resourceSizes + 1, *end = resourceSizes + 1 + sectionSize; iterator < end; nameList += *iterator++)
+      {
+         if (*iterator != 0 && nameList[*iterator - 1] != '\0')
+         {
+            free(buf);
+            goto CORRUPTED;
+         }
+      }
    }
-   char *buf, **names;
-   buf = malloc(maxSize * sizeof(char));
-   uint32_t namesAllocated = maxSize / 16; // Approximation
+   uint32_t namesAllocated = namesSize / 16 + 1; // Approximation
    names = malloc(namesAllocated * sizeof(char*));
    cce_rloadfun *fun = resourceLoadingFunctions;
    cce_dataparsefun *initFun = resourceCreatingFunctions;
-   size_t dataBufferSize;
    {
+      // Trailing resources without names are neither stored nor allocated
       uint32_t *iterator = resourceSizes + sectionSize;
-      size_t *bufferSizes = resourceLoadingFunctionsBufferSizes + sectionSize - 1;
-      resourceSizes[0] = 1; // Workaround to avoid out-of-bounds check
-      dataBufferSize = resourceSpaceToBeAllocated;
       while (*iterator == 0)
-      {
-         dataBufferSize -= *bufferSizes;
          --iterator;
-         --bufferSizes;
-      }
       sectionSize = (iterator - resourceSizes);
    }
-   map->resourceData = malloc(dataBufferSize);
+   map->resourceData = malloc(resourceLoadingFunctionsBufferSizes[sectionSize]);
    map->resourcesQuantity = sectionSize;
    cce_void *jiterator = map->resourceData;
-   size_t *bufferSizes = resourceLoadingFunctionsBufferSizes;
-   for (uint32_t *iterator = resourceSizes + 1, *end = iterator + sectionSize; iterator < end; ++iterator, ++fun, ++initFun, jiterator = (cce_void*)map->resourceData + *bufferSizes++)
+   size_t *bufferSizes = resourceLoadingFunctionsBufferSizes + 1;
+   char *nameList = buf;
+   for (uint32_t *iterator = resourceSizes + 1, *end = iterator + sectionSize; iterator < end;
+        nameList += *iterator++, ++fun, ++initFun, jiterator = (cce_void*)map->resourceData + *bufferSizes++)
    {
       if (*iterator == 0)
       {
@@ -325,8 +515,7 @@ static int loadResourcesSection (void *buffer, uint16_t sectionSize, struct cce_
          continue;
       }
       
-      fread(buf, sizeof(char), *iterator, file);
-      for (char *it = buf, **jit = names, *iend = buf + *iterator;; ++jit, it += strlen(it) + 1)
+      for (char *it = nameList, **jit = names, *iend = nameList + *iterator;; ++jit, it += strlen(it) + 1)
       {
          ptrdiff_t namesQuantity = jit - names;
          if (namesQuantity >= namesAllocated)
@@ -345,7 +534,13 @@ static int loadResourcesSection (void *buffer, uint16_t sectionSize, struct cce_
    }
    free(buf);
    free(names);
+   free(resourceSizes);
    return 0;
+   
+CORRUPTED:
+   fprintf(stderr, "ENGINE::MAP2D_LOADING::RESOURCES_LOAD_ERROR:\nResource section is truncated or has unterminated name list\n");
+   free(resourceSizes);
+   return -1;
 }
 
 static void createResourcesSection (void *buffer, struct cce_buffer *info)
@@ -353,7 +548,7 @@ static void createResourcesSection (void *buffer, struct cce_buffer *info)
    struct cce_resourceinfo *map = buffer;
    map->resourceData = malloc(resourceSpaceToBeAllocated);
    map->resourcesQuantity = resourceLoadingFunctionsQuantity;
-   size_t *sizes = resourceLoadingFunctionsBufferSizes;
+   size_t *sizes = resourceLoadingFunctionsBufferSizes + 1;
    cce_void *data = map->resourceData;
    for (cce_dataparsefun *fun = resourceCreatingFunctions, *end = resourceCreatingFunctions + resourceLoadingFunctionsQuantity;
         fun < end; ++fun, data = (cce_void*)map->resourceData + *sizes++)
@@ -365,7 +560,7 @@ static void createResourcesSection (void *buffer, struct cce_buffer *info)
 static void freeResourcesSection (void *buffer, struct cce_buffer *info)
 {
    struct cce_resourceinfo *map = buffer;
-   size_t *sizes = resourceLoadingFunctionsBufferSizes;
+   size_t *sizes = resourceLoadingFunctionsBufferSizes + 1;
    cce_void *data = map->resourceData;
    for (cce_dataparsefun *fun = resourceUnloadingFunctions, *end = resourceUnloadingFunctions + map->resourcesQuantity;
         fun < end; ++fun, data = (cce_void*)map->resourceData + *sizes++)
@@ -380,7 +575,7 @@ static uint16_t storeResourcesSection (void *buffer, struct cce_buffer *info, FI
    struct cce_resourceinfo *map = buffer;
    uint32_t resourceSizes[256] = {0};
    uint16_t sectionSize = map->resourcesQuantity;
-   size_t *sizes = resourceLoadingFunctionsBufferSizes;
+   size_t *sizes = resourceLoadingFunctionsBufferSizes + 1;
    size_t bytesWritten = 0, size;
    cce_void *data = (cce_void*) map->resourceData;
    cce_rstorefun *fun = resourceStoringFunctions;
@@ -412,7 +607,10 @@ static uint16_t storeResourcesSection (void *buffer, struct cce_buffer *info, FI
       }
       if (iterator - resourceSizes != sectionSize)
       {
-         cceMoveFileContent(file, (iterator - resourceSizes) - sectionSize, SEEK_CUR, bytesWritten);
+         // Trailing resources without names don't need space for their sizes
+         fseek(file, beginOffset + sectionSize * sizeof(uint32_t), SEEK_SET);
+         cceMoveFileContent(file, beginOffset + (iterator - resourceSizes) * sizeof(uint32_t), SEEK_SET, bytesWritten);
+         endOffset = ftell(file);
          sectionSize = (iterator - resourceSizes);
       }
    }
@@ -440,12 +638,16 @@ void cce__initMap2DLoaders (void)
    cce__staticMapFunctionSet = cceGetFileIOfunctionSet();
    cceRegisterFileIOcallbacks(cce__staticMapFunctionSet, cceNameToUID("m2Dres"),  loadResourcesSection, freeResourcesSection, NULL,                   NULL,                  sizeof(struct cce_resourceinfo));
    cceRegisterFileIOcallbacks(cce__staticMapFunctionSet, cceNameToUID("m2Drend"), loadElements,         freeElements,         NULL,                   NULL,                  sizeof(struct cce_renderinginfo));
+   cceRegisterFileIOmappedReader(cce__staticMapFunctionSet, cceNameToUID("m2Drend"), loadElementsMapped);
    
    cce__resourceLoadersOffset = cceGetFunctionBufferOffset(cceNameToUID("m2Dres"), cce__staticMapFunctionSet);
    cce__renderingInfoOffset   = cceGetFunctionBufferOffset(cceNameToUID("m2Drend"), cce__staticMapFunctionSet);
    cce__dynamicMapFunctionSet = cceGetFileIOfunctionSet();
    cceRegisterFileIOcallbacks(cce__dynamicMapFunctionSet, cceNameToUID("m2Dres"),  loadResourcesSection, freeResourcesSection, createResourcesSection, storeResourcesSection, sizeof(struct cce_resourceinfo));
    cceRegisterFileIOcallbacks(cce__dynamicMapFunctionSet, cceNameToUID("m2Drend"), loadElementsDynamic,  freeElementsDynamic,  createElements,         storeElements,         sizeof(struct cce_dynamicrenderinginfo));
+   cceSetFileIOcompression(cce__dynamicMapFunctionSet, mapCompression);
+   cceSetFileIOchecksums(cce__staticMapFunctionSet, mapChecksums);
+   cceSetFileIOchecksums(cce__dynamicMapFunctionSet, mapChecksums);
    if (cceIsPluginLoading(cceaPluginUID))
    {
       cceaRegisterActionsFileIOFunctions(cce__staticMapFunctionSet);
@@ -456,6 +658,7 @@ void cce__initMap2DLoaders (void)
 void cce__terminateMap2DLoaders (void)
 {
    free(resourceLoadingFunctions);
+   resourceLoadingFunctions = NULL;
    resourceLoadingFunctionsQuantity = 0;
    free(resourceUnloadingFunctions);
    free(resourceCreatingFunctions);
@@ -555,7 +758,7 @@ else \
 CCE_API struct cce_buffer* cceLoadMap2D (char *path)
 {
    struct cce_buffer *result;
-   CCE_EXPAND_PATH(path, result = cceLoadBinaryCCF(path, cce__staticMapFunctionSet));
+   CCE_EXPAND_PATH(path, result = cceLoadBinaryCCFmapped(path, cce__staticMapFunctionSet));
    if (result == NULL && ((cce__map2Dflags & (CCE_RETURN_NULL_ON_MAP_LOADING_FAILURE | CCE_RETURN_FALLBACK_ON_MAP_LOADING_FAILURE)) == CCE_RETURN_FALLBACK_ON_MAP_LOADING_FAILURE))
    {
       result = createFailMap(cce__staticMapFunctionSet);
@@ -44,8 +44,11 @@ extern "C"
 #endif
 
 #define CCE_LOADEDTEXTURES_TOBELOADED 0x1u
+#define CCE_LOADEDTEXTURES_DECODING   0x2u
 
 #define CCE_ELEMENT_UPDATED 0x80
+// Static rendering info: memory is allocated from positions, elements may reside in mapped file
+#define CCE_ELEMENTS_MAPPED 0x40
 
 struct cce_loadedtextures
 {
@@ -53,6 +56,7 @@ struct cce_loadedtextures
    struct cce_u16vec2 size;
    uint8_t            dependantMapsQuantity;
    uint8_t            flags;
+   uint16_t           decodingTicket; // Result of decoding is applied only if ticket didn't change (slot wasn't reused meanwhile)
 };
 
 struct cce_resourceinfo
@@ -86,11 +90,18 @@ struct cce_rendereringfuns
    void (*moveTextureFromOldArray)(uint16_t);
    void (*removeOldArray)(void);
    void (*terminateMap2DRenderer)(void);
+   void (*setElementsRangeUpdated)(struct cce_renderingdata*, uint16_t buffer, uint32_t begin, uint32_t end); // buffer 0 - elements, 1 + layer - positions of layer
 };
 
 extern struct cce_rendereringfuns            cce__renderingFunctions;
 extern struct cce_loadedtextures            *cce__textures;
 extern struct cce_i16vec2                    cce__cameraPosition;
+// Camera the frame is drawn with, blended between the last two ticks with fixed timestep (see cceGetTickInterpolation)
+extern struct cce__renderingcamera
+{
+   float x, y;
+}
+cce__renderingCameraPosition;
 extern cce_flag  cce__map2Dflags;
 extern ptrdiff_t cce__resourceLoadersOffset, cce__renderingInfoOffset;
 extern uint16_t  cce__staticMapFunctionSet,  cce__dynamicMapFunctionSet;
@@ -111,6 +122,7 @@ cce__renderingFunctions.map2DElementsToRenderingBuffer(layers, layersQuantity, e
 #define cce__moveTextureFromOldArray(texture) cce__renderingFunctions.moveTextureFromOldArray(texture)
 #define cce__removeOldArray() cce__renderingFunctions.removeOldArray()
 #define cce__terminateMap2DRenderer() cce__renderingFunctions.terminateMap2DRenderer()
+#define cce__setElementsRangeUpdated(data, buffer, begin, end) cce__renderingFunctions.setElementsRangeUpdated(data, buffer, begin, end)
 
 #define CCE_SET_PATH(pathVar, lengthVar, newPath) \
 newPath = cceGetAbsolutePath(newPath, CCE_PATH_RESERVED + 1); \
@@ -77,6 +77,17 @@ CCE_API int cceSetElementsPositionsUpdated (struct cce_elementpositionarray *ele
    return 0;
 }
 
+CCE_API int cceSetElementsPositionsRangeUpdated (uint8_t layer, uint32_t positionID, uint32_t quantity, struct cce_buffer *map)
+{
+   struct cce_renderinginfo *info = cceGetRenderingInfo(map);
+   if (layer >= info->layersQuantity)
+      return -1;
+   if (info->data == NULL || quantity == 0) // Everything is uploaded at first draw anyway
+      return 0;
+   cce__setElementsRangeUpdated(info->data, 1 + layer, positionID, positionID + quantity);
+   return 0;
+}
+
 CCE_API struct cce_elementpositionarray* cceGetElementPositionArray (uint8_t layer, struct cce_buffer *map)
 {
    assert(map != NULL);
@@ -158,6 +169,15 @@ CCE_API int cceSetElementsUpdated (struct cce_renderinginfo *info)
    return 0;
 }
 
+CCE_API int cceSetElementsRangeUpdated (uint16_t ID, uint16_t quantity, struct cce_buffer *map)
+{
+   struct cce_renderinginfo *info = cceGetRenderingInfo(map);
+   if (info->data == NULL || quantity == 0)
+      return 0;
+   cce__setElementsRangeUpdated(info->data, 0, ID, (uint32_t) ID + quantity);
+   return 0;
+}
+
 CCE_API struct cce_renderinginfo* cceGetRenderingInfo (struct cce_buffer *map)
 {
    assert(map != NULL);
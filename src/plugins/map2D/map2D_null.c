@@ -0,0 +1,130 @@
+/*
+    Conservative Creator's Engine - open source engine for making games.
+    Copyright (C) 2020-2023 Andrey Gaivoronskiy
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../../../include/cce/engine_common_IO.h"
+#include "../../../include/cce/utils.h"
+
+#include "map2D_internal.h"
+
+/* Renderer used with headless (null) backend: maps are loaded, modified and stored as usual, but nothing is drawn */
+
+static void drawMap2D__null (struct cce_layer *layers, uint32_t layersQuantity)
+{
+   CCE_UNUSED(layers);
+   CCE_UNUSED(layersQuantity);
+}
+
+static struct cce_renderingdata* map2DElementsToRenderingBuffer__null (const struct cce_elementpositionarray *layers, uint8_t layersQuantity,
+                                                                       const struct cce_element *elements, uint16_t elementsQuantity, uint16_t elementsAllocated)
+{
+   CCE_UNUSED(layers);
+   CCE_UNUSED(layersQuantity);
+   CCE_UNUSED(elements);
+   CCE_UNUSED(elementsQuantity);
+   CCE_UNUSED(elementsAllocated);
+   return NULL;
+}
+
+static struct cce_element* renderingBufferToMap2DElements__null (struct cce_renderingdata *data)
+{
+   CCE_UNUSED(data);
+   return NULL;
+}
+
+static size_t getRenderingDataSize__null (void)
+{
+   return 0;
+}
+
+static struct cce_renderingdata* createElementsBuffer__null (size_t size)
+{
+   CCE_UNUSED(size);
+   return NULL;
+}
+
+static struct cce_renderingdata* resizeElementsBuffer__null (struct cce_renderingdata *data, size_t size)
+{
+   CCE_UNUSED(size);
+   return data;
+}
+
+static void deleteMap2DRenderingBuffer__null (struct cce_renderingdata *data, uint8_t layersQuantity)
+{
+   CCE_UNUSED(data);
+   CCE_UNUSED(layersQuantity);
+}
+
+static void loadTexture__null (void *data, uint16_t width, uint16_t height, uint16_t textureID)
+{
+   CCE_UNUSED(data);
+   CCE_UNUSED(width);
+   CCE_UNUSED(height);
+   CCE_UNUSED(textureID);
+}
+
+static void reallocateTextureArray__null (uint16_t newSize)
+{
+   CCE_UNUSED(newSize);
+}
+
+static void moveTextureFromOldArray__null (uint16_t texture)
+{
+   CCE_UNUSED(texture);
+}
+
+static void removeOldArray__null (void)
+{
+   return;
+}
+
+static void setElementsRangeUpdated__null (struct cce_renderingdata *data, uint16_t buffer, uint32_t begin, uint32_t end)
+{
+   CCE_UNUSED(data);
+   CCE_UNUSED(buffer);
+   CCE_UNUSED(begin);
+   CCE_UNUSED(end);
+}
+
+static void terminateMap2DRenderer__null (void)
+{
+   return;
+}
+
+int initMap2DRenderer__null (const struct cce_loadedtextures **textures)
+{
+   CCE_UNUSED(textures);
+   cce__renderingFunctions.drawMap2D = drawMap2D__null;
+   cce__renderingFunctions.map2DElementsToRenderingBuffer = map2DElementsToRenderingBuffer__null;
+   cce__renderingFunctions.renderingBufferToMap2DElements = renderingBufferToMap2DElements__null;
+   cce__renderingFunctions.getRenderingDataSize = getRenderingDataSize__null;
+   cce__renderingFunctions.createElementsBuffer = createElementsBuffer__null;
+   cce__renderingFunctions.resizeElementsBuffer = resizeElementsBuffer__null;
+   cce__renderingFunctions.deleteMap2DRenderingBuffer = deleteMap2DRenderingBuffer__null;
+   cce__renderingFunctions.loadTexture = loadTexture__null;
+   cce__renderingFunctions.reallocateTextureArray = reallocateTextureArray__null;
+   cce__renderingFunctions.moveTextureFromOldArray = moveTextureFromOldArray__null;
+   cce__renderingFunctions.removeOldArray = removeOldArray__null;
+   cce__renderingFunctions.terminateMap2DRenderer = terminateMap2DRenderer__null;
+   cce__renderingFunctions.setElementsRangeUpdated = setElementsRangeUpdated__null;
+   return 0;
+}
@@ -39,11 +39,16 @@
 #define CCE_UPDATE_VIEW 0x1
 #define CCE_UPDATE_CAMERA 0x2
 
+// More dirty ranges than that are uploaded as a whole buffer - one big transfer is cheaper than many mappings
+#define CCE_MAX_DIRTY_RANGES 32u
+#define CCE_DIRTY_RANGES_MERGE_GAP 16u
+
 struct cce_renderingdata
 {
-   GLuint   elementBuffer;
-   GLuint   elementTexture;
-   uint32_t elementsQuantity;
+   GLuint                elementBuffer;
+   GLuint                elementTexture;
+   uint32_t              elementsQuantity;
+   struct cce_rangearray dirty;
 };
 
 static const struct cce_loadedtextures **g_textures;
@@ -55,7 +60,7 @@ static GLuint                            g_VAO, g_VBO;
 static GLint                             g_uniformLocations[3];
 static uint8_t                           g_rotationAngle;
 static uint16_t                          g_pixelsPerCoordinate;
-struct cce_i16vec2                       g_cameraPosition;
+struct cce__renderingcamera              g_cameraPosition;
 
 static void openGLErrorPrint (GLenum error, size_t line, const char *file)
 {
@@ -123,7 +128,7 @@ static inline void updateView (void)
 
 static inline void updateCamera (void)
 {
-   g_cameraPosition = cce__cameraPosition;
+   g_cameraPosition = cce__renderingCameraPosition;
    float matrix[3 * 3] = {0};
    matrix[0] = 1;
    matrix[2] = g_cameraPosition.x;
@@ -205,6 +210,41 @@ static void resizeTextureArrayEnd__openGL_no_ext (void)
    GL_CHECK_ERRORS;
 }
 
+static void packLayer (struct cce_i16vec4 *iterator, const struct cce_elementposition *position, uint32_t quantity)
+{
+   for (struct cce_i16vec4 *end = iterator + quantity; iterator < end; ++iterator, ++position)
+   {
+      iterator->x = position->position.x;
+      iterator->y = -position->position.y;
+      iterator->z = (position->cce__reserved | (position->textureDataOffsetGroup << 8)) - (1 << (sizeof(uint16_t) * 8 - 1));
+      iterator->w = position->textureDataID - (1 << (sizeof(uint16_t) * 8 - 1)); /* We need to get it back as unsigned in glsl (simple reinterpret cast won't work - glsl doesn't have 16-bit types) */
+   }
+}
+
+static void packElements (struct cce_u32vec4 *iterator, const struct cce_element *elements, uint32_t quantity)
+{
+   uint16_t texturePosY;
+   for (struct cce_u32vec4 *end = iterator + quantity; iterator < end; ++iterator, ++elements)
+   {
+      if (elements->textureID == 0) /* Fragment has fixed color if no texture is applied */
+      {
+         iterator->x = (elements->data.rgba.x << 8) | elements->data.rgba.y | ((uint32_t)elements->position.x << 16);
+         iterator->y = (elements->data.rgba.z << 8) | (elements->size.x & 0xFF) | ((uint32_t)(-elements->position.y - elements->size.y) << 16);
+         iterator->w = elements->data.rgba.w | ((uint16_t)((int16_t)(cceFastCosInt8(elements->rotation + (-((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0) & 128)) * INT16_MAX)) << 16) |
+                       (-(!(elements->flags & CCE_ELEMENT_IGNORE_CAMERA)) & 0x8000) | (-(((elements->flags & CCE_ELEMENT_FLIP_HORIZONTALLY) > 0) != ((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0)) & 0x4000);
+      }
+      else
+      {
+         texturePosY = cceTextureSize->y - elements->data.texturePosition.y - elements->size.y; /* Normally textures go from top to bottom. It is reversed by openGL. */
+         iterator->x = (elements->data.texturePosition.x & 0xFFF) | ((texturePosY << 4) & 0xF000) | ((uint32_t)elements->position.x << 16);
+         iterator->y = ((texturePosY & 0xFF) << 8) | (elements->size.x & 0xFF) | ((uint32_t)(-elements->position.y - elements->size.y) << 16);
+         iterator->w = ((elements->textureID + 255) & 0x3FFF) | ((uint16_t)((int16_t)(cceFastCosInt8(elements->rotation + (-((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0) & 128)) * INT16_MAX)) << 16) |
+                       (-(!(elements->flags & CCE_ELEMENT_IGNORE_CAMERA)) & 0x8000) | (-(((elements->flags & CCE_ELEMENT_FLIP_HORIZONTALLY) > 0) != ((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0)) & 0x4000);
+      }
+      iterator->z = ((elements->size.x << 4) & 0xF000) | (elements->size.y & 0xFFF) | ((uint16_t)((int16_t)(cceFastSinInt8(elements->rotation + (-((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0) & 128)) * INT16_MAX)) << 16);
+   }
+}
+
 /* Buffer MUST be bound to GL_TEXTURE_BUFFER!*/
 #define UPDATE_LAYER(layer, mapFN) \
 do \
@@ -212,48 +252,68 @@ do \
    struct cce_i16vec4 *ITERATOR = mapFN; \
    GL_CHECK_ERRORS; \
    assert(ITERATOR != NULL); \
-   struct cce_elementposition *position = layer->data; \
-   for (struct cce_i16vec4 *END = ITERATOR + layer->dataQuantity; ITERATOR < END; ++ITERATOR, ++position) \
-   { \
-      ITERATOR->x = position->position.x; \
-      ITERATOR->y = -position->position.y; \
-      ITERATOR->z = (position->cce__reserved | (position->textureDataOffsetGroup << 8)) - (1 << (sizeof(uint16_t) * 8 - 1)); \
-      ITERATOR->w = position->textureDataID - (1 << (sizeof(uint16_t) * 8 - 1)); /* We need to get it back as unsigned in glsl (simple reinterpret cast won't work - glsl doesn't have 16-bit types) */ \
-   } \
+   packLayer(ITERATOR, layer->data, layer->dataQuantity); \
 } \
 while (glUnmapBuffer(GL_TEXTURE_BUFFER) == GL_FALSE)
 
 #define UPDATE_ELEMENTS(elements, elementsQuantity, mapFN) \
-struct cce_u32vec4 *ITERATOR; \
 do \
 { \
-   ITERATOR = mapFN; \
+   struct cce_u32vec4 *ITERATOR = mapFN; \
    GL_CHECK_ERRORS; \
-   memset(ITERATOR++, 0, sizeof(struct cce_u32vec4)); /* Zeroth element is always empty */ \
-   uint16_t TEXTURE_POS_Y; \
-   for (struct cce_u32vec4 *END = ITERATOR + elementsQuantity; ITERATOR < END; ++ITERATOR, ++elements) \
-   { \
-      if (elements->textureID == 0) /* Fragment has fixed color if no texture is applied */ \
-      { \
-         ITERATOR->x = (elements->data.rgba.x << 8) | elements->data.rgba.y | ((uint32_t)elements->position.x << 16); \
-         ITERATOR->y = (elements->data.rgba.z << 8) | (elements->size.x & 0xFF) | ((uint32_t)(-elements->position.y - elements->size.y) << 16); \
-         ITERATOR->w = elements->data.rgba.w | ((uint16_t)((int16_t)(cceFastCosInt8(elements->rotation + (-((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0) & 128)) * INT16_MAX)) << 16) | \
-                       (-(!(elements->flags & CCE_ELEMENT_IGNORE_CAMERA)) & 0x8000) | (-(((elements->flags & CCE_ELEMENT_FLIP_HORIZONTALLY) > 0) != ((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0)) & 0x4000); \
-      } \
-      else \
-      { \
-         TEXTURE_POS_Y = cceTextureSize->y - elements->data.texturePosition.y - elements->size.y; /* Normally textures go from top to bottom. It is reversed by openGL. */ \
-         ITERATOR->x = (elements->data.texturePosition.x & 0xFFF) | ((TEXTURE_POS_Y << 4) & 0xF000) | ((uint32_t)elements->position.x << 16); \
-         ITERATOR->y = ((TEXTURE_POS_Y & 0xFF) << 8) | (elements->size.x & 0xFF) | ((uint32_t)(-elements->position.y - elements->size.y) << 16); \
-         ITERATOR->w = ((elements->textureID + 255) & 0x3FFF) | ((uint16_t)((int16_t)(cceFastCosInt8(elements->rotation + (-((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0) & 128)) * INT16_MAX)) << 16) | \
-                       (-(!(elements->flags & CCE_ELEMENT_IGNORE_CAMERA)) & 0x8000) | (-(((elements->flags & CCE_ELEMENT_FLIP_HORIZONTALLY) > 0) != ((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0)) & 0x4000); \
-      } \
-      ITERATOR->z = ((elements->size.x << 4) & 0xF000) | (elements->size.y & 0xFFF) | ((uint16_t)((int16_t)(cceFastSinInt8(elements->rotation + (-((elements->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0) & 128)) * INT16_MAX)) << 16); \
-   } \
-   elements -= elementsQuantity; \
+   assert(ITERATOR != NULL); \
+   memset(ITERATOR, 0, sizeof(struct cce_u32vec4)); /* Zeroth element is always empty */ \
+   packElements(ITERATOR + 1, elements, elementsQuantity); \
 } \
 while (glUnmapBuffer(GL_TEXTURE_BUFFER) != GL_TRUE)
 
+/* Buffer MUST be bound to GL_TEXTURE_BUFFER! Only ranges reported by setElementsRangeUpdated__openGL are mapped and rewritten,
+ * ranges are clipped to current quantity. Elements buffer is shifted by one, because zeroth element is always empty */
+static void uploadLayerRanges (struct cce_renderingdata *data, const struct cce_elementpositionarray *layer)
+{
+   for (const struct cce_range *iterator = data->dirty.data, *end = iterator + data->dirty.dataQuantity; iterator < end; ++iterator)
+   {
+      const uint32_t rangeEnd = CCE_MIN(iterator->end, layer->dataQuantity);
+      if (iterator->begin >= rangeEnd)
+         continue;
+      do
+      {
+         struct cce_i16vec4 *mapped = glMapBufferRange(GL_TEXTURE_BUFFER, iterator->begin * sizeof(struct cce_i16vec4), (rangeEnd - iterator->begin) * sizeof(struct cce_i16vec4),
+                                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+         GL_CHECK_ERRORS;
+         assert(mapped != NULL);
+         packLayer(mapped, layer->data + iterator->begin, rangeEnd - iterator->begin);
+      }
+      while (glUnmapBuffer(GL_TEXTURE_BUFFER) == GL_FALSE);
+   }
+   data->dirty.dataQuantity = 0;
+}
+
+static void uploadElementsRanges (struct cce_renderingdata *data, const struct cce_element *elements, uint32_t elementsQuantity)
+{
+   for (const struct cce_range *iterator = data->dirty.data, *end = iterator + data->dirty.dataQuantity; iterator < end; ++iterator)
+   {
+      const uint32_t rangeEnd = CCE_MIN(iterator->end, elementsQuantity);
+      if (iterator->begin >= rangeEnd)
+         continue;
+      do
+      {
+         struct cce_u32vec4 *mapped = glMapBufferRange(GL_TEXTURE_BUFFER, (1 + iterator->begin) * sizeof(struct cce_u32vec4), (rangeEnd - iterator->begin) * sizeof(struct cce_u32vec4),
+                                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+         GL_CHECK_ERRORS;
+         assert(mapped != NULL);
+         packElements(mapped, elements + iterator->begin, rangeEnd - iterator->begin);
+      }
+      while (glUnmapBuffer(GL_TEXTURE_BUFFER) != GL_TRUE);
+   }
+   data->dirty.dataQuantity = 0;
+}
+
+static void setElementsRangeUpdated__openGL (struct cce_renderingdata *data, uint16_t buffer, uint32_t begin, uint32_t end)
+{
+   cceAddRange(&(data[buffer].dirty), begin, end, CCE_DIRTY_RANGES_MERGE_GAP);
+}
+
 static struct cce_renderingdata* map2DElementsToRenderingBuffer__openGL (const struct cce_elementpositionarray *layers, uint8_t layersQuantity,
                                                                          const struct cce_element *elements, uint16_t elementsQuantity, uint16_t elementsAllocated)
 {
@@ -283,11 +343,13 @@ static struct cce_renderingdata* map2DElementsToRenderingBuffer__openGL (const s
       GL_CHECK_ERRORS;
       diterator->elementBuffer = *ebiterator;
       diterator->elementTexture = *titerator;
+      diterator->dirty = (struct cce_rangearray){NULL, 0u, 0u};
       
    }
    data->elementBuffer = elementsBuffers[0];
    data->elementTexture = textures[0];
    data->elementsQuantity = elementsAllocated;
+   data->dirty = (struct cce_rangearray){NULL, 0u, 0u};
    glBindBuffer(GL_TEXTURE_BUFFER, elementsBuffers[0]);
    GL_CHECK_ERRORS;
    glBufferData(GL_TEXTURE_BUFFER, (elementsAllocated + 1) * 16, NULL, GL_DYNAMIC_DRAW);
@@ -313,6 +375,7 @@ static void deleteMap2DRenderingBuffer__openGL (struct cce_renderingdata *data,
    {
       *jiterator = iterator->elementBuffer;
       *kiterator = iterator->elementTexture;
+      free(iterator->dirty.data);
    }
    glDeleteBuffers(1 + layersQuantity, buffers);
    GL_CHECK_ERRORS;
@@ -349,7 +412,7 @@ static void drawMap2D__openGL (struct cce_layer *layers, uint32_t layersQuantity
 {
    if (g_pixelsPerCoordinate != cce__pixelsPerCoordinate || g_rotationAngle != cce__viewRotationAngle)
       updateView();
-   if (g_cameraPosition.x != cce__cameraPosition.x || g_cameraPosition.y != cce__cameraPosition.y)
+   if (g_cameraPosition.x != cce__renderingCameraPosition.x || g_cameraPosition.y != cce__renderingCameraPosition.y)
       updateCamera();
    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
    GL_CHECK_ERRORS;
@@ -377,6 +440,11 @@ static void drawMap2D__openGL (struct cce_layer *layers, uint32_t layersQuantity
       }
       else
       {
+         if (!(info->flags & CCE_ELEMENT_UPDATED) && (info->data[0].dirty.dataQuantity > CCE_MAX_DIRTY_RANGES ||
+             ((iterator->flags & CCE_LAYER_DYNAMIC) && info->elementsAllocated > info->data[0].elementsQuantity)))
+         {
+            info->flags |= CCE_ELEMENT_UPDATED;
+         }
          if (info->flags & CCE_ELEMENT_UPDATED)
          {
             glBindBuffer(GL_TEXTURE_BUFFER, info->data[0].elementBuffer);
@@ -393,26 +461,50 @@ static void drawMap2D__openGL (struct cce_layer *layers, uint32_t layersQuantity
                UPDATE_ELEMENTS(info->elements, info->elementsQuantity, glMapBufferRange(GL_TEXTURE_BUFFER, 0, (info->elementsQuantity + 1) * sizeof(struct cce_element), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
             }
             info->flags &= ~CCE_ELEMENT_UPDATED;
+            info->data[0].dirty.dataQuantity = 0;
+         }
+         else if (info->data[0].dirty.dataQuantity > 0)
+         {
+            glBindBuffer(GL_TEXTURE_BUFFER, info->data[0].elementBuffer);
+            GL_CHECK_ERRORS;
+            uploadElementsRanges(info->data, info->elements, info->elementsQuantity);
          }
+         struct cce_renderingdata *layerData = info->data + 1 + iterator->layer;
+         struct cce_elementpositionarray *layer = info->positions + iterator->layer;
+         uint8_t wholeLayer = 0;
          // Workaround!
-         if ((info->positions[iterator->layer].dataAllocated & 1) == !(info->positions->dataQuantity == 1 || info->positions->dataAllocated > 0x80000000))
+         if ((layer->dataAllocated & 1) == !(info->positions->dataQuantity == 1 || info->positions->dataAllocated > 0x80000000))
+         {
+            layer->dataAllocated ^= 1;
+            wholeLayer = 1;
+         }
+         else if (layerData->dirty.dataQuantity > CCE_MAX_DIRTY_RANGES || layer->dataQuantity > layerData->elementsQuantity)
+         {
+            wholeLayer = 1;
+         }
+         if (wholeLayer)
          {
-            info->positions[iterator->layer].dataAllocated ^= 1;
-            struct cce_elementpositionarray *layer = info->positions + iterator->layer;
-            glBindBuffer(GL_TEXTURE_BUFFER, info->data[1 + iterator->layer].elementBuffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, layerData->elementBuffer);
             GL_CHECK_ERRORS;
-            if ((iterator->flags & CCE_LAYER_DYNAMIC) && layer->dataAllocated > info->data[1 + iterator->layer].elementsQuantity)
+            if ((iterator->flags & CCE_LAYER_DYNAMIC) && layer->dataAllocated > layerData->elementsQuantity)
             {
                glBufferData(GL_TEXTURE_BUFFER, layer->dataAllocated * sizeof(struct cce_elementposition), NULL, GL_STATIC_DRAW);
                UPDATE_LAYER(layer, glMapBuffer(GL_TEXTURE_BUFFER, GL_WRITE_ONLY));
                GL_CHECK_ERRORS;
-               info->data[1 + iterator->layer].elementsQuantity = info->positions[iterator->layer].dataAllocated;
+               layerData->elementsQuantity = layer->dataAllocated;
             }
             else
             {
                // Invalidate buffer
                UPDATE_LAYER(layer, glMapBufferRange(GL_TEXTURE_BUFFER, 0, layer->dataQuantity * sizeof(struct cce_elementposition), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
             }
+            layerData->dirty.dataQuantity = 0;
+         }
+         else if (layerData->dirty.dataQuantity > 0)
+         {
+            glBindBuffer(GL_TEXTURE_BUFFER, layerData->elementBuffer);
+            GL_CHECK_ERRORS;
+            uploadLayerRanges(layerData, layer);
          }
       }
       glActiveTexture(GL_TEXTURE1);
@@ -507,7 +599,7 @@ int initMap2DRenderer__openGL (const struct cce_loadedtextures **textures)
    g_textures = textures;
    glTexturesArray = 0;
    g_rotationAngle = 0;
-   g_cameraPosition = (struct cce_i16vec2){0, 0};
+   g_cameraPosition = (struct cce__renderingcamera){0.0f, 0.0f};
    g_pixelsPerCoordinate = 1;
    glUniform1i(glGetUniformLocation(shaderProgram, "Textures"), 0);
    GL_CHECK_ERRORS;
@@ -521,6 +613,7 @@ int initMap2DRenderer__openGL (const struct cce_loadedtextures **textures)
    cce__renderingFunctions.loadTexture = loadTexture__openGL;
    cce__renderingFunctions.terminateMap2DRenderer = terminateMap2DRenderer__openGL;
    cce__renderingFunctions.getRenderingDataSize = getRenderingDataSize__openGL;
+   cce__renderingFunctions.setElementsRangeUpdated = setElementsRangeUpdated__openGL;
    if (GLAD_GL_NV_copy_image == 0)
    {
       glGenFramebuffers(1, &glTemporaryFBO);
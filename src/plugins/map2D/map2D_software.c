@@ -0,0 +1,365 @@
+/*
+    Conservative Creator's Engine - open source engine for making games.
+    Copyright (C) 2020-2023 Andrey Gaivoronskiy
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../../include/cce/engine_common_IO.h"
+#include "../../../include/cce/utils.h"
+
+#include "../../../include/cce/engine_common_internal.h"
+#include "map2D_internal.h"
+
+/* Renders into RGBA8 framebuffer in memory (top row first) with the same transformations as shaders/map2D.vert and shaders/map2D.frag
+ * Map data is read directly at draw time, so nothing is stored in rendering buffers */
+
+struct cce_affine2D
+{
+   float xx, xy, yx, yy; // Columns are screen-space images of quad's unit axes
+   float x, y;           // Screen-space image of quad's center
+};
+
+static struct cce_u8vec4  *g_framebuffer = NULL;
+static struct cce_u16vec2  g_framebufferSize;
+static int32_t            *g_columnTexels = NULL; // Texel column for every column of axis-aligned quad
+static struct cce_u8vec4  *g_texels = NULL;       // Texture array, every layer is cceTextureSize->x * cceTextureSize->y, top row first
+static struct cce_u8vec4  *g_oldTexels = NULL;
+static uint16_t            g_texelLayersQuantity;
+static uint16_t            g_oldTexelLayersQuantity;
+
+CCE_API const struct cce_u8vec4* cceGetMap2DFramebuffer (void)
+{
+   return g_framebuffer;
+}
+
+static inline size_t texelLayerSize (void)
+{
+   return (size_t) cceTextureSize->x * cceTextureSize->y;
+}
+
+static inline void blendPixel (struct cce_u8vec4 *destination, struct cce_u8vec4 source)
+{
+   // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+   if (source.w == 0xFF)
+   {
+      *destination = source;
+      return;
+   }
+   if (source.w == 0)
+      return;
+   const uint16_t alpha = source.w, inverseAlpha = 0xFF - source.w;
+   destination->x = (source.x * alpha + destination->x * inverseAlpha + 127) / 255;
+   destination->y = (source.y * alpha + destination->y * inverseAlpha + 127) / 255;
+   destination->z = (source.z * alpha + destination->z * inverseAlpha + 127) / 255;
+   destination->w = (source.w * alpha + destination->w * inverseAlpha + 127) / 255;
+}
+
+static inline float quantizedSin (uint8_t angle)
+{
+   // Same precision as element data sent to GPU
+   return (int16_t)(cceFastSinInt8(angle) * INT16_MAX) * (1.0f / 32767.0f);
+}
+
+/* Mirrors map2D.vert: local quad coordinates (-0.5..0.5) -> layer position -> flip -> element rotation -> camera -> element position -> view
+ * Everything is linear, so the whole transformation is stored as an affine matrix to screen pixels */
+static struct cce_affine2D elementTransform (const struct cce_element *element, const struct cce_elementposition *position)
+{
+   const uint8_t flipV = (element->flags & CCE_ELEMENT_FLIP_VERTICALLY) > 0;
+   const uint8_t flipH = (element->flags & CCE_ELEMENT_FLIP_HORIZONTALLY) > 0;
+   const float flip = (flipH != flipV) ? -1.0f : 1.0f;
+   const uint8_t rotation = element->rotation + (flipV ? 128u : 0u);
+   const float sine = quantizedSin(rotation), cosine = quantizedSin(rotation + 64u);
+   const float viewSine = cceFastSinInt8(cce__viewRotationAngle), viewCosine = cceFastCosInt8(cce__viewRotationAngle);
+   const float kx = (cce__pixelsPerCoordinate * 2.0f) / g_framebufferSize.x, ky = (cce__pixelsPerCoordinate * 2.0f) / g_framebufferSize.y;
+   const struct cce_i16vec2 group = {element->position.x, (int16_t)(-element->position.y - element->size.y)};
+   float points[3][2] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}};
+   for (float (*iterator)[2] = points, (*end)[2] = points + 3; iterator < end; ++iterator)
+   {
+      float x = ((*iterator)[0] * element->size.x + position->position.x) * flip;
+      float y = (*iterator)[1] * element->size.y - position->position.y;
+      float tmp = x * cosine + y * sine;
+      y = y * cosine - x * sine;
+      x = tmp;
+      if (!(element->flags & CCE_ELEMENT_IGNORE_CAMERA))
+      {
+         x += cce__renderingCameraPosition.x;
+         y += cce__renderingCameraPosition.y;
+      }
+      x += element->size.x * 0.5f + group.x;
+      y += element->size.y * 0.5f + group.y;
+      tmp = kx * (x * viewCosine + y * viewSine);
+      y = ky * (y * viewCosine - x * viewSine);
+      x = tmp;
+      // NDC -> pixels, framebuffer rows go from top to bottom
+      (*iterator)[0] = (x + 1.0f) * 0.5f * g_framebufferSize.x;
+      (*iterator)[1] = (1.0f - y) * 0.5f * g_framebufferSize.y;
+   }
+   return (struct cce_affine2D){points[1][0] - points[0][0], points[1][1] - points[0][1],
+                                points[2][0] - points[0][0], points[2][1] - points[0][1],
+                                points[0][0], points[0][1]};
+}
+
+static inline int32_t clampTexel (float coordinate, int32_t maximum)
+{
+   int32_t texel = (int32_t) floorf(coordinate);
+   return CCE_MAX(CCE_MIN(texel, maximum), 0);
+}
+
+/* Both axes of quad are parallel to the screen axes: texel column of every screen column is computed once per quad,
+ * texel row - once per scanline */
+static void drawAxisAligned (const struct cce_affine2D *transform, const struct cce_element *element, const struct cce_u8vec4 *layer,
+                             int32_t left, int32_t top, int32_t right, int32_t bottom)
+{
+   const float inverseX = 1.0f / transform->xx, inverseY = 1.0f / transform->yy;
+   int32_t first = right, last = left;
+   for (int32_t column = left; column < right; ++column)
+   {
+      const float u = (column + 0.5f - transform->x) * inverseX;
+      if (u < -0.5f || u >= 0.5f)
+         continue;
+      first = CCE_MIN(first, column);
+      last  = CCE_MAX(last, column + 1);
+      g_columnTexels[column] = clampTexel(element->data.texturePosition.x + (u + 0.5f) * element->size.x, cceTextureSize->x - 1);
+   }
+   if (first >= last)
+      return;
+   for (int32_t row = top; row < bottom; ++row)
+   {
+      const float v = (row + 0.5f - transform->y) * inverseY;
+      if (v < -0.5f || v >= 0.5f)
+         continue;
+      struct cce_u8vec4 *pixel = g_framebuffer + (size_t) row * g_framebufferSize.x + first;
+      if (layer == NULL)
+      {
+         for (struct cce_u8vec4 *end = pixel + (last - first); pixel < end; ++pixel)
+            blendPixel(pixel, element->data.rgba);
+         continue;
+      }
+      const struct cce_u8vec4 *texelRow = layer + (size_t) clampTexel(element->data.texturePosition.y + (0.5f - v) * element->size.y, cceTextureSize->y - 1) * cceTextureSize->x;
+      for (int32_t *column = g_columnTexels + first, *end = g_columnTexels + last; column < end; ++column, ++pixel)
+         blendPixel(pixel, texelRow[*column]);
+   }
+}
+
+static void drawTransformed (const struct cce_affine2D *transform, const struct cce_element *element, const struct cce_u8vec4 *layer,
+                             int32_t left, int32_t top, int32_t right, int32_t bottom)
+{
+   const float determinant = transform->xx * transform->yy - transform->yx * transform->xy;
+   if (fabsf(determinant) < 1e-6f)
+      return;
+   // Inverse matrix: screen offset -> local quad coordinates
+   const float ixx =  transform->yy / determinant, ixy = -transform->xy / determinant;
+   const float iyx = -transform->yx / determinant, iyy =  transform->xx / determinant;
+   const int32_t maxX = cceTextureSize->x - 1, maxY = cceTextureSize->y - 1;
+   for (int32_t row = top; row < bottom; ++row)
+   {
+      const float dx = left + 0.5f - transform->x, dy = row + 0.5f - transform->y;
+      float u = ixx * dx + iyx * dy, v = ixy * dx + iyy * dy;
+      struct cce_u8vec4 *pixel = g_framebuffer + (size_t) row * g_framebufferSize.x + left;
+      for (struct cce_u8vec4 *end = pixel + (right - left); pixel < end; ++pixel, u += ixx, v += ixy)
+      {
+         if (u < -0.5f || u >= 0.5f || v < -0.5f || v >= 0.5f)
+            continue;
+         if (layer == NULL)
+         {
+            blendPixel(pixel, element->data.rgba);
+            continue;
+         }
+         const int32_t texelX = clampTexel(element->data.texturePosition.x + (u + 0.5f) * element->size.x, maxX);
+         const int32_t texelY = clampTexel(element->data.texturePosition.y + (0.5f - v) * element->size.y, maxY);
+         blendPixel(pixel, layer[(size_t) texelY * cceTextureSize->x + texelX]);
+      }
+   }
+}
+
+static void drawElement (const struct cce_element *element, const struct cce_elementposition *position)
+{
+   if (element->size.x == 0 || element->size.y == 0)
+      return;
+   const struct cce_u8vec4 *layer = NULL;
+   if (element->textureID != 0)
+   {
+      if (element->textureID > g_texelLayersQuantity)
+         return;
+      layer = g_texels + (element->textureID - 1) * texelLayerSize();
+   }
+   const struct cce_affine2D transform = elementTransform(element, position);
+   const float halfWidth  = (fabsf(transform.xx) + fabsf(transform.yx)) * 0.5f;
+   const float halfHeight = (fabsf(transform.xy) + fabsf(transform.yy)) * 0.5f;
+   const int32_t left   = CCE_MAX((int32_t) floorf(transform.x - halfWidth), 0);
+   const int32_t right  = CCE_MIN((int32_t) ceilf(transform.x + halfWidth),  (int32_t) g_framebufferSize.x);
+   const int32_t top    = CCE_MAX((int32_t) floorf(transform.y - halfHeight), 0);
+   const int32_t bottom = CCE_MIN((int32_t) ceilf(transform.y + halfHeight), (int32_t) g_framebufferSize.y);
+   if (left >= right || top >= bottom)
+      return;
+   if (transform.xy == 0.0f && transform.yx == 0.0f)
+      drawAxisAligned(&transform, element, layer, left, top, right, bottom);
+   else
+      drawTransformed(&transform, element, layer, left, top, right, bottom);
+}
+
+static void drawMap2D__software (struct cce_layer *layers, uint32_t layersQuantity)
+{
+   if (g_framebufferSize.x != cce__gameResolution.x || g_framebufferSize.y != cce__gameResolution.y)
+   {
+      g_framebufferSize = cce__gameResolution;
+      free(g_framebuffer);
+      free(g_columnTexels);
+      g_framebuffer = malloc((size_t) g_framebufferSize.x * g_framebufferSize.y * sizeof(struct cce_u8vec4));
+      g_columnTexels = malloc(g_framebufferSize.x * sizeof(int32_t));
+   }
+   memset(g_framebuffer, 0, (size_t) g_framebufferSize.x * g_framebufferSize.y * sizeof(struct cce_u8vec4));
+   for (struct cce_layer *iterator = layers, *end = layers + layersQuantity; iterator < end; ++iterator)
+   {
+      if (iterator->layersData == NULL)
+         continue;
+      struct cce_dynamicrenderinginfo *info = iterator->layersData;
+      if (info->elementsQuantity == 0 || iterator->layer >= info->layersQuantity)
+         continue;
+      info->flags &= ~CCE_ELEMENT_UPDATED;
+      const struct cce_elementpositionarray *positions = info->positions + iterator->layer;
+      for (const struct cce_elementposition *position = positions->data, *positionsEnd = positions->data + positions->dataQuantity; position < positionsEnd; ++position)
+      {
+         // Zeroth element is always empty
+         if (position->textureDataID == 0 || position->textureDataID > info->elementsQuantity)
+            continue;
+         drawElement(info->elements + position->textureDataID - 1, position);
+      }
+   }
+}
+
+static struct cce_renderingdata* map2DElementsToRenderingBuffer__software (const struct cce_elementpositionarray *layers, uint8_t layersQuantity,
+                                                                           const struct cce_element *elements, uint16_t elementsQuantity, uint16_t elementsAllocated)
+{
+   CCE_UNUSED(layers);
+   CCE_UNUSED(layersQuantity);
+   CCE_UNUSED(elements);
+   CCE_UNUSED(elementsQuantity);
+   CCE_UNUSED(elementsAllocated);
+   return NULL;
+}
+
+static struct cce_element* renderingBufferToMap2DElements__software (struct cce_renderingdata *data)
+{
+   CCE_UNUSED(data);
+   return NULL;
+}
+
+static size_t getRenderingDataSize__software (void)
+{
+   return 0;
+}
+
+static struct cce_renderingdata* createElementsBuffer__software (size_t size)
+{
+   CCE_UNUSED(size);
+   return NULL;
+}
+
+static struct cce_renderingdata* resizeElementsBuffer__software (struct cce_renderingdata *data, size_t size)
+{
+   CCE_UNUSED(size);
+   return data;
+}
+
+static void deleteMap2DRenderingBuffer__software (struct cce_renderingdata *data, uint8_t layersQuantity)
+{
+   CCE_UNUSED(data);
+   CCE_UNUSED(layersQuantity);
+}
+
+static void loadTexture__software (void *data, uint16_t width, uint16_t height, uint16_t textureID)
+{
+   if (textureID >= g_texelLayersQuantity)
+      return;
+   const uint16_t copyWidth = CCE_MIN(width, cceTextureSize->x);
+   height = CCE_MIN(height, cceTextureSize->y);
+   struct cce_u8vec4 *destination = g_texels + textureID * texelLayerSize();
+   for (const struct cce_u8vec4 *source = data, *end = source + (size_t) height * width; source < end; source += width, destination += cceTextureSize->x)
+   {
+      memcpy(destination, source, copyWidth * sizeof(struct cce_u8vec4));
+   }
+}
+
+static void reallocateTextureArray__software (uint16_t newSize)
+{
+   g_oldTexels = g_texels;
+   g_oldTexelLayersQuantity = g_texelLayersQuantity;
+   g_texels = calloc((size_t) newSize * texelLayerSize(), sizeof(struct cce_u8vec4));
+   g_texelLayersQuantity = newSize;
+}
+
+static void moveTextureFromOldArray__software (uint16_t texture)
+{
+   if (texture >= g_oldTexelLayersQuantity || texture >= g_texelLayersQuantity)
+      return;
+   memcpy(g_texels + texture * texelLayerSize(), g_oldTexels + texture * texelLayerSize(), texelLayerSize() * sizeof(struct cce_u8vec4));
+}
+
+static void removeOldArray__software (void)
+{
+   free(g_oldTexels);
+   g_oldTexels = NULL;
+   g_oldTexelLayersQuantity = 0;
+}
+
+static void setElementsRangeUpdated__software (struct cce_renderingdata *data, uint16_t buffer, uint32_t begin, uint32_t end)
+{
+   CCE_UNUSED(data);
+   CCE_UNUSED(buffer);
+   CCE_UNUSED(begin);
+   CCE_UNUSED(end);
+}
+
+static void terminateMap2DRenderer__software (void)
+{
+   free(g_framebuffer);
+   free(g_columnTexels);
+   free(g_texels);
+   free(g_oldTexels);
+   g_framebuffer = NULL;
+   g_columnTexels = NULL;
+   g_texels = NULL;
+   g_oldTexels = NULL;
+}
+
+int initMap2DRenderer__software (const struct cce_loadedtextures **textures)
+{
+   CCE_UNUSED(textures);
+   g_framebufferSize = (struct cce_u16vec2){0, 0};
+   g_texelLayersQuantity = 0;
+   g_oldTexelLayersQuantity = 0;
+   cce__renderingFunctions.drawMap2D = drawMap2D__software;
+   cce__renderingFunctions.map2DElementsToRenderingBuffer = map2DElementsToRenderingBuffer__software;
+   cce__renderingFunctions.renderingBufferToMap2DElements = renderingBufferToMap2DElements__software;
+   cce__renderingFunctions.getRenderingDataSize = getRenderingDataSize__software;
+   cce__renderingFunctions.createElementsBuffer = createElementsBuffer__software;
+   cce__renderingFunctions.resizeElementsBuffer = resizeElementsBuffer__software;
+   cce__renderingFunctions.deleteMap2DRenderingBuffer = deleteMap2DRenderingBuffer__software;
+   cce__renderingFunctions.loadTexture = loadTexture__software;
+   cce__renderingFunctions.reallocateTextureArray = reallocateTextureArray__software;
+   cce__renderingFunctions.moveTextureFromOldArray = moveTextureFromOldArray__software;
+   cce__renderingFunctions.removeOldArray = removeOldArray__software;
+   cce__renderingFunctions.terminateMap2DRenderer = terminateMap2DRenderer__software;
+   cce__renderingFunctions.setElementsRangeUpdated = setElementsRangeUpdated__software;
+   return 0;
+}
@@ -0,0 +1,204 @@
+/*
+    Conservative Creator's Engine - open source engine for making games.
+    Copyright (C) 2020-2023 Andrey Gaivoronskiy
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../external/stb_image.h"
+#include "../../platform/threads.h"
+#include "map2D_internal.h"
+
+/* Workers take paths from FIFO of pending jobs, decode them without holding the lock and append results to the finished
+ * array, so that main thread receives them in completion order. Texture uploads stay on the main thread (GL context) */
+
+#define CCE_TEXTURE_DECODER_MAX_THREADS 64u
+
+struct cce_decodingjob
+{
+   char    *path;
+   uint32_t userID;
+};
+
+CCE_ARRAY_STRUCT(cce_decodingjobs, struct cce_decodingjob, uint32_t);
+CCE_ARRAY_STRUCT(cce_decodedtextures, struct cce_decodedtexture, uint32_t);
+
+struct cce_texturedecoder
+{
+   struct cce__mutex          *mutex;
+   struct cce__condition      *jobQueued;
+   struct cce__condition      *jobFinished;
+   struct cce__thread         *threads[CCE_TEXTURE_DECODER_MAX_THREADS];
+   struct cce_decodingjobs     pending;
+   struct cce_decodedtextures  finished;
+   uint32_t                    pendingFirst;
+   uint32_t                    inFlight;
+   uint8_t                     threadsQuantity;
+   uint8_t                     terminate;
+};
+
+static void decodingThread (void *data)
+{
+   struct cce_texturedecoder *decoder = data;
+   cce__lockMutex(decoder->mutex);
+   for (;;)
+   {
+      while (!decoder->terminate && decoder->pendingFirst == decoder->pending.dataQuantity)
+         cce__waitCondition(decoder->jobQueued, decoder->mutex);
+      if (decoder->terminate)
+         break;
+      struct cce_decodingjob job = decoder->pending.data[decoder->pendingFirst++];
+      if (decoder->pendingFirst == decoder->pending.dataQuantity)
+         decoder->pendingFirst = decoder->pending.dataQuantity = 0;
+      ++(decoder->inFlight);
+      cce__unlockMutex(decoder->mutex);
+      
+      int width = 0, height = 0;
+      struct cce_decodedtexture result = {stbi_load(job.path, &width, &height, NULL, 4), job.path, job.userID, 0u, 0u};
+      if (result.data == NULL)
+         fprintf(stderr, "ENGINE::TEXTURE::DECODING_ERROR:\n%s\nFile located at %s\n", stbi_failure_reason(), job.path);
+      else
+         result.width = width, result.height = height;
+      
+      cce__lockMutex(decoder->mutex);
+      if (decoder->finished.dataQuantity >= decoder->finished.dataAllocated)
+         CCE_REALLOC_ARRAY(decoder->finished.data, decoder->finished.dataQuantity + 1);
+      decoder->finished.data[decoder->finished.dataQuantity++] = result;
+      --(decoder->inFlight);
+      cce__broadcastCondition(decoder->jobFinished);
+   }
+   cce__unlockMutex(decoder->mutex);
+}
+
+CCE_API struct cce_texturedecoder* cceCreateTextureDecoder (uint8_t threadsQuantity)
+{
+   if (threadsQuantity == 0)
+      return NULL;
+   threadsQuantity = CCE_MIN(threadsQuantity, CCE_TEXTURE_DECODER_MAX_THREADS);
+   struct cce_texturedecoder *decoder = calloc(1, sizeof(struct cce_texturedecoder));
+   decoder->mutex = cce__createMutex();
+   decoder->jobQueued = cce__createCondition();
+   decoder->jobFinished = cce__createCondition();
+   if (decoder->mutex == NULL || decoder->jobQueued == NULL || decoder->jobFinished == NULL)
+   {
+      fputs("ENGINE::TEXTURE_DECODER::SYNCHRONIZATION_FAILURE:\nCan't create mutex or condition variable\n", stderr);
+      cce__freeCondition(decoder->jobFinished);
+      cce__freeCondition(decoder->jobQueued);
+      cce__freeMutex(decoder->mutex);
+      free(decoder);
+      return NULL;
+   }
+   for (; decoder->threadsQuantity < threadsQuantity; ++(decoder->threadsQuantity))
+   {
+      decoder->threads[decoder->threadsQuantity] = cce__createThread(decodingThread, decoder);
+      if (decoder->threads[decoder->threadsQuantity] == NULL)
+         break;
+   }
+   if (decoder->threadsQuantity == 0)
+   {
+      fputs("ENGINE::TEXTURE_DECODER::THREAD_CREATION_FAILURE:\nCan't start any decoding thread\n", stderr);
+      cceFreeTextureDecoder(decoder);
+      return NULL;
+   }
+   return decoder;
+}
+
+CCE_API int cceQueueTextureDecoding (struct cce_texturedecoder *decoder, const char *path, uint32_t userID)
+{
+   size_t length = strlen(path);
+   struct cce_decodingjob job = {malloc(length + 1), userID};
+   memcpy(job.path, path, length + 1);
+   cce__lockMutex(decoder->mutex);
+   if (decoder->pending.dataQuantity >= decoder->pending.dataAllocated)
+      CCE_REALLOC_ARRAY(decoder->pending.data, decoder->pending.dataQuantity + 1);
+   decoder->pending.data[decoder->pending.dataQuantity++] = job;
+   cce__signalCondition(decoder->jobQueued);
+   cce__unlockMutex(decoder->mutex);
+   return 0;
+}
+
+CCE_API uint32_t cceCollectDecodedTextures (struct cce_texturedecoder *decoder, struct cce_decodedtexture *textures, uint32_t texturesMax)
+{
+   cce__lockMutex(decoder->mutex);
+   uint32_t collected = CCE_MIN(texturesMax, decoder->finished.dataQuantity);
+   // finished.data is NULL until the first texture is finished
+   if (collected > 0)
+   {
+      memcpy(textures, decoder->finished.data, collected * sizeof(struct cce_decodedtexture));
+      decoder->finished.dataQuantity -= collected;
+      memmove(decoder->finished.data, decoder->finished.data + collected, decoder->finished.dataQuantity * sizeof(struct cce_decodedtexture));
+   }
+   cce__unlockMutex(decoder->mutex);
+   return collected;
+}
+
+CCE_API uint32_t cceGetPendingTexturesQuantity (struct cce_texturedecoder *decoder)
+{
+   cce__lockMutex(decoder->mutex);
+   uint32_t quantity = decoder->pending.dataQuantity - decoder->pendingFirst + decoder->inFlight + decoder->finished.dataQuantity;
+   cce__unlockMutex(decoder->mutex);
+   return quantity;
+}
+
+CCE_API void cceWaitTextureDecoder (struct cce_texturedecoder *decoder)
+{
+   cce__lockMutex(decoder->mutex);
+   while (decoder->pendingFirst < decoder->pending.dataQuantity || decoder->inFlight > 0)
+      cce__waitCondition(decoder->jobFinished, decoder->mutex);
+   cce__unlockMutex(decoder->mutex);
+}
+
+CCE_API void cceFreeDecodedTexture (struct cce_decodedtexture *texture)
+{
+   stbi_image_free(texture->data);
+   free(texture->path);
+   texture->data = NULL;
+   texture->path = NULL;
+}
+
+// Jobs not yet started are dropped, the ones being decoded are finished first
+CCE_API void cceFreeTextureDecoder (struct cce_texturedecoder *decoder)
+{
+   if (decoder == NULL)
+      return;
+   cce__lockMutex(decoder->mutex);
+   decoder->terminate = 1;
+   cce__broadcastCondition(decoder->jobQueued);
+   cce__unlockMutex(decoder->mutex);
+   for (struct cce__thread **iterator = decoder->threads, **end = decoder->threads + decoder->threadsQuantity; iterator < end; ++iterator)
+   {
+      cce__joinThread(*iterator);
+   }
+   for (struct cce_decodingjob *iterator = decoder->pending.data + decoder->pendingFirst, *end = decoder->pending.data + decoder->pending.dataQuantity; iterator < end; ++iterator)
+   {
+      free(iterator->path);
+   }
+   for (struct cce_decodedtexture *iterator = decoder->finished.data, *end = decoder->finished.data + decoder->finished.dataQuantity; iterator < end; ++iterator)
+   {
+      cceFreeDecodedTexture(iterator);
+   }
+   free(decoder->pending.data);
+   free(decoder->finished.data);
+   cce__freeCondition(decoder->jobFinished);
+   cce__freeCondition(decoder->jobQueued);
+   cce__freeMutex(decoder->mutex);
+   free(decoder);
+}
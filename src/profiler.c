@@ -0,0 +1,247 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../include/cce/profiler.h"
+#include "../include/cce/utils.h"
+
+#include "../include/cce/engine_common_internal.h"
+
+#ifdef CCE_PROFILER
+
+#include "../include/cce/os_interaction.h"
+#include "platform/threads.h"
+
+#define PROFILER_ZONES_PER_THREAD 16384u
+
+struct profilerzone
+{
+   const char *name;
+   uint64_t start;
+   uint64_t duration;
+   uint32_t id;
+};
+
+struct profilerthread
+{
+   struct profilerthread *next;
+   uint32_t tid;
+   uint32_t position;
+   uint32_t quantity;
+   struct profilerzone zones[PROFILER_ZONES_PER_THREAD];
+};
+
+static struct
+{
+   struct cce__mutex *mutex;
+   struct profilerthread *threads;
+   uint64_t start;
+   uint32_t generation;
+   uint32_t threadsQuantity;
+   volatile uint8_t isProfiling;
+} g_profiler = {NULL, NULL, 0, 1, 0, 0};
+
+/* Rings are freed on termination, generation tells thread that its pointer is stale
+ * (thread-local variables of other threads can't be reset) */
+static CCE_THREAD_LOCAL struct profilerthread *t_thread;
+static CCE_THREAD_LOCAL uint32_t t_generation;
+
+static struct profilerthread* getThreadRing (void)
+{
+   if (t_thread != NULL && t_generation == g_profiler.generation)
+      return t_thread;
+   struct profilerthread *thread = malloc(sizeof(struct profilerthread));
+   if (thread == NULL)
+      return NULL;
+   thread->position = 0;
+   thread->quantity = 0;
+   cce__lockMutex(g_profiler.mutex);
+   thread->tid = ++g_profiler.threadsQuantity;
+   thread->next = g_profiler.threads;
+   g_profiler.threads = thread;
+   cce__unlockMutex(g_profiler.mutex);
+   t_thread = thread;
+   t_generation = g_profiler.generation;
+   return thread;
+}
+
+CCE_API uint64_t cce__beginProfilerZone (void)
+{
+   if (!g_profiler.isProfiling)
+      return 0;
+   uint64_t time = cceGetMonotonicTimeNs();
+   return time + (time == 0);
+}
+
+CCE_API void cce__endProfilerZone (const char *name, uint32_t id, uint64_t start)
+{
+   // Zones begun before the last start are dropped: they would be placed before the beginning of the trace
+   if (!g_profiler.isProfiling || start < g_profiler.start || start == 0)
+      return;
+   uint64_t end = cceGetMonotonicTimeNs();
+   struct profilerthread *thread = getThreadRing();
+   if (thread == NULL)
+      return;
+   thread->zones[thread->position] = (struct profilerzone){name, start, end - start, id};
+   thread->position = (thread->position + 1u) % PROFILER_ZONES_PER_THREAD;
+   thread->quantity += (thread->quantity < PROFILER_ZONES_PER_THREAD);
+}
+
+CCE_API void cceStartProfiling (void)
+{
+   if (g_profiler.mutex == NULL)
+   {
+      g_profiler.mutex = cce__createMutex();
+      if (g_profiler.mutex == NULL)
+      {
+         fputs("ENGINE::PROFILER::ERROR:\nMutex can't be created, profiling isn't started\n", stderr);
+         return;
+      }
+   }
+   // Ring of the calling thread is registered first, so the main thread is the first one in the trace
+   getThreadRing();
+   cce__lockMutex(g_profiler.mutex);
+   for (struct profilerthread *iterator = g_profiler.threads; iterator != NULL; iterator = iterator->next)
+   {
+      iterator->position = 0;
+      iterator->quantity = 0;
+   }
+   g_profiler.start = cceGetMonotonicTimeNs();
+   g_profiler.isProfiling = 1;
+   cce__unlockMutex(g_profiler.mutex);
+}
+
+CCE_API void cceStopProfiling (void)
+{
+   g_profiler.isProfiling = 0;
+}
+
+static void writeJSONstring (FILE *file, const char *string)
+{
+   fputc('"', file);
+   for (; *string != '\0'; ++string)
+   {
+      if (*string == '"' || *string == '\\')
+         fprintf(file, "\\%c", *string);
+      else if ((unsigned char) *string < 0x20u)
+         fprintf(file, "\\u%04x", (unsigned) *string);
+      else
+         fputc(*string, file);
+   }
+   fputc('"', file);
+}
+
+CCE_API int cceWriteProfilerTrace (const char *path)
+{
+   FILE *file = fopen(path, "wb");
+   if (file == NULL)
+   {
+      fprintf(stderr, "ENGINE::PROFILER::ERROR:\nTrace can't be written to %s\n", path);
+      return -1;
+   }
+   fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+         "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"cce\"}}", file);
+   if (g_profiler.mutex != NULL)
+   {
+      cce__lockMutex(g_profiler.mutex);
+      for (const struct profilerthread *iterator = g_profiler.threads; iterator != NULL; iterator = iterator->next)
+      {
+         if (iterator->tid == 1u)
+            fputs(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}", file);
+         else
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                    (unsigned) iterator->tid, (unsigned) iterator->tid - 1u);
+         // The oldest zone is the one that will be overwritten next
+         uint32_t index = (iterator->quantity < PROFILER_ZONES_PER_THREAD) ? 0 : iterator->position;
+         for (uint32_t i = 0; i < iterator->quantity; ++i, index = (index + 1u) % PROFILER_ZONES_PER_THREAD)
+         {
+            const struct profilerzone *zone = iterator->zones + index;
+            fputs(",\n{\"name\":", file);
+            writeJSONstring(file, zone->name);
+            fprintf(file, ",\"cat\":\"cce\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+                    (double)(zone->start - g_profiler.start) / 1000.0, (double) zone->duration / 1000.0, (unsigned) iterator->tid);
+            if (zone->id != CCE_PROFILER_NO_ID)
+               fprintf(file, ",\"args\":{\"id\":%u}", (unsigned) zone->id);
+            fputc('}', file);
+         }
+      }
+      cce__unlockMutex(g_profiler.mutex);
+   }
+   fputs("\n]}\n", file);
+   if (ferror(file) | fclose(file))
+   {
+      fprintf(stderr, "ENGINE::PROFILER::ERROR:\nTrace can't be written to %s\n", path);
+      return -1;
+   }
+   return 0;
+}
+
+void cce__terminateProfiler (void)
+{
+   g_profiler.isProfiling = 0;
+   struct profilerthread *iterator = g_profiler.threads;
+   while (iterator != NULL)
+   {
+      struct profilerthread *next = iterator->next;
+      free(iterator);
+      iterator = next;
+   }
+   if (g_profiler.mutex != NULL)
+      cce__freeMutex(g_profiler.mutex);
+   g_profiler.mutex = NULL;
+   g_profiler.threads = NULL;
+   g_profiler.threadsQuantity = 0;
+   ++g_profiler.generation;
+}
+
+#else
+
+CCE_API uint64_t cce__beginProfilerZone (void)
+{
+   return 0;
+}
+
+CCE_API void cce__endProfilerZone (const char *name, uint32_t id, uint64_t start)
+{
+   CCE_UNUSED(name);
+   CCE_UNUSED(id);
+   CCE_UNUSED(start);
+}
+
+CCE_API void cceStartProfiling (void)
+{
+}
+
+CCE_API void cceStopProfiling (void)
+{
+}
+
+CCE_API int cceWriteProfilerTrace (const char *path)
+{
+   fprintf(stderr, "ENGINE::PROFILER::ERROR:\nEngine is built without profiler (CCE_PROFILER), trace %s isn't written\n", path);
+   return -1;
+}
+
+void cce__terminateProfiler (void)
+{
+}
+
+#endif // CCE_PROFILER
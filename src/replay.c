@@ -0,0 +1,303 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Conservative Creator's Engine is free software: you can redistribute it and/or modify it under 
+   the terms of the GNU Lesser General Public License as published by the Free Software Foundation,
+   either version 2 of the License, or (at your option) any later version.
+
+   Conservative Creator's Engine is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR 
+   PURPOSE. See the GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License along
+   with Conservative Creator's Engine. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../include/cce/replay.h"
+#include "../include/cce/os_interaction.h"
+#include "../include/cce/utils.h"
+
+#include "../include/cce/engine_common_internal.h"
+
+/* Log: "CCER", version, clock at the start (uint64_t), state of every gamepad (buttons bitfield - uint16_t, axes - 8 x int8_t,
+ * connected - uint8_t), then records in the order they happened. Integers are little-endian, varints are LEB128, signed ones are zigzag-encoded:
+ * CCE_REPLAY_EVENT - type, code, gamepad, value (signed varint), time since the previous clock reading (varint)
+ * CCE_REPLAY_CLOCK - clock reading of cceUpdate, difference with the previous one (varint)
+ * CCE_REPLAY_SEED  - size (varint), seed bytes */
+
+#define CCE_REPLAY_VERSION 2u
+#define CCE_REPLAY_GAMEPAD_SIZE 11u
+#define CCE_REPLAY_HEADER_SIZE (13u + CCE_GAMEPADS_MAX * CCE_REPLAY_GAMEPAD_SIZE)
+
+#define CCE_REPLAY_EVENT 0u
+#define CCE_REPLAY_CLOCK 1u
+#define CCE_REPLAY_SEED  2u
+
+uint8_t cce__replayMode;
+
+static FILE     *g_log;
+static uint8_t  *g_playback;
+static size_t    g_playbackSize;
+static size_t    g_playbackPosition;
+static uint64_t  g_clockNs;       // The last clock reading written or read
+static uint64_t  g_clockOffsetNs; // Keeps clock continuous after playback, which has its own time
+
+static void writeVarint (uint64_t value)
+{
+   uint8_t bytes[10], *end = bytes;
+   do
+   {
+      *end++ = (uint8_t)(value & 0x7Fu) | ((value > 0x7Fu) << 7);
+      value >>= 7;
+   }
+   while (value > 0);
+   fwrite(bytes, sizeof(uint8_t), end - bytes, g_log);
+}
+
+static uint8_t readByte (uint8_t *byte)
+{
+   if (g_playbackPosition >= g_playbackSize)
+      return 0;
+   *byte = g_playback[g_playbackPosition++];
+   return 1;
+}
+
+static uint8_t readVarint (uint64_t *value)
+{
+   uint8_t byte = 0x80u;
+   *value = 0;
+   for (uint8_t shift = 0; (byte & 0x80u) && shift < 64u; shift += 7u)
+   {
+      if (!readByte(&byte))
+         return 0;
+      *value |= (uint64_t)(byte & 0x7Fu) << shift;
+   }
+   return !(byte & 0x80u);
+}
+
+static void stopPlayback (const char *error)
+{
+   if (error != NULL)
+      fprintf(stderr, "ENGINE::REPLAY::%s\nPlayback is stopped at offset %zu, live input is used from now on\n", error, g_playbackPosition);
+   cceUnmapFile(g_playback, g_playbackSize);
+   g_playback = NULL;
+   g_clockOffsetNs = g_clockNs - cceGetMonotonicTimeNs();
+   cce__replayMode = CCE_REPLAY_OFF;
+   cce__syncGamepadsMapping();
+}
+
+// Record which is to be read next, playback stops at the end of the log
+static uint8_t peekRecord (uint8_t *type)
+{
+   if (g_playbackPosition >= g_playbackSize)
+   {
+      stopPlayback(NULL);
+      return 0;
+   }
+   *type = g_playback[g_playbackPosition];
+   return 1;
+}
+
+CCE_API int cceStartRecording (const char *path)
+{
+   cceStopRecording();
+   cceStopPlayback();
+   g_log = fopen(path, "wb");
+   if (g_log == NULL)
+   {
+      fprintf(stderr, "ENGINE::REPLAY::FILE_NOT_CREATED:\n%s - file can't be opened with fopen\n", path);
+      return -1;
+   }
+   g_clockNs = cce__getReplayTimeNs();
+   cce__resetFrameState(g_clockNs);
+   uint8_t header[CCE_REPLAY_HEADER_SIZE] = {'C', 'C', 'E', 'R', CCE_REPLAY_VERSION};
+   for (uint8_t i = 0; i < 8u; ++i)
+      header[5 + i] = (uint8_t)(g_clockNs >> (i * 8u));
+   for (uint8_t i = 0, *gamepad = header + 13; i < CCE_GAMEPADS_MAX; ++i, gamepad += CCE_REPLAY_GAMEPAD_SIZE)
+   {
+      gamepad[0] = (uint8_t) cce__gamepads[i].buttons;
+      gamepad[1] = (uint8_t)(cce__gamepads[i].buttons >> 8);
+      memcpy(gamepad + 2, cce__gamepads[i].axes, 8u);
+      gamepad[10] = cce__gamepads[i].connected;
+   }
+   fwrite(header, sizeof(uint8_t), CCE_REPLAY_HEADER_SIZE, g_log);
+   cce__replayMode = CCE_REPLAY_RECORDING;
+   return 0;
+}
+
+CCE_API void cceStopRecording (void)
+{
+   if (g_log == NULL)
+      return;
+   if (fclose(g_log) != 0)
+      fputs("ENGINE::REPLAY::FILE_NOT_WRITTEN:\nEnd of the log may be lost\n", stderr);
+   g_log = NULL;
+   cce__replayMode = CCE_REPLAY_OFF;
+}
+
+CCE_API int cceStartPlayback (const char *path)
+{
+   cceStopRecording();
+   cceStopPlayback();
+   g_playback = cceMapFile(path, &g_playbackSize);
+   if (g_playback == NULL)
+   {
+      fprintf(stderr, "ENGINE::REPLAY::FILE_NOT_FOUND:\n%s - file can't be mapped\n", path);
+      return -1;
+   }
+   if (g_playbackSize < CCE_REPLAY_HEADER_SIZE || memcmp(g_playback, "CCER", 4u) != 0 || g_playback[4] != CCE_REPLAY_VERSION)
+   {
+      fprintf(stderr, "ENGINE::REPLAY::UNSUPPORTED_LOG:\n%s isn't a log of this engine version\n", path);
+      cceUnmapFile(g_playback, g_playbackSize);
+      g_playback = NULL;
+      return -1;
+   }
+   g_clockNs = 0;
+   for (uint8_t i = 0; i < 8u; ++i)
+      g_clockNs |= (uint64_t) g_playback[5 + i] << (i * 8u);
+   for (uint8_t i = 0, *gamepad = g_playback + 13; i < CCE_GAMEPADS_MAX; ++i, gamepad += CCE_REPLAY_GAMEPAD_SIZE)
+   {
+      cce__gamepads[i].buttons = gamepad[0] | (uint16_t)(gamepad[1] << 8);
+      memcpy(cce__gamepads[i].axes, gamepad + 2, 8u);
+      cce__gamepads[i].connected = gamepad[10] != 0;
+   }
+   cce__resetFrameState(g_clockNs);
+   g_playbackPosition = CCE_REPLAY_HEADER_SIZE;
+   cce__replayMode = CCE_REPLAY_PLAYING;
+   return 0;
+}
+
+CCE_API void cceStopPlayback (void)
+{
+   if (g_playback != NULL)
+      stopPlayback(NULL);
+}
+
+CCE_API uint8_t cceIsPlayingBack (void)
+{
+   return cce__replayMode == CCE_REPLAY_PLAYING;
+}
+
+uint64_t cce__getReplayTimeNs (void)
+{
+   return cceGetMonotonicTimeNs() + g_clockOffsetNs;
+}
+
+uint64_t cce__getReplayClock (void)
+{
+   if (cce__replayMode == CCE_REPLAY_PLAYING)
+   {
+      uint8_t type = CCE_REPLAY_CLOCK, byte;
+      uint64_t delta;
+      if (!peekRecord(&type))
+         return cce__getReplayTimeNs();
+      if (type != CCE_REPLAY_CLOCK || !readByte(&byte) || !readVarint(&delta))
+      {
+         stopPlayback((type != CCE_REPLAY_CLOCK) ? "DESYNC:\nframe is expected" : "CORRUPTED_LOG:\nframe is truncated");
+         return cce__getReplayTimeNs();
+      }
+      return g_clockNs += delta;
+   }
+   const uint64_t clockNs = cce__getReplayTimeNs();
+   if (cce__replayMode == CCE_REPLAY_RECORDING)
+   {
+      fputc(CCE_REPLAY_CLOCK, g_log);
+      writeVarint(clockNs - g_clockNs);
+      // Log of a crashed game should still reproduce it
+      fflush(g_log);
+      g_clockNs = clockNs;
+   }
+   return clockNs;
+}
+
+void cce__recordInputEvent (const struct cce_inputevent *event)
+{
+   fputc(CCE_REPLAY_EVENT, g_log);
+   fputc(event->type, g_log);
+   fputc(event->code, g_log);
+   fputc(event->gamepad, g_log);
+   writeVarint(((uint64_t) event->value << 1) ^ (uint64_t)(int64_t)(event->value >> 15));
+   writeVarint(event->timeNs - g_clockNs);
+}
+
+// Events of the frame are applied the same way backends apply live input
+void cce__playInputEvents (void)
+{
+   uint8_t type;
+   while (cce__replayMode == CCE_REPLAY_PLAYING && peekRecord(&type) && type == CCE_REPLAY_EVENT)
+   {
+      uint8_t bytes[4];
+      uint64_t value, time;
+      if (!readByte(bytes) || !readByte(bytes + 1) || !readByte(bytes + 2) || !readByte(bytes + 3) || !readVarint(&value) || !readVarint(&time))
+      {
+         stopPlayback("CORRUPTED_LOG:\ninput event is truncated");
+         return;
+      }
+      const struct cce_inputevent event = {g_clockNs + time, (int16_t)((value >> 1) ^ -(value & 1u)), bytes[2], bytes[1], bytes[3]};
+      if (event.type != CCE_INPUT_EVENT_KEY && (event.gamepad == 0 || event.gamepad > CCE_GAMEPADS_MAX))
+      {
+         stopPlayback("CORRUPTED_LOG:\ninput event of unknown gamepad");
+         return;
+      }
+      // Setters don't queue events during playback, the recorded ones are queued with their time
+      switch (event.type)
+      {
+         case CCE_INPUT_EVENT_KEY:
+            if (cce__keyCallback != NULL)
+               cce__keyCallback(event.code, (cce_enum) event.value);
+            break;
+         case CCE_INPUT_EVENT_BUTTON:
+            cce__setGamepadButton(event.gamepad, event.code & 0xF, event.value != 0);
+            break;
+         case CCE_INPUT_EVENT_AXIS:
+            cce__setGamepadAxis(event.gamepad, event.code & 0x7, (int8_t) event.value);
+            break;
+         case CCE_INPUT_EVENT_CONNECTION:
+            cce__setGamepadConnected(event.gamepad, event.value != 0);
+            break;
+      }
+      cce__queueInputEvent(&event);
+   }
+}
+
+int cce__getReplayRandomSeed (void *buffer, size_t bufferSize, int (*getRandomSeed)(void*, size_t))
+{
+   if (cce__replayMode == CCE_REPLAY_PLAYING)
+   {
+      uint8_t type = CCE_REPLAY_SEED, byte;
+      uint64_t size;
+      if (peekRecord(&type))
+      {
+         if (type == CCE_REPLAY_SEED && readByte(&byte) && readVarint(&size) && size == bufferSize && g_playbackSize - g_playbackPosition >= size)
+         {
+            memcpy(buffer, g_playback + g_playbackPosition, bufferSize);
+            g_playbackPosition += bufferSize;
+            return 0;
+         }
+         stopPlayback("DESYNC:\nrandom seed of different size or no seed is expected");
+      }
+   }
+   int result = getRandomSeed(buffer, bufferSize);
+   if (cce__replayMode == CCE_REPLAY_RECORDING && result == 0)
+   {
+      fputc(CCE_REPLAY_SEED, g_log);
+      writeVarint(bufferSize);
+      fwrite(buffer, sizeof(uint8_t), bufferSize, g_log);
+   }
+   return result;
+}
+
+void cce__terminateReplay (void)
+{
+   cceStopRecording();
+   cceStopPlayback();
+   g_clockOffsetNs = 0;
+}
@@ -0,0 +1,422 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cce/engine_common.h>
+#include <cce/engine_common_IO.h>
+#include <cce/os_interaction.h>
+#include <cce/utils.h>
+#include <cce/plugins/actions.h>
+#include <cce/plugins/actions_internal.h>
+#include <cce/plugins/actions_runactions.h>
+
+/* Actions plugin is tested on the null backend with a buffer which has only actions section. Test action appends its value to the log,
+ * so the order actions were run in can be checked. Map time is set directly: frame delta time does not change until engine loop runs */
+
+#define ACTIONS_TEST_LOG_SIZE 64u
+
+struct recordaction
+{
+   uint32_t UID;
+   uint32_t value;
+};
+
+// Followed by size - sizeof(struct blobaction) bytes, makes delayed actions of any size
+struct blobaction
+{
+   uint32_t UID;
+   uint32_t size;
+};
+
+static uint32_t g_log[ACTIONS_TEST_LOG_SIZE];
+static uint32_t g_logQuantity;
+static uint32_t g_recordUID;
+static uint32_t g_blobUID;
+
+static void recordAction (void *data, uint32_t count, struct cce_buffer *state)
+{
+   CCE_UNUSED(state);
+   struct recordaction *action = data;
+   for (uint32_t i = 0; i < count && g_logQuantity < ACTIONS_TEST_LOG_SIZE; ++i)
+      g_log[g_logQuantity++] = action->value;
+}
+
+static void blobAction (void *data, uint32_t count, struct cce_buffer *state)
+{
+   CCE_UNUSED(state);
+   struct blobaction *action = data;
+   for (uint32_t i = 0; i < count && g_logQuantity < ACTIONS_TEST_LOG_SIZE; ++i)
+      g_log[g_logQuantity++] = action->size;
+}
+
+static struct cce_buffer* initActionsTest (void)
+{
+   char *tmpDir = cceGetTemporaryDirectory(0);
+   if (tmpDir == NULL)
+      return NULL;
+   char *path = cceCreateNewPathFromOldPath(tmpDir, "game.ini", 0);
+   free(tmpDir);
+   FILE *ini = fopen(path, "w");
+   if (ini == NULL)
+   {
+      free(path);
+      return NULL;
+   }
+   fputs("[Window]\ngameResolution = 64x64\nwindowName = CCE actions test\n", ini);
+   fclose(ini);
+   cceSetBackend("null");
+   cceaLoadActionsPlugin();
+   int status = cceInit(path);
+   free(path);
+   if (status != 0)
+      return NULL;
+   uint16_t functionSet = cceGetFileIOfunctionSet();
+   cceaRegisterActionsFileIOFunctions(functionSet);
+   g_recordUID = cceNameToUID("trecord");
+   cceaRegisterAction(g_recordUID, recordAction, NULL, sizeof(struct recordaction));
+   g_blobUID = cceNameToUID("tblob");
+   cceaRegisterAction(g_blobUID, blobAction, NULL, CCEA_ACTION_SIZE_VARIABLE);
+   g_logQuantity = 0;
+   return cceCreateBuffer(1, functionSet);
+}
+
+static void terminateActionsTest (struct cce_buffer *map)
+{
+   cceFreeBuffer(map);
+   cceTerminate();
+}
+
+// Map time becomes exactly time after delayed actions are run
+static void runDelayedActionsAt (struct cce_buffer *map, uint32_t time)
+{
+   ccea__setMapTime(map, time - cceGetFrameDeltaTime());
+   cceaRunDelayedActions(map);
+}
+
+static void delayRecord (struct cce_buffer *map, uint32_t delay, uint32_t value)
+{
+   CCEA_RUNACTIONS_CREATE_STATIC1(action, struct cceaDelayActions, ((struct cceaDelayActions){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS], 0, delay}),
+                                          struct recordaction, ((struct recordaction){g_recordUID, value}));
+   cceaRunAction((struct cceaAction*) action, 1, map);
+}
+
+static uint8_t checkLog (const char *name, const uint32_t *expected, uint32_t expectedQuantity)
+{
+   if (g_logQuantity == expectedQuantity && (expectedQuantity == 0 || memcmp(g_log, expected, expectedQuantity * sizeof(uint32_t)) == 0))
+   {
+      g_logQuantity = 0;
+      return 1;
+   }
+   printf("%s:\nExpected:", name);
+   for (uint32_t i = 0; i < expectedQuantity; ++i)
+      printf(" %u", expected[i]);
+   printf("\nGot:     ");
+   for (uint32_t i = 0; i < g_logQuantity; ++i)
+      printf(" %u", g_log[i]);
+   putchar('\n');
+   g_logQuantity = 0;
+   return 0;
+}
+
+uint8_t delayedActionsTest (void)
+{
+   struct cce_buffer *map = initActionsTest();
+   if (map == NULL)
+   {
+      puts("Actions test:\nEngine initialization failed");
+      return 0;
+   }
+   uint8_t result = 1;
+
+   // Timeouts past the end of uint32_t range are after the ones before it
+   ccea__setMapTime(map, 0xFFFFFFF0u);
+   delayRecord(map, 40, 4);
+   delayRecord(map, 5, 1);
+   delayRecord(map, 20, 3);
+   delayRecord(map, 10, 2);
+   runDelayedActionsAt(map, 0xFFFFFFF8u);
+   result &= checkLog("Delayed actions before wraparound", (uint32_t[]){1}, 1);
+   runDelayedActionsAt(map, 0x20u);
+   result &= checkLog("Delayed actions across wraparound", (uint32_t[]){2, 3, 4}, 3);
+
+   // Actions due on the same tick run in the order they were delayed, however heap got shuffled by the others
+   ccea__setMapTime(map, 1000);
+   for (uint32_t i = 0; i < 16u; ++i)
+      delayRecord(map, (i & 0x1) ? 10 : 20, i);
+   runDelayedActionsAt(map, 1030);
+   result &= checkLog("Delayed actions with equal timeouts", (uint32_t[]){1, 3, 5, 7, 9, 11, 13, 15, 0, 2, 4, 6, 8, 10, 12, 14}, 16);
+
+   // Action which is removed from the heap while it runs delays another one, due on the same tick
+   ccea__setMapTime(map, 1500);
+   {
+      CCEA_RUNACTIONS_CREATE_NESTED1_STATIC1(action, struct cceaDelayActions, ((struct cceaDelayActions){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS], 0, 5}),
+                                                     struct recordaction, ((struct recordaction){g_recordUID, 1}),
+                                                     struct cceaDelayActions, ((struct cceaDelayActions){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS], 0, 0}),
+                                                     struct recordaction, ((struct recordaction){g_recordUID, 4}));
+      cceaRunAction((struct cceaAction*) action, 1, map);
+   }
+   delayRecord(map, 5, 2);
+   delayRecord(map, 6, 3);
+   runDelayedActionsAt(map, 1510);
+   result &= checkLog("Delayed action delaying another one", (uint32_t[]){1, 2, 3, 4}, 4);
+   runDelayedActionsAt(map, 1600);
+   result &= checkLog("Delayed actions after they were run", NULL, 0);
+
+   // Periodic and repeated actions are put back into the heap after each run and keep their place among the others
+   ccea__setMapTime(map, 2000);
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC1(periodic, struct cceaDelayActionsPeriodic, ((struct cceaDelayActionsPeriodic){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS_PERIODIC], 0, 10}),
+                                               struct recordaction, ((struct recordaction){g_recordUID, 1}));
+      cceaRunAction((struct cceaAction*) periodic, 1, map);
+      CCEA_RUNACTIONS_CREATE_STATIC1(repeated, struct cceaDelayActionsRepeated, ((struct cceaDelayActionsRepeated){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS_REPEATED], 0, 15, 2}),
+                                               struct recordaction, ((struct recordaction){g_recordUID, 2}));
+      cceaRunAction((struct cceaAction*) repeated, 1, map);
+   }
+   delayRecord(map, 25, 3);
+   for (uint32_t time = 2005; time <= 2050; time += 5)
+      runDelayedActionsAt(map, time);
+   // 2010: periodic, 2015: repeated, 2020: periodic, 2025: one-shot, 2030: periodic, then repeated, 2040 and 2050: periodic
+   result &= checkLog("Periodic and repeated actions", (uint32_t[]){1, 2, 1, 3, 1, 2, 1, 1}, 8);
+   // Periodic action runs once per each period passed, even if they all passed since the last frame
+   runDelayedActionsAt(map, 2080);
+   result &= checkLog("Periodic action after long frame", (uint32_t[]){1, 1, 1}, 3);
+
+   terminateActionsTest(map);
+   return result;
+}
+
+#define POOL_TEST_BLOBS 4u
+
+// Class of the only block allocated between two statistics, CCEA_POOL_SIZE_CLASSES for oversized one. -1 if anything else has changed
+static int32_t allocatedClass (const struct cceaPoolStatistics *before, const struct cceaPoolStatistics *after)
+{
+   int32_t result = -1;
+   for (uint32_t i = 0; i < CCEA_POOL_SIZE_CLASSES; ++i)
+   {
+      if (after->inUse[i] == before->inUse[i])
+         continue;
+      if (after->inUse[i] != before->inUse[i] + 1u || result != -1 ||
+          after->highWaterMark[i] != CCE_MAX(before->highWaterMark[i], after->inUse[i]) || after->reserved[i] < after->inUse[i])
+         return -1;
+      result = i;
+   }
+   if (after->oversizedInUse != before->oversizedInUse)
+   {
+      if (after->oversizedInUse != before->oversizedInUse + 1u || result != -1 ||
+          after->oversizedHighWaterMark != CCE_MAX(before->oversizedHighWaterMark, after->oversizedInUse))
+         return -1;
+      result = CCEA_POOL_SIZE_CLASSES;
+   }
+   return result;
+}
+
+uint8_t actionsPoolTest (void)
+{
+   struct cce_buffer *map = initActionsTest();
+   if (map == NULL)
+   {
+      puts("Actions pool test:\nEngine initialization failed");
+      return 0;
+   }
+   static const uint32_t blobSizes[POOL_TEST_BLOBS] = {8, 60, 150, 1024};
+   uint32_t blob[256] = {0};
+   uint8_t result = 1;
+   struct cceaPoolStatistics baseline, before, after, peak;
+   cceaGetPoolStatistics(&baseline);
+   for (uint32_t i = 0; i < CCEA_POOL_SIZE_CLASSES; ++i)
+   {
+      if (baseline.blockSize[i] != 16u << i)
+      {
+         printf("cceaGetPoolStatistics:\nSize class %u has %u-byte blocks instead of %u\n", i, baseline.blockSize[i], 16u << i);
+         result = 0;
+      }
+   }
+   
+   // Every delayed action takes exactly one block, bigger actions take blocks of the same or bigger class
+   ccea__setMapTime(map, 0);
+   before = baseline;
+   int32_t previousClass = 0;
+   for (uint32_t i = 0; i < POOL_TEST_BLOBS; ++i)
+   {
+      *(struct blobaction*) blob = (struct blobaction){g_blobUID, blobSizes[i]};
+      ccea__delayDynamicAction(cceaBasicActionUIDs[CCEA_RUN_DELAYED_ACTIONS], 100, blob, blobSizes[i], map);
+      cceaGetPoolStatistics(&after);
+      int32_t sizeClass = allocatedClass(&before, &after);
+      if (sizeClass < 0)
+      {
+         printf("cceaGetPoolStatistics:\nDelaying %u-byte action has changed statistics by more than one block\n", blobSizes[i]);
+         result = 0;
+      }
+      else if (sizeClass < previousClass || (sizeClass < CCEA_POOL_SIZE_CLASSES && after.blockSize[sizeClass] < blobSizes[i]))
+      {
+         printf("cceaGetPoolStatistics:\n%u-byte delayed action was allocated from size class %d (previous one from %d)\n", blobSizes[i], sizeClass, previousClass);
+         result = 0;
+      }
+      previousClass = sizeClass;
+      before = after;
+   }
+   if (previousClass != CCEA_POOL_SIZE_CLASSES)
+   {
+      printf("cceaGetPoolStatistics:\n%u-byte delayed action wasn't allocated with malloc\n", blobSizes[POOL_TEST_BLOBS - 1u]);
+      result = 0;
+   }
+   peak = after;
+   
+   // Released blocks are reused, high-water marks stay
+   runDelayedActionsAt(map, 100);
+   result &= checkLog("Delayed actions of different sizes", blobSizes, POOL_TEST_BLOBS);
+   for (uint32_t repeat = 0; repeat < 2u; ++repeat)
+   {
+      cceaGetPoolStatistics(&after);
+      if (memcmp(after.inUse, baseline.inUse, sizeof(after.inUse)) != 0 || after.oversizedInUse != baseline.oversizedInUse ||
+          memcmp(after.highWaterMark, peak.highWaterMark, sizeof(after.highWaterMark)) != 0 || after.oversizedHighWaterMark != peak.oversizedHighWaterMark ||
+          memcmp(after.reserved, peak.reserved, sizeof(after.reserved)) != 0)
+      {
+         printf("cceaGetPoolStatistics:\nBlocks of delayed actions weren't released or high-water marks have changed (run %u)\n", repeat);
+         result = 0;
+         break;
+      }
+      for (uint32_t i = 0; i < POOL_TEST_BLOBS; ++i)
+      {
+         *(struct blobaction*) blob = (struct blobaction){g_blobUID, blobSizes[i]};
+         ccea__delayDynamicAction(cceaBasicActionUIDs[CCEA_RUN_DELAYED_ACTIONS], 200, blob, blobSizes[i], map);
+      }
+      runDelayedActionsAt(map, 200);
+      g_logQuantity = 0;
+   }
+   terminateActionsTest(map);
+   return result;
+}
+
+static void addRecordOnEvent (struct cce_buffer *map, uint32_t actionSubsUID, uint32_t value)
+{
+   struct recordaction action = {g_recordUID, value};
+   cceaAddActionOnEvent(cceaBasicEventsUIDs[CCEA_EVENT_WRITE], actionSubsUID, (struct cceaAction*) &action, map);
+}
+
+uint8_t compiledActionsTest (void)
+{
+   struct cce_buffer *map = initActionsTest();
+   if (map == NULL)
+   {
+      puts("Compiled actions test:\nEngine initialization failed");
+      return 0;
+   }
+   const uint32_t event = cceaBasicEventsUIDs[CCEA_EVENT_WRITE];
+   uint8_t result = 1;
+   
+   // Actions on event are compiled on the first invocation after every change
+   addRecordOnEvent(map, 1, 1);
+   addRecordOnEvent(map, 2, 2);
+   addRecordOnEvent(map, 3, 3);
+   cceaInvokeEvent(event, 1, map);
+   result &= checkLog("Compiled event actions", (uint32_t[]){1, 2, 3}, 3);
+   cceaInvokeEvent(event, 2, map);
+   result &= checkLog("Compiled event actions run twice", (uint32_t[]){1, 1, 2, 2, 3, 3}, 6);
+   cceaRemoveActionOnEvent(event, 2, map);
+   cceaInvokeEvent(event, 1, map);
+   result &= checkLog("Event actions recompiled after removal", (uint32_t[]){1, 3}, 2);
+   {
+      uint32_t blob[5] = {g_blobUID, sizeof(blob)};
+      cceaAddActionOnEvent(event, 4, (struct cceaAction*) blob, map);
+   }
+   addRecordOnEvent(map, 5, 5);
+   cceaInvokeEvent(event, 1, map);
+   result &= checkLog("Event actions recompiled after addition", (uint32_t[]){1, 3, 20, 5}, 4);
+   cceaRemoveActionOnEvent(event, 1, map);
+   cceaRemoveActionOnEvent(event, 4, map);
+   cceaInvokeEvent(event, 1, map);
+   result &= checkLog("Event actions recompiled after removals", (uint32_t[]){3, 5}, 2);
+   cceaRemoveActionOnEvent(event, 3, map);
+   cceaRemoveActionOnEvent(event, 5, map);
+   cceaInvokeEvent(event, 1, map);
+   result &= checkLog("Event without actions", NULL, 0);
+   
+   // Periodic and repeated actions run their compiled streams, offsets of variable-sized actions included
+   ccea__setMapTime(map, 0);
+   {
+      CCEA_RUNACTIONS_CREATE_STATIC2(periodic, struct cceaDelayActionsPeriodic, ((struct cceaDelayActionsPeriodic){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS_PERIODIC], 0, 10}),
+                                               struct blobaction, ((struct blobaction){g_blobUID, sizeof(struct blobaction)}),
+                                               struct recordaction, ((struct recordaction){g_recordUID, 1}));
+      cceaRunAction((struct cceaAction*) periodic, 1, map);
+      CCEA_RUNACTIONS_CREATE_STATIC2(repeated, struct cceaDelayActionsRepeated, ((struct cceaDelayActionsRepeated){cceaBasicActionUIDs[CCEA_DELAY_ACTIONS_REPEATED], 0, 20, 2}),
+                                               struct recordaction, ((struct recordaction){g_recordUID, 2}),
+                                               struct recordaction, ((struct recordaction){g_recordUID, 3}));
+      cceaRunAction((struct cceaAction*) repeated, 1, map);
+   }
+   runDelayedActionsAt(map, 10);
+   result &= checkLog("Compiled periodic actions", (uint32_t[]){sizeof(struct blobaction), 1}, 2);
+   runDelayedActionsAt(map, 20);
+   result &= checkLog("Compiled periodic and repeated actions", (uint32_t[]){sizeof(struct blobaction), 1, 2, 3}, 4);
+   // Periodic actions are due twice: each action of their stream runs with doubled count. Repeated ones run for the last time
+   runDelayedActionsAt(map, 40);
+   result &= checkLog("Compiled actions after long frame", (uint32_t[]){sizeof(struct blobaction), sizeof(struct blobaction), 1, 1, 2, 3}, 6);
+   runDelayedActionsAt(map, 60);
+   result &= checkLog("Compiled periodic actions after repeated ones ended", (uint32_t[]){sizeof(struct blobaction), sizeof(struct blobaction), 1, 1}, 4);
+   
+   terminateActionsTest(map);
+   return result;
+}
+
+// Loaded buffer runs its load event (and with it the stored delayed actions) while it's being loaded
+static struct cce_buffer* writeAndLoadActions (struct cce_buffer *map, const char *path)
+{
+   if (cceWriteBinaryCCF(map, (char*) path) != 0)
+      return NULL;
+   return cceLoadBinaryCCF((char*) path, map->loadingFunctionBlockID);
+}
+
+uint8_t actionsRoundTripTest (void)
+{
+   struct cce_buffer *map = initActionsTest();
+   if (map == NULL)
+   {
+      puts("Actions round trip test:\nEngine initialization failed");
+      return 0;
+   }
+   char *tmpDir = cceGetTemporaryDirectory(0);
+   char *path = cceCreateNewPathFromOldPath(tmpDir, "actions.ccf", 0);
+   free(tmpDir);
+   const uint32_t event = cceaBasicEventsUIDs[CCEA_EVENT_LOAD];
+   uint8_t result = 1;
+   
+   // Load event is the only one with actions, so nothing follows them in the file
+   {
+      struct recordaction actions[2] = {{g_recordUID, 1}, {g_recordUID, 2}};
+      cceaAddActionOnEvent(event, 1, (struct cceaAction*) actions, map);
+      cceaAddActionOnEvent(event, 2, (struct cceaAction*) (actions + 1), map);
+   }
+   struct cce_buffer *loaded = writeAndLoadActions(map, path);
+   result &= (loaded != NULL) & checkLog("Load event actions after round trip", (uint32_t[]){1, 2}, 2);
+   cceFreeBuffer(loaded);
+   
+   // Delayed actions are stored in front of load event actions and keep their timeouts
+   ccea__setMapTime(map, 100);
+   delayRecord(map, 10, 3);
+   loaded = writeAndLoadActions(map, path);
+   result &= (loaded != NULL) & checkLog("Load event actions with delayed ones after round trip", (uint32_t[]){1, 2}, 2);
+   if (loaded != NULL)
+   {
+      runDelayedActionsAt(loaded, 105);
+      result &= checkLog("Delayed actions before timeout after round trip", NULL, 0);
+      runDelayedActionsAt(loaded, 110);
+      result &= checkLog("Delayed actions after round trip", (uint32_t[]){3}, 1);
+   }
+   cceFreeBuffer(loaded);
+   
+   remove(path);
+   free(path);
+   terminateActionsTest(map);
+   return result;
+}
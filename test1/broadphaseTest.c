@@ -0,0 +1,355 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cce/engine_common.h>
+#include <cce/os_interaction.h>
+#include <cce/utils.h>
+#include <cce/plugins/map2D/map2D.h>
+
+/* Every broadphase query is compared with brute force over all colliders of the layer, after the build and after positions were moved,
+ * switched to other elements (or to none) and appended. Map2D runs on the null backend */
+
+#define BROADPHASE_TEST_POSITIONS 256u
+#define BROADPHASE_TEST_APPENDED 32u
+#define BROADPHASE_TEST_QUERIES 64u
+#define BROADPHASE_TEST_ROUNDS 4u
+#define BROADPHASE_TEST_CANDIDATES 4096u
+
+static struct cce_collidermap2D g_colliders[] =
+{
+   {.data.rectangle = {{0, 0}, {6, 5}},    0, 2, CCE_RECTANGLE_COLLIDER},
+   {.data.circle    = {{3, -2}, 7},        0, 2, CCE_CIRCLE_COLLIDER},
+   {.data.rectangle = {{-4, 1}, {10, 3}},  1, 2, CCE_RECTANGLE_COLLIDER},
+   {.data.circle    = {{1, 1}, 0},         1, 2, CCE_CIRCLE_COLLIDER},
+   {.data.rectangle = {{-20, -20}, {40, 2}}, 2, 1, CCE_RECTANGLE_COLLIDER}
+};
+
+struct testbox
+{
+   struct cce_i32vec2 min;
+   struct cce_i32vec2 max;
+   struct cce_broadphasecandidate2D candidate;
+};
+
+static uint32_t g_random = 0x2545F491u;
+
+static uint32_t testRandom (void)
+{
+   g_random ^= g_random << 13;
+   g_random ^= g_random >> 17;
+   g_random ^= g_random << 5;
+   return g_random;
+}
+
+static int32_t randomCoordinate (void)
+{
+   return (int32_t)(testRandom() % 400u) - 200;
+}
+
+// Same bounds as broadphase computes: flips are applied, rotation is ignored
+static uint32_t collectBoxes (struct cce_buffer *map, struct testbox *boxes)
+{
+   struct cce_elementpositionarray *positions = cceGetElementPositionArray(0, map);
+   const struct cce_renderinginfo *info = cceGetRenderingInfo(map);
+   uint32_t quantity = 0;
+   for (uint32_t i = 0; i < positions->dataQuantity; ++i)
+   {
+      const struct cce_elementposition *position = positions->data + i;
+      if (position->textureDataID == 0 || position->textureDataID > info->elementsQuantity)
+         continue;
+      const struct cce_element *element = info->elements + position->textureDataID - 1;
+      for (uint32_t j = 0; j < CCE_STATIC_ARRAY_LENGTH(g_colliders); ++j)
+      {
+         const struct cce_collidermap2D *collider = g_colliders + j;
+         if (collider->element != position->textureDataID - 1)
+            continue;
+         int32_t x, y, width, height;
+         if (collider->type == CCE_CIRCLE_COLLIDER)
+         {
+            x = collider->data.circle.position.x;
+            y = collider->data.circle.position.y;
+            width = height = collider->data.circle.diameter;
+         }
+         else
+         {
+            x = collider->data.rectangle.position.x;
+            y = collider->data.rectangle.position.y;
+            width = collider->data.rectangle.size.x;
+            height = collider->data.rectangle.size.y;
+         }
+         if (element->flags & CCE_ELEMENT_FLIP_HORIZONTALLY)
+            x = -x - width;
+         if (element->flags & CCE_ELEMENT_FLIP_VERTICALLY)
+            y = -y - height;
+         struct testbox *box = boxes + quantity++;
+         box->min = (struct cce_i32vec2){x + element->position.x + position->position.x, y + element->position.y + position->position.y};
+         box->max = (struct cce_i32vec2){box->min.x + width, box->min.y + height};
+         box->candidate = (struct cce_broadphasecandidate2D){i, j};
+      }
+   }
+   return quantity;
+}
+
+static inline uint8_t boxesOverlap (const struct testbox *box, struct cce_i32vec2 min, struct cce_i32vec2 max)
+{
+   return box->min.x < max.x && box->max.x > min.x && box->min.y < max.y && box->max.y > min.y;
+}
+
+static inline uint8_t boxOverlapsCircle (const struct testbox *box, struct cce_collider_cir2D_32_32 circle)
+{
+   int64_t centerX = (int64_t) circle.position.x * 2 + circle.diameter, centerY = (int64_t) circle.position.y * 2 + circle.diameter;
+   int64_t dx = centerX - CCE_CLAMP(centerX, (int64_t) box->min.x * 2, (int64_t) box->max.x * 2);
+   int64_t dy = centerY - CCE_CLAMP(centerY, (int64_t) box->min.y * 2, (int64_t) box->max.y * 2);
+   return dx * dx + dy * dy < (int64_t) circle.diameter * circle.diameter;
+}
+
+// Box is half-open, so segment which only touches its max edge doesn't hit it
+static uint8_t boxOverlapsSegment (const struct testbox *box, struct cce_i32vec2 origin, struct cce_i32vec2 end)
+{
+   float tMin = 0.0f, tMax = 1.0f;
+   float tMaxEdge[2] = {INFINITY, INFINITY};
+   const float from[2] = {(float) origin.x, (float) origin.y}, direction[2] = {(float)(end.x - origin.x), (float)(end.y - origin.y)};
+   const float boxMin[2] = {(float) box->min.x, (float) box->min.y}, boxMax[2] = {(float) box->max.x, (float) box->max.y};
+   for (uint8_t axis = 0; axis < 2; ++axis)
+   {
+      if (direction[axis] == 0.0f)
+      {
+         if (from[axis] < boxMin[axis] || from[axis] >= boxMax[axis])
+            return 0;
+         continue;
+      }
+      float t1 = (boxMin[axis] - from[axis]) / direction[axis];
+      tMaxEdge[axis] = (boxMax[axis] - from[axis]) / direction[axis];
+      tMin = CCE_MAX(tMin, CCE_MIN(t1, tMaxEdge[axis]));
+      tMax = CCE_MIN(tMax, CCE_MAX(t1, tMaxEdge[axis]));
+      if (tMin > tMax)
+         return 0;
+   }
+   return !(tMin == tMax && (tMin == tMaxEdge[0] || tMin == tMaxEdge[1]));
+}
+
+static int compareCandidates (const void *a, const void *b)
+{
+   const struct cce_broadphasecandidate2D *first = a, *second = b;
+   if (first->positionID != second->positionID)
+      return (first->positionID > second->positionID) - (first->positionID < second->positionID);
+   return (first->collider > second->collider) - (first->collider < second->collider);
+}
+
+static int comparePairs (const void *a, const void *b)
+{
+   const struct cce_broadphasepair2D *first = a, *second = b;
+   int result = compareCandidates(&first->a, &second->a);
+   return (result != 0) ? result : compareCandidates(&first->b, &second->b);
+}
+
+// Order of candidates is unspecified, so both sets are sorted
+static uint8_t compareResults (const char *name, uint32_t round, struct cce_broadphasecandidate2D *found, uint32_t foundQuantity,
+                               struct cce_broadphasecandidate2D *expected, uint32_t expectedQuantity)
+{
+   if (foundQuantity == expectedQuantity)
+   {
+      qsort(found, foundQuantity, sizeof(struct cce_broadphasecandidate2D), compareCandidates);
+      qsort(expected, expectedQuantity, sizeof(struct cce_broadphasecandidate2D), compareCandidates);
+      if (foundQuantity == 0 || memcmp(found, expected, foundQuantity * sizeof(struct cce_broadphasecandidate2D)) == 0)
+         return 1;
+   }
+   printf("%s (round %u):\nBroadphase found %u candidates, brute force found %u\n", name, round, foundQuantity, expectedQuantity);
+   return 0;
+}
+
+static uint8_t checkRay (struct cce_broadphase2D *broadphase, const struct testbox *boxes, uint32_t boxesQuantity,
+                         struct cce_i32vec2 origin, struct cce_i32vec2 end, uint32_t round)
+{
+   static struct cce_broadphasecandidate2D found[BROADPHASE_TEST_CANDIDATES], expected[BROADPHASE_TEST_CANDIDATES];
+   uint32_t expectedQuantity = 0;
+   for (uint32_t i = 0; i < boxesQuantity; ++i)
+   {
+      if (boxOverlapsSegment(boxes + i, origin, end))
+         expected[expectedQuantity++] = boxes[i].candidate;
+   }
+   uint32_t foundQuantity = cceQueryBroadphaseRay2D(broadphase, origin, end, found, BROADPHASE_TEST_CANDIDATES);
+   return compareResults("cceQueryBroadphaseRay2D", round, found, foundQuantity, expected, expectedQuantity);
+}
+
+static uint8_t checkQueries (struct cce_broadphase2D *broadphase, struct cce_buffer *map, uint32_t round)
+{
+   static struct testbox boxes[(BROADPHASE_TEST_POSITIONS + BROADPHASE_TEST_APPENDED) * CCE_STATIC_ARRAY_LENGTH(g_colliders)];
+   static struct cce_broadphasecandidate2D found[BROADPHASE_TEST_CANDIDATES], expected[BROADPHASE_TEST_CANDIDATES];
+   static struct cce_broadphasepair2D foundPairs[BROADPHASE_TEST_CANDIDATES * 4u], expectedPairs[BROADPHASE_TEST_CANDIDATES * 4u];
+   const uint32_t boxesQuantity = collectBoxes(map, boxes);
+   uint8_t result = 1;
+
+   // Colliders of the same element position are not paired
+   uint32_t expectedQuantity = 0;
+   for (uint32_t i = 0; i < boxesQuantity; ++i)
+   {
+      for (uint32_t j = i + 1; j < boxesQuantity; ++j)
+      {
+         if (boxes[i].candidate.positionID == boxes[j].candidate.positionID || !boxesOverlap(boxes + i, boxes[j].min, boxes[j].max))
+            continue;
+         expectedPairs[expectedQuantity++] = (struct cce_broadphasepair2D){boxes[i].candidate, boxes[j].candidate};
+      }
+   }
+   uint32_t foundQuantity = cceGetBroadphasePairs2D(broadphase, foundPairs, CCE_STATIC_ARRAY_LENGTH(foundPairs));
+   for (uint32_t i = 0; i < CCE_MIN(foundQuantity, CCE_STATIC_ARRAY_LENGTH(foundPairs)); ++i)
+   {
+      if (compareCandidates(&foundPairs[i].a, &foundPairs[i].b) > 0)
+         foundPairs[i] = (struct cce_broadphasepair2D){foundPairs[i].b, foundPairs[i].a};
+   }
+   qsort(foundPairs, CCE_MIN(foundQuantity, CCE_STATIC_ARRAY_LENGTH(foundPairs)), sizeof(struct cce_broadphasepair2D), comparePairs);
+   qsort(expectedPairs, expectedQuantity, sizeof(struct cce_broadphasepair2D), comparePairs);
+   if (foundQuantity != expectedQuantity || (foundQuantity > 0 && memcmp(foundPairs, expectedPairs, foundQuantity * sizeof(struct cce_broadphasepair2D)) != 0))
+   {
+      printf("cceGetBroadphasePairs2D (round %u):\nBroadphase found %u pairs, brute force found %u\n", round, foundQuantity, expectedQuantity);
+      result = 0;
+   }
+
+   for (uint32_t query = 0; query < BROADPHASE_TEST_QUERIES; ++query)
+   {
+      // The last box spans past the range of int16 cells
+      struct cce_collider_rect2D_32_32 box = {{randomCoordinate(), randomCoordinate()}, {testRandom() % 64u, testRandom() % 64u}};
+      if (query == BROADPHASE_TEST_QUERIES - 1u)
+         box = (struct cce_collider_rect2D_32_32){{-250, -10}, {400000u, 20u}};
+      struct cce_i32vec2 max = {box.position.x + (int32_t) box.size.x, box.position.y + (int32_t) box.size.y};
+      expectedQuantity = 0;
+      for (uint32_t i = 0; i < boxesQuantity; ++i)
+      {
+         if (boxesOverlap(boxes + i, box.position, max))
+            expected[expectedQuantity++] = boxes[i].candidate;
+      }
+      foundQuantity = cceQueryBroadphaseAABB2D(broadphase, box, found, BROADPHASE_TEST_CANDIDATES);
+      result &= compareResults("cceQueryBroadphaseAABB2D", round, found, foundQuantity, expected, expectedQuantity);
+
+      struct cce_i32vec2 point = {randomCoordinate(), randomCoordinate()};
+      expectedQuantity = 0;
+      for (uint32_t i = 0; i < boxesQuantity; ++i)
+      {
+         if (boxesOverlap(boxes + i, point, (struct cce_i32vec2){point.x + 1, point.y + 1}))
+            expected[expectedQuantity++] = boxes[i].candidate;
+      }
+      foundQuantity = cceQueryBroadphasePoint2D(broadphase, point, found, BROADPHASE_TEST_CANDIDATES);
+      result &= compareResults("cceQueryBroadphasePoint2D", round, found, foundQuantity, expected, expectedQuantity);
+
+      struct cce_collider_cir2D_32_32 circle = {{randomCoordinate(), randomCoordinate()}, testRandom() % 48u};
+      expectedQuantity = 0;
+      for (uint32_t i = 0; i < boxesQuantity; ++i)
+      {
+         if (boxOverlapsCircle(boxes + i, circle))
+            expected[expectedQuantity++] = boxes[i].candidate;
+      }
+      foundQuantity = cceQueryBroadphaseCircle2D(broadphase, circle, found, BROADPHASE_TEST_CANDIDATES);
+      result &= compareResults("cceQueryBroadphaseCircle2D", round, found, foundQuantity, expected, expectedQuantity);
+
+      // Axis-aligned rays take the other branch of the slab test, diagonal ones from cell corners cross only cell corners
+      struct cce_i32vec2 origin = {randomCoordinate(), randomCoordinate()}, end = {randomCoordinate(), randomCoordinate()};
+      if (query % 8u == 0)
+      {
+         end.y = origin.y;
+      }
+      else if (query % 8u == 4u)
+      {
+         origin = (struct cce_i32vec2){origin.x & ~0x7, origin.y & ~0x7};
+         int32_t length = (int32_t)(testRandom() % 16u) * 8 - 64;
+         end = (struct cce_i32vec2){origin.x + length, origin.y + ((query & 0x8) ? length : -length)};
+      }
+      result &= checkRay(broadphase, boxes, boxesQuantity, origin, end, round);
+   }
+   // Diagonal segments which end exactly at cell aligned min corner of box, from both sides with mixed directions
+   for (uint32_t i = 0; i < boxesQuantity; ++i)
+   {
+      if ((boxes[i].min.x | boxes[i].min.y) & 0x7)
+         continue;
+      result &= checkRay(broadphase, boxes, boxesQuantity, (struct cce_i32vec2){boxes[i].min.x - 16, boxes[i].min.y + 16}, boxes[i].min, round);
+      result &= checkRay(broadphase, boxes, boxesQuantity, (struct cce_i32vec2){boxes[i].min.x + 16, boxes[i].min.y - 16}, boxes[i].min, round);
+   }
+   return result;
+}
+
+static struct cce_buffer* initBroadphaseTest (void)
+{
+   char *tmpDir = cceGetTemporaryDirectory(0);
+   if (tmpDir == NULL)
+      return NULL;
+   char *path = cceCreateNewPathFromOldPath(tmpDir, "game.ini", 0);
+   FILE *ini = fopen(path, "w");
+   if (ini == NULL)
+   {
+      free(tmpDir);
+      free(path);
+      return NULL;
+   }
+   fprintf(ini, "[Window]\ngameResolution = 64x64\nwindowName = CCE broadphase test\n\n"
+                "[Map2D]\nrenderingLayersQuantity = 1\ntextureSize = 16x16\ntexturePath = %s\nuseFallbackMap = false\npxPerCell = 1\n", tmpDir);
+   fclose(ini);
+   free(tmpDir);
+   cceSetBackend("null");
+   cceLoadMap2Dplugin();
+   int status = cceInit(path);
+   free(path);
+   return (status == 0) ? cceCreateMap2Ddynamic() : NULL;
+}
+
+uint8_t broadphaseTest (void)
+{
+   struct cce_buffer *map = initBroadphaseTest();
+   if (map == NULL)
+   {
+      puts("Broadphase test:\nEngine initialization failed");
+      return 0;
+   }
+   struct cce_element *elements = cceGetElements(0, 3, map);
+   elements[0] = (struct cce_element) {{2, -3}, {.rgba = {255, 255, 255, 255}}, {8, 8}, 0, 0, 0};
+   elements[1] = (struct cce_element) {{-5, 4}, {.rgba = {255, 255, 255, 255}}, {8, 8}, 0, 0, CCE_ELEMENT_FLIP_HORIZONTALLY};
+   elements[2] = (struct cce_element) {{0, 0},  {.rgba = {255, 255, 255, 255}}, {8, 8}, 0, 0, CCE_ELEMENT_FLIP_VERTICALLY};
+   struct cce_elementposition *positions = cceGetElementsPosition(0, 0, BROADPHASE_TEST_POSITIONS, map);
+   for (uint32_t i = 0; i < BROADPHASE_TEST_POSITIONS; ++i)
+      positions[i] = (struct cce_elementposition) {{(int16_t) randomCoordinate(), (int16_t) randomCoordinate()}, (uint16_t)(i % 4u), 0, 0};
+   // Rectangle collider of the first element starts exactly at cell corner (8, 8)
+   positions[0] = (struct cce_elementposition) {{6, 11}, 1, 0, 0};
+   struct cce_collisioninfo collisionInfo = {g_colliders, CCE_STATIC_ARRAY_LENGTH(g_colliders)};
+   struct cce_broadphase2D *broadphase = cceCreateBroadphase2D(3);
+   uint8_t result = (cceBuildBroadphaseMap2D(broadphase, &collisionInfo, 0, map) == 0);
+   result &= checkQueries(broadphase, map, 0);
+   for (uint32_t round = 1; round <= BROADPHASE_TEST_ROUNDS && result; ++round)
+   {
+      // Moved by a few pixels (mostly inside the same cells) or anywhere, some of them get other element
+      for (uint32_t i = 0; i < BROADPHASE_TEST_POSITIONS / 4u; ++i)
+      {
+         uint32_t positionID = testRandom() % BROADPHASE_TEST_POSITIONS;
+         positions = cceGetElementsPosition(0, positionID, 1, map);
+         if (i & 0x1)
+            positions->position = (struct cce_i16vec2) {(int16_t) randomCoordinate(), (int16_t) randomCoordinate()};
+         else
+            positions->position.x += (int16_t)(testRandom() % 5u) - 2;
+         if (i % 3u == 0)
+            positions->textureDataID = testRandom() % 4u;
+         result &= (cceUpdateBroadphaseMap2D(broadphase, positionID, 1) == 0);
+      }
+      if (round == 2)
+      {
+         positions = cceGetElementsPosition(0, BROADPHASE_TEST_POSITIONS, BROADPHASE_TEST_APPENDED, map);
+         for (uint32_t i = 0; i < BROADPHASE_TEST_APPENDED; ++i)
+            positions[i] = (struct cce_elementposition) {{(int16_t) randomCoordinate(), (int16_t) randomCoordinate()}, (uint16_t)(1u + i % 3u), 0, 0};
+         result &= (cceUpdateBroadphaseMap2D(broadphase, BROADPHASE_TEST_POSITIONS, BROADPHASE_TEST_APPENDED) == 0);
+      }
+      result &= checkQueries(broadphase, map, round);
+   }
+   cceFreeBroadphase2D(broadphase);
+   cceFreeMap2Ddynamic(map);
+   cceTerminate();
+   return result;
+}
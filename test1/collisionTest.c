@@ -0,0 +1,116 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <cce/engine_common.h>
+#include <cce/utils.h>
+
+#define BATCH_SIZE 203 // Not multiple of any SIMD width, so scalar tail is tested too
+#define BATCH_ROUNDS 64
+
+static uint32_t g_randomState = 0x9E3779B9u;
+
+static uint32_t testRandom (void)
+{
+   g_randomState ^= g_randomState << 13;
+   g_randomState ^= g_randomState >> 17;
+   g_randomState ^= g_randomState << 5;
+   return g_randomState;
+}
+
+static const char *const g_implementationNames[] = {"auto", "scalar", "SSE2", "AVX2", "NEON"};
+
+uint8_t collisionBatchTest (void)
+{
+   int16_t  positionX[BATCH_SIZE], positionY[BATCH_SIZE];
+   uint16_t sizeX[BATCH_SIZE], sizeY[BATCH_SIZE], diameter[BATCH_SIZE];
+   const struct cce_rect2Dbatch_16_16 rects = {positionX, positionY, sizeX, sizeY};
+   const struct cce_cir2Dbatch_16_16 circles = {positionX, positionY, diameter};
+   uint32_t reference[4][(BATCH_SIZE + 31) / 32], result[(BATCH_SIZE + 31) / 32], indices[BATCH_SIZE];
+   for (uint32_t round = 0; round < BATCH_ROUNDS; ++round)
+   {
+      // Every fourth round uses whole int16 range to catch overflows
+      const uint8_t wide = (round & 3) == 0;
+      for (uint32_t i = 0; i < BATCH_SIZE; ++i)
+      {
+         positionX[i] = wide ? (int16_t) testRandom() : (int16_t)(testRandom() % 128) - 64;
+         positionY[i] = wide ? (int16_t) testRandom() : (int16_t)(testRandom() % 128) - 64;
+         sizeX[i] = wide ? (uint16_t) testRandom() : testRandom() % 32;
+         sizeY[i] = wide ? (uint16_t) testRandom() : testRandom() % 32;
+         diameter[i] = wide ? (uint16_t) testRandom() : testRandom() % 32;
+      }
+      const struct cce_collider_rect2D_16_16 rect = {{(int16_t)(testRandom() % 128) - 64, (int16_t)(testRandom() % 128) - 64}, {testRandom() % 48, testRandom() % 48}};
+      const struct cce_collider_cir2D_16_16 circle = {rect.position, testRandom() % 48};
+      cceSetCollisionBatchImplementation(CCE_COLLISION_BATCH_SCALAR);
+      cceCheckCollisionRect2DBatch(rect, &rects, BATCH_SIZE, reference[0]);
+      cceCheckCollisionCir2DBatch(circle, &circles, BATCH_SIZE, reference[1]);
+      cceCheckCollisionCirRect2DBatch(circle, &rects, BATCH_SIZE, reference[2]);
+      cceCheckCollisionRectCir2DBatch(rect, &circles, BATCH_SIZE, reference[3]);
+      // Scalar batch must agree with single pair macros where they do not overflow
+      for (uint32_t i = 0; !wide && i < BATCH_SIZE; ++i)
+      {
+         const struct cce_collider_rect2D_16_16 otherRect = {{positionX[i], positionY[i]}, {sizeX[i], sizeY[i]}};
+         const struct cce_collider_cir2D_16_16 otherCircle = {{positionX[i], positionY[i]}, diameter[i]};
+         const uint8_t expected[4] = {cceCheckCollisionRect2D(rect, otherRect), cceCheckCollisionCir2D(circle, otherCircle),
+                                      cceCheckCollisionCirRect2D(circle, otherRect), cceCheckCollisionCirRect2D(otherCircle, rect)};
+         for (uint8_t kernel = 0; kernel < 4; ++kernel)
+         {
+            if (((reference[kernel][i >> 5] >> (i & 31)) & 1) != expected[kernel])
+            {
+               printf("Batch collision kernel %u, element %u:\nExpected: %u\nGot: %u\n", kernel, i, expected[kernel], !expected[kernel]);
+               return 0;
+            }
+         }
+      }
+      for (uint8_t implementation = CCE_COLLISION_BATCH_SSE2; implementation <= CCE_COLLISION_BATCH_NEON; ++implementation)
+      {
+         // Implementations which are not supported on this CPU are skipped
+         if (cceSetCollisionBatchImplementation(implementation) != implementation)
+            continue;
+         for (uint8_t kernel = 0; kernel < 4; ++kernel)
+         {
+            switch (kernel)
+            {
+               case 0: cceCheckCollisionRect2DBatch(rect, &rects, BATCH_SIZE, result); break;
+               case 1: cceCheckCollisionCir2DBatch(circle, &circles, BATCH_SIZE, result); break;
+               case 2: cceCheckCollisionCirRect2DBatch(circle, &rects, BATCH_SIZE, result); break;
+               case 3: cceCheckCollisionRectCir2DBatch(rect, &circles, BATCH_SIZE, result); break;
+            }
+            if (memcmp(result, reference[kernel], sizeof(result)) != 0)
+            {
+               printf("Batch collision kernel %u: %s implementation differs from scalar one\n", kernel, g_implementationNames[implementation]);
+               return 0;
+            }
+         }
+      }
+      uint32_t indicesQuantity = cceCollisionMaskToIndices(reference[0], BATCH_SIZE, indices), expectedQuantity = 0;
+      for (uint32_t i = 0; i < BATCH_SIZE; ++i)
+      {
+         if (((reference[0][i >> 5] >> (i & 31)) & 1) == 0)
+            continue;
+         if (expectedQuantity >= indicesQuantity || indices[expectedQuantity] != i)
+         {
+            printf("cceCollisionMaskToIndices:\nExpected index %u at position %u\n", i, expectedQuantity);
+            return 0;
+         }
+         ++expectedQuantity;
+      }
+      if (expectedQuantity != indicesQuantity)
+      {
+         printf("cceCollisionMaskToIndices:\nExpected: %u indices\nGot: %u\n", expectedQuantity, indicesQuantity);
+         return 0;
+      }
+   }
+   cceSetCollisionBatchImplementation(CCE_COLLISION_BATCH_AUTO);
+   return 1;
+}
@@ -0,0 +1,91 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cce/compression.h>
+#include <cce/utils.h>
+
+/* Data of different entropy goes through compression and back, damaged input must not be accepted silently */
+
+#define COMPRESSION_TEST_SIZE 70000u // Longer than maximum back reference distance
+
+static uint32_t nextRandom (uint32_t *state)
+{
+   *state ^= *state << 13;
+   *state ^= *state >> 17;
+   *state ^= *state << 5;
+   return *state;
+}
+
+static void fillData (uint8_t *data, size_t size, uint8_t kind, uint32_t *random)
+{
+   for (size_t i = 0; i < size; ++i)
+   {
+      switch (kind)
+      {
+         case 0: data[i] = (uint8_t) nextRandom(random); break;          // Incompressible
+         case 1: data[i] = (uint8_t)(i % 7u); break;                     // Short period, long overlapping matches
+         case 2: data[i] = (uint8_t)(nextRandom(random) % 3u); break;    // Few symbols
+         default: data[i] = (i < 300u) ? (uint8_t) nextRandom(random) : data[i - 1u - nextRandom(random) % 300u]; break; // Reused fragments
+      }
+   }
+}
+
+uint8_t compressionTest (void)
+{
+   uint8_t *data = malloc(COMPRESSION_TEST_SIZE);
+   uint8_t *compressed = malloc(cceGetCompressLZbound(COMPRESSION_TEST_SIZE));
+   uint8_t *decompressed = malloc(COMPRESSION_TEST_SIZE);
+   uint32_t random = 0x9E3779B9u;
+   uint8_t result = 1;
+   const size_t sizes[] = {0u, 1u, 12u, 13u, 255u, 4096u, COMPRESSION_TEST_SIZE};
+   for (uint8_t kind = 0; kind < 4u && result; ++kind)
+   {
+      for (const size_t *size = sizes; size < sizes + CCE_STATIC_ARRAY_LENGTH(sizes); ++size)
+      {
+         fillData(data, *size, kind, &random);
+         size_t compressedSize = cceCompressLZ(data, *size, compressed, cceGetCompressLZbound(*size));
+         if (compressedSize == 0 || cceDecompressLZ(compressed, compressedSize, decompressed, *size) != 0 ||
+             memcmp(data, decompressed, *size) != 0)
+         {
+            printf("cceCompressLZ/cceDecompressLZ:\nData kind %u of size %zu doesn't survive round trip (compressed to %zu)\n", kind, *size, compressedSize);
+            result = 0;
+            break;
+         }
+         if (kind == 1u && *size == COMPRESSION_TEST_SIZE && compressedSize > COMPRESSION_TEST_SIZE / 100u)
+         {
+            printf("cceCompressLZ:\nPeriodic data of size %zu is compressed to %zu bytes\n", *size, compressedSize);
+            result = 0;
+            break;
+         }
+         // Wrong expected size and truncated input are errors
+         if (*size > 0u && (cceDecompressLZ(compressed, compressedSize, decompressed, *size - 1u) == 0 ||
+                            cceDecompressLZ(compressed, compressedSize - 1u, decompressed, *size) == 0))
+         {
+            printf("cceDecompressLZ:\nDamaged input of size %zu is accepted\n", *size);
+            result = 0;
+            break;
+         }
+         // Random damage may decode into wrong data, but never out of bounds (checked by sanitizers)
+         for (uint8_t i = 0; i < 16u; ++i)
+         {
+            compressed[nextRandom(&random) % compressedSize] ^= (uint8_t)(1u << (nextRandom(&random) & 7u));
+            cceDecompressLZ(compressed, compressedSize, decompressed, *size);
+         }
+      }
+   }
+   free(data);
+   free(compressed);
+   free(decompressed);
+   return result;
+}
@@ -0,0 +1,85 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cce/jobs.h>
+
+/* Every job has to run exactly once, including ones submitted by jobs which wait for them (workers help instead of blocking),
+ * and counter must reach zero only after all of its jobs are finished */
+
+#define JOBS_TEST_PARENTS 64u
+#define JOBS_TEST_CHILDREN 64u
+
+struct parentjob
+{
+   uint32_t runs[JOBS_TEST_CHILDREN];
+   uint32_t sum;
+};
+
+static void childJob (void *data)
+{
+   uint32_t *runs = data;
+   volatile uint32_t sink = 0;
+   for (uint32_t i = 0; i < 1000u; ++i)
+      sink += i;
+   ++(*runs);
+}
+
+static void parentJob (void *data)
+{
+   struct parentjob *parent = data;
+   struct cce_job jobs[JOBS_TEST_CHILDREN];
+   for (uint32_t i = 0; i < JOBS_TEST_CHILDREN; ++i)
+      jobs[i] = (struct cce_job){childJob, parent->runs + i};
+   struct cce_jobcounter counter = {0};
+   cceSubmitJobs(jobs, JOBS_TEST_CHILDREN, &counter);
+   cceWaitForJobCounter(&counter);
+   // Children are finished, so their results are visible here
+   for (uint32_t i = 0; i < JOBS_TEST_CHILDREN; ++i)
+      parent->sum += parent->runs[i];
+}
+
+uint8_t jobsTest (void)
+{
+   struct parentjob *parents = calloc(JOBS_TEST_PARENTS, sizeof(struct parentjob));
+   struct cce_job jobs[JOBS_TEST_PARENTS];
+   for (uint32_t i = 0; i < JOBS_TEST_PARENTS; ++i)
+      jobs[i] = (struct cce_job){parentJob, parents + i};
+   struct cce_jobcounter counter = {0};
+   const uint32_t workersQuantity = cceGetJobWorkersQuantity();
+   // Submitted in two parts, so that the counter is reused while its jobs are still running
+   cceSubmitJobs(jobs, JOBS_TEST_PARENTS / 2u, &counter);
+   cceSubmitJobs(jobs + JOBS_TEST_PARENTS / 2u, JOBS_TEST_PARENTS / 2u, &counter);
+   cceWaitForJobCounter(&counter);
+   uint8_t result = 1;
+   for (const struct parentjob *iterator = parents, *end = parents + JOBS_TEST_PARENTS; iterator < end; ++iterator)
+   {
+      if (iterator->sum != JOBS_TEST_CHILDREN)
+      {
+         printf("cceWaitForJobCounter:\nParent job %u has seen %u of %u finished children (%u workers)\n",
+                (unsigned)(iterator - parents), iterator->sum, JOBS_TEST_CHILDREN, workersQuantity);
+         result = 0;
+         break;
+      }
+      for (uint32_t i = 0; i < JOBS_TEST_CHILDREN && result; ++i)
+      {
+         if (iterator->runs[i] != 1u)
+         {
+            printf("cceSubmitJobs:\nJob ran %u times instead of once (%u workers)\n", iterator->runs[i], workersQuantity);
+            result = 0;
+         }
+      }
+   }
+   free(parents);
+   return result;
+}
@@ -10,7 +10,7 @@
    without any warranty.
 */
 
-#define TESTS_QUANTITY 3lu
+#define TESTS_QUANTITY 15lu
 
 #include <stdint.h>
 #include <stdio.h>
@@ -18,6 +18,18 @@
 uint8_t tmpDirTest (void);
 uint8_t appDataDirTest (void);
 uint8_t utf8Test (void);
+uint8_t delayedActionsTest (void);
+uint8_t actionsPoolTest (void);
+uint8_t compiledActionsTest (void);
+uint8_t actionsRoundTripTest (void);
+uint8_t broadphaseTest (void);
+uint8_t collisionBatchTest (void);
+uint8_t rangeTest (void);
+uint8_t crc32cTest (void);
+uint8_t textureDecoderTest (void);
+uint8_t compressionTest (void);
+uint8_t profilerTest (void);
+uint8_t jobsTest (void);
 uint8_t test4 (void);
 
 int main (int argc, char **argv)
@@ -31,5 +43,17 @@ int main (int argc, char **argv)
    testsPassed += tmpDirTest();
    testsPassed += appDataDirTest();
    testsPassed += utf8Test();
+   testsPassed += delayedActionsTest();
+   testsPassed += actionsPoolTest();
+   testsPassed += compiledActionsTest();
+   testsPassed += actionsRoundTripTest();
+   testsPassed += broadphaseTest();
+   testsPassed += collisionBatchTest();
+   testsPassed += rangeTest();
+   testsPassed += crc32cTest();
+   testsPassed += textureDecoderTest();
+   testsPassed += compressionTest();
+   testsPassed += profilerTest();
+   testsPassed += jobsTest();
    return testsPassed != TESTS_QUANTITY;
 }
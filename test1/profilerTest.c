@@ -0,0 +1,260 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cce/os_interaction.h>
+#include <cce/profiler.h>
+
+/* Trace written by profiler has to be valid JSON with nested zones inside their parents.
+ * Without CCE_PROFILER zones must still run the code they wrap */
+
+#define PROFILER_TEST_RING_ZONES 20000u // More than a ring keeps, the oldest ones are dropped
+#define PROFILER_TEST_STARTS_WITH(string, literal) (strncmp(string, literal, sizeof(literal) - 1u) == 0)
+
+#ifdef CCE_PROFILER
+
+static volatile uint32_t g_sink;
+
+static void spin (void)
+{
+   for (uint32_t i = 0; i < 10000u; ++i)
+      g_sink += i;
+}
+
+// Recursive descent validator, returns position after the value or NULL
+static const char* skipSpaces (const char *json)
+{
+   while (*json == ' ' || *json == '\n' || *json == '\r' || *json == '\t')
+      ++json;
+   return json;
+}
+
+static const char* validateValue (const char *json, unsigned depth);
+
+static const char* validateString (const char *json)
+{
+   if (*json++ != '"')
+      return NULL;
+   for (; *json != '"'; ++json)
+   {
+      if ((unsigned char) *json < 0x20u)
+         return NULL;
+      if (*json == '\\')
+      {
+         ++json;
+         if (*json == 'u')
+         {
+            for (uint8_t i = 1; i <= 4u; ++i)
+               if (strchr("0123456789abcdefABCDEF", json[i]) == NULL || json[i] == '\0')
+                  return NULL;
+            json += 4;
+         }
+         else if (*json == '\0' || strchr("\"\\/bfnrt", *json) == NULL)
+         {
+            return NULL;
+         }
+      }
+   }
+   return json + 1;
+}
+
+static const char* validateNumber (const char *json)
+{
+   json += (*json == '-');
+   if (*json < '0' || *json > '9')
+      return NULL;
+   while (*json >= '0' && *json <= '9')
+      ++json;
+   if (*json == '.')
+   {
+      if (*++json < '0' || *json > '9')
+         return NULL;
+      while (*json >= '0' && *json <= '9')
+         ++json;
+   }
+   return json;
+}
+
+static const char* validateValue (const char *json, unsigned depth)
+{
+   json = skipSpaces(json);
+   if (depth > 16u)
+      return NULL;
+   if (*json == '"')
+      return validateString(json);
+   if (*json == '{' || *json == '[')
+   {
+      const char close = (*json == '{') ? '}' : ']';
+      json = skipSpaces(json + 1);
+      if (*json == close)
+         return json + 1;
+      while (json != NULL)
+      {
+         if (close == '}')
+         {
+            json = validateString(skipSpaces(json));
+            if (json == NULL || *(json = skipSpaces(json)) != ':')
+               return NULL;
+            ++json;
+         }
+         json = validateValue(json, depth + 1u);
+         if (json == NULL)
+            return NULL;
+         json = skipSpaces(json);
+         if (*json == close)
+            return json + 1;
+         json = (*json == ',') ? json + 1 : NULL;
+      }
+      return NULL;
+   }
+   if (!strncmp(json, "true", 4))
+      return json + 4;
+   if (!strncmp(json, "false", 5))
+      return json + 5;
+   if (!strncmp(json, "null", 4))
+      return json + 4;
+   return validateNumber(json);
+}
+
+// Finds complete event of the zone, its tail is checked by the caller
+static uint8_t findZone (const char *json, const char *name, double *start, double *duration, const char **tail)
+{
+   const char *zone = strstr(json, name);
+   if (zone == NULL || sscanf(zone + strlen(name), ",\"cat\":\"cce\",\"ph\":\"X\",\"ts\":%lf,\"dur\":%lf", start, duration) != 2)
+      return 0;
+   *tail = strstr(zone, ",\"pid\":1,\"tid\":1");
+   return *tail != NULL;
+}
+
+static char* readTrace (const char *path)
+{
+   FILE *file = fopen(path, "rb");
+   if (file == NULL)
+      return NULL;
+   fseek(file, 0, SEEK_END);
+   long size = ftell(file);
+   fseek(file, 0, SEEK_SET);
+   char *json = (size > 0) ? malloc(size + 1) : NULL;
+   if (json != NULL && fread(json, 1, size, file) == (size_t) size)
+   {
+      json[size] = '\0';
+   }
+   else
+   {
+      free(json);
+      json = NULL;
+   }
+   fclose(file);
+   return json;
+}
+
+uint8_t profilerTest (void)
+{
+   const char *fileName = "trace.json";
+   char *path = cceGetTemporaryDirectory(strlen(fileName) + 1u);
+   cceAppendPath(path, strlen(path) + strlen(fileName) + 2u, fileName);
+   // Zones of the stopped profiler aren't recorded
+   CCE_PROFILE_SCOPE("beforeStart") spin();
+   cceStartProfiling();
+   for (uint32_t i = 0; i < PROFILER_TEST_RING_ZONES; ++i)
+      CCE_PROFILE_SCOPE("ring") g_sink += i;
+   CCE_PROFILE_SCOPE("outer")
+   {
+      spin();
+      CCE_PROFILE_SCOPE_ID("inner \"quoted\"\n", 7u) spin();
+      CCE_PROFILE_BEGIN(zone);
+      spin();
+      CCE_PROFILE_END(zone, "sibling");
+   }
+   cceStopProfiling();
+   CCE_PROFILE_SCOPE("afterStop") spin();
+   uint8_t result = 0;
+   char *json = (cceWriteProfilerTrace(path) == 0) ? readTrace(path) : NULL;
+   if (json == NULL)
+   {
+      printf("cceWriteProfilerTrace:\nTrace isn't written to %s\n", path);
+      goto END;
+   }
+   const char *end = validateValue(json, 0);
+   if (end == NULL || *skipSpaces(end) != '\0')
+   {
+      printf("cceWriteProfilerTrace:\nTrace isn't valid JSON, error before offset %zu\n", (end != NULL) ? (size_t)(end - json) : strlen(json));
+      goto END;
+   }
+   double outerStart, outerDuration, innerStart, innerDuration, siblingStart, siblingDuration;
+   const char *outerTail, *innerTail, *siblingTail;
+   if (!findZone(json, "\"outer\"", &outerStart, &outerDuration, &outerTail) ||
+       !findZone(json, "\"inner \\\"quoted\\\"\\u000a\"", &innerStart, &innerDuration, &innerTail) ||
+       !findZone(json, "\"sibling\"", &siblingStart, &siblingDuration, &siblingTail))
+   {
+      puts("cceWriteProfilerTrace:\nZones are missing from trace");
+      goto END;
+   }
+   if (!PROFILER_TEST_STARTS_WITH(innerTail, ",\"pid\":1,\"tid\":1,\"args\":{\"id\":7}}") || !PROFILER_TEST_STARTS_WITH(outerTail, ",\"pid\":1,\"tid\":1}"))
+   {
+      puts("cceWriteProfilerTrace:\nZone ids aren't written as arguments");
+      goto END;
+   }
+   if (innerStart < outerStart || innerStart + innerDuration > outerStart + outerDuration ||
+       siblingStart < innerStart + innerDuration || siblingStart + siblingDuration > outerStart + outerDuration)
+   {
+      printf("cceWriteProfilerTrace:\nZones aren't nested: outer %.3f+%.3f, inner %.3f+%.3f, sibling %.3f+%.3f\n",
+             outerStart, outerDuration, innerStart, innerDuration, siblingStart, siblingDuration);
+      goto END;
+   }
+   if (strstr(json, "\"beforeStart\"") != NULL || strstr(json, "\"afterStop\"") != NULL)
+   {
+      puts("cceWriteProfilerTrace:\nZones are recorded while profiling is stopped");
+      goto END;
+   }
+   uint32_t ringZones = 0;
+   for (const char *iterator = json; (iterator = strstr(iterator, "\"ring\"")) != NULL; ++iterator)
+      ++ringZones;
+   if (ringZones == 0 || ringZones >= PROFILER_TEST_RING_ZONES)
+   {
+      printf("cceWriteProfilerTrace:\n%u of %u zones are kept, ring buffer should keep the newest ones\n", ringZones, PROFILER_TEST_RING_ZONES);
+      goto END;
+   }
+   result = 1;
+
+END:
+   free(json);
+   free(path);
+   cceTerminateTemporaryDirectory();
+   return result;
+}
+
+#else
+
+uint8_t profilerTest (void)
+{
+   uint32_t runs = 0;
+   CCE_PROFILE_SCOPE("scope") ++runs;
+   CCE_PROFILE_SCOPE_ID("scopeWithId", 1u)
+   {
+      ++runs;
+   }
+   CCE_PROFILE_BEGIN(zone);
+   ++runs;
+   CCE_PROFILE_END(zone, "zone");
+   cceStartProfiling();
+   if (runs != 3u || cceWriteProfilerTrace("trace.json") != -1)
+   {
+      puts("cceWriteProfilerTrace:\nProfiler disabled at build time changes behaviour");
+      return 0;
+   }
+   cceStopProfiling();
+   return 1;
+}
+
+#endif // CCE_PROFILER
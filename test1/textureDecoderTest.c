@@ -0,0 +1,180 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cce/os_interaction.h>
+#include <cce/utils.h>
+#include <cce/plugins/map2D/map2D.h>
+
+/* Decoding pool is tested without engine initialization: images are written as binary PPM into temporary directory */
+
+#define DECODER_TEST_IMAGES 12u
+#define DECODER_TEST_MISSING DECODER_TEST_IMAGES // ID of file which does not exist
+
+static struct cce_u8vec4 expectedPixel (uint32_t image, uint32_t x, uint32_t y)
+{
+   return (struct cce_u8vec4){(uint8_t)(image * 20u + x), (uint8_t)(y * 7u), (uint8_t)(image ^ (x + y)), 255u};
+}
+
+static uint16_t imageWidth (uint32_t image)
+{
+   return image + 1u;
+}
+
+static uint16_t imageHeight (uint32_t image)
+{
+   return image % 3u + 1u;
+}
+
+static void imagePath (char *buffer, size_t bufferSize, const char *directory, uint32_t image)
+{
+   snprintf(buffer, bufferSize, "%s%ctex%u.ppm", directory, cceNativePathDelimiter, image);
+}
+
+static uint8_t writeImage (const char *path, uint32_t image)
+{
+   FILE *file = fopen(path, "wb");
+   if (file == NULL)
+      return 0u;
+   fprintf(file, "P6\n%u %u\n255\n", imageWidth(image), imageHeight(image));
+   for (uint32_t y = 0; y < imageHeight(image); ++y)
+   {
+      for (uint32_t x = 0; x < imageWidth(image); ++x)
+      {
+         const struct cce_u8vec4 pixel = expectedPixel(image, x, y);
+         fwrite(&pixel, 1u, 3u, file);
+      }
+   }
+   fclose(file);
+   return 1u;
+}
+
+static uint8_t checkDecoded (const struct cce_decodedtexture *texture)
+{
+   if (texture->userID == DECODER_TEST_MISSING)
+   {
+      if (texture->data == NULL)
+         return 1u;
+      printf("TEXTURE_DECODER_TEST::FAILED\nMissing file %s was decoded\n", texture->path);
+      return 0u;
+   }
+   if (texture->data == NULL || texture->width != imageWidth(texture->userID) || texture->height != imageHeight(texture->userID))
+   {
+      printf("TEXTURE_DECODER_TEST::FAILED\n%s is not decoded or has wrong size (%ux%u)\n", texture->path, texture->width, texture->height);
+      return 0u;
+   }
+   const struct cce_u8vec4 *pixels = texture->data;
+   for (uint32_t y = 0; y < texture->height; ++y)
+   {
+      for (uint32_t x = 0; x < texture->width; ++x)
+      {
+         const struct cce_u8vec4 expected = expectedPixel(texture->userID, x, y);
+         if (memcmp(pixels + y * texture->width + x, &expected, sizeof(struct cce_u8vec4)) != 0)
+         {
+            printf("TEXTURE_DECODER_TEST::FAILED\nPixel (%u, %u) of %s differs\n", x, y, texture->path);
+            return 0u;
+         }
+      }
+   }
+   return 1u;
+}
+
+static void queueImages (struct cce_texturedecoder *decoder, const char *directory)
+{
+   char path[512];
+   for (uint32_t i = 0; i <= DECODER_TEST_MISSING; ++i)
+   {
+      imagePath(path, sizeof(path), directory, i);
+      cceQueueTextureDecoding(decoder, path, i);
+   }
+}
+
+uint8_t textureDecoderTest (void)
+{
+   char *directory = cceGetTemporaryDirectory(0u);
+   if (directory == NULL)
+      return 0u;
+   char path[512];
+   for (uint32_t i = 0; i < DECODER_TEST_IMAGES; ++i)
+   {
+      imagePath(path, sizeof(path), directory, i);
+      if (!writeImage(path, i))
+      {
+         printf("TEXTURE_DECODER_TEST::FAILED\nfile at path %s cannot be created\n", path);
+         free(directory);
+         cceTerminateTemporaryDirectory();
+         return 0u;
+      }
+   }
+   uint8_t result = 1u;
+   struct cce_decodedtexture decoded[DECODER_TEST_IMAGES + 1u];
+   
+   // Single worker takes jobs in FIFO order, so completion order must match queueing order
+   struct cce_texturedecoder *decoder = cceCreateTextureDecoder(1u);
+   queueImages(decoder, directory);
+   cceWaitTextureDecoder(decoder);
+   uint32_t collected = cceCollectDecodedTextures(decoder, decoded, DECODER_TEST_IMAGES + 1u);
+   if (collected != DECODER_TEST_IMAGES + 1u || cceGetPendingTexturesQuantity(decoder) != 0u)
+   {
+      printf("TEXTURE_DECODER_TEST::FAILED\nExpected: %u decoded textures\nGot: %u\n", DECODER_TEST_IMAGES + 1u, collected);
+      result = 0u;
+   }
+   for (uint32_t i = 0; i < collected; ++i)
+   {
+      if (decoded[i].userID != i)
+      {
+         printf("TEXTURE_DECODER_TEST::FAILED\nCompletion order: expected %u at position %u, got %u\n", i, i, decoded[i].userID);
+         result = 0u;
+      }
+      result &= checkDecoded(decoded + i);
+      cceFreeDecodedTexture(decoded + i);
+   }
+   cceFreeTextureDecoder(decoder);
+   
+   // Several workers: any order, but every texture exactly once. Collected by polling, as map2D does every frame
+   decoder = cceCreateTextureDecoder(4u);
+   queueImages(decoder, directory);
+   uint32_t seen = 0u;
+   collected = 0u;
+   while (collected < DECODER_TEST_IMAGES + 1u)
+   {
+      uint32_t quantity = cceCollectDecodedTextures(decoder, decoded, 3u);
+      for (uint32_t i = 0; i < quantity; ++i)
+      {
+         if (decoded[i].userID > DECODER_TEST_MISSING || (seen & (1u << decoded[i].userID)))
+         {
+            printf("TEXTURE_DECODER_TEST::FAILED\nUnexpected or repeated texture %u\n", decoded[i].userID);
+            result = 0u;
+         }
+         else
+         {
+            seen |= 1u << decoded[i].userID;
+         }
+         result &= checkDecoded(decoded + i);
+         cceFreeDecodedTexture(decoded + i);
+      }
+      collected += quantity;
+      if (quantity == 0u)
+         cceWaitTextureDecoder(decoder);
+   }
+   cceFreeTextureDecoder(decoder);
+   
+   // Freeing with jobs still queued must not leak or hang
+   decoder = cceCreateTextureDecoder(2u);
+   queueImages(decoder, directory);
+   cceFreeTextureDecoder(decoder);
+   
+   free(directory);
+   cceTerminateTemporaryDirectory();
+   return result;
+}
@@ -11,6 +11,7 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <cce/engine_common.h>
 #include <cce/utils.h>
@@ -28,6 +29,16 @@ uint8_t utf8Test (void)
       printf("Expected: 0x%xu\nGot: 0x%xu\n", dollar, result1);
       return 0;
    }
+   // Every ASCII symbol (including 0x40-0x7F, which has 6-th bit set) is single byte
+   for (unsigned char ascii = 0x1; ascii < 0x80; ++ascii)
+   {
+      result1 = cceGetCharSizeUTF8(&ascii);
+      if (result1 != 1)
+      {
+         printf("Symbol 0x%x length:\nExpected: %u\nGot: %u\n", ascii, 1, result1);
+         return 0;
+      }
+   }
    // £ (U+00A3)
    unsigned char poundLE[2] = {0xc2, 0xa3}, poundBE[2] = {0xa3, 0xc2};
    result1 = cceGetCharSizeUTF8(poundLE);
@@ -116,3 +127,110 @@ uint8_t utf8Test (void)
    }
    return 1;
 }
+
+#define RANGE_TEST_SPACE 512
+
+static uint8_t checkRanges (const struct cce_rangearray *ranges, const uint8_t *added, uint32_t mergeGap)
+{
+   for (uint32_t i = 0; i < ranges->dataQuantity; ++i)
+   {
+      const struct cce_range *range = ranges->data + i;
+      // Merging must not extend range beyond what was added
+      if (range->begin >= range->end || !added[range->begin] || !added[range->end - 1])
+      {
+         printf("Range [%u, %u) has edges which were not added\n", range->begin, range->end);
+         return 0;
+      }
+      if (i > 0 && range->begin <= ranges->data[i - 1].end + mergeGap)
+      {
+         printf("Ranges [%u, %u) and [%u, %u) should have been merged (gap %u)\n", ranges->data[i - 1].begin, ranges->data[i - 1].end, range->begin, range->end, mergeGap);
+         return 0;
+      }
+   }
+   for (uint32_t position = 0, i = 0; position < RANGE_TEST_SPACE; ++position)
+   {
+      while (i < ranges->dataQuantity && ranges->data[i].end <= position)
+         ++i;
+      if (added[position] && (i >= ranges->dataQuantity || ranges->data[i].begin > position))
+      {
+         printf("Position %u was added, but is not covered by any range\n", position);
+         return 0;
+      }
+   }
+   return 1;
+}
+
+uint8_t rangeTest (void)
+{
+   struct cce_rangearray ranges = {NULL, 0, 0};
+   // Adjacent ranges are merged even without gap, disjoint are kept sorted
+   cceAddRange(&ranges, 10, 20, 0);
+   cceAddRange(&ranges, 30, 40, 0);
+   cceAddRange(&ranges, 0, 5, 0);
+   cceAddRange(&ranges, 20, 25, 0);
+   const struct cce_range expected[3] = {{0, 5}, {10, 25}, {30, 40}};
+   if (ranges.dataQuantity != 3 || memcmp(ranges.data, expected, sizeof(expected)) != 0)
+   {
+      printf("cceAddRange:\nExpected: 3 ranges [0, 5) [10, 25) [30, 40)\nGot: %u ranges\n", ranges.dataQuantity);
+      free(ranges.data);
+      return 0;
+   }
+   // Range covering several existing ones replaces them
+   if (cceAddRange(&ranges, 3, 31, 0) != 1 || ranges.data[0].begin != 0 || ranges.data[0].end != 40)
+   {
+      printf("cceAddRange:\nExpected: [0, 40)\nGot: %u ranges, first [%u, %u)\n", ranges.dataQuantity, ranges.data[0].begin, ranges.data[0].end);
+      free(ranges.data);
+      return 0;
+   }
+   // Randomized against coverage map, with and without gap
+   uint32_t random = 0x12345678u;
+   for (uint32_t mergeGap = 0; mergeGap < 16; mergeGap += 5)
+   {
+      uint8_t added[RANGE_TEST_SPACE] = {0};
+      ranges.dataQuantity = 0;
+      for (uint32_t i = 0; i < 200; ++i)
+      {
+         random ^= random << 13;
+         random ^= random >> 17;
+         random ^= random << 5;
+         uint32_t begin = random % RANGE_TEST_SPACE, end = CCE_MIN(begin + 1 + (random >> 16) % 8, RANGE_TEST_SPACE);
+         memset(added + begin, 1, end - begin);
+         cceAddRange(&ranges, begin, end, mergeGap);
+         if (!checkRanges(&ranges, added, mergeGap))
+         {
+            free(ranges.data);
+            return 0;
+         }
+      }
+   }
+   free(ranges.data);
+   return 1;
+}
+
+#define CRC_TEST_SIZE 1000u
+
+uint8_t crc32cTest (void)
+{
+   // Check value of CRC-32C, the same data passed in two blocks has to give the same result
+   const char check[] = "123456789";
+   uint32_t whole = cceCRC32C(0, check, 9), split = cceCRC32C(cceCRC32C(0, check, 4), check + 4, 5);
+   if (whole != 0xE3069283u || split != whole)
+   {
+      printf("cceCRC32C:\nExpected: E3069283 for \"123456789\"\nGot: %08X (%08X in two blocks)\n", whole, split);
+      return 0;
+   }
+   // Unaligned buffer longer than a word goes through wide steps of accelerated implementations, byte by byte it doesn't
+   uint8_t data[CRC_TEST_SIZE + 1];
+   for (uint32_t i = 0; i < CRC_TEST_SIZE + 1; ++i)
+      data[i] = (uint8_t)(i * 37u + (i >> 3));
+   uint32_t bytewise = 0;
+   for (uint32_t i = 1; i < CRC_TEST_SIZE + 1; ++i)
+      bytewise = cceCRC32C(bytewise, data + i, 1);
+   whole = cceCRC32C(0, data + 1, CRC_TEST_SIZE);
+   if (whole != bytewise)
+   {
+      printf("cceCRC32C:\nExpected: %08X (computed byte by byte)\nGot: %08X\n", bytewise, whole);
+      return 0;
+   }
+   return 1;
+}
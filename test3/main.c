@@ -0,0 +1,953 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+
+   This file is part of Conservative Creator's Engine.
+
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cce/engine_common.h>
+#include <cce/engine_common_keyboard.h>
+#include <cce/engine_common_null.h>
+#include <cce/engine_common_IO.h>
+#include <cce/plugins/actions.h>
+#include <cce/plugins/map2D/map2D.h>
+#include <cce/os_interaction.h>
+#include <cce/replay.h>
+
+/* Headless rendering with software renderer, frame is compared with expected pixels */
+
+#define RESOLUTION 32
+
+struct expectedpixel
+{
+   uint8_t x, y;
+   struct cce_u8vec4 color;
+};
+
+static int checkFrame (const struct expectedpixel *expected, size_t expectedQuantity, const char *frameName)
+{
+   const struct cce_u8vec4 *framebuffer = cceGetMap2DFramebuffer();
+   if (framebuffer == NULL)
+   {
+      fputs("Software renderer is not used\n", stderr);
+      return -1;
+   }
+   int result = 0;
+   for (const struct expectedpixel *iterator = expected, *end = expected + expectedQuantity; iterator < end; ++iterator)
+   {
+      const struct cce_u8vec4 pixel = framebuffer[iterator->y * RESOLUTION + iterator->x];
+      if (memcmp(&pixel, &iterator->color, sizeof(struct cce_u8vec4)) != 0)
+      {
+         fprintf(stderr, "%s: pixel (%u, %u) is %u %u %u %u, expected %u %u %u %u\n", frameName, iterator->x, iterator->y, pixel.x, pixel.y, pixel.z, pixel.w,
+                 iterator->color.x, iterator->color.y, iterator->color.z, iterator->color.w);
+         result = -1;
+      }
+   }
+   return result;
+}
+
+#define ROUND_TRIP_POSITIONS 256u
+
+/* Compressed dynamic map is written and loaded back as static one (memory mapped), element arrays have to stay identical */
+static int mapRoundTrip (void)
+{
+   struct cce_buffer *map = cceCreateMap2Ddynamic();
+   struct cce_element elements[] =
+   {
+      {{-4, -4}, {.rgba = {255, 0, 0, 255}}, {2, 1}, 0, 0,  0},
+      {{ 2,  2}, {.rgba = {0, 0, 255, 128}}, {2, 2}, 0, 64, CCE_ELEMENT_IGNORE_CAMERA},
+   };
+   struct cce_elementposition *positions = cceGetElementsPosition(0, 0, ROUND_TRIP_POSITIONS, map);
+   for (uint16_t i = 0; i < ROUND_TRIP_POSITIONS; ++i)
+      positions[i] = (struct cce_elementposition){{(int16_t)(i % 16), (int16_t)(i / 16)}, (uint16_t)(i % 2 + 1), 0, 0};
+   memcpy(cceGetElements(0, 2, map), elements, 2 * sizeof(struct cce_element));
+   
+   char *path = cceGetTemporaryDirectory(sizeof("/roundtrip.c2m"));
+   strcat(path, "/roundtrip.c2m");
+   cceSetMap2Dcompression(CCE_CCF_CODEC_LZ);
+   cceSetMap2Dchecksums(CCE_CCF_WRITE_CHECKSUMS | CCE_CCF_VERIFY_CHECKSUMS);
+   int result = cceWriteMap2Ddynamic(map, path);
+   cceSetMap2Dcompression(CCE_CCF_CODEC_NONE);
+   struct cce_buffer *loaded = (result == 0) ? cceLoadMap2D(path) : NULL;
+   if (loaded == NULL || loaded->sectionsQuantity < 2)
+   {
+      fputs("Round trip: map can't be written or loaded\n", stderr);
+      result = -1;
+      goto END;
+   }
+   {
+      FILE *file = fopen(path, "rb");
+      fseek(file, 0, SEEK_END);
+      long fileSize = ftell(file);
+      fclose(file);
+      if (fileSize >= (long)(ROUND_TRIP_POSITIONS * sizeof(struct cce_elementposition)))
+      {
+         fprintf(stderr, "Round trip: %ld bytes written, positions aren't compressed\n", fileSize);
+         result = -1;
+      }
+   }
+   struct cce_renderinginfo *info = cceGetRenderingInfo(loaded);
+   if (info->layersQuantity != 1 || info->positions[0].dataQuantity != ROUND_TRIP_POSITIONS ||
+       memcmp(info->positions[0].data, positions, ROUND_TRIP_POSITIONS * sizeof(struct cce_elementposition)) != 0)
+   {
+      fputs("Round trip: element positions differ\n", stderr);
+      result = -1;
+   }
+   if (info->elementsQuantity != 2 || memcmp(info->elements, elements, sizeof(elements)) != 0)
+   {
+      fputs("Round trip: elements differ\n", stderr);
+      result = -1;
+   }
+   {
+      // Changed byte has to be caught by section checksum, so loading gives either NULL or the fallback map
+      cceFreeMap2D(loaded); // Mapping is released, so the file can be modified on every platform
+      loaded = NULL;
+      FILE *file = fopen(path, "rb+");
+      fseek(file, -1, SEEK_END);
+      int byte = fgetc(file);
+      fseek(file, -1, SEEK_END);
+      fputc(byte ^ 0x1, file);
+      fclose(file);
+      struct cce_buffer *corrupted = cceLoadMap2D(path);
+      if (corrupted != NULL && cceGetRenderingInfo(corrupted)->positions[0].dataQuantity == ROUND_TRIP_POSITIONS)
+      {
+         fputs("Round trip: corrupted map is loaded\n", stderr);
+         result = -1;
+      }
+      cceFreeMap2D(corrupted);
+   }
+END:
+   cceSetMap2Dchecksums(0);
+   cceFreeMap2D(loaded);
+   cceFreeMap2Ddynamic(map);
+   remove(path);
+   free(path);
+   return result;
+}
+
+// Custom resource stored after textures: its single name is read back into its own buffer, textures stay untouched
+static char g_resourceName[] = "roundtrip";
+
+static int loadTagResource (void *buffer, struct cce_buffer *info, char **names)
+{
+   CCE_UNUSED(info);
+   *(uint32_t*) buffer = (names[0] != NULL && strcmp(names[0], g_resourceName) == 0 && names[1] == NULL) ? 0xC0FFEEu : 0u;
+   return 0;
+}
+
+static void createTagResource (void *buffer, struct cce_buffer *info)
+{
+   CCE_UNUSED(info);
+   *(uint32_t*) buffer = 0u;
+}
+
+static void freeTagResource (void *buffer, struct cce_buffer *info)
+{
+   CCE_UNUSED(buffer);
+   CCE_UNUSED(info);
+}
+
+static char** storeTagResource (void *buffer, struct cce_buffer *info)
+{
+   CCE_UNUSED(info);
+   char **names = malloc(2 * sizeof(char*));
+   names[0] = (*(uint32_t*) buffer != 0u) ? g_resourceName : NULL;
+   names[1] = NULL;
+   return names;
+}
+
+/* Dynamic map with two layers, two textures and a custom resource is written and loaded back as dynamic one.
+ * Textured element refers to the texture which is the second one once the list is sorted by path */
+static int mapDynamicRoundTrip (void)
+{
+   cceRegisterMapCustomResourceCallback(loadTagResource, freeTagResource, createTagResource, storeTagResource, sizeof(uint32_t));
+   struct cce_buffer *map = cceCreateMap2Ddynamic();
+   const uint16_t textures[2] = {cceLoadTexture("rtb.png", 1), cceLoadTexture("rta.png", 1)};
+   {
+      struct cce_usedtexinfo *usedTextures = cceGetResource(0, map);
+      usedTextures->texturesMapDependsOn = malloc(sizeof(textures));
+      memcpy(usedTextures->texturesMapDependsOn, textures, sizeof(textures));
+      usedTextures->texturesMapDependsOnQuantity = usedTextures->texturesMapDependsOnAllocated = 2;
+      *(uint32_t*) cceGetResource(1, map) = 0xC0FFEEu;
+   }
+   struct cce_element elements[] =
+   {
+      {{0, 0}, {.rgba = {255, 0, 0, 255}}, {1, 1}, 0,           0, 0},
+      {{1, 1}, {.texturePosition = {4, 8}}, {2, 2}, textures[0], 0, 0},
+   };
+   memcpy(cceGetElements(0, 2, map), elements, sizeof(elements));
+   // Layers have different sizes, so reading them in wrong order or with wrong quantities shows up
+   const uint16_t layerSizes[2] = {3, 5};
+   for (uint8_t layer = 0; layer < 2; ++layer)
+   {
+      struct cce_elementposition *positions = cceGetElementsPosition(layer, 0, layerSizes[layer], map);
+      for (uint16_t i = 0; i < layerSizes[layer]; ++i)
+         positions[i] = (struct cce_elementposition){{(int16_t) i, (int16_t) layer}, (uint16_t)(i % 2 + 1), (uint8_t)(layer + 1), (uint8_t) i};
+   }
+
+   char *path = cceGetTemporaryDirectory(sizeof("/roundtrip_dynamic.c2m"));
+   strcat(path, "/roundtrip_dynamic.c2m");
+   int result = cceWriteMap2Ddynamic(map, path);
+   {
+      // Without compression and checksums the map keeps legacy header, it begins with sections quantity
+      FILE *file = fopen(path, "rb");
+      int headSize = (file != NULL) ? fgetc(file) : EOF;
+      if (file != NULL)
+         fclose(file);
+      if (headSize != 2)
+      {
+         fprintf(stderr, "Dynamic round trip: header begins with %d instead of legacy sections quantity\n", headSize);
+         result = -1;
+      }
+   }
+   struct cce_buffer *loaded = (result == 0) ? cceLoadMap2Ddynamic(path) : NULL;
+   if (loaded == NULL || loaded->sectionsQuantity < 2)
+   {
+      fputs("Dynamic round trip: map can't be written or loaded\n", stderr);
+      result = -1;
+      goto END;
+   }
+   const struct cce_dynamicrenderinginfo *info = cceGetDynamicRenderingInfo(loaded), *original = cceGetDynamicRenderingInfo(map);
+   if (info->layersQuantity != 2)
+   {
+      fprintf(stderr, "Dynamic round trip: %u layers are loaded\n", info->layersQuantity);
+      result = -1;
+      goto END;
+   }
+   for (uint8_t layer = 0; layer < 2; ++layer)
+   {
+      if (info->positions[layer].dataQuantity != layerSizes[layer] ||
+          memcmp(info->positions[layer].data, original->positions[layer].data, layerSizes[layer] * sizeof(struct cce_elementposition)) != 0)
+      {
+         fprintf(stderr, "Dynamic round trip: positions of layer %u differ\n", layer);
+         result = -1;
+      }
+   }
+   if (info->elementsQuantity != 2 || memcmp(info->elements, elements, sizeof(elements)) != 0)
+   {
+      fputs("Dynamic round trip: elements or their textures differ\n", stderr);
+      result = -1;
+   }
+   {
+      const struct cce_usedtexinfo *usedTextures = cceGetResource(0, loaded);
+      if (usedTextures->texturesMapDependsOnQuantity != 2 || *(uint32_t*) cceGetResource(1, loaded) != 0xC0FFEEu)
+      {
+         fprintf(stderr, "Dynamic round trip: %u textures are loaded, custom resource is %s\n", usedTextures->texturesMapDependsOnQuantity,
+                 (*(uint32_t*) cceGetResource(1, loaded) != 0xC0FFEEu) ? "lost" : "kept");
+         result = -1;
+      }
+   }
+   {
+      // Uncompressed rendering data is read from the mapping, single byte fields of positions must come through as they are
+      struct cce_buffer *mapped = cceLoadMap2D(path);
+      const struct cce_renderinginfo *mappedInfo = (mapped != NULL) ? cceGetRenderingInfo(mapped) : NULL;
+      if (mappedInfo == NULL || mappedInfo->layersQuantity != 2)
+      {
+         fputs("Mapped round trip: map can't be loaded\n", stderr);
+         result = -1;
+      }
+      else
+      {
+         for (uint8_t layer = 0; layer < 2; ++layer)
+         {
+            if (mappedInfo->positions[layer].dataQuantity != layerSizes[layer] ||
+                memcmp(mappedInfo->positions[layer].data, original->positions[layer].data, layerSizes[layer] * sizeof(struct cce_elementposition)) != 0)
+            {
+               fprintf(stderr, "Mapped round trip: positions of layer %u differ\n", layer);
+               result = -1;
+            }
+         }
+         if (mappedInfo->elementsQuantity != 2 || memcmp(mappedInfo->elements, elements, sizeof(elements)) != 0)
+         {
+            fputs("Mapped round trip: elements or their textures differ\n", stderr);
+            result = -1;
+         }
+      }
+      cceFreeMap2D(mapped);
+   }
+END:
+   cceFreeMap2Ddynamic(loaded);
+   cceFreeMap2Ddynamic(map);
+   remove(path);
+   free(path);
+   return result;
+}
+
+#define TEXTURE_TABLE_PATHS 200u
+
+// Dynamic map releases every texture it depends on once when it's freed
+static void releaseTextures (const uint16_t *textures, uint16_t quantity)
+{
+   struct cce_buffer *map = cceCreateMap2Ddynamic();
+   struct cce_usedtexinfo *usedTextures = cceGetResource(0, map);
+   usedTextures->texturesMapDependsOn = malloc(quantity * sizeof(uint16_t));
+   memcpy(usedTextures->texturesMapDependsOn, textures, quantity * sizeof(uint16_t));
+   usedTextures->texturesMapDependsOnQuantity = usedTextures->texturesMapDependsOnAllocated = quantity;
+   cceFreeMap2Ddynamic(map);
+}
+
+// Loading with 0 users finds texture without changing its reference count
+static int checkTexturesFound (const uint16_t *textures, const uint8_t *released, const char *stage)
+{
+   char path[32];
+   for (uint16_t i = 0; i < TEXTURE_TABLE_PATHS; ++i)
+   {
+      snprintf(path, sizeof(path), "table/%u.png", i);
+      if (released[i] || cceLoadTexture(path, 0) == textures[i])
+         continue;
+      fprintf(stderr, "Texture table: %s is lost %s\n", path, stage);
+      return -1;
+   }
+   return 0;
+}
+
+static int checkTextureTable (void)
+{
+   // Table starts with 64 buckets and is grown at 1/2 load, so 200 paths grow it twice and leave long probe chains to delete from
+   uint16_t textures[TEXTURE_TABLE_PATHS], releasedTextures[TEXTURE_TABLE_PATHS / 3u], reused[TEXTURE_TABLE_PATHS / 3u];
+   uint8_t released[TEXTURE_TABLE_PATHS] = {0};
+   uint16_t releasedQuantity = 0;
+   char path[32];
+   int result = 0;
+   for (uint16_t i = 0; i < TEXTURE_TABLE_PATHS; ++i)
+   {
+      snprintf(path, sizeof(path), "table/%u.png", i);
+      textures[i] = cceLoadTexture(path, 1);
+      for (uint16_t j = 0; j < i; ++j)
+      {
+         if (textures[j] != textures[i])
+            continue;
+         fprintf(stderr, "Texture table: table/%u.png and %s share texture %u\n", j, path, textures[i]);
+         result = -1;
+      }
+   }
+   if (result != 0 || checkTexturesFound(textures, released, "after growth") != 0)
+      return -1;
+   // Repeated path adds a user, so it takes two releases to free the texture
+   snprintf(path, sizeof(path), "table/%u.png", 1u);
+   if (cceLoadTexture(path, 1) != textures[1])
+   {
+      fputs("Texture table: repeated path gives another texture\n", stderr);
+      return -1;
+   }
+   releaseTextures(textures + 1, 1);
+   if (checkTexturesFound(textures, released, "after one of two users is released") != 0)
+      return -1;
+   // The last texture would be trimmed instead of leaving a free slot, so it's kept
+   for (uint16_t i = 1; i < TEXTURE_TABLE_PATHS - 1u; i += 3)
+   {
+      released[i] = 1;
+      releasedTextures[releasedQuantity++] = textures[i];
+   }
+   releaseTextures(releasedTextures, releasedQuantity);
+   if (checkTexturesFound(textures, released, "after its neighbours are removed") != 0)
+      return -1;
+   // New paths take the freed slots before the array grows
+   for (uint16_t i = 0; i < releasedQuantity; ++i)
+   {
+      snprintf(path, sizeof(path), "table/new%u.png", i);
+      reused[i] = cceLoadTexture(path, 1);
+      uint8_t isFreedSlot = 0;
+      for (uint16_t j = 0; j < releasedQuantity; ++j)
+         isFreedSlot |= (reused[i] == releasedTextures[j]);
+      for (uint16_t j = 0; j < i; ++j)
+         isFreedSlot &= (reused[i] != reused[j]);
+      if (!isFreedSlot)
+      {
+         fprintf(stderr, "Texture table: %s got texture %u instead of a freed one\n", path, reused[i]);
+         result = -1;
+      }
+      if (cceLoadTexture(path, 0) != reused[i])
+      {
+         fprintf(stderr, "Texture table: %s is lost after it's added\n", path);
+         result = -1;
+      }
+   }
+   if (checkTexturesFound(textures, released, "after freed slots are reused") != 0)
+      result = -1;
+   releaseTextures(reused, releasedQuantity);
+   for (uint16_t i = 0, kept = 0; i < TEXTURE_TABLE_PATHS; ++i)
+   {
+      if (!released[i])
+         textures[kept++] = textures[i];
+   }
+   releaseTextures(textures, TEXTURE_TABLE_PATHS - releasedQuantity);
+   return result;
+}
+
+static int emptyInit (void *data)
+{
+   CCE_UNUSED(data);
+   return 0;
+}
+
+// Backend registers first and map2D after it, every stage of both has to be measured. Map2D waits for plugin registered after it
+static int checkPluginStats (void)
+{
+   uint16_t quantity;
+   const struct cce_pluginstats *stats = cceGetPluginStats(&quantity);
+   const struct cce_pluginstats *map2D = NULL, *mapDependency = NULL;
+   for (uint16_t i = 0; i < quantity; ++i)
+   {
+      if (stats[i].uid == cceNameToUID("map2d"))
+         map2D = stats + i;
+      else if (stats[i].uid == cceNameToUID("mapdep"))
+         mapDependency = stats + i;
+   }
+   if (quantity < 2u || map2D == NULL)
+   {
+      printf("Plugin stats:\n%u plugins are reported, map2D is %s\n", (unsigned) quantity, (map2D == NULL) ? "missing" : "present");
+      return -1;
+   }
+   if (stats[0].order[CCE_PLUGIN_STAGE_INIT] != 0 || map2D->order[CCE_PLUGIN_STAGE_INIT] == CCE_PLUGIN_STAGE_NOT_RUN ||
+       map2D->order[CCE_PLUGIN_STAGE_INIT] == 0 || map2D->order[CCE_PLUGIN_STAGE_POSTINIT] != CCE_PLUGIN_STAGE_NOT_RUN ||
+       map2D->order[CCE_PLUGIN_STAGE_TERMINATE] == CCE_PLUGIN_STAGE_NOT_RUN || map2D->iniKeys != 4u || stats[0].iniKeys != 1u)
+   {
+      puts("Plugin stats:\nInitialization order, stages run or ini keys quantity are wrong");
+      return -1;
+   }
+   if (map2D->timeNs[CCE_PLUGIN_STAGE_INIT] == 0 || map2D->timeNs[CCE_PLUGIN_STAGE_INI_CALLBACK] == 0)
+   {
+      puts("Plugin stats:\nTime of map2D stages isn't measured");
+      return -1;
+   }
+   if (mapDependency == NULL || mapDependency->order[CCE_PLUGIN_STAGE_INIT] >= map2D->order[CCE_PLUGIN_STAGE_INIT])
+   {
+      puts("Plugin dependencies:\nMap2D is initialized before plugin it depends on");
+      return -1;
+   }
+   return 0;
+}
+
+#define UPDATE_POSITIONS 0x1u
+#define UPDATE_BOUNDS    0x2u
+#define UPDATE_SOUND     0x4u
+
+static struct
+{
+   uint32_t positions, bounds, sound, checks;
+   uint8_t  failed;
+}
+g_update;
+
+static void movePositions (void)
+{
+   ++g_update.positions;
+}
+
+static void updateBounds (void)
+{
+   g_update.bounds = g_update.positions * 2u;
+}
+
+static void playSound (void)
+{
+   ++g_update.sound;
+}
+
+static void checkUpdate (void)
+{
+   g_update.failed |= (g_update.bounds != g_update.positions * 2u || g_update.sound != g_update.positions);
+   ++g_update.checks;
+}
+
+// Bounds read what positions write, so they wait for them, sound runs alongside both. Ordinary callback sees every result
+static int checkParallelUpdateCallbacks (void)
+{
+   const uint16_t callbacks[] =
+   {
+      cceRegisterParallelUpdateCallback(movePositions, 0, UPDATE_POSITIONS),
+      cceRegisterParallelUpdateCallback(updateBounds, UPDATE_POSITIONS, UPDATE_BOUNDS),
+      cceRegisterParallelUpdateCallback(playSound, 0, UPDATE_SOUND),
+      cceRegisterUpdateCallback(checkUpdate),
+   };
+   for (uint8_t i = 0; i < 3u; ++i)
+      cceUpdate();
+   for (uint8_t i = 0; i < CCE_STATIC_ARRAY_LENGTH(callbacks); ++i)
+      cceDisableUpdateCallback(callbacks[i]);
+   if (g_update.failed || g_update.checks != 3u || g_update.positions != 3u)
+   {
+      printf("Parallel update callbacks:\nConflicting callbacks aren't ordered or some don't run (%u checks, %u updates)\n", g_update.checks, g_update.positions);
+      return -1;
+   }
+   return 0;
+}
+
+static struct
+{
+   uint64_t deltaTimeNs;
+   uint32_t ticks;
+   uint8_t  failed;
+}
+g_tick;
+
+static void countTick (void)
+{
+   ++g_tick.ticks;
+   g_tick.failed |= (cceGetFrameDeltaTimeNs() != g_tick.deltaTimeNs || cceGetTicksQuantity() == 0);
+}
+
+// Frame much longer than a tick runs as many ticks as the catch-up limit allows, each of them sees exactly one tick of time
+static int checkFixedTimestep (void)
+{
+   cceSetTickRate(1000u);
+   g_tick.deltaTimeNs = 1000000u;
+   const uint16_t callback = cceRegisterUpdateCallback(countTick);
+   const uint64_t start = cceGetMonotonicTimeNs();
+   while (cceGetMonotonicTimeNs() - start < 20000000u);
+   cceUpdate();
+   cceDisableUpdateCallback(callback);
+   const float interpolation = cceGetTickInterpolation();
+   const uint64_t frameDeltaTimeNs = cceGetFrameDeltaTimeNs();
+   cceSetTickRate(0);
+   if (g_tick.failed || g_tick.ticks != 5u || frameDeltaTimeNs != 5u * g_tick.deltaTimeNs || interpolation < 0.0f || interpolation >= 1.0f)
+   {
+      printf("Fixed timestep:\n%u ticks, %llu ns per frame and %.3f interpolation after 20 ms frame at 1000 ticks per second\n",
+             g_tick.ticks, (unsigned long long) frameDeltaTimeNs, interpolation);
+      return -1;
+   }
+   return 0;
+}
+
+// Press and release within one frame don't change buttons bitfield, but both have to be queued in order
+static int checkInputEvents (void)
+{
+   struct cce_inputevent events[8];
+   while (cceReadInputEvents(events, 8u) > 0);
+   const uint32_t frame = cceGetScriptedInputFrame();
+   const struct cce_scriptedinput input[] =
+   {
+      {frame, CCE_BUTTON_A,     CCE_SCRIPTED_INPUT_BUTTONS, 0},
+      {frame, 0,                CCE_SCRIPTED_INPUT_BUTTONS, 0},
+      {frame, (uint16_t) -5,    CCE_SCRIPTED_INPUT_AXIS,    1},
+      {frame, CCE_KEY_SPACE,    CCE_SCRIPTED_INPUT_KEY,     1},
+   };
+   const struct cce_inputevent expected[] =
+   {
+      {0,  1, 0,             CCE_INPUT_EVENT_BUTTON, 1},
+      {0,  0, 0,             CCE_INPUT_EVENT_BUTTON, 1},
+      {0, -5, 1,             CCE_INPUT_EVENT_AXIS,   1},
+      {0,  1, CCE_KEY_SPACE, CCE_INPUT_EVENT_KEY,    CCE_INPUT_KEYBOARD},
+   };
+   cceSetScriptedInput(input, CCE_STATIC_ARRAY_LENGTH(input));
+   cceUpdate();
+   cceSetScriptedInput(NULL, 0);
+   const uint32_t quantity = cceReadInputEvents(events, 8u);
+   uint8_t matches = (quantity == CCE_STATIC_ARRAY_LENGTH(expected));
+   for (uint32_t i = 0; i < quantity && matches; ++i)
+   {
+      matches = events[i].value == expected[i].value && events[i].code == expected[i].code && events[i].type == expected[i].type &&
+                events[i].gamepad == expected[i].gamepad && events[i].timeNs > 0 && (i == 0 || events[i].timeNs >= events[i - 1].timeNs);
+   }
+   if (!matches || cceReadInputEvents(events, 8u) != 0)
+   {
+      printf("Input events:\n%u events are queued instead of %u, or they differ from scripted input\n", quantity, (unsigned)(CCE_STATIC_ARRAY_LENGTH(expected)));
+      return -1;
+   }
+   return 0;
+}
+
+static struct
+{
+   uint32_t crc;
+   uint32_t frames;
+   uint8_t  playing;
+}
+g_replay;
+
+static void hashReplayButtons (uint16_t buttonState, uint16_t diff)
+{
+   const uint16_t buttons[2] = {buttonState, diff};
+   g_replay.crc = cceCRC32C(g_replay.crc, buttons, sizeof(buttons));
+}
+
+// Frame after the end of the log runs with live input again, so it isn't hashed
+static void hashReplayFrame (void)
+{
+   if (g_replay.playing && !cceIsPlayingBack())
+      return;
+   struct cce_inputevent events[8];
+   const uint64_t deltaTimeNs = cceGetFrameDeltaTimeNs();
+   g_replay.crc = cceCRC32C(g_replay.crc, &deltaTimeNs, sizeof(deltaTimeNs));
+   for (uint32_t quantity; (quantity = cceReadInputEvents(events, 8u)) > 0;)
+   {
+      for (uint32_t i = 0; i < quantity; ++i)
+      {
+         const int64_t event[5] = {(int64_t) events[i].timeNs, events[i].value, events[i].code, events[i].type, events[i].gamepad};
+         g_replay.crc = cceCRC32C(g_replay.crc, event, sizeof(event));
+      }
+   }
+   if (g_replay.frames % 3u == 0)
+   {
+      uint32_t seed;
+      cceGetRandomSeed(&seed, sizeof(seed));
+      g_replay.crc = cceCRC32C(g_replay.crc, &seed, sizeof(seed));
+   }
+   ++g_replay.frames;
+}
+
+// Played back frames have to see the same time, input and seeds as recorded ones, though they run without waiting
+static int checkReplay (void)
+{
+   const char *fileName = "replay.ccer";
+   char *path = cceGetTemporaryDirectory(strlen(fileName) + 1u);
+   cceAppendPath(path, strlen(path) + strlen(fileName) + 2u, fileName);
+   const uint16_t callback = cceRegisterUpdateCallback(hashReplayFrame);
+   cceSetButtonCallback(hashReplayButtons);
+   int result = -(cceStartRecording(path) != 0);
+   const uint32_t frame = cceGetScriptedInputFrame();
+   const struct cce_scriptedinput input[] =
+   {
+      {frame,      CCE_BUTTON_A,                CCE_SCRIPTED_INPUT_BUTTONS, 0},
+      {frame + 1u, (uint16_t) 100,              CCE_SCRIPTED_INPUT_AXIS,    0},
+      {frame + 1u, (uint16_t) -100,             CCE_SCRIPTED_INPUT_AXIS,    1},
+      {frame + 2u, CCE_BUTTON_A | CCE_BUTTON_B, CCE_SCRIPTED_INPUT_BUTTONS, 0},
+      {frame + 3u, CCE_KEY_SPACE,               CCE_SCRIPTED_INPUT_KEY,     1},
+      {frame + 4u, CCE_KEY_SPACE,               CCE_SCRIPTED_INPUT_KEY,     0},
+      {frame + 5u, 0,                           CCE_SCRIPTED_INPUT_BUTTONS, 0},
+      {frame + 5u, 0,                           CCE_SCRIPTED_INPUT_AXIS,    0},
+   };
+   cceSetScriptedInput(input, CCE_STATIC_ARRAY_LENGTH(input));
+   for (uint8_t i = 0; i < 8u; ++i)
+   {
+      const uint64_t start = cceGetMonotonicTimeNs();
+      while (cceGetMonotonicTimeNs() - start < i * 100000u);
+      cceUpdate();
+   }
+   cceSetScriptedInput(NULL, 0);
+   cceStopRecording();
+   const uint32_t recordedCRC = g_replay.crc, recordedFrames = g_replay.frames;
+   g_replay.crc = 0;
+   g_replay.frames = 0;
+   g_replay.playing = 1;
+   result |= -(cceStartPlayback(path) != 0);
+   for (uint8_t i = 0; i < 16u && cceIsPlayingBack(); ++i)
+      cceUpdate();
+   cceDisableUpdateCallback(callback);
+   cceSetButtonCallback(NULL);
+   if (result != 0 || cceIsPlayingBack() || g_replay.crc != recordedCRC || g_replay.frames != recordedFrames)
+   {
+      printf("Replay:\n%u of %u frames are played back, they %s the recorded ones\n", g_replay.frames, recordedFrames,
+             (g_replay.crc == recordedCRC) ? "match" : "differ from");
+      result = -1;
+   }
+   remove(path);
+   free(path);
+   return result;
+}
+
+static struct
+{
+   uint16_t buttons[CCE_GAMEPADS_MAX + 1u]; // 0 - merged ones
+   int8_t   stick[CCE_GAMEPADS_MAX + 1u][2];
+   uint8_t  connections[CCE_GAMEPADS_MAX + 1u];
+}
+g_gamepads;
+
+static void gamepadButtons (uint8_t gamepad, uint16_t buttonState, uint16_t diff)
+{
+   CCE_UNUSED(diff);
+   g_gamepads.buttons[gamepad] = buttonState;
+}
+
+static void gamepadStick (uint8_t gamepad, int8_t x, int8_t y)
+{
+   g_gamepads.stick[gamepad][0] = x;
+   g_gamepads.stick[gamepad][1] = y;
+}
+
+static void gamepadConnection (uint8_t gamepad, uint8_t connected)
+{
+   g_gamepads.connections[gamepad] = (uint8_t)(g_gamepads.connections[gamepad] << 1) | connected;
+}
+
+static void mergedButtons (uint16_t buttonState, uint16_t diff)
+{
+   gamepadButtons(0, buttonState, diff);
+}
+
+static void mergedStick (int8_t x, int8_t y)
+{
+   gamepadStick(0, x, y);
+}
+
+// Gamepad 2 has its own deadzone (0.05 in [Player2]), its physical input doesn't touch gamepad 1 and is released on disconnection.
+// Merged stick is the stronger one, so it falls back to gamepad 1 (moved by previous checks)
+static int checkGamepads (void)
+{
+   cceSetGamepadButtonCallback(gamepadButtons);
+   cceSetGamepadAxisChangeCallback(gamepadStick, CCE_AXISPAIR_LSTICK);
+   cceSetGamepadConnectionCallback(gamepadConnection);
+   cceSetButtonCallback(mergedButtons);
+   cceSetAxisChangeCallback(mergedStick, CCE_AXISPAIR_LSTICK);
+   const uint32_t frame = cceGetScriptedInputFrame();
+   const struct cce_scriptedinput input[] =
+   {
+      {frame,      1,                      CCE_SCRIPTED_INPUT_CONNECTION,      0, 2},
+      {frame,      INT16_MAX / 10,         CCE_SCRIPTED_INPUT_GAMEPAD_AXIS,    0, 2},
+      {frame,      INT16_MAX,              CCE_SCRIPTED_INPUT_GAMEPAD_AXIS,    1, 2},
+      {frame,      1,                      CCE_SCRIPTED_INPUT_GAMEPAD_BUTTONS, 0, 2},
+      {frame,      CCE_BUTTON_B,           CCE_SCRIPTED_INPUT_BUTTONS,         0, 1},
+      {frame + 1u, 0,                      CCE_SCRIPTED_INPUT_CONNECTION,      0, 2},
+      {frame + 1u, 0,                      CCE_SCRIPTED_INPUT_BUTTONS,         0, 1},
+   };
+   cceSetScriptedInput(input, CCE_STATIC_ARRAY_LENGTH(input));
+   cceUpdate();
+   int result = -(!cceIsGamepadConnected(2) || cceIsGamepadConnected(1) || cceGetGamepadButtons(2) != CCE_BUTTON_A ||
+                  cceGetGamepadButtons(1) != CCE_BUTTON_B || cceGetGamepadAxis(2, 0) != 6 || cceGetGamepadAxis(2, 1) != INT8_MAX ||
+                  g_gamepads.buttons[0] != (CCE_BUTTON_A | CCE_BUTTON_B) || g_gamepads.buttons[2] != CCE_BUTTON_A ||
+                  g_gamepads.stick[2][0] != 6 || g_gamepads.stick[0][1] != INT8_MAX || g_gamepads.stick[1][1] != 0);
+   cceUpdate();
+   cceSetScriptedInput(NULL, 0);
+   result |= -(cceIsGamepadConnected(2) || cceGetGamepadButtons(2) != 0 || cceGetGamepadAxis(2, 1) != 0 || g_gamepads.buttons[0] != 0 ||
+               g_gamepads.stick[0][0] != cceGetGamepadAxis(1, 0) || g_gamepads.stick[0][1] != cceGetGamepadAxis(1, 1) || g_gamepads.connections[2] != 0x2 || g_gamepads.connections[1] != 0);
+   cceSetGamepadButtonCallback(NULL);
+   cceSetGamepadAxisChangeCallback(NULL, CCE_AXISPAIR_LSTICK);
+   cceSetGamepadConnectionCallback(NULL);
+   cceSetButtonCallback(NULL);
+   cceSetAxisChangeCallback(NULL, CCE_AXISPAIR_LSTICK);
+   if (result != 0)
+   {
+      printf("Gamepads:\nGamepad 2 has %04x buttons, (%d, %d) stick and %x connections, merged ones are %04x and (%d, %d)\n", cceGetGamepadButtons(2),
+             cceGetGamepadAxis(2, 0), cceGetGamepadAxis(2, 1), g_gamepads.connections[2], g_gamepads.buttons[0], g_gamepads.stick[0][0], g_gamepads.stick[0][1]);
+   }
+   return result;
+}
+
+// Recording reports gamepads connected at its start. Playback stopped while gamepad 2 is pressed and connected in the log,
+// but unplugged physically, has to release and disconnect it instead of leaving the played back state
+static int checkReplayGamepads (void)
+{
+   const char *fileName = "gamepads.ccer";
+   char *path = cceGetTemporaryDirectory(strlen(fileName) + 1u);
+   cceAppendPath(path, strlen(path) + strlen(fileName) + 2u, fileName);
+   memset(&g_gamepads, 0, sizeof(g_gamepads));
+   cceSetGamepadButtonCallback(gamepadButtons);
+   cceSetGamepadConnectionCallback(gamepadConnection);
+   const uint32_t frame = cceGetScriptedInputFrame();
+   const struct cce_scriptedinput input[] =
+   {
+      {frame,      1, CCE_SCRIPTED_INPUT_CONNECTION,      0, 2},
+      {frame,      1, CCE_SCRIPTED_INPUT_GAMEPAD_BUTTONS, 0, 2},
+      {frame + 2u, 0, CCE_SCRIPTED_INPUT_CONNECTION,      0, 2},
+   };
+   cceSetScriptedInput(input, CCE_STATIC_ARRAY_LENGTH(input));
+   cceUpdate();
+   int result = -(cceStartRecording(path) != 0);
+   cceUpdate();
+   struct cce_inputevent events[8];
+   uint32_t quantity = cceReadInputEvents(events, 8u);
+   result |= -(quantity != 1u || events[0].type != CCE_INPUT_EVENT_CONNECTION || events[0].gamepad != 2u || events[0].value != 1);
+   cceUpdate();
+   cceStopRecording();
+   cceSetScriptedInput(NULL, 0);
+   result |= -(cceStartPlayback(path) != 0);
+   cceUpdate();
+   result |= -(!cceIsGamepadConnected(2) || cceGetGamepadButtons(2) != CCE_BUTTON_A);
+   cceStopPlayback();
+   cceUpdate();
+   while (cceReadInputEvents(events, 8u) > 0);
+   result |= -(cceIsGamepadConnected(2) || cceGetGamepadButtons(2) != 0 || g_gamepads.buttons[2] != 0 || g_gamepads.connections[2] != 0x1A);
+   cceSetGamepadButtonCallback(NULL);
+   cceSetGamepadConnectionCallback(NULL);
+   if (result != 0)
+   {
+      printf("Replay of gamepads:\nGamepad 2 has %04x buttons and %x connections after playback, connection is %s at the start of recording\n",
+             cceGetGamepadButtons(2), g_gamepads.connections[2], (quantity == 1u) ? "reported" : "not reported");
+   }
+   remove(path);
+   free(path);
+   return result;
+}
+
+static volatile uint8_t g_slowPluginInitialized, g_slowPluginSeen;
+
+static int slowInit (void *data)
+{
+   CCE_UNUSED(data);
+   const uint64_t start = cceGetMonotonicTimeNs();
+   while (cceGetMonotonicTimeNs() - start < 20000000u);
+   g_slowPluginInitialized = 1;
+   return 0;
+}
+
+static int seeSlowPlugin (void *data)
+{
+   CCE_UNUSED(data);
+   g_slowPluginSeen = g_slowPluginInitialized;
+   return 0;
+}
+
+// Plugin which declares no dependencies relies on registration order, thread-safe plugin registered before it has to be initialized first
+static int checkImplicitPluginOrder (void)
+{
+   g_slowPluginInitialized = g_slowPluginSeen = 0;
+   cceSetBackend("null");
+   cceRegisterPlugin(cceNameToUID("slow"), NULL, NULL, slowInit, NULL, NULL, CCE_INI_CALLBACK_THREAD_SAFE_INIT);
+   cceRegisterPlugin(cceNameToUID("after"), NULL, NULL, seeSlowPlugin, NULL, NULL, 0);
+   if (cceInit("test3/game.ini") != 0)
+   {
+      puts("Plugin dependencies:\nPlugins without dependencies aren't initialized");
+      return -1;
+   }
+   cceTerminate();
+   if (!g_slowPluginSeen)
+   {
+      puts("Plugin dependencies:\nPlugin is initialized before thread-safe plugin registered before it");
+      return -1;
+   }
+   return 0;
+}
+
+// Precise map time advances by the nanosecond frame delta exactly, the default one by the millisecond delta. Millisecond deltas sum up
+// to the millisecond frame time, which stays within a millisecond of the nanosecond one
+static int checkMapTime (void)
+{
+   cceSetBackend("null");
+   cceaLoadActionsPlugin();
+   if (cceInit("test3/game.ini") != 0)
+   {
+      puts("Map time:\nEngine with actions plugin isn't initialized");
+      return -1;
+   }
+   const uint16_t functionSet = cceGetFileIOfunctionSet();
+   cceaRegisterActionsFileIOFunctions(functionSet);
+   struct cce_buffer *map = cceCreateBuffer(1, functionSet);
+   const uint64_t startNs = cceGetFrameCurrentTimeNs();
+   const uint32_t start = cceGetFrameCurrentTime();
+   uint64_t mapTimeNs = cceaGetMapTimeNs(map), deltaTimesNs = 0;
+   uint32_t deltaTimes = 0;
+   int result = 0;
+   for (uint8_t i = 0; i < 16u; ++i)
+   {
+      cceaSetPreciseTiming(i < 8u);
+      const uint64_t begin = cceGetMonotonicTimeNs();
+      while (cceGetMonotonicTimeNs() - begin < 300000u + i * 70000u);
+      cceUpdate();
+      cceaRunDelayedActions(map);
+      const uint64_t deltaTimeNs = cceGetFrameDeltaTimeNs(), currentMapTimeNs = cceaGetMapTimeNs(map);
+      const uint32_t deltaTime = cceGetFrameDeltaTime();
+      deltaTimesNs += deltaTimeNs;
+      deltaTimes += deltaTime;
+      result |= -(currentMapTimeNs - mapTimeNs != ((i < 8u) ? deltaTimeNs : deltaTime * 1000000ull));
+      result |= -(deltaTimesNs != cceGetFrameCurrentTimeNs() - startNs || deltaTimes != cceGetFrameCurrentTime() - start ||
+                  cceGetFrameCurrentTime() != (uint32_t)(cceGetFrameCurrentTimeNs() / 1000000u));
+      mapTimeNs = currentMapTimeNs;
+   }
+   cceaSetPreciseTiming(0);
+   cceFreeBuffer(map);
+   cceTerminate();
+   if (result != 0)
+   {
+      printf("Map time:\nMap time is %llu ns after frames of %llu ns (%u ms in total)\n", (unsigned long long) mapTimeNs,
+             (unsigned long long) deltaTimesNs, deltaTimes);
+   }
+   return result;
+}
+
+// Engine has to refuse initialization instead of hanging or initializing part of the plugins
+static int checkPluginDependencyCycle (void)
+{
+   const uint32_t first = cceNameToUID("cyclea"), second = cceNameToUID("cycleb");
+   cceSetBackend("null");
+   cceRegisterPlugin(first, NULL, NULL, emptyInit, NULL, NULL, CCE_INI_CALLBACK_THREAD_SAFE_INIT);
+   cceRegisterPlugin(second, NULL, NULL, emptyInit, NULL, NULL, 0);
+   cceSetPluginDependencies(first, &second, 1);
+   cceSetPluginDependencies(second, &first, 1);
+   if (cceInit("test3/game.ini") == 0)
+   {
+      puts("Plugin dependencies:\nPlugins which depend on each other are initialized");
+      cceTerminate();
+      return -1;
+   }
+   return 0;
+}
+
+int main (int argc, char **argv)
+{
+   if (argc >= 2)
+   {
+      if (argc > 2 || (argc == 2 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))))
+      {
+         printf("Usage: %s [PATH_TO_ENGINE_RESOURCES]\nWhen PATH_TO_ENGINE_RESOURCES is not provided, current directory is assumed.", argv[0]);
+         return -(argc > 2);
+      }
+      cceSetCurrentPath(argv[1]);
+   }
+   cceSetBackend("null");
+   cceLoadMap2Dplugin();
+   {
+      const uint32_t dependency = cceNameToUID("mapdep");
+      cceRegisterPlugin(dependency, NULL, NULL, emptyInit, NULL, NULL, CCE_INI_CALLBACK_THREAD_SAFE_INIT);
+      cceSetPluginDependencies(cceNameToUID("map2d"), &dependency, 1);
+   }
+   if (cceInit("test3/game.ini") != 0)
+   {
+      fputs("Initialization failure\n", stderr);
+      return -1;
+   }
+   struct cce_buffer *map = cceCreateMap2Ddynamic();
+   struct cce_elementposition positions[] =
+   {
+      {{0, 0}, 1, 0, 0},
+      {{0, 0}, 2, 0, 0},
+   };
+   struct cce_element elements[] =
+   {
+      {{-4, -4}, {.rgba = {255, 0, 0, 255}}, {2, 1}, 0, 0, 0},
+      {{ 2,  2}, {.rgba = {0, 0, 255, 128}}, {2, 2}, 0, 0, CCE_ELEMENT_IGNORE_CAMERA},
+   };
+   memcpy(cceGetElementsPosition(0, 0, 2, map), positions, 2 * sizeof(struct cce_elementposition));
+   memcpy(cceGetElements(0, 2, map),            elements,  2 * sizeof(struct cce_element));
+   cceSetElementsUpdated(cceGetRenderingInfo(map));
+   cceSetRenderingLayerMap2D(0, 0, map);
+   int result = 0;
+   {
+      // 2 pixels per coordinate, (0, 0) is at the center of the screen, y goes down
+      cceRenderMap2D();
+      const struct expectedpixel expected[] =
+      {
+         { 8,  8, {255, 0, 0, 255}}, {11,  9, {255, 0, 0, 255}}, {12,  8, {0, 0, 0, 0}}, { 8, 10, {0, 0, 0, 0}},
+         {20, 20, {0, 0, 128, 64}},  {23, 23, {0, 0, 128, 64}},  {24, 24, {0, 0, 0, 0}}, {19, 20, {0, 0, 0, 0}},
+      };
+      result |= checkFrame(expected, CCE_STATIC_ARRAY_LENGTH(expected), "Frame 1");
+   }
+   {
+      // Camera moves the first element only
+      cceSetCameraPosition((struct cce_i16vec2){4, 0});
+      cceGetElements(0, 1, map)->flags |= CCE_ELEMENT_FLIP_HORIZONTALLY;
+      cceSetElementsUpdated(cceGetRenderingInfo(map));
+      cceRenderMap2D();
+      const struct expectedpixel expected[] =
+      {
+         { 8,  8, {0, 0, 0, 0}},     {16,  8, {255, 0, 0, 255}}, {19,  9, {255, 0, 0, 255}}, {20,  8, {0, 0, 0, 0}},
+         {20, 20, {0, 0, 128, 64}},
+      };
+      result |= checkFrame(expected, CCE_STATIC_ARRAY_LENGTH(expected), "Frame 2");
+   }
+   cceFreeMap2Ddynamic(map);
+   result |= mapRoundTrip();
+   result |= mapDynamicRoundTrip();
+   result |= checkTextureTable();
+   result |= checkParallelUpdateCallbacks();
+   result |= checkFixedTimestep();
+   result |= checkInputEvents();
+   result |= checkReplay();
+   result |= checkGamepads();
+   result |= checkReplayGamepads();
+   cceTerminate();
+   result |= checkPluginStats();
+   result |= checkMapTime();
+   result |= checkImplicitPluginOrder();
+   result |= checkPluginDependencyCycle();
+   return result;
+}
@@ -0,0 +1,464 @@
+/*
+   Conservative Creator's Engine - open source engine for making games.
+   Copyright © 2020-2023 Andrey Gaivoronskiy
+   
+   This file is part of Conservative Creator's Engine.
+   
+   Copying and distribution of this file, with or without modification,
+   are permitted in any medium without royalty provided the copyright
+   notice and this notice are preserved.  This file is offered as-is,
+   without any warranty.
+*/
+
+/* cce-ccfcheck file...
+ * Validates CCF files (maps and anything else written by cceWriteBinaryCCF) without loading them into the engine: header,
+ * section bounds, checksums and compressed data, then contents of the sections defined by the engine itself (map resources,
+ * rendering data, actions). Every problem is printed, exit code is 0 only if all files are valid */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cce/compression.h>
+#include <cce/utils.h>
+#include <cce/plugins/actions.h>
+#include <cce/plugins/map2D/map2D.h>
+
+// Same values as in engine_common_file_IO.c and engine_common_IO.h
+#define CCF_VERSION 3u
+#define CCF_UNCHECKED_VERSION 2u
+#define CCF_CODEC_NONE 0u
+#define CCF_CODEC_LZ   1u
+
+struct ccf_section
+{
+   uint32_t uid;
+   uint32_t sectionSize; // Quantity of entries, meaning depends on section
+   uint32_t storedSize;
+   uint32_t rawSize;
+   uint32_t checksum;
+   uint8_t  codec;
+   const uint8_t *stored;
+};
+
+struct ccf_reader
+{
+   const uint8_t *position;
+   const uint8_t *end;
+   uint8_t failed;
+};
+
+struct ccf_context
+{
+   const char *path;
+   const char *section;
+   unsigned    errors;
+   uint32_t    texturesQuantity;
+   uint8_t     hasTextures;
+};
+
+static uint32_t g_resourcesUID, g_renderingUID, g_actionsUID, g_loadEventUID, g_delayedListUID;
+
+static void report (struct ccf_context *context, const char *format, ...)
+{
+   va_list args;
+   va_start(args, format);
+   fprintf(stderr, "%s: %s: ", context->path, context->section);
+   vfprintf(stderr, format, args);
+   fputc('\n', stderr);
+   va_end(args);
+   ++context->errors;
+}
+
+static const uint8_t* readBytes (struct ccf_reader *reader, uint64_t size)
+{
+   if (reader->failed || (uint64_t)(reader->end - reader->position) < size)
+   {
+      reader->failed = 1;
+      return NULL;
+   }
+   const uint8_t *result = reader->position;
+   reader->position += size;
+   return result;
+}
+
+// All fields are little-endian
+static uint32_t readUint32 (struct ccf_reader *reader)
+{
+   const uint8_t *bytes = readBytes(reader, sizeof(uint32_t));
+   return (bytes == NULL) ? 0 : bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+static uint16_t readUint16 (struct ccf_reader *reader)
+{
+   const uint8_t *bytes = readBytes(reader, sizeof(uint16_t));
+   return (bytes == NULL) ? 0 : (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+static uint16_t getUint16 (const uint8_t *bytes)
+{
+   return (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+static uint32_t getUint32 (const uint8_t *bytes)
+{
+   return bytes[0] | (uint32_t) bytes[1] << 8 | (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+static void checkResources (struct ccf_context *context, struct ccf_reader *reader, uint32_t sectionSize)
+{
+   const uint8_t *sizes = readBytes(reader, (uint64_t) sectionSize * sizeof(uint32_t));
+   if (sizes == NULL)
+      return;
+   for (uint32_t i = 0; i < sectionSize; ++i)
+   {
+      uint32_t size = getUint32(sizes + i * sizeof(uint32_t));
+      const uint8_t *names = readBytes(reader, size);
+      if (names == NULL)
+         return;
+      if (size > 0 && names[size - 1] != '\0')
+         report(context, "name list of resource %u is not terminated", i);
+      if (i != 0)
+         continue;
+      
+      // Resource 0 lists textures, rendering data refers to them by 1-based index
+      context->hasTextures = 1;
+      for (const uint8_t *iterator = names, *end = names + size; iterator < end; ++iterator)
+         context->texturesQuantity += (*iterator == '\0');
+   }
+}
+
+static void checkRendering (struct ccf_context *context, struct ccf_reader *reader, uint32_t sectionSize)
+{
+   if (sectionSize == 0)
+   {
+      report(context, "section has no layers");
+      return;
+   }
+   uint16_t elementsQuantity = readUint16(reader);
+   uint32_t elementsTotal = readUint32(reader);
+   const uint8_t *layers = readBytes(reader, (uint64_t) sectionSize * sizeof(uint32_t));
+   const uint8_t *elements = readBytes(reader, (uint64_t) elementsQuantity * sizeof(struct cce_element));
+   const uint8_t *positions = readBytes(reader, (uint64_t) elementsTotal * sizeof(struct cce_elementposition));
+   if (positions == NULL)
+      return;
+   
+   uint64_t sum = 0;
+   for (uint32_t i = 0; i < sectionSize; ++i)
+      sum += getUint32(layers + i * sizeof(uint32_t));
+   if (sum != elementsTotal)
+      report(context, "layers hold %llu positions, header of section says %u", (unsigned long long) sum, elementsTotal);
+   
+   uint32_t textures = context->hasTextures ? context->texturesQuantity : 0;
+   for (uint32_t i = 0; i < elementsQuantity; ++i)
+   {
+      uint16_t textureID = getUint16(elements + i * sizeof(struct cce_element) + offsetof(struct cce_element, textureID));
+      if (textureID > textures)
+         report(context, "element %u uses texture %u, map depends on %u textures", i, textureID, textures);
+   }
+   // Position with no element (ID 0) is skipped by renderers, the rest refer to elements by 1-based index
+   uint32_t invalidPositions = 0, firstInvalid = 0;
+   for (uint32_t i = 0; i < elementsTotal; ++i)
+   {
+      uint16_t elementID = getUint16(positions + i * sizeof(struct cce_elementposition) + offsetof(struct cce_elementposition, textureDataID));
+      if (elementID > elementsQuantity && invalidPositions++ == 0)
+         firstInvalid = i;
+   }
+   if (invalidPositions > 0)
+      report(context, "%u positions (first: %u) refer to elements past %u", invalidPositions, firstInvalid, elementsQuantity);
+}
+
+// Actions themselves are registered by the game, so only sizes of the lists they are stored in can be checked
+static void checkActions (struct ccf_context *context, struct ccf_reader *reader, uint32_t sectionSize)
+{
+   readUint32(reader); // Map time
+   const uint8_t *events = readBytes(reader, (uint64_t) sectionSize * sizeof(uint32_t));
+   if (events == NULL)
+      return;
+   for (uint32_t i = 0; i < sectionSize; ++i)
+   {
+      uint32_t uid = getUint32(events + i * sizeof(uint32_t));
+      for (uint32_t j = 0; j < i; ++j)
+      {
+         if (getUint32(events + j * sizeof(uint32_t)) == uid)
+            report(context, "event %s (uid: %u) is listed twice", cceUIDToName(uid), uid);
+      }
+   }
+   for (uint32_t i = 0; i < sectionSize; ++i)
+      readBytes(reader, (uint64_t) readUint32(reader) * sizeof(uint32_t));
+   for (uint32_t i = 0; i < sectionSize; ++i)
+   {
+      uint32_t size = readUint32(reader);
+      const uint8_t *actions = readBytes(reader, size);
+      if (actions == NULL)
+         return;
+      if (size > 0 && size < sizeof(uint32_t))
+         report(context, "actions of event %u take %u bytes, less than one action", i, size);
+      // Delayed actions of saved map are stored as the first action of load event
+      if (getUint32(events + i * sizeof(uint32_t)) != g_loadEventUID || size < sizeof(struct cceaAppendListOfRunDelayedActions) ||
+          getUint32(actions + offsetof(struct cceaAppendListOfRunDelayedActions, UID)) != g_delayedListUID)
+         continue;
+      uint32_t delayedSize = getUint32(actions + offsetof(struct cceaAppendListOfRunDelayedActions, totalSize));
+      if (delayedSize < sizeof(struct cceaAppendListOfRunDelayedActions) || delayedSize > size)
+         report(context, "delayed actions take %u bytes of %u bytes of load event", delayedSize, size);
+   }
+}
+
+static void checkSection (struct ccf_context *context, const struct ccf_section *section, const uint8_t *raw)
+{
+   struct ccf_reader reader = {raw, raw + section->rawSize, 0};
+   if (section->uid == g_resourcesUID)
+      checkResources(context, &reader, section->sectionSize);
+   else if (section->uid == g_renderingUID)
+      checkRendering(context, &reader, section->sectionSize);
+   else if (section->uid == g_actionsUID)
+      checkActions(context, &reader, section->sectionSize);
+   else
+      return; // Defined by the game
+   
+   if (reader.failed)
+      report(context, "section is truncated");
+   else if (reader.position != reader.end)
+      report(context, "%llu bytes after the end of section", (unsigned long long)(reader.end - reader.position));
+}
+
+static const char* sectionName (uint32_t uid)
+{
+   if (uid == g_resourcesUID)
+      return "m2Dres";
+   if (uid == g_renderingUID)
+      return "m2Drend";
+   if (uid == g_actionsUID)
+      return "cceacde";
+   static char name[sizeof("uid 4294967295")];
+   snprintf(name, sizeof(name), "uid %u", uid);
+   return name;
+}
+
+/* Legacy header doesn't store where sections end, so they are measured by parsing, which is only possible for known sections.
+ * Returns UINT32_MAX for unknown section and UINT32_MAX - 1 for truncated one */
+static uint32_t measureLegacySection (const struct ccf_section *section, const uint8_t *data, const uint8_t *end)
+{
+   struct ccf_reader reader = {data, end, 0};
+   if (section->uid == g_resourcesUID)
+   {
+      const uint8_t *sizes = readBytes(&reader, (uint64_t) section->sectionSize * sizeof(uint32_t));
+      for (uint32_t i = 0; sizes != NULL && i < section->sectionSize; ++i)
+         readBytes(&reader, getUint32(sizes + i * sizeof(uint32_t)));
+   }
+   else if (section->uid == g_renderingUID)
+   {
+      uint16_t elementsQuantity = readUint16(&reader);
+      uint32_t elementsTotal = readUint32(&reader);
+      readBytes(&reader, (uint64_t) section->sectionSize * sizeof(uint32_t) + (uint64_t) elementsQuantity * sizeof(struct cce_element) +
+                         (uint64_t) elementsTotal * sizeof(struct cce_elementposition));
+   }
+   else if (section->uid == g_actionsUID)
+   {
+      readBytes(&reader, sizeof(uint32_t) + (uint64_t) section->sectionSize * sizeof(uint32_t));
+      for (uint32_t i = 0; i < section->sectionSize; ++i)
+         readBytes(&reader, (uint64_t) readUint32(&reader) * sizeof(uint32_t));
+      for (uint32_t i = 0; i < section->sectionSize; ++i)
+         readBytes(&reader, readUint32(&reader));
+   }
+   else
+   {
+      return UINT32_MAX;
+   }
+   return reader.failed ? UINT32_MAX - 1u : (uint32_t)(reader.position - data);
+}
+
+static unsigned checkFile (const char *path)
+{
+   struct ccf_context context = {path, "header", 0, 0, 0};
+   FILE *file = fopen(path, "rb");
+   if (file == NULL)
+   {
+      report(&context, "can't open file");
+      return context.errors;
+   }
+   fseek(file, 0, SEEK_END);
+   long fileSize = ftell(file);
+   fseek(file, 0, SEEK_SET);
+   uint8_t *data = malloc(fileSize > 0 ? fileSize : 1);
+   if (fileSize < 0 || fread(data, sizeof(uint8_t), fileSize, file) != (size_t) fileSize)
+   {
+      report(&context, "can't read file");
+      fclose(file);
+      free(data);
+      return context.errors;
+   }
+   fclose(file);
+   
+   struct ccf_reader reader = {data, data + fileSize, 0};
+   struct ccf_section sections[255];
+   uint8_t version = 0, loaders = 0, complete = 1;
+   if (fileSize == 0)
+   {
+      report(&context, "file is empty");
+      goto END;
+   }
+   if (data[0] == 0 && fileSize > 1)
+   {
+      if (fileSize < 3 || (data[1] != CCF_VERSION && data[1] != CCF_UNCHECKED_VERSION))
+      {
+         report(&context, "unknown version %u", data[1]);
+         goto END;
+      }
+      version = data[1];
+      readBytes(&reader, 2);
+   }
+   loaders = *readBytes(&reader, 1);
+   for (unsigned i = 0; i < loaders; ++i)
+      sections[i].uid = readUint32(&reader);
+   if (version != 0)
+   {
+      for (unsigned i = 0; i < loaders; ++i)
+         sections[i].sectionSize = readUint32(&reader);
+      for (unsigned i = 0; i < loaders; ++i)
+         sections[i].storedSize = readUint32(&reader);
+      for (unsigned i = 0; i < loaders; ++i)
+         sections[i].rawSize = readUint32(&reader);
+      for (unsigned i = 0; i < loaders; ++i)
+         sections[i].checksum = (version == CCF_VERSION) ? readUint32(&reader) : 0;
+      for (unsigned i = 0; i < loaders; ++i)
+      {
+         const uint8_t *codec = readBytes(&reader, 1);
+         sections[i].codec = (codec == NULL) ? 0 : *codec;
+      }
+   }
+   else
+   {
+      for (unsigned i = 0; i < loaders; ++i)
+      {
+         sections[i].sectionSize = readUint16(&reader);
+         sections[i].codec = CCF_CODEC_NONE;
+      }
+   }
+   if (reader.failed)
+   {
+      report(&context, "header is truncated");
+      goto END;
+   }
+   for (unsigned i = 0; i < loaders; ++i)
+   {
+      for (unsigned j = 0; j < i; ++j)
+      {
+         if (sections[j].uid == sections[i].uid)
+            report(&context, "section %s is stored twice", sectionName(sections[i].uid));
+      }
+   }
+   
+   for (unsigned i = 0; i < loaders; ++i)
+   {
+      struct ccf_section *section = sections + i;
+      context.section = sectionName(section->uid);
+      if (version == 0)
+      {
+         uint32_t size = measureLegacySection(section, reader.position, reader.end);
+         if (size == UINT32_MAX)
+         {
+            // Not an error, the file may be valid for the game which wrote it
+            printf("%s: %s: unknown section in legacy file, the rest isn't checked\n", path, context.section);
+            loaders = i;
+            complete = 0;
+            break;
+         }
+         if (size == UINT32_MAX - 1u)
+         {
+            report(&context, "section is truncated");
+            goto END;
+         }
+         section->storedSize = section->rawSize = size;
+      }
+      section->stored = readBytes(&reader, section->storedSize);
+      if (section->stored == NULL)
+      {
+         report(&context, "section takes %u bytes, only %llu are left in the file", section->storedSize, (unsigned long long)(reader.end - reader.position));
+         goto END;
+      }
+      if (version != 0 && section->sectionSize > UINT16_MAX)
+         report(&context, "section size %u is larger than loaders accept", section->sectionSize);
+      if (version == CCF_VERSION)
+      {
+         uint32_t checksum = cceCRC32C(0, section->stored, section->storedSize);
+         if (checksum != section->checksum)
+         {
+            report(&context, "checksum is %08X, header expects %08X", checksum, section->checksum);
+            continue;
+         }
+      }
+      if (section->codec == CCF_CODEC_NONE)
+      {
+         if (section->rawSize != section->storedSize)
+            report(&context, "uncompressed section stores %u bytes, header says %u", section->storedSize, section->rawSize);
+      }
+      else if (section->codec != CCF_CODEC_LZ)
+      {
+         report(&context, "unknown codec %u", section->codec);
+      }
+   }
+   if (reader.position != reader.end && complete)
+   {
+      context.section = "file";
+      report(&context, "%llu bytes after the last section", (unsigned long long)(reader.end - reader.position));
+   }
+   
+   // Resources are checked first, rendering data refers to textures listed there
+   for (unsigned pass = 0; pass < 2; ++pass)
+   {
+      for (unsigned i = 0; i < loaders; ++i)
+      {
+         struct ccf_section *section = sections + i;
+         if ((section->uid == g_resourcesUID) != (pass == 0))
+            continue;
+         context.section = sectionName(section->uid);
+         if (section->codec == CCF_CODEC_NONE)
+         {
+            if (section->rawSize == section->storedSize)
+               checkSection(&context, section, section->stored);
+            continue;
+         }
+         if (section->codec != CCF_CODEC_LZ)
+            continue;
+         if (section->rawSize > cceGetDecompressLZbound(section->storedSize))
+         {
+            report(&context, "%u compressed bytes can't unpack into %u", section->storedSize, section->rawSize);
+            continue;
+         }
+         uint8_t *raw = malloc(section->rawSize > 0 ? section->rawSize : 1);
+         if (cceDecompressLZ(section->stored, section->storedSize, raw, section->rawSize) != 0)
+            report(&context, "compressed data is corrupted");
+         else
+            checkSection(&context, section, raw);
+         free(raw);
+      }
+   }
+
+END:
+   free(data);
+   if (context.errors == 0)
+      printf("%s: OK, %u sections checked, %s header\n", path, loaders, (version == CCF_VERSION) ? "checksummed" : (version != 0) ? "versioned" : "legacy");
+   return context.errors;
+}
+
+int main (int argc, char **argv)
+{
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s file...\nChecks structure of CCF files (maps and other files written by the engine)\n", argv[0]);
+      return 2;
+   }
+   g_resourcesUID = cceNameToUID("m2Dres");
+   g_renderingUID = cceNameToUID("m2Drend");
+   g_actionsUID = cceNameToUID("cceacde");
+   g_loadEventUID = cceNameToUID("cceload");
+   g_delayedListUID = cceNameToUID("ccealrd");
+   unsigned errors = 0;
+   for (int i = 1; i < argc; ++i)
+      errors += checkFile(argv[i]);
+   return errors != 0;
+}